@@ -1,62 +1,182 @@
 #include "application.hpp"
 #include "renderSystem.hpp"
+#include "instancedRenderSystem.hpp"
+#include "indirectRenderSystem.hpp"
+
+#include "lwEngine/assetmanager.hpp"
+#include "lwEngine/parallelrecorder.hpp"
+#include "lwEngine/pipelinecache.hpp"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
-#include <array>
+#include <chrono>
+#include <iostream>
 #include <vector>
 
 void Application::run() {
 	// Create descriptor set layout
 	std::unique_ptr<DescriptorSetLayout> descriptorSetLayout = DescriptorSetLayout::Builder(m_device)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
+			.build();
+	std::unique_ptr<DescriptorSetLayout> instancedSetLayout = DescriptorSetLayout::Builder(m_device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1)
 			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
 			.build();
 
 	// Create render systems
-	RenderSystem rotationSystem{m_device, m_renderer.swapchainRenderPass(), descriptorSetLayout->descriptorSetLayout()};
-	std::vector<Model*> rotationObjects = {&m_modelViking};
+	const uint32_t framesInFlight = m_renderer.maxFramesInFlight();
+	RenderSystem rotationSystem{m_device, m_renderer.swapchainRenderPass(), descriptorSetLayout->descriptorSetLayout(), framesInFlight};
+	// Three rooms share one model and differ only in their transform.
+	// The fourth one is loaded in the background and appears once its upload finished.
+	AssetManager assets{m_device, m_jobs, m_assetCache};
+	ModelHandle streamedViking = assets.loadModelAsync(RESOURCE_PATH_VIKING_MODEL, RESOURCE_PATH_VIKING_TEXTURE);
+	std::vector<RenderObject> rotationObjects = {
+			{&m_modelViking, {0.0f, 0.0f, 0.0f}},
+			{&m_modelViking, {1.5f, -1.5f, 0.0f}, {1.0f, 0.6f, 0.6f, 1.0f}},
+			{&m_modelViking, {-1.5f, 1.5f, 0.0f}, {0.6f, 0.6f, 1.0f, 1.0f}},
+			{nullptr, {1.5f, 1.5f, 0.0f}, {0.6f, 1.0f, 0.6f, 1.0f}}
+	};
+	InstancedRenderSystem instancedSystem{m_device, m_renderer.swapchainRenderPass(), instancedSetLayout->descriptorSetLayout(), framesInFlight};
+	IndirectRenderSystem indirectSystem{m_device, m_renderer.swapchainRenderPass(), instancedSetLayout->descriptorSetLayout(),
+	                                    m_meshPool, m_pooledViking.meshRange(), framesInFlight};
+
+	// Draws are recorded into secondary command buffers by the jobs of all cores.
+	ParallelRecorder recorder{m_device, m_jobs, framesInFlight};
 
 	// Create descriptor pool
 	m_descriptorPool = DescriptorPool::Builder(m_device)
-			.setMaxSets(static_cast<uint32_t>(Swapchain::MAX_FRAMES_IN_FLIGHT))
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Swapchain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Swapchain::MAX_FRAMES_IN_FLIGHT)
+			.setMaxSets(3 * framesInFlight)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4 * framesInFlight)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3 * framesInFlight)
 			.build();
 
 	// Create two descriptor sets
-	std::array<VkDescriptorSet, Swapchain::MAX_FRAMES_IN_FLIGHT> descriptorSets;
+	std::vector<VkDescriptorSet> descriptorSets(framesInFlight);
 	for (std::size_t i = 0; i != descriptorSets.size(); ++i) {
 		auto bufferInfo = rotationSystem.bufferDescriptor(static_cast<uint32_t>(i));
 		auto imageInfo = m_modelViking.descriptorInfo();
+		auto objectInfo = rotationSystem.objectDescriptor(static_cast<uint32_t>(i));
 
-		// Create descriptor set with two descriptors from the specified pool with the specified layout.
+		// Create descriptor set with three descriptors from the specified pool with the specified layout.
 		DescriptorWriter(*descriptorSetLayout, *m_descriptorPool)
 				.writeBuffer(0, &bufferInfo)
 				.writeImage(1, &imageInfo)
+				.writeBuffer(2, &objectInfo)
 				.build(descriptorSets[i]);
 	}
 
+	std::vector<VkDescriptorSet> instancedSets(framesInFlight);
+	for (std::size_t i = 0; i != instancedSets.size(); ++i) {
+		auto bufferInfo = instancedSystem.bufferDescriptor(static_cast<uint32_t>(i));
+		auto imageInfo = m_modelViking.descriptorInfo();
+
+		DescriptorWriter(*instancedSetLayout, *m_descriptorPool)
+				.writeBuffer(0, &bufferInfo)
+				.writeImage(1, &imageInfo)
+				.build(instancedSets[i]);
+	}
+
+	std::vector<VkDescriptorSet> indirectSets(framesInFlight);
+	for (std::size_t i = 0; i != indirectSets.size(); ++i) {
+		auto bufferInfo = indirectSystem.bufferDescriptor(static_cast<uint32_t>(i));
+		auto imageInfo = m_pooledViking.descriptorInfo();
+
+		DescriptorWriter(*instancedSetLayout, *m_descriptorPool)
+				.writeBuffer(0, &bufferInfo)
+				.writeImage(1, &imageInfo)
+				.build(indirectSets[i]);
+	}
+
 	// Render loop
+	GpuProfiler& profiler = m_renderer.profiler();
+	assets.setProfiler(&profiler);
+	uint64_t frameCount = 0;
+	const auto loopStart = std::chrono::steady_clock::now();
 	while(!m_window.shouldClose()) {
+		m_renderer.waitForNextFrame();  // Input is sampled as late as possible
         glfwPollEvents();
+		m_jobs.runMainThreadJobs();
+		assets.update();
+		rotationObjects.back().model = streamedViking.get();
+
+		// A new surface format replaced the render pass. Rare enough to wait for the frames that use the old pipelines.
+		if(m_renderer.renderPassChanged()) {
+			vkDeviceWaitIdle(m_device.device());
+			const VkRenderPass renderPass = m_renderer.swapchainRenderPass();
+			rotationSystem.recreatePipeline(renderPass, descriptorSetLayout->descriptorSetLayout());
+			instancedSystem.recreatePipeline(renderPass, instancedSetLayout->descriptorSetLayout());
+			indirectSystem.recreatePipeline(renderPass, instancedSetLayout->descriptorSetLayout());
+		}
 
 		// Start rendering
 		VkCommandBuffer commandBuffer = m_renderer.beginFrame();
 		if(commandBuffer) {
-			m_renderer.beginSwapchainRenderPass(commandBuffer);
+			const uint32_t frame = m_renderer.currentSwapchainFrame();
+			m_assetCache.endFrame();  // The fence of the frame was waited for
+
+			// Compute work has to be recorded outside of the render pass.
+			const uint32_t cullScope = profiler.beginScope(commandBuffer, "Culling");
+			indirectSystem.cullObjects(frame, commandBuffer, m_renderer.swapchainExtent());
+			profiler.endScope(commandBuffer, cullScope);
+
+			recorder.beginFrame(frame, m_renderer.swapchainRenderPassTarget());
+			m_renderer.beginSwapchainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
 			// Rendering ouf stuff
-			rotationSystem.renderObjects(m_renderer.currentSwapchainFrame(), commandBuffer,
-										 m_renderer.swapchainExtent(), descriptorSets[m_renderer.currentSwapchainFrame()],
-										 rotationObjects);
+			rotationSystem.renderObjects(frame, recorder, m_renderer.swapchainExtent(), descriptorSets[frame], rotationObjects);
+			// A subpass either records inline or executes secondary command buffers, single draws get one of their own.
+			recorder.record(1, [&](VkCommandBuffer secondary, uint32_t, uint32_t) {
+				const uint32_t instancedScope = profiler.beginScope(secondary, "Instanced");
+				instancedSystem.renderObjects(frame, secondary, m_renderer.swapchainExtent(), instancedSets[frame], m_modelViking);
+				profiler.endScope(secondary, instancedScope);
+
+				const uint32_t indirectScope = profiler.beginScope(secondary, "Indirect");
+				indirectSystem.renderObjects(frame, secondary, m_renderer.swapchainExtent(), indirectSets[frame]);
+				profiler.endScope(secondary, indirectScope);
+			});
+			recorder.execute(commandBuffer);
 
 			// End rendering
 			m_renderer.endSwapchainRenderPass(commandBuffer);
+			const uint32_t pyramidScope = profiler.beginScope(commandBuffer, "Depth pyramid");
+			indirectSystem.buildDepthPyramid(m_renderer.currentSwapchainFrame(), commandBuffer, m_renderer.depthAttachment());
+			profiler.endScope(commandBuffer, pyramidScope);
 			m_renderer.endFrame();
+			++frameCount;
 		}
     }
 
     vkDeviceWaitIdle(m_device.device());
+
+	if(streamedViking.state() == AssetState::Failed) {
+		std::cout << streamedViking.error() << "\n";
+	}
+	// A GPU frame time close to the CPU frame time means the GPU is the bottleneck.
+	const double loopMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loopStart).count();
+	if(frameCount != 0) {
+		std::cout << "CPU frame time: " << loopMs / static_cast<double>(frameCount) << " ms\n";
+	}
+	if(profiler.isSupported()) {
+		std::cout << profiler.report();
+	}
+
+	const FrameLatencyStats& latency = m_renderer.latency();
+	std::cout << "Input to present latency of the last frames: " << latency.averageMs << " ms average, " << latency.maxMs << " ms max\n";
+	const ResourceCacheStats& cacheStatistics = m_assetCache.stats();
+	std::cout << "Asset cache: " << cacheStatistics.entryCount << " resources, " << cacheStatistics.residentBytes / 1024 << " KiB, "
+	          << cacheStatistics.hits << " hits, " << cacheStatistics.misses << " misses, " << cacheStatistics.evictions << " evictions\n";
+
+	// Compare the first start (cold) with the following ones (warm).
+	const PipelineCacheStatistics& statistics = m_device.pipelineCache().statistics();
+	std::cout << "Pipeline creation (" << (statistics.warm ? "warm" : "cold") << " cache): " << statistics.pipelineCount
+	          << " pipelines in " << statistics.creationMilliseconds << " ms\n";
+	std::cout << "Indirect draws: " << indirectSystem.objectCount() << " objects submitted in "
+	          << indirectSystem.averageSubmissionMicroseconds() << " us per frame\n";
+	std::cout << "Draw recording: " << recorder.threadCount() << " threads, " << rotationSystem.averageRecordingMicroseconds()
+	          << " us per frame\n";
+	std::cout << "Culling (" << (indirectSystem.gpuCulling() ? "GPU" : "none") << "): " << indirectSystem.averageVisibleObjects()
+	          << " of " << indirectSystem.objectCount() << " objects visible per frame\n";
 }
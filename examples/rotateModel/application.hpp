@@ -6,7 +6,10 @@
 #include "lwEngine/device.hpp"
 #include "lwEngine/renderer.hpp"
 #include "lwEngine/descriptor.hpp"
+#include "lwEngine/assetcache.hpp"
+#include "lwEngine/jobsystem.hpp"
 #include "lwEngine/model.hpp"
+#include "lwEngine/meshpool.hpp"
 
 class Application {
 public:
@@ -16,10 +19,16 @@ private:
     static constexpr int WIDTH = 800;
     static constexpr int HEIGHT = 600;
 
+    JobSystem m_jobs;  //! Created on the main thread, which becomes thread 0
     Window m_window{WIDTH, HEIGHT, "Vulkan"};
     Device m_device{m_window};
 	Renderer m_renderer{m_device, m_window};
 
 	std::unique_ptr<DescriptorPool> m_descriptorPool;
+	AssetCache m_assetCache{m_device, AssetCache::DEFAULT_BUDGET, m_renderer.maxFramesInFlight()};  //! Meshes and textures shared by all streamed models
 	Model m_modelViking{m_device, RESOURCE_PATH_VIKING_MODEL, RESOURCE_PATH_VIKING_TEXTURE};
+
+	// Shared vertex and index buffer for the indirect draws
+	MeshPool m_meshPool{m_device, 1 << 20, 1 << 22};
+	Model m_pooledViking{m_device, m_meshPool, RESOURCE_PATH_VIKING_MODEL, RESOURCE_PATH_VIKING_TEXTURE};
 };
@@ -0,0 +1,196 @@
+#include "indirectRenderSystem.hpp"
+#include "lwEngine/swapchain.hpp"
+#include "lwEngine/vertex.hpp"
+#include "lwEngine/upload.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+
+//! Unit cube with the texture mapped onto every face.
+static MeshData makeCube() {
+	const glm::vec3 corners[8] = {{-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f},
+	                              {-0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f}};
+	const uint32_t faces[6][4] = {{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {2, 3, 7, 6}, {1, 2, 6, 5}, {3, 0, 4, 7}};
+	const glm::vec2 texCoords[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+
+	MeshData mesh;
+	for(const auto& face : faces) {
+		const uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+		for(uint32_t i = 0; i != 4; ++i) {
+			mesh.vertices.push_back({corners[face[i]], {1.0f, 1.0f, 1.0f}, texCoords[i]});
+		}
+		mesh.indices.insert(mesh.indices.end(), {first, first + 1, first + 2, first + 2, first + 3, first});
+	}
+	mesh.bounds = computeBounds(mesh.vertices.data(), mesh.vertices.size());
+	return mesh;
+}
+
+IndirectRenderSystem::IndirectRenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, MeshPool& meshPool, const MeshRange& model,
+                                           uint32_t framesInFlight)
+	: m_device(device), m_meshPool(meshPool), m_framesInFlight(framesInFlight) {
+	createGraphicsPipeline(renderPass, descriptorSetLayout);
+
+	UploadBatch upload{m_device};
+	m_meshes = {model, m_meshPool.add(upload, makeCube())};
+	upload.submit();
+	upload.wait();
+
+	m_frameArena = std::make_unique<FrameArena>(m_device, m_framesInFlight, 64 * 1024);
+	m_instances = std::make_unique<InstanceBuffer>(m_device, m_framesInFlight, GRID_SIZE * GRID_SIZE);
+	m_draws = std::make_unique<IndirectDrawBuffer>(m_device, m_framesInFlight, GRID_SIZE * GRID_SIZE);
+	if(CullingPass::isSupported(m_device)) {
+		m_culling = std::make_unique<CullingPass>(m_device, m_pathCullShader, *m_draws, m_framesInFlight);
+		m_culled.assign(m_framesInFlight, false);
+	}
+	createObjects(m_framesInFlight);
+}
+
+VkDescriptorBufferInfo IndirectRenderSystem::bufferDescriptor(uint32_t currentFrame) {
+	return m_frameArena->descriptorInfo(currentFrame, sizeof(UniformBufferObject));
+}
+
+double IndirectRenderSystem::averageSubmissionMicroseconds() const {
+	return m_frames != 0 ? m_submissionMicroseconds / static_cast<double>(m_frames) : 0.0;
+}
+
+double IndirectRenderSystem::averageVisibleObjects() const {
+	if(!m_culling) {
+		return static_cast<double>(objectCount());
+	}
+	return m_culledFrames != 0 ? static_cast<double>(m_visibleObjects) / static_cast<double>(m_culledFrames) : 0.0;
+}
+
+uint32_t IndirectRenderSystem::objectCount() const {
+	return static_cast<uint32_t>(m_objectMeshes.size());
+}
+
+bool IndirectRenderSystem::gpuCulling() const {
+	return m_culling != nullptr;
+}
+
+UniformBufferObject IndirectRenderSystem::camera(VkExtent2D frameExtent) const {
+	UniformBufferObject ubo{};
+	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	ubo.proj = glm::perspective(glm::radians(45.0f), static_cast<float>(frameExtent.width) / static_cast<float>(frameExtent.height), 0.1f, 10.0f);
+	ubo.proj[1][1] *= -1;  // Invert the y-coordinate of clip coordinate because glm was designed for OpenGL
+	return ubo;
+}
+
+void IndirectRenderSystem::recreatePipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout) {
+	createGraphicsPipeline(renderPass, descriptorSetLayout);
+}
+
+void IndirectRenderSystem::createGraphicsPipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout) {
+	PipelineInfo pipelineInfo{};
+	pipelineInfo.descriptorSetLayout = &descriptorSetLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.instanced = true;
+
+	m_graphicsPipeline = std::make_unique<Pipeline>(m_device, m_pathVertexShader, m_pathFragmentShader, pipelineInfo);
+}
+
+void IndirectRenderSystem::createObjects(uint32_t frameCount) {
+	// A wide field of small objects below the other systems, most of it outside of the view.
+	const float spacing = 0.04f;
+	const float origin = -0.5f * spacing * static_cast<float>(GRID_SIZE - 1);
+
+	std::vector<InstanceData> instances(GRID_SIZE * GRID_SIZE);
+	std::vector<CullObject> objects(instances.size());
+	m_objectMeshes.resize(instances.size());
+	for(uint32_t y = 0; y != GRID_SIZE; ++y) {
+		for(uint32_t x = 0; x != GRID_SIZE; ++x) {
+			const uint32_t object = y * GRID_SIZE + x;
+			m_objectMeshes[object] = (x % 8 == 0 && y % 8 == 0) ? 0 : 1;  // Every 64th object is the model
+
+			InstanceData& instance = instances[object];
+			instance.transform = glm::translate(glm::mat4(1.0f), {origin + spacing * static_cast<float>(x), origin + spacing * static_cast<float>(y), -1.2f});
+			instance.transform = glm::scale(instance.transform, glm::vec3(m_objectMeshes[object] == 0 ? 0.04f : 0.015f));
+			instance.color = {static_cast<float>(x) / GRID_SIZE, static_cast<float>(y) / GRID_SIZE, 0.8f, 1.0f};
+			instance.custom = glm::vec4(0.0f);
+
+			const MeshRange& mesh = m_meshes[m_objectMeshes[object]];
+			const BoundingSphere sphere = transformSphere(boundingSphere(mesh.bounds), instance.transform);
+			objects[object] = {glm::vec4(sphere.center, sphere.radius), mesh.indexCount, mesh.firstIndex, mesh.vertexOffset, object};
+		}
+	}
+
+	// Transforms do not change, every frame gets the same copy once.
+	for(uint32_t frame = 0; frame != frameCount; ++frame) {
+		m_instances->update(frame, instances.data(), static_cast<uint32_t>(instances.size()));
+		if(m_culling) {
+			m_culling->update(frame, objects.data(), static_cast<uint32_t>(objects.size()));
+		}
+	}
+}
+
+void IndirectRenderSystem::cullObjects(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkExtent2D frameExtent) {
+	if(!m_culling) {
+		return;
+	}
+
+	// Result of the last culling of this frame, its fence is signaled.
+	if(m_culled[currentFrame]) {
+		m_visibleObjects += m_draws->gpuWrittenCount(currentFrame);
+		++m_culledFrames;
+	}
+
+	// Pyramids of an old size are destroyed once every frame index was waited for, no frame in flight reads them anymore.
+	for(auto& retired : m_retiredPyramids) {
+		--retired.second;
+	}
+	m_retiredPyramids.erase(std::remove_if(m_retiredPyramids.begin(), m_retiredPyramids.end(), [](const auto& retired) { return retired.second == 0; }),
+	                        m_retiredPyramids.end());
+
+	// The depth attachment has the size of the swapchain.
+	if(!m_depthPyramid || m_depthPyramid->depthExtent().width != frameExtent.width || m_depthPyramid->depthExtent().height != frameExtent.height) {
+		if(m_depthPyramid) {
+			m_retiredPyramids.emplace_back(std::move(m_depthPyramid), m_framesInFlight);
+		}
+		m_depthPyramid = std::make_unique<DepthPyramid>(m_device, m_pathDepthReduceShader, frameExtent, m_framesInFlight);
+	}
+
+	const UniformBufferObject ubo = camera(frameExtent);
+	m_culling->dispatch(commandBuffer, currentFrame, ubo.proj * ubo.view, *m_depthPyramid);
+	m_culled[currentFrame] = true;
+}
+
+void IndirectRenderSystem::buildDepthPyramid(uint32_t currentFrame, VkCommandBuffer commandBuffer, const DepthAttachment& depth) {
+	if(m_culling) {
+		m_depthPyramid->build(commandBuffer, currentFrame, depth);
+	}
+}
+
+void IndirectRenderSystem::renderObjects(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkExtent2D frameExtent, VkDescriptorSet descriptorSet) {
+	m_frameArena->beginFrame(currentFrame);
+	const uint32_t frameOffset = m_frameArena->push(camera(frameExtent));
+
+	m_graphicsPipeline->bind(commandBuffer);
+	vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_graphicsPipeline->layout(), 0, 1,
+			&descriptorSet, 1, &frameOffset
+	);
+	m_meshPool.bind(commandBuffer);
+	m_instances->bind(commandBuffer, currentFrame);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	if(m_culling) {
+		// The culling wrote the draws of the visible objects.
+		m_draws->recordGpuWritten(commandBuffer, m_culling->count(currentFrame));
+	} else {
+		// One command per object, written straight into mapped memory. The object index selects its instance data.
+		m_draws->begin(currentFrame);
+		for(uint32_t object = 0; object != m_objectMeshes.size(); ++object) {
+			m_draws->add(m_meshes[m_objectMeshes[object]], 1, object);
+		}
+		m_draws->record(commandBuffer);
+	}
+
+	m_submissionMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	++m_frames;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "lwEngine/device.hpp"
+#include "lwEngine/pipeline.hpp"
+#include "lwEngine/framearena.hpp"
+#include "lwEngine/instancebuffer.hpp"
+#include "lwEngine/indirectdraw.hpp"
+#include "lwEngine/meshpool.hpp"
+#include "lwEngine/cullingpass.hpp"
+#include "lwEngine/depthpyramid.hpp"
+#include "lwEngine/vertex.hpp"
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+//! Example render system that draws a large number of objects from a mesh pool with one indirect draw.
+//! The transforms are static and stored as instance data. If the device supports it, a compute pass culls the objects
+//! against the frustum and the depth of the previous frame and writes the draws. Otherwise the CPU writes all draws every frame.
+class IndirectRenderSystem {
+public:
+	static constexpr uint32_t GRID_SIZE = 224;  //! GRID_SIZE * GRID_SIZE objects (~50k)
+
+	//! @param model Mesh of the pool that is drawn for some of the objects, the others are cubes.
+	IndirectRenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, MeshPool& meshPool, const MeshRange& model,
+	                     uint32_t framesInFlight);
+
+	//! Record the culling of the frame. Outside of the render pass, before renderObjects().
+	void cullObjects(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkExtent2D frameExtent);
+	void renderObjects(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkExtent2D frameExtent, VkDescriptorSet descriptorSet);
+	//! Record the depth pyramid for the culling of the next frame. After the render pass.
+	void buildDepthPyramid(uint32_t currentFrame, VkCommandBuffer commandBuffer, const DepthAttachment& depth);
+
+	//! Dynamic uniform buffer descriptor of the frame uniforms (binding 0).
+	VkDescriptorBufferInfo bufferDescriptor(uint32_t currentFrame);
+
+	//! Average CPU time to write the draw commands and record them.
+	double averageSubmissionMicroseconds() const;
+	//! Average number of objects that passed the GPU culling, all objects without it.
+	double averageVisibleObjects() const;
+	uint32_t objectCount() const;
+	bool gpuCulling() const;
+
+	//! Like RenderSystem::recreatePipeline().
+	void recreatePipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
+
+private:
+	void createGraphicsPipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
+	void createObjects(uint32_t frameCount);
+	UniformBufferObject camera(VkExtent2D frameExtent) const;
+
+private:
+	// Owned by application
+	Device& m_device;
+	MeshPool& m_meshPool;
+
+	uint32_t m_framesInFlight;
+
+	const std::string m_pathVertexShader = SHADER_PATH_INSTANCED_VERTEX;
+	const std::string m_pathFragmentShader = SHADER_PATH_INSTANCED_FRAGMENT;
+	const std::string m_pathCullShader = SHADER_PATH_CULL;
+	const std::string m_pathDepthReduceShader = SHADER_PATH_DEPTH_REDUCE;
+
+	std::vector<MeshRange> m_meshes;
+	std::vector<uint32_t> m_objectMeshes;  //! Index into m_meshes for every object
+
+	std::unique_ptr<FrameArena> m_frameArena;
+	std::unique_ptr<InstanceBuffer> m_instances;
+	std::unique_ptr<IndirectDrawBuffer> m_draws;
+	std::unique_ptr<Pipeline> m_graphicsPipeline;
+
+	// Only used with GPU culling
+	std::unique_ptr<CullingPass> m_culling;
+	std::unique_ptr<DepthPyramid> m_depthPyramid;  //! Recreated when the size of the swapchain changes
+	std::vector<std::pair<std::unique_ptr<DepthPyramid>, uint32_t>> m_retiredPyramids;  //! With the frames until they are unused
+	std::vector<bool> m_culled;                    //! Frames with a culling result to read back
+
+	double m_submissionMicroseconds = 0.0;
+	uint64_t m_frames = 0;
+	uint64_t m_visibleObjects = 0;
+	uint64_t m_culledFrames = 0;
+};
@@ -0,0 +1,81 @@
+#include "instancedRenderSystem.hpp"
+#include "lwEngine/vertex.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+
+InstancedRenderSystem::InstancedRenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, uint32_t framesInFlight)
+	: m_device(device) {
+	createGraphicsPipeline(renderPass, descriptorSetLayout);
+	m_frameArena = std::make_unique<FrameArena>(m_device, framesInFlight, 64 * 1024);
+	m_instances = std::make_unique<InstanceBuffer>(m_device, framesInFlight, GRID_SIZE * GRID_SIZE);
+}
+
+VkDescriptorBufferInfo InstancedRenderSystem::bufferDescriptor(uint32_t currentFrame) {
+	return m_frameArena->descriptorInfo(currentFrame, sizeof(UniformBufferObject));
+}
+
+void InstancedRenderSystem::recreatePipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout) {
+	createGraphicsPipeline(renderPass, descriptorSetLayout);
+}
+
+void InstancedRenderSystem::createGraphicsPipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout) {
+	PipelineInfo pipelineInfo{};
+	pipelineInfo.descriptorSetLayout = &descriptorSetLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.instanced = true;
+
+	m_graphicsPipeline = std::make_unique<Pipeline>(m_device, m_pathVertexShader, m_pathFragmentShader, pipelineInfo);
+}
+
+void InstancedRenderSystem::updateInstances(uint32_t currentFrame, float time) {
+	// Small rooms on a plane below the rotating rooms, each spinning with its own phase.
+	const float spacing = 0.12f;
+	const float origin = -0.5f * spacing * static_cast<float>(GRID_SIZE - 1);
+
+	InstanceData* instances = m_instances->instances(currentFrame);
+	for(uint32_t y = 0; y != GRID_SIZE; ++y) {
+		for(uint32_t x = 0; x != GRID_SIZE; ++x) {
+			const float u = static_cast<float>(x) / static_cast<float>(GRID_SIZE - 1);
+			const float v = static_cast<float>(y) / static_cast<float>(GRID_SIZE - 1);
+
+			InstanceData& instance = instances[y * GRID_SIZE + x];
+			instance.transform = glm::translate(glm::mat4(1.0f), {origin + spacing * static_cast<float>(x), origin + spacing * static_cast<float>(y), -0.8f});
+			instance.transform = glm::rotate(instance.transform, time + 4.0f * (u + v), glm::vec3(0.0f, 0.0f, 1.0f));
+			instance.transform = glm::scale(instance.transform, glm::vec3(0.05f));
+			instance.color = {0.5f + 0.5f * u, 0.5f + 0.5f * v, 1.0f, 1.0f};
+			instance.custom = glm::vec4(0.0f);
+		}
+	}
+	m_instances->setCount(currentFrame, GRID_SIZE * GRID_SIZE);
+}
+
+void InstancedRenderSystem::renderObjects(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkExtent2D frameExtent, VkDescriptorSet descriptorSet, Model& model) {
+	static auto startTime = std::chrono::high_resolution_clock::now();
+
+	auto currentTime = std::chrono::high_resolution_clock::now();
+	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+
+	// The fence of this frame was waited for in beginFrame, the GPU does not read the buffers of this frame anymore.
+	updateInstances(currentFrame, time);
+
+	m_frameArena->beginFrame(currentFrame);
+	UniformBufferObject ubo{};
+	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	ubo.proj = glm::perspective(glm::radians(45.0f), static_cast<float>(frameExtent.width) / static_cast<float>(frameExtent.height), 0.1f, 10.0f);
+	ubo.proj[1][1] *= -1;  // Invert the y-coordinate of clip coordinate because glm was designed for OpenGL
+	const uint32_t frameOffset = m_frameArena->push(ubo);
+
+	m_graphicsPipeline->bind(commandBuffer);
+	vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_graphicsPipeline->layout(), 0, 1,
+			&descriptorSet, 1, &frameOffset
+	);
+
+	// One draw call for all instances.
+	model.drawInstanced(commandBuffer, *m_instances, currentFrame);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "lwEngine/device.hpp"
+#include "lwEngine/pipeline.hpp"
+#include "lwEngine/model.hpp"
+#include "lwEngine/framearena.hpp"
+#include "lwEngine/instancebuffer.hpp"
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+
+//! Example render system that draws a grid of copies of one model with a single instanced draw.
+//! The instances are animated on the CPU and written to a persistently mapped instance buffer every frame.
+class InstancedRenderSystem {
+public:
+	static constexpr uint32_t GRID_SIZE = 32;  //! GRID_SIZE * GRID_SIZE instances
+
+	InstancedRenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, uint32_t framesInFlight);
+
+	void renderObjects(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkExtent2D frameExtent, VkDescriptorSet descriptorSet, Model& model);
+
+	//! Dynamic uniform buffer descriptor of the frame uniforms (binding 0).
+	VkDescriptorBufferInfo bufferDescriptor(uint32_t currentFrame);
+
+	//! Like RenderSystem::recreatePipeline().
+	void recreatePipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
+
+private:
+	void createGraphicsPipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
+	//! Scene update: Write the transform and color of every instance for this frame.
+	void updateInstances(uint32_t currentFrame, float time);
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	const std::string m_pathVertexShader = SHADER_PATH_INSTANCED_VERTEX;
+	const std::string m_pathFragmentShader = SHADER_PATH_INSTANCED_FRAGMENT;
+
+	std::unique_ptr<FrameArena> m_frameArena;
+	std::unique_ptr<InstanceBuffer> m_instances;
+	std::unique_ptr<Pipeline> m_graphicsPipeline;
+};
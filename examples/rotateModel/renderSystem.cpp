@@ -1,25 +1,28 @@
 #include "renderSystem.hpp"
-#include "lwEngine/swapchain.hpp"
 #include "lwEngine/vertex.hpp"
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <chrono>
+#include <limits>
 
-RenderSystem::RenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout)
+RenderSystem::RenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, uint32_t framesInFlight)
 	: m_device(device) {
 	createGraphicsPipeline(renderPass, descriptorSetLayout);
-	createUniformBuffers();
+	m_frameArena = std::make_unique<FrameArena>(m_device, framesInFlight);
 }
 
 VkDescriptorBufferInfo RenderSystem::bufferDescriptor(uint32_t currentFrame) {
-	VkDescriptorBufferInfo bufferInfo{};
-	bufferInfo.buffer = m_uniformBuffers[currentFrame];
-	bufferInfo.offset = 0;
-	bufferInfo.range = sizeof(UniformBufferObject);
+	return m_frameArena->descriptorInfo(currentFrame, sizeof(UniformBufferObject));
+}
+
+VkDescriptorBufferInfo RenderSystem::objectDescriptor(uint32_t currentFrame) {
+	return m_frameArena->descriptorInfo(currentFrame, sizeof(ObjectUniforms));
+}
 
-	return bufferInfo;
+void RenderSystem::recreatePipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout) {
+	createGraphicsPipeline(renderPass, descriptorSetLayout);
 }
 
 void RenderSystem::createGraphicsPipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout) {
@@ -27,61 +30,85 @@ void RenderSystem::createGraphicsPipeline(VkRenderPass renderPass, VkDescriptorS
 	PipelineInfo pipelineInfo{};
 	pipelineInfo.descriptorSetLayout = &descriptorSetLayout;
 	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.pushConstantRanges = {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ObjectPushConstants)}};
 
 	m_graphicsPipeline = std::make_unique<Pipeline>(m_device, m_pathVertexShader, m_pathFragmentShader, pipelineInfo);
 };
 
-void RenderSystem::createUniformBuffers() {
-	VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+void RenderSystem::renderObjects(uint32_t currentImage, ParallelRecorder& recorder, VkExtent2D frameExtent, VkDescriptorSet descriptorSet, const std::vector<RenderObject>& objects) {
+	static auto startTime = std::chrono::high_resolution_clock::now();
 
-	m_uniformBuffers.resize(Swapchain::MAX_FRAMES_IN_FLIGHT);
-	m_uniformBuffersMemory.resize(Swapchain::MAX_FRAMES_IN_FLIGHT);
+	auto currentTime = std::chrono::high_resolution_clock::now();
+	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-	for(size_t i = 0; i != Swapchain::MAX_FRAMES_IN_FLIGHT; ++i) {
-		m_device.createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_uniformBuffers[i], m_uniformBuffersMemory[i]);
+	// The fence of this frame was waited for in beginFrame, the GPU does not read the arena of this frame anymore.
+	m_frameArena->beginFrame(currentImage);
+	glm::mat4 viewProjection;
+	const uint32_t frameOffset = updateUniformBuffer(frameExtent, viewProjection);
+
+	const glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	m_transforms.resize(objects.size());
+	m_culling.resize(static_cast<uint32_t>(objects.size()));
+	for(uint32_t i = 0; i != objects.size(); ++i) {
+		m_transforms[i] = glm::translate(glm::mat4(1.0f), objects[i].position) * rotation;
+		// A negative radius is outside of every plane, objects without a model are culled with the rest.
+		m_culling.set(i, objects[i].model ? transformSphere(objects[i].model->boundingSphere(), m_transforms[i])
+		                                  : BoundingSphere{glm::vec3(0.0f), -std::numeric_limits<float>::infinity()});
 	}
-}
-
-void RenderSystem::renderObjects(uint32_t currentImage, VkCommandBuffer commandBuffer, VkExtent2D frameExtent, VkDescriptorSet descriptorSet, std::vector<Model*> objects) {
-	m_graphicsPipeline->bind(commandBuffer);
-	vkCmdBindDescriptorSets(
-			commandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_graphicsPipeline->layout(), 0, 1,
-			&descriptorSet, 0, nullptr
-	);
-
-	for(unsigned i = 0; i != objects.size(); ++i) {
-		objects[i]->bind(commandBuffer);
-		updateUniformBuffer(currentImage, frameExtent, {0.0f, 0.0f, 0.0f});
-		objects[i]->draw(commandBuffer);
+	m_culling.cull(viewProjection, m_visible);
+
+	// The frame arena is not thread safe, all uniforms are written before recording.
+	m_uniformOffsets.resize(m_visible.size());
+	for(size_t i = 0; i != m_visible.size(); ++i) {
+		ObjectUniforms uniforms{};
+		uniforms.tint = objects[m_visible[i]].tint;
+		m_uniformOffsets[i] = m_frameArena->push(uniforms);
 	}
-}
 
-void RenderSystem::updateUniformBuffer(uint32_t currentImage, VkExtent2D frameExtent, glm::vec3 offset) {
-	static auto startTime = std::chrono::high_resolution_clock::now();
+	const auto recordStart = std::chrono::steady_clock::now();
+	recorder.record(static_cast<uint32_t>(m_visible.size()), [&](VkCommandBuffer commandBuffer, uint32_t first, uint32_t count) {
+		// Every secondary command buffer starts without a bound pipeline.
+		m_graphicsPipeline->bind(commandBuffer);
+
+		for(uint32_t i = first; i != first + count; ++i) {
+			const RenderObject& object = objects[m_visible[i]];
+
+			// Push constants are recorded into the command buffer, so every draw keeps its own transform.
+			ObjectPushConstants push{};
+			push.model = m_transforms[m_visible[i]];
+			m_graphicsPipeline->pushConstants(commandBuffer, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+
+			// Same descriptor set for every object, only the dynamic offsets (in binding order) change.
+			const uint32_t dynamicOffsets[] = {frameOffset, m_uniformOffsets[i]};
+			vkCmdBindDescriptorSets(
+					commandBuffer,
+					VK_PIPELINE_BIND_POINT_GRAPHICS,
+					m_graphicsPipeline->layout(), 0, 1,
+					&descriptorSet, 2, dynamicOffsets
+			);
+
+			object.model->bind(commandBuffer);
+			object.model->draw(commandBuffer);
+		}
+	});
+	const auto recordEnd = std::chrono::steady_clock::now();
+
+	m_recordingMicroseconds += std::chrono::duration<double, std::micro>(recordEnd - recordStart).count();
+	++m_recordedFrames;
+}
 
-	auto currentTime = std::chrono::high_resolution_clock::now();
-	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+double RenderSystem::averageRecordingMicroseconds() const {
+	return m_recordedFrames != 0 ? m_recordingMicroseconds / static_cast<double>(m_recordedFrames) : 0.0;
+}
 
+uint32_t RenderSystem::updateUniformBuffer(VkExtent2D frameExtent, glm::mat4& viewProjection) {
 	UniformBufferObject ubo{};
-	ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 	ubo.proj = glm::perspective(glm::radians(45.0f), static_cast<float>(frameExtent.width) / static_cast<float>(frameExtent.height), 0.1f, 10.0f);
 	ubo.proj[1][1] *= -1;  // Invert the y-coordinate of clip coordinate because glm was designed for OpenGL
-	ubo.offset = offset;
+	viewProjection = ubo.proj * ubo.view;
 
-	// NOTE: More efficient way to do this is by using push constants.
-	void* data = nullptr;
-	vkMapMemory(m_device.device(), m_uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-	memcpy(data, &ubo, sizeof(ubo));
-	vkUnmapMemory(m_device.device(), m_uniformBuffersMemory[currentImage]);
+	return m_frameArena->push(ubo);
 }
 
-RenderSystem::~RenderSystem() {
-	for(size_t i = 0; i != Swapchain::MAX_FRAMES_IN_FLIGHT; ++i) {
-		vkDestroyBuffer(m_device.device(), m_uniformBuffers[i], nullptr);
-		vkFreeMemory(m_device.device(), m_uniformBuffersMemory[i], nullptr);
-	}
-}
\ No newline at end of file
+RenderSystem::~RenderSystem() = default;
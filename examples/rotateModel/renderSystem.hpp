@@ -3,25 +3,52 @@
 #include "lwEngine/device.hpp"
 #include "lwEngine/pipeline.hpp"
 #include "lwEngine/model.hpp"
+#include "lwEngine/framearena.hpp"
+#include "lwEngine/cullingsystem.hpp"
+#include "lwEngine/parallelrecorder.hpp"
 
 #include <vulkan/vulkan.hpp>
 #include <vector>
 #include <memory>
 
+//! Model placed in the world. Several objects can share one model.
+struct RenderObject {
+	Model* model;  //! Objects without a model (eg. still loading) are skipped.
+	glm::vec3 position;
+	glm::vec4 tint{1.0f};  //! Multiplied with the texture color.
+};
+
+//! Per object uniforms, written to the frame arena. Larger per object data than fits into push constants goes here.
+struct ObjectUniforms {
+	alignas(16) glm::vec4 tint;
+};
+
 //! Example render system that does simple transformation.
 class RenderSystem {
 public:
-	RenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
+	RenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, uint32_t framesInFlight);
 	~RenderSystem();
 
-	void renderObjects(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkExtent2D frameExtent, VkDescriptorSet descriptorSet, std::vector<Model*> objects);
+	//! View and projection are written once per frame, the model matrix of each object is pushed with its draw.
+	//! Uniforms are written to the frame arena and selected with dynamic offsets, no buffer is mapped.
+	//! Objects outside of the view frustum are culled on the CPU and not drawn.
+	//! Transforms and uniforms are written on this thread, the draws are recorded on all threads of the recorder.
+	void renderObjects(uint32_t currentFrame, ParallelRecorder& recorder, VkExtent2D frameExtent, VkDescriptorSet descriptorSet, const std::vector<RenderObject>& objects);
+
+	//! Average time of ParallelRecorder::record for the draws of a frame.
+	double averageRecordingMicroseconds() const;
 
+	//! Dynamic uniform buffer descriptors of a frame: Frame uniforms (binding 0) and object uniforms (binding 2).
 	VkDescriptorBufferInfo bufferDescriptor(uint32_t currentFrame);
+	VkDescriptorBufferInfo objectDescriptor(uint32_t currentFrame);
+
+	//! Recreate the pipeline for a new render pass of the swapchain. Frames using the old pipeline have to be finished.
+	void recreatePipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
 
 private:
 	void createGraphicsPipeline(VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
-	void createUniformBuffers();
-	void updateUniformBuffer(uint32_t currentImage, VkExtent2D frameExtent, glm::vec3 offset);
+	//! @return Dynamic offset of the frame uniforms.
+	uint32_t updateUniformBuffer(VkExtent2D frameExtent, glm::mat4& viewProjection);
 
 private:
 	// Owned by application
@@ -30,7 +57,14 @@ private:
 	const std::string m_pathVertexShader = SHADER_PATH_VERTEX;
 	const std::string m_pathFragmentShader = SHADER_PATH_FRAGMENT;
 
-	std::vector<VkBuffer> m_uniformBuffers;
-	std::vector<VkDeviceMemory> m_uniformBuffersMemory;
+	std::unique_ptr<FrameArena> m_frameArena;
 	std::unique_ptr<Pipeline> m_graphicsPipeline;
+
+	CullingSystem m_culling;
+	std::vector<glm::mat4> m_transforms;  //! Model matrix of each object in the current frame.
+	std::vector<uint32_t> m_visible;      //! Indices of the objects drawn in the current frame.
+	std::vector<uint32_t> m_uniformOffsets;  //! Frame arena offset of the uniforms of each visible object.
+
+	double m_recordingMicroseconds = 0.0;
+	uint64_t m_recordedFrames = 0;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+// Per instance (InstanceData)
+layout(location = 3) in mat4 instanceTransform;
+layout(location = 7) in vec4 instanceColor;
+layout(location = 8) in vec4 instanceCustom;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * instanceTransform * vec4(inPosition, 1.0);
+    fragColor = instanceColor;
+    fragTexCoord = inTexCoord;
+}
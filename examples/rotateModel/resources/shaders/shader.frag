@@ -2,11 +2,15 @@
 
 layout(binding = 1) uniform sampler2D texSampler;
 
+layout(binding = 2) uniform ObjectUniforms {
+    vec4 tint;
+} object;
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    outColor = texture(texSampler, fragTexCoord) * object.tint;
 }
\ No newline at end of file
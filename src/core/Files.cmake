@@ -1,22 +1,85 @@
 set(coreHeaders
+    "${CMAKE_CURRENT_LIST_DIR}/assetcache.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/assetmanager.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/blockcompression.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/buffer.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/computepipeline.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/culling.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/cullingpass.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/cullingsystem.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/depthpyramid.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/descriptor.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/device.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/file.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/framearena.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/framepacer.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/frustum.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/gpumesh.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/gpuprofiler.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/gputexture.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/image.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/indirectdraw.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/instancebuffer.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/jobsystem.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/memory.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/mesh.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/meshcache.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/meshpool.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/model.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/objparser.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/parallelrecorder.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/pipeline.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/pipelinecache.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/renderer.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/rendererconfig.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/rendertarget.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/resourcecache.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/staging.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/swapchain.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/texture.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/upload.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/vertex.hpp"
     "${CMAKE_CURRENT_LIST_DIR}/window.hpp"
 )
 
 set(coreSources
+    "${CMAKE_CURRENT_LIST_DIR}/assetcache.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/assetmanager.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/blockcompression.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/buffer.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/computepipeline.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/culling.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/cullingpass.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/cullingsystem.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/depthpyramid.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/descriptor.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/device.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/file.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/framearena.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/framepacer.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/frustum.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/gpumesh.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/gpuprofiler.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/gputexture.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/image.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/indirectdraw.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/instancebuffer.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/jobsystem.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/memory.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/mesh.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/meshcache.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/meshpool.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/model.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/objparser.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/parallelrecorder.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/pipeline.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/pipelinecache.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/renderer.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/rendertarget.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/resourcecache.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/staging.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/swapchain.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/texture.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/upload.cpp"
     "${CMAKE_CURRENT_LIST_DIR}/window.cpp"
 )
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "assetcache.hpp"
+
+#include <filesystem>
+
+AssetCache::AssetCache(Device& device, VkDeviceSize budget, uint32_t retireFrames)
+	: m_device(device), m_cache(budget, retireFrames) {}
+
+Model AssetCache::loadModel(UploadBatch& upload, const std::string& pathModel, const std::string& pathTexture, MeshPool* meshPool) {
+	return Model(mesh(upload, pathModel, meshPool), texture(upload, pathTexture));
+}
+
+std::shared_ptr<GpuMesh> AssetCache::mesh(UploadBatch& upload, const std::string& path, MeshPool* meshPool) {
+	if(auto cached = findMesh(path, meshPool)) {
+		return cached;
+	}
+	return addMesh(upload, path, loadMeshSource(path), meshPool);
+}
+
+std::shared_ptr<GpuTexture> AssetCache::texture(UploadBatch& upload, const std::string& path) {
+	if(auto cached = findTexture(path)) {
+		return cached;
+	}
+	return addTexture(upload, path, loadTexture(path));
+}
+
+std::shared_ptr<GpuMesh> AssetCache::findMesh(const std::string& path, MeshPool* meshPool) {
+	return std::static_pointer_cast<GpuMesh>(m_cache.find(meshKey(path, meshPool)));
+}
+
+std::shared_ptr<GpuTexture> AssetCache::findTexture(const std::string& path) {
+	return std::static_pointer_cast<GpuTexture>(m_cache.find(textureKey(path)));
+}
+
+std::shared_ptr<GpuMesh> AssetCache::addMesh(UploadBatch& upload, const std::string& path, const MeshSource& source, MeshPool* meshPool) {
+	auto mesh = std::make_shared<GpuMesh>(m_device, upload, source, meshPool);
+	m_cache.insert(meshKey(path, meshPool), mesh, mesh->sizeBytes());
+	return mesh;
+}
+
+std::shared_ptr<GpuTexture> AssetCache::addTexture(UploadBatch& upload, const std::string& path, const TextureData& data) {
+	auto texture = std::make_shared<GpuTexture>(m_device, upload, data);
+	m_cache.insert(textureKey(path), texture, texture->sizeBytes());
+	return texture;
+}
+
+void AssetCache::endFrame() {
+	m_cache.endFrame();
+}
+
+void AssetCache::setBudget(VkDeviceSize budget) {
+	m_cache.setBudget(budget);
+}
+
+const ResourceCacheStats& AssetCache::stats() const {
+	return m_cache.stats();
+}
+
+AssetKey AssetCache::meshKey(const std::string& path, MeshPool* meshPool) {
+	// Different spellings of one file share the entry.
+	return AssetKey{AssetKey::Type::Mesh, std::filesystem::weakly_canonical(path).generic_string(), meshPool};
+}
+
+AssetKey AssetCache::textureKey(const std::string& path) {
+	return AssetKey{AssetKey::Type::Texture, std::filesystem::weakly_canonical(path).generic_string(), nullptr};
+}
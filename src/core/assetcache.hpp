@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <string>
+
+#include "device.hpp"
+#include "gpumesh.hpp"
+#include "gputexture.hpp"
+#include "meshpool.hpp"
+#include "model.hpp"
+#include "rendererconfig.hpp"
+#include "resourcecache.hpp"
+#include "upload.hpp"
+
+//! Shares GPU meshes and textures between all models loaded from the same files.
+//! Resources are keyed by their canonical path and load options (the mesh pool of a mesh), so GPU memory grows with
+//! the unique assets instead of the placed models. Resources nobody uses anymore stay cached until the resident bytes
+//! exceed the budget, then the least recently used ones are evicted in endFrame().
+//!
+//! A resource found in the cache may still be uploading in an earlier batch. Batches on one queue complete in
+//! submission order: Drawing it once the batch of the lookup is complete is always safe. Main thread only.
+class AssetCache {
+public:
+	static constexpr VkDeviceSize DEFAULT_BUDGET = 512ull * 1024 * 1024;
+
+	//! @param retireFrames Frames in flight of the renderer, see Renderer::maxFramesInFlight().
+	AssetCache(Device& device, VkDeviceSize budget = DEFAULT_BUDGET, uint32_t retireFrames = RendererConfig::DEFAULT_FRAMES_IN_FLIGHT);
+
+	AssetCache(const AssetCache&) = delete;
+	AssetCache& operator=(const AssetCache&) = delete;
+
+	//! Model sharing the resources of the files. Only resources missing in the cache are loaded and recorded into the batch.
+	//! @param meshPool Upload the mesh into the pool if set.
+	Model loadModel(UploadBatch& upload, const std::string& pathModel, const std::string& pathTexture, MeshPool* meshPool = nullptr);
+	std::shared_ptr<GpuMesh> mesh(UploadBatch& upload, const std::string& path, MeshPool* meshPool = nullptr);
+	std::shared_ptr<GpuTexture> texture(UploadBatch& upload, const std::string& path);
+
+	//! @return Cached resource or nullptr, nothing is loaded.
+	std::shared_ptr<GpuMesh> findMesh(const std::string& path, MeshPool* meshPool = nullptr);
+	std::shared_ptr<GpuTexture> findTexture(const std::string& path);
+	//! Create resources from data loaded before a miss, eg. on a worker thread.
+	std::shared_ptr<GpuMesh> addMesh(UploadBatch& upload, const std::string& path, const MeshSource& source, MeshPool* meshPool = nullptr);
+	std::shared_ptr<GpuTexture> addTexture(UploadBatch& upload, const std::string& path, const TextureData& data);
+
+	//! Once per frame after the fence of the frame was waited for.
+	void endFrame();
+
+	void setBudget(VkDeviceSize budget);
+	const ResourceCacheStats& stats() const;
+
+private:
+	static AssetKey meshKey(const std::string& path, MeshPool* meshPool);
+	static AssetKey textureKey(const std::string& path);
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	ResourceCache m_cache;
+};
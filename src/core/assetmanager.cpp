@@ -0,0 +1,212 @@
+#include "assetmanager.hpp"
+
+#include <exception>
+#include <utility>
+
+#include "texture.hpp"
+
+// ----- Handle -----
+ModelHandle::ModelHandle(std::shared_ptr<ModelAsset> asset) : m_asset(std::move(asset)) {}
+
+AssetState ModelHandle::state() const {
+	return m_asset ? m_asset->state.load(std::memory_order_acquire) : AssetState::Failed;
+}
+
+bool ModelHandle::isReady() const {
+	return state() == AssetState::Ready;
+}
+
+Model* ModelHandle::get() const {
+	return isReady() ? m_asset->model.get() : nullptr;
+}
+
+Model* ModelHandle::getOr(Model* placeholder) const {
+	Model* model = get();
+	return model ? model : placeholder;
+}
+
+const std::string& ModelHandle::error() const {
+	static const std::string none;
+	return state() == AssetState::Failed && m_asset ? m_asset->error : none;
+}
+
+
+// ----- Manager -----
+AssetManager::AssetManager(Device& device, JobSystem& jobs, AssetCache& cache, VkDeviceSize uploadBudget)
+	: m_device(device), m_jobs(jobs), m_cache(cache), m_uploadBudget(uploadBudget) {}
+
+AssetManager::~AssetManager() {
+	// Decode jobs reference this manager and copies read the staging ring.
+	m_jobs.wait(m_decoding);
+	for(auto& inFlight : m_inFlight) {
+		inFlight.batch->wait();
+		publish(inFlight);
+	}
+
+	// Decoded or queued models are never uploaded.
+	for(auto& [key, asset] : m_loading) {
+		asset->error = "Failed to load model " + std::get<0>(key) + ": The asset manager was destroyed";
+		asset->state.store(AssetState::Failed, std::memory_order_release);
+	}
+}
+
+ModelHandle AssetManager::loadModelAsync(const std::string& pathModel, const std::string& pathTexture, MeshPool* meshPool) {
+	// The model is already on its way.
+	const RequestKey key{pathModel, pathTexture, meshPool};
+	auto loading = m_loading.find(key);
+	if(loading != m_loading.end()) {
+		return ModelHandle(loading->second);
+	}
+
+	auto asset = std::make_shared<ModelAsset>();
+	m_loading.emplace(key, asset);
+
+	// Cached files are not read again. The references keep them from being evicted until the model holds them.
+	Request request{asset, pathModel, pathTexture, meshPool, m_cache.findMesh(pathModel, meshPool), m_cache.findTexture(pathTexture)};
+	if(request.mesh && request.texture) {
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		m_decoded.push_back(Decoded{std::move(request), ModelData{}, {}});
+	} else if(m_jobs.threadCount() == 1) {
+		// Without workers, jobs only run while thread 0 waits and newer jobs run first: Decode in update() instead.
+		m_requests.push_back(std::move(request));
+	} else {
+		m_jobs.submit([this, request]() { decode(request); }, &m_decoding);
+	}
+
+	return ModelHandle(std::move(asset));
+}
+
+void AssetManager::decode(Request request) {
+	Decoded decoded{std::move(request), ModelData{}, {}};
+	try {
+		decoded.data.pathModel = decoded.request.pathModel;
+		decoded.data.pathTexture = decoded.request.pathTexture;
+		if(!decoded.request.mesh) {
+			decoded.data.mesh = loadMeshSource(decoded.request.pathModel, &m_jobs);
+		}
+		if(!decoded.request.texture) {
+			decoded.data.texture = loadTexture(decoded.request.pathTexture);
+			// Decode here instead of on the main thread if the device can not sample the stored format.
+			if(!GpuTexture::canSample(m_device, decoded.data.texture.format)) {
+				decoded.data.texture = decompress(decoded.data.texture);
+			}
+		}
+	} catch(const std::exception& e) {
+		// Missing or broken files only fail this model.
+		decoded.error = "Failed to load model " + decoded.request.pathModel + ": " + e.what();
+	}
+
+	std::lock_guard<std::mutex> lock(m_decodedMutex);
+	m_decoded.push_back(std::move(decoded));
+}
+
+void AssetManager::finish(const Request& request, AssetState state) {
+	request.asset->state.store(state, std::memory_order_release);
+	m_loading.erase(RequestKey{request.pathModel, request.pathTexture, request.meshPool});
+}
+
+void AssetManager::publish(InFlight& inFlight) {
+	for(size_t i = 0; i != inFlight.requests.size(); ++i) {
+		inFlight.requests[i].asset->model = std::move(inFlight.models[i]);
+		finish(inFlight.requests[i], AssetState::Ready);
+	}
+}
+
+void AssetManager::update() {
+	// Publish finished uploads. Batches complete in submission order on the queue, stop at the first running one.
+	size_t completed = 0;
+	while(completed != m_inFlight.size() && m_inFlight[completed].batch->isComplete()) {
+		InFlight& inFlight = m_inFlight[completed];
+		if(m_profiler) {
+			if(const std::optional<double> ms = inFlight.batch->gpuTimeMs()) {
+				m_profiler->addScopeTime("Upload", *ms);
+			}
+		}
+		publish(inFlight);
+		++completed;
+	}
+	m_inFlight.erase(m_inFlight.begin(), m_inFlight.begin() + static_cast<std::ptrdiff_t>(completed));
+
+	// Single threaded: One model per frame keeps the stall short.
+	if(!m_requests.empty()) {
+		decode(std::move(m_requests.front()));
+		m_requests.pop_front();
+	}
+
+	std::vector<Decoded> decoded;
+	{
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		decoded.swap(m_decoded);
+	}
+	if(decoded.empty()) {
+		return;
+	}
+
+	// One batch for everything decoded since the last frame, up to the budget.
+	InFlight inFlight;
+	inFlight.batch = std::make_unique<UploadBatch>(m_device, &m_jobs);
+	size_t recorded = 0;
+	for(; recorded != decoded.size() && inFlight.batch->uploadedBytes() < m_uploadBudget; ++recorded) {
+		Decoded& model = decoded[recorded];
+		if(!model.error.empty()) {
+			model.request.asset->error = std::move(model.error);
+			finish(model.request, AssetState::Failed);
+			continue;
+		}
+
+		// Another request may have uploaded the files since. Failing to create Vulkan objects is not a problem of
+		// the asset: It throws like everywhere else.
+		Request& request = model.request;
+		if(!request.mesh) {
+			request.mesh = m_cache.findMesh(request.pathModel, request.meshPool);
+		}
+		if(!request.mesh) {
+			request.mesh = m_cache.addMesh(*inFlight.batch, request.pathModel, model.data.mesh, request.meshPool);
+		}
+		if(!request.texture) {
+			request.texture = m_cache.findTexture(request.pathTexture);
+		}
+		if(!request.texture) {
+			request.texture = m_cache.addTexture(*inFlight.batch, request.pathTexture, model.data.texture);
+		}
+
+		inFlight.models.push_back(std::make_unique<Model>(request.mesh, request.texture));
+		inFlight.requests.push_back(std::move(request));
+	}
+	inFlight.batch->submit();
+	m_inFlight.push_back(std::move(inFlight));
+
+	// Over the budget: Keep the rest for the next frame, in front of models decoded meanwhile.
+	if(recorded != decoded.size()) {
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		m_decoded.insert(m_decoded.begin(), std::make_move_iterator(decoded.begin() + static_cast<std::ptrdiff_t>(recorded)),
+		                 std::make_move_iterator(decoded.end()));
+	}
+}
+
+void AssetManager::waitAll() {
+	while(!m_requests.empty()) {
+		decode(std::move(m_requests.front()));
+		m_requests.pop_front();
+	}
+	m_jobs.wait(m_decoding);
+	while(true) {
+		update();
+		if(m_inFlight.empty()) {
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			if(m_decoded.empty()) {
+				break;
+			}
+			continue;
+		}
+		m_inFlight.back().batch->wait();
+	}
+}
+
+uint32_t AssetManager::pendingCount() const {
+	return static_cast<uint32_t>(m_loading.size());
+}
+
+void AssetManager::setProfiler(GpuProfiler* profiler) {
+	m_profiler = profiler;
+}
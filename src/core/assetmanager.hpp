@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "assetcache.hpp"
+#include "device.hpp"
+#include "gpuprofiler.hpp"
+#include "jobsystem.hpp"
+#include "meshpool.hpp"
+#include "model.hpp"
+#include "upload.hpp"
+
+enum class AssetState {
+	Loading,    //! Files are read and decoded or the upload is running.
+	Ready,      //! The model can be drawn.
+	Failed      //! See ModelHandle::error().
+};
+
+//! State of an asynchronously loaded model, shared by the asset manager and all handles to it.
+struct ModelAsset {
+	std::atomic<AssetState> state{AssetState::Loading};
+	std::unique_ptr<Model> model;  //! Set before the state becomes Ready.
+	std::string error;             //! Set before the state becomes Failed.
+};
+
+//! Handle to a model that may still be loading. Cheap to copy, the model lives as long as a handle to it.
+class ModelHandle {
+public:
+	ModelHandle() = default;
+
+	AssetState state() const;
+	bool isReady() const;
+	//! The model once it is ready, nullptr before: Draw calls skip the handle until then.
+	Model* get() const;
+	//! The model once it is ready, the placeholder before (or if loading failed).
+	Model* getOr(Model* placeholder) const;
+	//! Reason the load failed. Empty unless the state is Failed.
+	const std::string& error() const;
+
+private:
+	friend class AssetManager;
+	explicit ModelHandle(std::shared_ptr<ModelAsset> asset);
+
+	std::shared_ptr<ModelAsset> m_asset;
+};
+
+//! Loads models without blocking the frame.
+//! Reading the mesh (or its cache), decoding the texture and decompressing it for the device run as jobs on the
+//! worker threads. Creating the Vulkan objects and recording the copies happens in update() on the main thread: All
+//! models decoded since the last call share one UploadBatch, which is polled in later frames instead of waited for.
+//! Meshes and textures come from the AssetCache: Files already cached are not decoded again, and requests for a model
+//! that is still loading return the handle of the running request.
+//! A job system without workers has no thread to decode in the background, update() then decodes one model per call.
+//!
+//! Usage:
+//!   ModelHandle handle = assets.loadModelAsync(pathModel, pathTexture);  // Returns immediately
+//!   Per frame: assets.update(); if(Model* model = handle.get()) { draw model }
+class AssetManager {
+public:
+	//! Models recorded into the batch of one update() until it holds this many bytes, the rest waits for the next
+	//! frame. Keeps the staging ring from flushing early and a frame from stalling when many loads finish at once.
+	static constexpr VkDeviceSize DEFAULT_UPLOAD_BUDGET = 64ull * 1024 * 1024;
+
+	AssetManager(Device& device, JobSystem& jobs, AssetCache& cache, VkDeviceSize uploadBudget = DEFAULT_UPLOAD_BUDGET);
+	//! Waits for running loads. Models not uploaded yet fail, their handles do not stay loading.
+	~AssetManager();
+
+	AssetManager(const AssetManager&) = delete;
+	AssetManager& operator=(const AssetManager&) = delete;
+
+	//! Start loading a model and return its handle right away. Thread 0 only, like update().
+	//! @param meshPool Upload the mesh into the pool if set.
+	ModelHandle loadModelAsync(const std::string& pathModel, const std::string& pathTexture, MeshPool* meshPool = nullptr);
+
+	//! Publish models whose uploads finished and record the uploads of decoded models. Once per frame on thread 0.
+	//! Throws if Vulkan objects can not be created, files that can not be loaded only fail their model.
+	void update();
+	//! Block until every requested model is ready or failed, eg. behind a loading screen.
+	void waitAll();
+
+	//! Models requested but not yet ready or failed. Requests of the same model count once.
+	uint32_t pendingCount() const;
+
+	//! Add the GPU time of every finished upload batch as the "Upload" scope. nullptr stops it.
+	void setProfiler(GpuProfiler* profiler);
+
+private:
+	using RequestKey = std::tuple<std::string, std::string, MeshPool*>;
+
+	struct Request {
+		std::shared_ptr<ModelAsset> asset;
+		std::string pathModel;
+		std::string pathTexture;
+		MeshPool* meshPool;
+		std::shared_ptr<GpuMesh> mesh;        //! Cached when requested, not decoded again.
+		std::shared_ptr<GpuTexture> texture;  //! Cached when requested, not decoded again.
+	};
+
+	//! Output of a decode job, waiting for update().
+	struct Decoded {
+		Request request;
+		ModelData data;     //! Only what was not cached.
+		std::string error;  //! Loading failed if not empty.
+	};
+
+	//! Models whose copies were submitted together.
+	struct InFlight {
+		std::unique_ptr<UploadBatch> batch;
+		std::vector<Request> requests;
+		std::vector<std::unique_ptr<Model>> models;
+	};
+
+	//! Read and decode the files of a model. Runs as a job, thread safe.
+	void decode(Request request);
+	void finish(const Request& request, AssetState state);
+	//! Hand the models of a completed batch to their handles.
+	void publish(InFlight& inFlight);
+
+private:
+	// Owned by application
+	Device& m_device;
+	JobSystem& m_jobs;
+	AssetCache& m_cache;
+	GpuProfiler* m_profiler = nullptr;
+
+	VkDeviceSize m_uploadBudget;
+	std::map<RequestKey, std::shared_ptr<ModelAsset>> m_loading;  //! Requests not yet ready or failed.
+
+	std::deque<Request> m_requests;     //! Decoded in update() if the job system has no workers.
+	JobCounter m_decoding;              //! Decode jobs not yet finished.
+	std::mutex m_decodedMutex;
+	std::vector<Decoded> m_decoded;     //! Written by the decode jobs.
+	std::vector<InFlight> m_inFlight;   //! Oldest first.
+};
@@ -0,0 +1,677 @@
+#include "blockcompression.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "jobsystem.hpp"
+
+static constexpr uint32_t BLOCK_TEXELS = 16;
+
+// Interpolation weights of BC7 indices, out of 64.
+static constexpr int WEIGHTS2[4] = {0, 21, 43, 64};
+static constexpr int WEIGHTS3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+static constexpr int WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+enum class BlockCodec {
+	BC1,
+	BC3,
+	BC7
+};
+
+static BlockCodec codecOf(VkFormat format) {
+	switch(format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return BlockCodec::BC1;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			return BlockCodec::BC3;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return BlockCodec::BC7;
+		default:
+			throw std::invalid_argument("Unsupported block compressed format!");
+	}
+}
+
+static uint32_t blockBytes(BlockCodec codec) {
+	return codec == BlockCodec::BC1 ? 8 : 16;
+}
+
+//! Little endian bit stream over the 128 bits of a BC7 block.
+class BlockBits {
+public:
+	explicit BlockBits(const uint8_t* data) : m_data(const_cast<uint8_t*>(data)) {}
+
+	//! The block must be zeroed before writing.
+	void write(uint32_t value, uint32_t bits) {
+		for(uint32_t i = 0; i != bits; ++i, ++m_position) {
+			if((value >> i) & 1u) {
+				m_data[m_position >> 3] |= static_cast<uint8_t>(1u << (m_position & 7));
+			}
+		}
+	}
+
+	uint32_t read(uint32_t bits) {
+		uint32_t value = 0;
+		for(uint32_t i = 0; i != bits; ++i, ++m_position) {
+			value |= static_cast<uint32_t>((m_data[m_position >> 3] >> (m_position & 7)) & 1u) << i;
+		}
+		return value;
+	}
+
+private:
+	uint8_t* m_data;
+	uint32_t m_position = 0;
+};
+
+//! End points of the segment that covers the block colors along their principal axis.
+template<size_t CHANNELS>
+static void principalEndpoints(const uint8_t* rgba, float* e0, float* e1) {
+	float mean[CHANNELS] = {};
+	float minimum[CHANNELS];
+	float maximum[CHANNELS];
+	std::fill(minimum, minimum + CHANNELS, 255.0f);
+	std::fill(maximum, maximum + CHANNELS, 0.0f);
+
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		for(size_t c = 0; c != CHANNELS; ++c) {
+			const float value = rgba[i * 4 + c];
+			mean[c] += value;
+			minimum[c] = std::min(minimum[c], value);
+			maximum[c] = std::max(maximum[c], value);
+		}
+	}
+	for(size_t c = 0; c != CHANNELS; ++c) {
+		mean[c] /= BLOCK_TEXELS;
+	}
+
+	float covariance[CHANNELS][CHANNELS] = {};
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		for(size_t a = 0; a != CHANNELS; ++a) {
+			for(size_t b = 0; b != CHANNELS; ++b) {
+				covariance[a][b] += (rgba[i * 4 + a] - mean[a]) * (rgba[i * 4 + b] - mean[b]);
+			}
+		}
+	}
+
+	// Power iteration, starting at the diagonal of the bounding box.
+	float axis[CHANNELS];
+	for(size_t c = 0; c != CHANNELS; ++c) {
+		axis[c] = maximum[c] - minimum[c];
+	}
+	for(int iteration = 0; iteration != 8; ++iteration) {
+		float next[CHANNELS] = {};
+		float largest = 0.0f;
+		for(size_t a = 0; a != CHANNELS; ++a) {
+			for(size_t b = 0; b != CHANNELS; ++b) {
+				next[a] += covariance[a][b] * axis[b];
+			}
+			largest = std::max(largest, std::abs(next[a]));
+		}
+		if(largest == 0.0f) {
+			break;
+		}
+		for(size_t c = 0; c != CHANNELS; ++c) {
+			axis[c] = next[c] / largest;
+		}
+	}
+
+	float length = 0.0f;
+	for(size_t c = 0; c != CHANNELS; ++c) {
+		length += axis[c] * axis[c];
+	}
+	length = std::sqrt(length);
+
+	// Uniform block: Both end points are the mean.
+	float tMin = 0.0f;
+	float tMax = 0.0f;
+	if(length > 0.0f) {
+		for(size_t c = 0; c != CHANNELS; ++c) {
+			axis[c] /= length;
+		}
+		tMin = 1e9f;
+		tMax = -1e9f;
+		for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+			float t = 0.0f;
+			for(size_t c = 0; c != CHANNELS; ++c) {
+				t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+			}
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+	}
+
+	for(size_t c = 0; c != CHANNELS; ++c) {
+		e0[c] = std::clamp(mean[c] + tMin * axis[c], 0.0f, 255.0f);
+		e1[c] = std::clamp(mean[c] + tMax * axis[c], 0.0f, 255.0f);
+	}
+}
+
+template<size_t CHANNELS, size_t COUNT>
+static uint32_t nearestIndex(const uint8_t* texel, const int (&palette)[COUNT][4]) {
+	uint32_t best = 0;
+	int bestError = INT32_MAX;
+	for(uint32_t i = 0; i != COUNT; ++i) {
+		int error = 0;
+		for(size_t c = 0; c != CHANNELS; ++c) {
+			const int difference = texel[c] - palette[i][c];
+			error += difference * difference;
+		}
+		if(error < bestError) {
+			bestError = error;
+			best = i;
+		}
+	}
+	return best;
+}
+
+
+// ----- BC1 -----
+static uint16_t packRgb565(const float* color) {
+	const uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+	const uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+	const uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void unpackRgb565(uint16_t color, int* rgb) {
+	const int r = (color >> 11) & 31;
+	const int g = (color >> 5) & 63;
+	const int b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+//! @param fourColors BC2 and BC3 always use four colors, BC1 only if the first end point is larger.
+static void colorPalette(uint16_t c0, uint16_t c1, bool fourColors, int (&palette)[4][4]) {
+	unpackRgb565(c0, palette[0]);
+	unpackRgb565(c1, palette[1]);
+	palette[0][3] = 255;
+	palette[1][3] = 255;
+
+	for(int c = 0; c != 3; ++c) {
+		if(fourColors || c0 > c1) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		} else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = (fourColors || c0 > c1) ? 255 : 0;
+}
+
+static void encodeColor(const uint8_t* rgba, uint8_t* block) {
+	float e0[3];
+	float e1[3];
+	principalEndpoints<3>(rgba, e0, e1);
+
+	// The larger end point first selects the opaque four color mode.
+	uint16_t c0 = packRgb565(e1);
+	uint16_t c1 = packRgb565(e0);
+	if(c0 < c1) {
+		std::swap(c0, c1);
+	}
+
+	int palette[4][4];
+	colorPalette(c0, c1, true, palette);
+
+	uint32_t indices = 0;
+	if(c0 != c1) {
+		for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+			indices |= nearestIndex<3>(rgba + i * 4, palette) << (2 * i);
+		}
+	}
+
+	block[0] = static_cast<uint8_t>(c0);
+	block[1] = static_cast<uint8_t>(c0 >> 8);
+	block[2] = static_cast<uint8_t>(c1);
+	block[3] = static_cast<uint8_t>(c1 >> 8);
+	memcpy(block + 4, &indices, 4);
+}
+
+static void decodeColor(const uint8_t* block, bool fourColors, uint8_t* rgba) {
+	const uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	const uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+	uint32_t indices;
+	memcpy(&indices, block + 4, 4);
+
+	int palette[4][4];
+	colorPalette(c0, c1, fourColors, palette);
+
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		const uint32_t index = (indices >> (2 * i)) & 3u;
+		for(int c = 0; c != 4; ++c) {
+			rgba[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+		}
+	}
+}
+
+void encodeBC1Block(const uint8_t* rgba, uint8_t* block) {
+	encodeColor(rgba, block);
+}
+
+void decodeBC1Block(const uint8_t* block, uint8_t* rgba) {
+	decodeColor(block, false, rgba);
+}
+
+
+// ----- BC3 -----
+static void alphaPalette(int a0, int a1, int (&palette)[8]) {
+	palette[0] = a0;
+	palette[1] = a1;
+	if(a0 > a1) {
+		for(int i = 2; i != 8; ++i) {
+			palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+		}
+	} else {
+		for(int i = 2; i != 6; ++i) {
+			palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+void encodeBC3Block(const uint8_t* rgba, uint8_t* block) {
+	uint8_t a0 = 0;
+	uint8_t a1 = 255;
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		a0 = std::max(a0, rgba[i * 4 + 3]);
+		a1 = std::min(a1, rgba[i * 4 + 3]);
+	}
+
+	int palette[8];
+	alphaPalette(a0, a1, palette);
+
+	uint64_t indices = 0;
+	if(a0 != a1) {
+		for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+			uint64_t best = 0;
+			for(uint64_t j = 1; j != 8; ++j) {
+				if(std::abs(rgba[i * 4 + 3] - palette[j]) < std::abs(rgba[i * 4 + 3] - palette[best])) {
+					best = j;
+				}
+			}
+			indices |= best << (3 * i);
+		}
+	}
+
+	block[0] = a0;
+	block[1] = a1;
+	for(int i = 0; i != 6; ++i) {
+		block[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+	}
+
+	encodeColor(rgba, block + 8);
+}
+
+void decodeBC3Block(const uint8_t* block, uint8_t* rgba) {
+	decodeColor(block + 8, true, rgba);
+
+	int palette[8];
+	alphaPalette(block[0], block[1], palette);
+
+	uint64_t indices = 0;
+	for(int i = 0; i != 6; ++i) {
+		indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+	}
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		rgba[i * 4 + 3] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7u]);
+	}
+}
+
+
+// ----- BC7 -----
+static int interpolate(int e0, int e1, int weight) {
+	return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+//! 7 bits per channel and a shared lowest bit (p-bit), whichever p-bit is closer.
+static void quantizeMode6(const float* endpoint, int* quantized, int& pBit) {
+	float bestError = 1e9f;
+	for(int p = 0; p != 2; ++p) {
+		int candidate[4];
+		float error = 0.0f;
+		for(int c = 0; c != 4; ++c) {
+			candidate[c] = std::clamp(static_cast<int>(std::lround((endpoint[c] - p) / 2.0f)), 0, 127);
+			const float difference = static_cast<float>((candidate[c] << 1) | p) - endpoint[c];
+			error += difference * difference;
+		}
+		if(error < bestError) {
+			bestError = error;
+			pBit = p;
+			std::copy(candidate, candidate + 4, quantized);
+		}
+	}
+}
+
+void encodeBC7Block(const uint8_t* rgba, uint8_t* block) {
+	float e0[4];
+	float e1[4];
+	principalEndpoints<4>(rgba, e0, e1);
+
+	int quantized[2][4];
+	int pBits[2];
+	quantizeMode6(e0, quantized[0], pBits[0]);
+	quantizeMode6(e1, quantized[1], pBits[1]);
+
+	int palette[16][4];
+	for(int i = 0; i != 16; ++i) {
+		for(int c = 0; c != 4; ++c) {
+			palette[i][c] = interpolate((quantized[0][c] << 1) | pBits[0], (quantized[1][c] << 1) | pBits[1], WEIGHTS4[i]);
+		}
+	}
+
+	uint32_t indices[BLOCK_TEXELS];
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		indices[i] = nearestIndex<4>(rgba + i * 4, palette);
+	}
+
+	// The highest bit of the first index is implicitly 0. The weights are symmetric, so swapping the end points
+	// and mirroring the indices selects the same colors.
+	if(indices[0] & 8u) {
+		std::swap(quantized[0], quantized[1]);
+		std::swap(pBits[0], pBits[1]);
+		for(uint32_t& index : indices) {
+			index = 15 - index;
+		}
+	}
+
+	memset(block, 0, 16);
+	BlockBits bits{block};
+	bits.write(1u << 6, 7);  // Mode 6
+	for(int c = 0; c != 4; ++c) {
+		bits.write(static_cast<uint32_t>(quantized[0][c]), 7);
+		bits.write(static_cast<uint32_t>(quantized[1][c]), 7);
+	}
+	bits.write(static_cast<uint32_t>(pBits[0]), 1);
+	bits.write(static_cast<uint32_t>(pBits[1]), 1);
+	bits.write(indices[0], 3);
+	for(uint32_t i = 1; i != BLOCK_TEXELS; ++i) {
+		bits.write(indices[i], 4);
+	}
+}
+
+// Subset of every texel for the 64 partitions with 2 and 3 subsets, shared by all BC7 encoders and decoders.
+static constexpr uint8_t PARTITIONS2[64][16] = {
+	{0,0,1,1,0,0,1,1,0,0,1,1,0,0,1,1}, {0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1}, {0,1,1,1,0,1,1,1,0,1,1,1,0,1,1,1}, {0,0,0,1,0,0,1,1,0,0,1,1,0,1,1,1},
+	{0,0,0,0,0,0,0,1,0,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,1,0,1,1,1,1,1,1,1}, {0,0,0,1,0,0,1,1,0,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,1,0,0,1,1,0,1,1,1},
+	{0,0,0,0,0,0,0,0,0,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,1,0,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,0,0,0,1,0,1,1,1},
+	{0,0,0,1,0,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1}, {0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1},
+	{0,0,0,0,1,0,0,0,1,1,1,0,1,1,1,1}, {0,1,1,1,0,0,0,1,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,1,0,0,0,1,1,1,0}, {0,1,1,1,0,0,1,1,0,0,0,1,0,0,0,0},
+	{0,0,1,1,0,0,0,1,0,0,0,0,0,0,0,0}, {0,0,0,0,1,0,0,0,1,1,0,0,1,1,1,0}, {0,0,0,0,0,0,0,0,1,0,0,0,1,1,0,0}, {0,1,1,1,0,0,1,1,0,0,1,1,0,0,0,1},
+	{0,0,1,1,0,0,0,1,0,0,0,1,0,0,0,0}, {0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0}, {0,1,1,0,0,1,1,0,0,1,1,0,0,1,1,0}, {0,0,1,1,0,1,1,0,0,1,1,0,1,1,0,0},
+	{0,0,0,1,0,1,1,1,1,1,1,0,1,0,0,0}, {0,0,0,0,1,1,1,1,1,1,1,1,0,0,0,0}, {0,1,1,1,0,0,0,1,1,0,0,0,1,1,1,0}, {0,0,1,1,1,0,0,1,1,0,0,1,1,1,0,0},
+	{0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1}, {0,0,0,0,1,1,1,1,0,0,0,0,1,1,1,1}, {0,1,0,1,1,0,1,0,0,1,0,1,1,0,1,0}, {0,0,1,1,0,0,1,1,1,1,0,0,1,1,0,0},
+	{0,0,1,1,1,1,0,0,0,0,1,1,1,1,0,0}, {0,1,0,1,0,1,0,1,1,0,1,0,1,0,1,0}, {0,1,1,0,1,0,0,1,0,1,1,0,1,0,0,1}, {0,1,0,1,1,0,1,0,1,0,1,0,0,1,0,1},
+	{0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0}, {0,0,0,1,0,0,1,1,1,1,0,0,1,0,0,0}, {0,0,1,1,0,0,1,0,0,1,0,0,1,1,0,0}, {0,0,1,1,1,0,1,1,1,1,0,1,1,1,0,0},
+	{0,1,1,0,1,0,0,1,1,0,0,1,0,1,1,0}, {0,0,1,1,1,1,0,0,1,1,0,0,0,0,1,1}, {0,1,1,0,0,1,1,0,1,0,0,1,1,0,0,1}, {0,0,0,0,0,1,1,0,0,1,1,0,0,0,0,0},
+	{0,1,0,0,1,1,1,0,0,1,0,0,0,0,0,0}, {0,0,1,0,0,1,1,1,0,0,1,0,0,0,0,0}, {0,0,0,0,0,0,1,0,0,1,1,1,0,0,1,0}, {0,0,0,0,0,1,0,0,1,1,1,0,0,1,0,0},
+	{0,1,1,0,1,1,0,0,1,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,0,1,1,0,0,1,0,0,1}, {0,1,1,0,0,0,1,1,1,0,0,1,1,1,0,0}, {0,0,1,1,1,0,0,1,1,1,0,0,0,1,1,0},
+	{0,1,1,0,1,1,0,0,1,1,0,0,1,0,0,1}, {0,1,1,0,0,0,1,1,0,0,1,1,1,0,0,1}, {0,1,1,1,1,1,1,0,1,0,0,0,0,0,0,1}, {0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,1},
+	{0,0,0,0,1,1,1,1,0,0,1,1,0,0,1,1}, {0,0,1,1,0,0,1,1,1,1,1,1,0,0,0,0}, {0,0,1,0,0,0,1,0,1,1,1,0,1,1,1,0}, {0,1,0,0,0,1,0,0,0,1,1,1,0,1,1,1}
+};
+
+static constexpr uint8_t PARTITIONS3[64][16] = {
+	{0,0,1,1,0,0,1,1,0,2,2,1,2,2,2,2}, {0,0,0,1,0,0,1,1,2,2,1,1,2,2,2,1}, {0,0,0,0,2,0,0,1,2,2,1,1,2,2,1,1}, {0,2,2,2,0,0,2,2,0,0,1,1,0,1,1,1},
+	{0,0,0,0,0,0,0,0,1,1,2,2,1,1,2,2}, {0,0,1,1,0,0,1,1,0,0,2,2,0,0,2,2}, {0,0,2,2,0,0,2,2,1,1,1,1,1,1,1,1}, {0,0,1,1,0,0,1,1,2,2,1,1,2,2,1,1},
+	{0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,2,2,2,2,2,2,2,2}, {0,0,1,2,0,0,1,2,0,0,1,2,0,0,1,2},
+	{0,1,1,2,0,1,1,2,0,1,1,2,0,1,1,2}, {0,1,2,2,0,1,2,2,0,1,2,2,0,1,2,2}, {0,0,1,1,0,1,1,2,1,1,2,2,1,2,2,2}, {0,0,1,1,2,0,0,1,2,2,0,0,2,2,2,0},
+	{0,0,0,1,0,0,1,1,0,1,1,2,1,1,2,2}, {0,1,1,1,0,0,1,1,2,0,0,1,2,2,0,0}, {0,0,0,0,1,1,2,2,1,1,2,2,1,1,2,2}, {0,0,2,2,0,0,2,2,0,0,2,2,1,1,1,1},
+	{0,1,1,1,0,1,1,1,0,2,2,2,0,2,2,2}, {0,0,0,1,0,0,0,1,2,2,2,1,2,2,2,1}, {0,0,0,0,0,0,1,1,0,1,2,2,0,1,2,2}, {0,0,0,0,1,1,0,0,2,2,1,0,2,2,1,0},
+	{0,1,2,2,0,1,2,2,0,0,1,1,0,0,0,0}, {0,0,1,2,0,0,1,2,1,1,2,2,2,2,2,2}, {0,1,1,0,1,2,2,1,1,2,2,1,0,1,1,0}, {0,0,0,0,0,1,1,0,1,2,2,1,1,2,2,1},
+	{0,0,2,2,1,1,0,2,1,1,0,2,0,0,2,2}, {0,1,1,0,0,1,1,0,2,0,0,2,2,2,2,2}, {0,0,1,1,0,1,2,2,0,1,2,2,0,0,1,1}, {0,0,0,0,2,0,0,0,2,2,1,1,2,2,2,1},
+	{0,0,0,0,0,0,0,2,1,1,2,2,1,2,2,2}, {0,2,2,2,0,0,2,2,0,0,1,2,0,0,1,1}, {0,0,1,1,0,0,1,2,0,0,2,2,0,2,2,2}, {0,1,2,0,0,1,2,0,0,1,2,0,0,1,2,0},
+	{0,0,0,0,1,1,1,1,2,2,2,2,0,0,0,0}, {0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0}, {0,1,2,0,2,0,1,2,1,2,0,1,0,1,2,0}, {0,0,1,1,2,2,0,0,1,1,2,2,0,0,1,1},
+	{0,0,1,1,1,1,2,2,2,2,0,0,0,0,1,1}, {0,1,0,1,0,1,0,1,2,2,2,2,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,2,1,2,1,2,1}, {0,0,2,2,1,1,2,2,0,0,2,2,1,1,2,2},
+	{0,0,2,2,0,0,1,1,0,0,2,2,0,0,1,1}, {0,2,2,0,1,2,2,1,0,2,2,0,1,2,2,1}, {0,1,0,1,2,2,2,2,2,2,2,2,0,1,0,1}, {0,0,0,0,2,1,2,1,2,1,2,1,2,1,2,1},
+	{0,1,0,1,0,1,0,1,0,1,0,1,2,2,2,2}, {0,2,2,2,0,1,1,1,0,2,2,2,0,1,1,1}, {0,0,0,2,1,1,1,2,0,0,0,2,1,1,1,2}, {0,0,0,0,2,1,1,2,2,1,1,2,2,1,1,2},
+	{0,2,2,2,0,1,1,1,0,1,1,1,0,2,2,2}, {0,0,0,2,1,1,1,2,1,1,1,2,0,0,0,2}, {0,1,1,0,0,1,1,0,0,1,1,0,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,1,2,2,1,1,2},
+	{0,1,1,0,0,1,1,0,2,2,2,2,2,2,2,2}, {0,0,2,2,0,0,1,1,0,0,1,1,0,0,2,2}, {0,0,2,2,1,1,2,2,1,1,2,2,0,0,2,2}, {0,0,0,0,0,0,0,0,0,0,0,0,2,1,1,2},
+	{0,0,0,2,0,0,0,1,0,0,0,2,0,0,0,1}, {0,2,2,2,1,2,2,2,0,2,2,2,1,2,2,2}, {0,1,0,1,2,2,2,2,2,2,2,2,2,2,2,2}, {0,1,1,1,2,0,1,1,2,2,0,1,2,2,2,0}
+};
+
+// Anchor texels: The first index of every subset has one bit less, its highest bit is implied 0. Subset 0 starts at texel 0.
+static constexpr uint8_t ANCHORS2[64] = {
+	15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15, 15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+	15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,  6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15
+};
+static constexpr uint8_t ANCHORS3_SECOND[64] = {
+	 3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,  3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+	 8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,  3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3
+};
+static constexpr uint8_t ANCHORS3_THIRD[64] = {
+	15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8, 15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+	15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8, 15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8
+};
+
+//! Layout of a BC7 mode, see the BC7 format specification.
+struct BC7Mode {
+	uint32_t subsets;
+	uint32_t partitionBits;
+	uint32_t rotationBits;
+	uint32_t indexModeBits;
+	uint32_t colorBits;
+	uint32_t alphaBits;       //! 0: Opaque
+	uint32_t endpointPBits;   //! 1: A p-bit per endpoint
+	uint32_t sharedPBits;     //! 1: A p-bit per subset, shared by both endpoints
+	uint32_t indexBits;
+	uint32_t secondIndexBits; //! Separate alpha indices (modes 4 and 5)
+};
+
+static constexpr BC7Mode BC7_MODES[8] = {
+	{3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+	{2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+	{3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+	{2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+	{1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+	{1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+	{1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+	{2, 6, 0, 0, 5, 5, 1, 0, 2, 0}
+};
+
+static const int* weightsOf(uint32_t indexBits) {
+	return indexBits == 2 ? WEIGHTS2 : indexBits == 3 ? WEIGHTS3 : WEIGHTS4;
+}
+
+//! Expand a quantized endpoint to 8 bits by repeating its highest bits.
+static int expandBits(uint32_t value, uint32_t bits) {
+	value <<= 8 - bits;
+	return static_cast<int>(value | (value >> bits));
+}
+
+void decodeBC7Block(const uint8_t* block, uint8_t* rgba) {
+	BlockBits bits{block};
+
+	uint32_t modeIndex = 0;
+	while(modeIndex != 8 && bits.read(1) == 0) {
+		++modeIndex;
+	}
+	if(modeIndex == 8) {
+		// Reserved mode: Decodes to transparent black.
+		memset(rgba, 0, BLOCK_TEXELS * 4);
+		return;
+	}
+	const BC7Mode& mode = BC7_MODES[modeIndex];
+
+	const uint32_t partition = bits.read(mode.partitionBits);
+	const uint32_t rotation = bits.read(mode.rotationBits);
+	const uint32_t indexMode = bits.read(mode.indexModeBits);
+
+	// Endpoints are stored channel by channel, both endpoints of every subset per channel.
+	uint32_t raw[3][2][4] = {};
+	const uint32_t channels = mode.alphaBits != 0 ? 4 : 3;
+	for(uint32_t c = 0; c != channels; ++c) {
+		for(uint32_t subset = 0; subset != mode.subsets; ++subset) {
+			for(uint32_t e = 0; e != 2; ++e) {
+				raw[subset][e][c] = bits.read(c == 3 ? mode.alphaBits : mode.colorBits);
+			}
+		}
+	}
+
+	uint32_t pBits[3][2] = {};
+	for(uint32_t subset = 0; subset != mode.subsets; ++subset) {
+		if(mode.endpointPBits) {
+			pBits[subset][0] = bits.read(1);
+			pBits[subset][1] = bits.read(1);
+		}
+	}
+	for(uint32_t subset = 0; subset != mode.subsets; ++subset) {
+		if(mode.sharedPBits) {
+			pBits[subset][0] = pBits[subset][1] = bits.read(1);
+		}
+	}
+
+	int endpoints[3][2][4];
+	const uint32_t pBit = mode.endpointPBits | mode.sharedPBits;
+	for(uint32_t subset = 0; subset != mode.subsets; ++subset) {
+		for(uint32_t e = 0; e != 2; ++e) {
+			for(uint32_t c = 0; c != 4; ++c) {
+				if(c == 3 && mode.alphaBits == 0) {
+					endpoints[subset][e][c] = 255;
+					continue;
+				}
+				const uint32_t channelBits = c == 3 ? mode.alphaBits : mode.colorBits;
+				const uint32_t value = (raw[subset][e][c] << pBit) | (pBit ? pBits[subset][e] : 0);
+				endpoints[subset][e][c] = expandBits(value, channelBits + pBit);
+			}
+		}
+	}
+
+	const uint8_t* subsetOf = mode.subsets == 1 ? nullptr : mode.subsets == 2 ? PARTITIONS2[partition] : PARTITIONS3[partition];
+	auto isAnchor = [&](uint32_t texel) {
+		if(texel == 0) {
+			return true;
+		}
+		if(mode.subsets == 2) {
+			return texel == ANCHORS2[partition];
+		}
+		return mode.subsets == 3 && (texel == ANCHORS3_SECOND[partition] || texel == ANCHORS3_THIRD[partition]);
+	};
+
+	uint32_t indices[BLOCK_TEXELS];
+	uint32_t secondIndices[BLOCK_TEXELS] = {};
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		indices[i] = bits.read(isAnchor(i) ? mode.indexBits - 1 : mode.indexBits);
+	}
+	if(mode.secondIndexBits != 0) {
+		for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+			secondIndices[i] = bits.read(i == 0 ? mode.secondIndexBits - 1 : mode.secondIndexBits);
+		}
+	}
+
+	// Modes 4 and 5 have separate alpha indices, the index mode of mode 4 swaps which set is used for color.
+	const bool swapIndices = indexMode != 0;
+	const uint32_t* colorIndices = swapIndices ? secondIndices : indices;
+	const uint32_t* alphaIndices = mode.secondIndexBits == 0 ? indices : swapIndices ? indices : secondIndices;
+	const int* colorWeights = weightsOf(swapIndices ? mode.secondIndexBits : mode.indexBits);
+	const int* alphaWeights = weightsOf(mode.secondIndexBits == 0 || swapIndices ? mode.indexBits : mode.secondIndexBits);
+
+	for(uint32_t i = 0; i != BLOCK_TEXELS; ++i) {
+		const uint32_t subset = subsetOf ? subsetOf[i] : 0;
+		const int* e0 = endpoints[subset][0];
+		const int* e1 = endpoints[subset][1];
+
+		uint8_t* texel = rgba + i * 4;
+		for(int c = 0; c != 3; ++c) {
+			texel[c] = static_cast<uint8_t>(interpolate(e0[c], e1[c], colorWeights[colorIndices[i]]));
+		}
+		texel[3] = static_cast<uint8_t>(interpolate(e0[3], e1[3], alphaWeights[alphaIndices[i]]));
+
+		// The rotation swaps alpha with a color channel.
+		if(rotation != 0) {
+			std::swap(texel[3], texel[rotation - 1]);
+		}
+	}
+}
+
+
+// ----- Images -----
+//! Call function(row) for every row of blocks, in parallel on the job system or on the calling thread without one.
+template<typename Function>
+static void parallelRows(JobSystem* jobs, uint32_t rowCount, Function function) {
+	if(jobs == nullptr) {
+		for(uint32_t row = 0; row != rowCount; ++row) {
+			function(row);
+		}
+		return;
+	}
+
+	jobs->parallelFor(rowCount, 1, [&function](uint32_t firstRow, uint32_t count) {
+		for(uint32_t row = firstRow; row != firstRow + count; ++row) {
+			function(row);
+		}
+	});
+}
+
+std::vector<uint8_t> compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, VkFormat format, JobSystem* jobs) {
+	const BlockCodec codec = codecOf(format);
+	const uint32_t blocksWide = (width + 3) / 4;
+	const uint32_t blocksHigh = (height + 3) / 4;
+	const uint32_t bytes = blockBytes(codec);
+
+	std::vector<uint8_t> blocks(static_cast<size_t>(blocksWide) * blocksHigh * bytes);
+
+	parallelRows(jobs, blocksHigh, [&](uint32_t blockRow) {
+		uint8_t texels[BLOCK_TEXELS * 4];
+		for(uint32_t blockColumn = 0; blockColumn != blocksWide; ++blockColumn) {
+			for(uint32_t y = 0; y != 4; ++y) {
+				const uint32_t row = std::min(blockRow * 4 + y, height - 1);
+				for(uint32_t x = 0; x != 4; ++x) {
+					const uint32_t column = std::min(blockColumn * 4 + x, width - 1);
+					memcpy(texels + (y * 4 + x) * 4, pixels + (static_cast<size_t>(row) * width + column) * 4, 4);
+				}
+			}
+
+			uint8_t* block = blocks.data() + (static_cast<size_t>(blockRow) * blocksWide + blockColumn) * bytes;
+			switch(codec) {
+				case BlockCodec::BC1: encodeBC1Block(texels, block); break;
+				case BlockCodec::BC3: encodeBC3Block(texels, block); break;
+				case BlockCodec::BC7: encodeBC7Block(texels, block); break;
+			}
+		}
+	});
+
+	return blocks;
+}
+
+std::vector<uint8_t> decompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, VkFormat format) {
+	const BlockCodec codec = codecOf(format);
+	const uint32_t blocksWide = (width + 3) / 4;
+	const uint32_t blocksHigh = (height + 3) / 4;
+	const uint32_t bytes = blockBytes(codec);
+
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+
+	for(uint32_t blockRow = 0; blockRow != blocksHigh; ++blockRow) {
+		for(uint32_t blockColumn = 0; blockColumn != blocksWide; ++blockColumn) {
+			const uint8_t* block = blocks + (static_cast<size_t>(blockRow) * blocksWide + blockColumn) * bytes;
+
+			uint8_t texels[BLOCK_TEXELS * 4];
+			switch(codec) {
+				case BlockCodec::BC1: decodeBC1Block(block, texels); break;
+				case BlockCodec::BC3: decodeBC3Block(block, texels); break;
+				case BlockCodec::BC7: decodeBC7Block(block, texels); break;
+			}
+
+			// Texels outside of the image are padding.
+			for(uint32_t y = 0; y != 4 && blockRow * 4 + y < height; ++y) {
+				for(uint32_t x = 0; x != 4 && blockColumn * 4 + x < width; ++x) {
+					const size_t pixel = static_cast<size_t>(blockRow * 4 + y) * width + blockColumn * 4 + x;
+					memcpy(pixels.data() + pixel * 4, texels + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+
+	return pixels;
+}
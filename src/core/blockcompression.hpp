@@ -0,0 +1,33 @@
+#pragma once
+
+// Overview:
+// Block compressed (BCn) formats store 4x4 texels in a fixed number of bytes. The GPU samples them directly, so they
+// take 4 (BC3, BC7) to 8 (BC1) times less memory and bandwidth than RGBA8.
+//
+// Encoders: Used offline by the TextureCompressor tool. Endpoints are placed on the principal axis of the block
+//           colors; Good enough for albedo textures, not a replacement for a full search encoder.
+// Decoders: Fallback for devices without textureCompressionBC. BC7 blocks are decoded in all 8 modes, including the
+//           partitioned ones that other encoders write.
+//
+// Pixels are RGBA8, 16 texels of a block in row major order.
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+void encodeBC1Block(const uint8_t* rgba, uint8_t* block);  //! 8 Bytes; Opaque, alpha is ignored.
+void encodeBC3Block(const uint8_t* rgba, uint8_t* block);  //! 16 Bytes; BC1 color and interpolated alpha.
+void encodeBC7Block(const uint8_t* rgba, uint8_t* block);  //! 16 Bytes; Mode 6, RGBA with 16 interpolation steps.
+
+void decodeBC1Block(const uint8_t* block, uint8_t* rgba);
+void decodeBC3Block(const uint8_t* block, uint8_t* rgba);
+void decodeBC7Block(const uint8_t* block, uint8_t* rgba);
+
+//! Encode a whole RGBA8 image into blocks of the format.
+//! Blocks on the right and bottom edge repeat the last column and row of the image.
+//! @param jobs Rows of blocks are encoded on all threads of the job system, otherwise on the calling thread.
+std::vector<uint8_t> compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, VkFormat format, JobSystem* jobs = nullptr);
+//! Decode the blocks of a whole image into tightly packed RGBA8 pixels.
+std::vector<uint8_t> decompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, VkFormat format);
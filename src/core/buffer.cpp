@@ -64,23 +64,28 @@ VkDeviceSize Buffer::getBufferSize() const {
 }
 
 /** Map a memory range of this m_buffer. If successful, m_mapped points to the specified m_buffer range.
+ *  @note The allocator keeps host visible memory mapped, so this does not call vkMapMemory.
  *  @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete m_buffer range.
  *  @param offset (Optional) Byte offset from beginning.
- *  @return VkResult of the m_buffer mapping call.
+ *  @return VK_ERROR_MEMORY_MAP_FAILED if the memory is not host visible.
  */
 VkResult Buffer::map(VkDeviceSize size, VkDeviceSize offset) {
-	assert(m_buffer && m_memory && "Called map on m_buffer before create");
-	return vkMapMemory(m_device.device(), m_memory, offset, size, 0, &m_mapped);
+	assert(m_buffer && m_memory.memory && "Called map on m_buffer before create");
+	(void)size;
+
+	if (!m_memory.mapped) {
+		return VK_ERROR_MEMORY_MAP_FAILED;
+	}
+
+	m_mapped = static_cast<char*>(m_memory.mapped) + offset;
+	return VK_SUCCESS;
 }
 
 /** Unmap a m_mapped memory range.
- *  @note Does not return a result as vkUnmapMemory can't fail.
+ *  @note The memory block stays mapped by the allocator; only the pointer of this m_buffer is reset.
  */
 void Buffer::unmap() {
-	if (m_mapped) {
-		vkUnmapMemory(m_device.device(), m_memory);
-		m_mapped = nullptr;
-	}
+	m_mapped = nullptr;
 }
 
 /** Copies the specified data to the m_mapped m_buffer. Default value writes whole m_buffer range.
@@ -88,7 +93,7 @@ void Buffer::unmap() {
  *  @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to flush the complete buffer range.
  *  @param offset (Optional) Byte offset from beginning of m_mapped region.
  */
-void Buffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset) {
+void Buffer::writeToBuffer(const void *data, VkDeviceSize size, VkDeviceSize offset) {
 	assert(m_mapped && "Cannot copy to unmapped m_buffer");
 
 	if (size == VK_WHOLE_SIZE) {
@@ -107,12 +112,7 @@ void Buffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset) {
  *  @return VkResult of the flush call.
  */
 VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-	VkMappedMemoryRange mappedRange = {};
-	mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	mappedRange.memory = m_memory;
-	mappedRange.offset = offset;
-	mappedRange.size = size;
-
+	VkMappedMemoryRange mappedRange = m_device.allocator().mappedRange(m_memory, size, offset);
 	return vkFlushMappedMemoryRanges(m_device.device(), 1, &mappedRange);
 }
 
@@ -123,11 +123,7 @@ VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset) {
  *  @return VkResult of the invalidate call.
  */
 VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-	VkMappedMemoryRange mappedRange = {};
-	mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	mappedRange.memory = m_memory;
-	mappedRange.offset = offset;
-	mappedRange.size = size;
+	VkMappedMemoryRange mappedRange = m_device.allocator().mappedRange(m_memory, size, offset);
 	return vkInvalidateMappedMemoryRanges(m_device.device(), 1, &mappedRange);
 }
 
@@ -144,7 +140,7 @@ VkDescriptorBufferInfo Buffer::descriptorInfo(VkDeviceSize size, VkDeviceSize of
  *  @param data Pointer to the data to copy.
  *  @param index Used in offset calculation.
  */
-void Buffer::writeToIndex(void *data, int index) {
+void Buffer::writeToIndex(const void *data, int index) {
 	writeToBuffer(data, m_instanceSize, index * m_alignmentSize);
 }
 
@@ -175,5 +171,20 @@ VkResult Buffer::invalidateIndex(int index) {
 Buffer::~Buffer() {
 	unmap();
 	vkDestroyBuffer(m_device.device(), m_buffer, nullptr);
-	vkFreeMemory(m_device.device(), m_memory, nullptr);
-}
\ No newline at end of file
+	m_device.allocator().free(m_memory);
+}
+
+std::vector<std::unique_ptr<Buffer>> createFrameBuffers(Device& device, uint32_t frameCount, VkDeviceSize instanceSize,
+                                                        uint32_t instanceCount, VkBufferUsageFlags usage) {
+	std::vector<std::unique_ptr<Buffer>> buffers;
+	buffers.reserve(frameCount);
+	for(uint32_t i = 0; i != frameCount; ++i) {
+		auto buffer = std::make_unique<Buffer>(device, instanceSize, instanceCount, usage,
+		                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if(buffer->map() != VK_SUCCESS) {
+			throw std::runtime_error("Failed to map per frame buffer!");
+		}
+		buffers.push_back(std::move(buffer));
+	}
+	return buffers;
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "device.hpp"
 
 class Buffer {
@@ -11,12 +14,12 @@ public:
 	VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 	void unmap();
 
-	void writeToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+	void writeToBuffer(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 	VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 	VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 	VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 
-	void writeToIndex(void* data, int index);
+	void writeToIndex(const void* data, int index);
 	VkResult flushIndex(int index);
 	VkDescriptorBufferInfo descriptorInfoForIndex(int index);
 	VkResult invalidateIndex(int index);
@@ -36,7 +39,7 @@ private:
 	Device& m_device;
 	void* m_mapped = nullptr;
 	VkBuffer m_buffer = VK_NULL_HANDLE;
-	VkDeviceMemory m_memory = VK_NULL_HANDLE;
+	MemoryAllocation m_memory{};  //! Sub allocation of the device allocator. Host visible memory is persistently mapped.
 
 	VkDeviceSize m_bufferSize;
 	uint32_t m_instanceCount;
@@ -46,3 +49,7 @@ private:
 	VkMemoryPropertyFlags m_memoryPropertyFlags;
 };
 
+//! One persistently mapped buffer per frame in flight, for data the CPU rewrites every frame. The memory is host
+//! coherent: Writes are visible to the next submission without flushing.
+std::vector<std::unique_ptr<Buffer>> createFrameBuffers(Device& device, uint32_t frameCount, VkDeviceSize instanceSize,
+                                                        uint32_t instanceCount, VkBufferUsageFlags usage);
@@ -0,0 +1,112 @@
+#include "computepipeline.hpp"
+#include "pipelinecache.hpp"
+#include "file.hpp"
+
+#include <chrono>
+
+ComputePipeline::ComputePipeline(Device& device, const std::string& pathComputeFile, const ComputePipelineInfo& info) : m_device(device) {
+	createComputePipeline(pathComputeFile, info);
+}
+
+ComputePipeline::~ComputePipeline() {
+	vkDestroyPipeline(m_device.device(), m_computePipeline, nullptr);
+	vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
+}
+
+VkPipelineLayout ComputePipeline::layout() const {
+	return m_pipelineLayout;
+}
+
+void ComputePipeline::bind(VkCommandBuffer commandBuffer) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline);
+}
+
+void ComputePipeline::bindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet, uint32_t set) {
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+}
+
+void ComputePipeline::pushConstants(VkCommandBuffer commandBuffer, uint32_t offset, uint32_t size, const void* data) {
+	vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, offset, size, data);
+}
+
+void ComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t invocationsX, uint32_t invocationsY, uint32_t invocationsZ) {
+	vkCmdDispatch(commandBuffer, groupCount(invocationsX, m_localSize[0]), groupCount(invocationsY, m_localSize[1]),
+	              groupCount(invocationsZ, m_localSize[2]));
+}
+
+uint32_t ComputePipeline::groupCount(uint32_t invocations, uint32_t groupSize) {
+	return (invocations + groupSize - 1) / groupSize;
+}
+
+void ComputePipeline::readLocalSize(const uint32_t* code, size_t wordCount) {
+	// SPIR-V: 5 words of header, then instructions. The first word of an instruction is (word count << 16) | opcode.
+	const uint32_t OP_EXECUTION_MODE = 16;
+	const uint32_t EXECUTION_MODE_LOCAL_SIZE = 17;
+
+	size_t i = 5;
+	while(i < wordCount) {
+		const uint32_t opcode = code[i] & 0xFFFF;
+		const uint32_t instructionWords = code[i] >> 16;
+		if(instructionWords == 0) {
+			break;
+		}
+
+		if(opcode == OP_EXECUTION_MODE && instructionWords >= 6 && i + 5 < wordCount && code[i + 2] == EXECUTION_MODE_LOCAL_SIZE) {
+			m_localSize[0] = code[i + 3];
+			m_localSize[1] = code[i + 4];
+			m_localSize[2] = code[i + 5];
+			return;
+		}
+		i += instructionWords;
+	}
+	// Local size given by specialization constants (LocalSizeId) is not supported, dispatch() assumes 1x1x1.
+}
+
+void ComputePipeline::createComputePipeline(const std::string& pathComputeFile, const ComputePipelineInfo& info) {
+	// Memory mapped: The mapping is page aligned, as required for the uint32_t words of the code.
+	const MappedFile code(pathComputeFile);
+	readLocalSize(reinterpret_cast<const uint32_t*>(code.data()), code.size() / sizeof(uint32_t));
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if(vkCreateShaderModule(m_device.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create shader module!");
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(info.descriptorSetLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = info.descriptorSetLayouts.empty() ? nullptr : info.descriptorSetLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(info.pushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = info.pushConstantRanges.empty() ? nullptr : info.pushConstantRanges.data();
+
+	if(vkCreatePipelineLayout(m_device.device(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
+		vkDestroyShaderModule(m_device.device(), shaderModule, nullptr);
+		throw std::runtime_error("Failed to create pipeline layout!");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = m_pipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	PipelineCache& cache = m_device.pipelineCache();
+	const auto start = std::chrono::steady_clock::now();
+	const VkResult result = vkCreateComputePipelines(m_device.device(), cache.handle(), 1, &pipelineInfo, nullptr, &m_computePipeline);
+	cache.recordCreation(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+	vkDestroyShaderModule(m_device.device(), shaderModule, nullptr);
+	if(result != VK_SUCCESS) {
+		vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
+		throw std::runtime_error("Failed to create compute pipeline!");
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <string>
+#include <vector>
+
+#include "device.hpp"
+
+struct ComputePipelineInfo {
+	std::vector<VkDescriptorSetLayout> descriptorSetLayouts;  //! Set 0, 1, ...
+	std::vector<VkPushConstantRange> pushConstantRanges;
+};
+
+//! Pipeline with a single compute shader, the counterpart of Pipeline for work outside of render passes.
+class ComputePipeline {
+public:
+	ComputePipeline(Device& device, const std::string& pathComputeFile, const ComputePipelineInfo& info);
+	~ComputePipeline();
+
+	ComputePipeline(const ComputePipeline&) = delete;
+	ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+	VkPipelineLayout layout() const;
+	void bind(VkCommandBuffer commandBuffer);
+	void bindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet, uint32_t set = 0);
+	//! Record push constants. The range has to be inside one of ComputePipelineInfo::pushConstantRanges.
+	void pushConstants(VkCommandBuffer commandBuffer, uint32_t offset, uint32_t size, const void* data);
+	//! Dispatch enough work groups to cover the invocations, the shader has to skip the ones past the end.
+	void dispatch(VkCommandBuffer commandBuffer, uint32_t invocationsX, uint32_t invocationsY = 1, uint32_t invocationsZ = 1);
+
+	//! Number of groups of groupSize that cover all invocations.
+	static uint32_t groupCount(uint32_t invocations, uint32_t groupSize);
+
+private:
+	void createComputePipeline(const std::string& pathComputeFile, const ComputePipelineInfo& info);
+	//! Read the work group size of the shader, dispatch() converts invocations to groups with it.
+	void readLocalSize(const uint32_t* code, size_t wordCount);
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	VkPipelineLayout m_pipelineLayout;
+	VkPipeline m_computePipeline;
+	uint32_t m_localSize[3] = {1, 1, 1};
+};
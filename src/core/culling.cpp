@@ -0,0 +1,160 @@
+#include "culling.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static_assert(sizeof(CullObject) == 32, "CullObject must match the std430 layout of cull.comp");
+static_assert(sizeof(CullUniforms) == 192, "CullUniforms must match the std140 layout of cull.comp");
+
+CullUniforms makeCullUniforms(const glm::mat4& viewProjection, uint32_t objectCount, uint32_t flags, glm::uvec2 pyramidSize, uint32_t pyramidLevels) {
+	const Frustum frustum = Frustum::fromMatrix(viewProjection);
+
+	CullUniforms uniforms{};
+	uniforms.viewProjection = viewProjection;
+	for(size_t i = 0; i != frustum.planes.size(); ++i) {
+		uniforms.planes[i] = frustum.planes[i];
+	}
+	uniforms.pyramidSize = pyramidSize;
+	uniforms.pyramidLevels = pyramidLevels;
+	uniforms.objectCount = objectCount;
+	uniforms.flags = flags;
+	return uniforms;
+}
+
+glm::uvec2 pyramidLevelSize(glm::uvec2 size) {
+	return glm::max((size + 1u) / 2u, glm::uvec2(1));
+}
+
+uint32_t pyramidLevelCount(glm::uvec2 depthSize) {
+	glm::uvec2 size = pyramidLevelSize(depthSize);
+	uint32_t levels = 1;
+	while(size.x > 1 || size.y > 1) {
+		size = pyramidLevelSize(size);
+		++levels;
+	}
+	return levels;
+}
+
+//! Farthest depth of the source texels covered by each destination texel. Covers partial texels of odd sizes.
+static std::vector<float> reduce(const float* source, glm::uvec2 sourceSize, glm::uvec2 size) {
+	std::vector<float> level(static_cast<size_t>(size.x) * size.y);
+	for(uint32_t y = 0; y != size.y; ++y) {
+		for(uint32_t x = 0; x != size.x; ++x) {
+			const glm::uvec2 texel{x, y};
+			const glm::uvec2 first = (texel * sourceSize) / size;
+			const glm::uvec2 last = ((texel + 1u) * sourceSize + size - 1u) / size;
+
+			float farthest = 0.0f;
+			for(uint32_t sy = first.y; sy != last.y; ++sy) {
+				for(uint32_t sx = first.x; sx != last.x; ++sx) {
+					farthest = std::max(farthest, source[static_cast<size_t>(sy) * sourceSize.x + sx]);
+				}
+			}
+			level[static_cast<size_t>(y) * size.x + x] = farthest;
+		}
+	}
+	return level;
+}
+
+DepthPyramidData buildDepthPyramid(const float* depth, uint32_t width, uint32_t height) {
+	if(width == 0 || height == 0) {
+		throw std::runtime_error("Failed to build depth pyramid, the depth image is empty!");
+	}
+
+	DepthPyramidData pyramid;
+	const float* source = depth;
+	glm::uvec2 sourceSize{width, height};
+
+	const uint32_t levelCount = pyramidLevelCount(sourceSize);
+	for(uint32_t level = 0; level != levelCount; ++level) {
+		const glm::uvec2 size = pyramidLevelSize(sourceSize);
+		pyramid.levels.push_back(reduce(source, sourceSize, size));
+		pyramid.sizes.push_back(size);
+
+		source = pyramid.levels.back().data();
+		sourceSize = size;
+	}
+	return pyramid;
+}
+
+//! Project the box around the sphere and compare its nearest depth with the farthest depth of the pyramid
+//! texels it covers. The level is the finest one where the box covers at most 2x2 texels.
+static bool isInFrontOfDepth(const glm::vec4& sphere, const CullUniforms& uniforms, const DepthPyramidData& pyramid) {
+	glm::vec2 uvMin{1.0f};
+	glm::vec2 uvMax{0.0f};
+	float nearest = 1.0f;
+
+	for(uint32_t i = 0; i != 8; ++i) {
+		const glm::vec3 offset{(i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f};
+		const glm::vec4 clip = uniforms.viewProjection * glm::vec4(glm::vec3(sphere) + offset * sphere.w, 1.0f);
+		if(clip.w <= 0.0f) {
+			return true;  // Crosses the camera plane, the projection is not bounded.
+		}
+
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		const glm::vec2 uv = glm::vec2(ndc) * 0.5f + 0.5f;
+		uvMin = glm::min(uvMin, uv);
+		uvMax = glm::max(uvMax, uv);
+		nearest = std::min(nearest, ndc.z);
+	}
+
+	uvMin = glm::clamp(uvMin, glm::vec2(0.0f), glm::vec2(1.0f));
+	uvMax = glm::clamp(uvMax, uvMin, glm::vec2(1.0f));
+
+	uint32_t level = 0;
+	glm::uvec2 first{0};
+	glm::uvec2 last{0};
+	glm::uvec2 size = uniforms.pyramidSize;
+	for(;;) {
+		first = glm::min(glm::uvec2(uvMin * glm::vec2(size)), size - 1u);
+		last = glm::min(glm::uvec2(uvMax * glm::vec2(size)), size - 1u);
+		if((last.x - first.x <= 1 && last.y - first.y <= 1) || level + 1 == uniforms.pyramidLevels) {
+			break;
+		}
+		size = pyramidLevelSize(size);
+		++level;
+	}
+
+	const std::vector<float>& texels = pyramid.levels[level];
+	float farthest = 0.0f;
+	for(uint32_t y = first.y; y <= last.y; ++y) {
+		for(uint32_t x = first.x; x <= last.x; ++x) {
+			farthest = std::max(farthest, texels[static_cast<size_t>(y) * size.x + x]);
+		}
+	}
+	return nearest <= farthest;
+}
+
+bool isObjectVisible(const CullObject& object, const CullUniforms& uniforms, const DepthPyramidData* pyramid) {
+	if(uniforms.flags & CULL_FRUSTUM) {
+		for(const glm::vec4& plane : uniforms.planes) {
+			if(glm::dot(glm::vec3(plane), glm::vec3(object.sphere)) + plane.w < -object.sphere.w) {
+				return false;
+			}
+		}
+	}
+
+	if((uniforms.flags & CULL_OCCLUSION) && pyramid) {
+		return isInFrontOfDepth(object.sphere, uniforms, *pyramid);
+	}
+	return true;
+}
+
+std::vector<VkDrawIndexedIndirectCommand> cullObjects(const CullObject* objects, uint32_t count, const CullUniforms& uniforms, const DepthPyramidData* pyramid) {
+	std::vector<VkDrawIndexedIndirectCommand> commands;
+	for(uint32_t i = 0; i != count; ++i) {
+		const CullObject& object = objects[i];
+		if(!isObjectVisible(object, uniforms, pyramid)) {
+			continue;
+		}
+
+		VkDrawIndexedIndirectCommand command{};
+		command.indexCount = object.indexCount;
+		command.instanceCount = 1;
+		command.firstIndex = object.firstIndex;
+		command.vertexOffset = object.vertexOffset;
+		command.firstInstance = object.firstInstance;
+		commands.push_back(command);
+	}
+	return commands;
+}
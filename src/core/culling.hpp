@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "frustum.hpp"
+
+// Data of the GPU culling pass (see CullingPass and cull.comp) and a CPU reference of the shader.
+// The reference decides exactly like the shader does, so the results of both can be compared (eg. on lavapipe).
+
+//! One object of the culling pass: World space bounds and the draw that is emitted if it is visible.
+//! std430 layout of the objects buffer of cull.comp.
+struct CullObject {
+	glm::vec4 sphere;        //! World space center (xyz) and radius (w)
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t firstInstance;  //! Usually the index of the object, selects its per object data.
+};
+
+enum CullFlags : uint32_t {
+	CULL_FRUSTUM = 1,    //! Skip objects outside of the frustum.
+	CULL_OCCLUSION = 2,  //! Skip objects behind the depth of the depth pyramid.
+	CULL_COMPACT = 4     //! Append visible draws and count them. Otherwise every draw is written, hidden ones with zero instances.
+};
+
+//! Uniform buffer of cull.comp, std140 layout.
+struct CullUniforms {
+	glm::mat4 viewProjection;
+	glm::vec4 planes[6];    //! Frustum::planes
+	glm::uvec2 pyramidSize; //! Level 0 of the depth pyramid
+	uint32_t pyramidLevels;
+	uint32_t objectCount;
+	uint32_t flags;         //! CullFlags
+	uint32_t padding[3];
+};
+
+CullUniforms makeCullUniforms(const glm::mat4& viewProjection, uint32_t objectCount, uint32_t flags, glm::uvec2 pyramidSize = {1, 1}, uint32_t pyramidLevels = 1);
+
+//! Host copy of a depth pyramid (hierarchical depth). Level 0 has half the size of the depth image (rounded up),
+//! every following level half the size of the previous one down to 1x1.
+//! A texel holds the farthest depth of all texels it covers in the level below.
+struct DepthPyramidData {
+	std::vector<glm::uvec2> sizes;
+	std::vector<std::vector<float>> levels;
+};
+
+//! Size of the next level, rounded up.
+glm::uvec2 pyramidLevelSize(glm::uvec2 size);
+//! Levels of a pyramid for a depth image of this size.
+uint32_t pyramidLevelCount(glm::uvec2 depthSize);
+
+//! Reduce the depth image like depthreduce.comp. Depth is in [0, 1], 1 is the far plane.
+DepthPyramidData buildDepthPyramid(const float* depth, uint32_t width, uint32_t height);
+
+//! Visibility of an object, like cull.comp decides it.
+//! @param pyramid Depth of the previous frame; Only used with CULL_OCCLUSION.
+bool isObjectVisible(const CullObject& object, const CullUniforms& uniforms, const DepthPyramidData* pyramid);
+
+//! Draw commands of the visible objects, in the order of the objects. The GPU appends them in any order.
+std::vector<VkDrawIndexedIndirectCommand> cullObjects(const CullObject* objects, uint32_t count, const CullUniforms& uniforms, const DepthPyramidData* pyramid);
@@ -0,0 +1,113 @@
+#include "cullingpass.hpp"
+
+#include <cstring>
+
+bool CullingPass::isSupported(const Device& device) {
+	return device.enabledFeatures().drawIndirectFirstInstance;
+}
+
+CullingPass::CullingPass(Device& device, const std::string& pathCullShader, IndirectDrawBuffer& draws, uint32_t frameCount)
+	: m_device(device), m_draws(draws), m_counts(frameCount, 0), m_lastUniforms(frameCount, CullUniforms{}) {
+	if(!isSupported(m_device)) {
+		throw std::runtime_error("Failed to create culling pass, drawIndirectFirstInstance is not supported!");
+	}
+
+	m_objects = createFrameBuffers(m_device, frameCount, sizeof(CullObject), m_draws.capacity(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	m_uniforms = createFrameBuffers(m_device, frameCount, sizeof(CullUniforms), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+	createDescriptors(frameCount);
+
+	ComputePipelineInfo info{};
+	info.descriptorSetLayouts = {m_setLayout->descriptorSetLayout()};
+	m_pipeline = std::make_unique<ComputePipeline>(m_device, pathCullShader, info);
+}
+
+void CullingPass::createDescriptors(uint32_t frameCount) {
+	m_setLayout = DescriptorSetLayout::Builder(m_device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)          // CullUniforms
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)          // Objects
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)          // Draw commands
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)          // Draw count
+			.addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)  // Depth pyramid
+			.build();
+
+	m_pool = DescriptorPool::Builder(m_device)
+			.setMaxSets(frameCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * frameCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount)
+			.build();
+
+	// The depth pyramid is written by dispatch(), it is recreated with the swapchain.
+	m_sets.resize(frameCount);
+	for(uint32_t frame = 0; frame != frameCount; ++frame) {
+		VkDescriptorBufferInfo uniformInfo = m_uniforms[frame]->descriptorInfo();
+		VkDescriptorBufferInfo objectInfo = m_objects[frame]->descriptorInfo();
+		VkDescriptorBufferInfo commandInfo{m_draws.commandBuffer(frame), 0, VK_WHOLE_SIZE};
+		VkDescriptorBufferInfo countInfo{m_draws.countBuffer(frame), 0, VK_WHOLE_SIZE};
+
+		if(!DescriptorWriter(*m_setLayout, *m_pool)
+				.writeBuffer(0, &uniformInfo)
+				.writeBuffer(1, &objectInfo)
+				.writeBuffer(2, &commandInfo)
+				.writeBuffer(3, &countInfo)
+				.build(m_sets[frame])) {
+			throw std::runtime_error("Failed to allocate culling descriptor set!");
+		}
+	}
+}
+
+void CullingPass::update(uint32_t frame, const CullObject* objects, uint32_t count) {
+	if(count > m_draws.capacity()) {
+		throw std::runtime_error("Failed to update culling objects, the count exceeds the capacity!");
+	}
+
+	memcpy(m_objects[frame]->getMappedMemory(), objects, count * sizeof(CullObject));
+	m_counts[frame] = count;
+}
+
+void CullingPass::dispatch(VkCommandBuffer commandBuffer, uint32_t frame, const glm::mat4& viewProjection, const DepthPyramid& pyramid) {
+	uint32_t flags = CULL_FRUSTUM;
+	if(pyramid.isBuilt()) {
+		flags |= CULL_OCCLUSION;
+	}
+	if(compacts()) {
+		flags |= CULL_COMPACT;
+	}
+
+	const VkExtent2D pyramidSize = pyramid.extent();
+	m_lastUniforms[frame] = makeCullUniforms(viewProjection, m_counts[frame], flags, {pyramidSize.width, pyramidSize.height}, pyramid.levelCount());
+	memcpy(m_uniforms[frame]->getMappedMemory(), &m_lastUniforms[frame], sizeof(CullUniforms));
+
+	// The set of the frame is not in use anymore, its fence is signaled.
+	VkDescriptorImageInfo pyramidInfo = pyramid.descriptorInfo();
+	DescriptorWriter(*m_setLayout, *m_pool)
+			.writeImage(4, &pyramidInfo)
+			.overwrite(m_sets[frame]);
+
+	m_draws.beginGpuWritten(frame);
+
+	m_pipeline->bind(commandBuffer);
+	m_pipeline->bindDescriptorSet(commandBuffer, m_sets[frame]);
+	m_pipeline->dispatch(commandBuffer, m_counts[frame]);
+
+	// Commands and count are written before the draws read them.
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
+	                     1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+uint32_t CullingPass::count(uint32_t frame) const {
+	return m_counts[frame];
+}
+
+bool CullingPass::compacts() const {
+	return m_device.drawIndexedIndirectCount() != nullptr;
+}
+
+const CullUniforms& CullingPass::uniforms(uint32_t frame) const {
+	return m_lastUniforms[frame];
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.hpp"
+#include "culling.hpp"
+#include "computepipeline.hpp"
+#include "depthpyramid.hpp"
+#include "descriptor.hpp"
+#include "indirectdraw.hpp"
+
+//! GPU driven culling with cull.comp: Tests the bounding sphere of every object against the frustum and the depth
+//! pyramid of the previous frame, and writes the draws of the visible objects into an IndirectDrawBuffer.
+//! Dense scenes then only pay vertex work for what is visible, and the CPU does not touch the objects per frame.
+//!
+//! With VK_KHR_draw_indirect_count the visible draws are compacted (appended with an atomic counter) and the GPU
+//! written count is used by the draw. Without it every object gets a command, hidden ones with zero instances.
+//! isObjectVisible() of culling.hpp decides like the shader and can be used to check the results.
+class CullingPass {
+public:
+	//! True if the device can draw commands written by the GPU (drawIndirectFirstInstance).
+	static bool isSupported(const Device& device);
+
+	//! @param pathCullShader SPIR-V of cull.comp.
+	//! @param draws Receives the visible draws. Its capacity is the maximum number of objects.
+	CullingPass(Device& device, const std::string& pathCullShader, IndirectDrawBuffer& draws, uint32_t frameCount);
+
+	CullingPass(const CullingPass&) = delete;
+	CullingPass& operator=(const CullingPass&) = delete;
+
+	//! Copy the objects of the frame. Objects that do not move only have to be copied once per frame in flight.
+	void update(uint32_t frame, const CullObject* objects, uint32_t count);
+
+	//! Record the culling; Outside of a render pass, before the draws are recorded with draws.recordGpuWritten().
+	//! The fence of the frame has to be signaled.
+	//! @param pyramid Depth of the previous frame. Occlusion culling is skipped until it was built once.
+	void dispatch(VkCommandBuffer commandBuffer, uint32_t frame, const glm::mat4& viewProjection, const DepthPyramid& pyramid);
+
+	uint32_t count(uint32_t frame) const;  //! Objects of the frame
+	//! True if the draws are compacted and counted on the GPU.
+	bool compacts() const;
+	//! Uniforms of the last dispatch of the frame, eg. to compare the result with cullObjects().
+	const CullUniforms& uniforms(uint32_t frame) const;
+
+private:
+	void createDescriptors(uint32_t frameCount);
+
+private:
+	// Owned by application
+	Device& m_device;
+	IndirectDrawBuffer& m_draws;
+
+	std::vector<std::unique_ptr<Buffer>> m_objects;   //! CullObjects, one buffer per frame in flight
+	std::vector<std::unique_ptr<Buffer>> m_uniforms;  //! CullUniforms, one per frame in flight
+	std::vector<uint32_t> m_counts;
+	std::vector<CullUniforms> m_lastUniforms;
+
+	std::unique_ptr<DescriptorSetLayout> m_setLayout;
+	std::unique_ptr<DescriptorPool> m_pool;
+	std::vector<VkDescriptorSet> m_sets;  //! One per frame in flight
+	std::unique_ptr<ComputePipeline> m_pipeline;
+};
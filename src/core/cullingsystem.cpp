@@ -0,0 +1,315 @@
+#include "cullingsystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define LW_CULLING_X86  // SSE2 is part of x86-64, AVX2 is checked at runtime
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
+#if defined(LW_CULLING_X86) && (defined(__GNUC__) || defined(__clang__))
+	#define LW_TARGET_AVX2 __attribute__((target("avx2")))  // Only this function, the library is built for plain x86-64
+#else
+	#define LW_TARGET_AVX2
+#endif
+
+// All paths evaluate the plane test with the same operations in the same order, so they agree bit for bit:
+//   distance = ((nx * cx + ny * cy) + nz * cz) + w
+//   radius   = ((r + |nx| * ex) + |ny| * ey) + |nz| * ez
+//   outside  = distance + radius < 0
+// Padding objects have a radius of -infinity and are always outside.
+
+static const float PADDING_RADIUS = -std::numeric_limits<float>::infinity();
+
+CullingSystem::CullingSystem(CullingPath path) {
+	setPath(path);
+}
+
+uint32_t CullingSystem::add(const BoundingSphere& sphere) {
+	resize(m_count + 1);
+	set(m_count - 1, sphere);
+	return m_count - 1;
+}
+
+uint32_t CullingSystem::add(const MeshBounds& box) {
+	resize(m_count + 1);
+	set(m_count - 1, box);
+	return m_count - 1;
+}
+
+void CullingSystem::set(uint32_t object, const BoundingSphere& sphere) {
+	m_centerX[object] = sphere.center.x;
+	m_centerY[object] = sphere.center.y;
+	m_centerZ[object] = sphere.center.z;
+	m_extentX[object] = 0.0f;
+	m_extentY[object] = 0.0f;
+	m_extentZ[object] = 0.0f;
+	m_radius[object] = sphere.radius;
+}
+
+void CullingSystem::set(uint32_t object, const MeshBounds& box) {
+	const glm::vec3 center = 0.5f * (box.min + box.max);
+	const glm::vec3 extent = 0.5f * (box.max - box.min);
+
+	m_centerX[object] = center.x;
+	m_centerY[object] = center.y;
+	m_centerZ[object] = center.z;
+	m_extentX[object] = extent.x;
+	m_extentY[object] = extent.y;
+	m_extentZ[object] = extent.z;
+	m_radius[object] = 0.0f;
+}
+
+void CullingSystem::resize(uint32_t count) {
+	const size_t padded = (static_cast<size_t>(count) + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+	for(std::vector<float>* component : {&m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ}) {
+		component->resize(padded, 0.0f);
+	}
+	m_radius.resize(padded, PADDING_RADIUS);
+
+	for(size_t i = m_count; i < count; ++i) {
+		m_radius[i] = 0.0f;
+	}
+	for(size_t i = count; i < padded; ++i) {
+		m_centerX[i] = m_centerY[i] = m_centerZ[i] = 0.0f;
+		m_extentX[i] = m_extentY[i] = m_extentZ[i] = 0.0f;
+		m_radius[i] = PADDING_RADIUS;
+	}
+	m_count = count;
+}
+
+void CullingSystem::clear() {
+	resize(0);
+}
+
+uint32_t CullingSystem::size() const {
+	return m_count;
+}
+
+uint32_t CullingSystem::visibleCapacity() const {
+	return static_cast<uint32_t>(m_radius.size());
+}
+
+CullingPath CullingSystem::path() const {
+	return m_path;
+}
+
+void CullingSystem::setPath(CullingPath path) {
+	if(!isSupported(path)) {
+		throw std::runtime_error("Failed to set culling path, the CPU does not support it!");
+	}
+	m_path = path;
+}
+
+bool CullingSystem::isSupported(CullingPath path) {
+	switch(path) {
+	case CullingPath::Scalar:
+		return true;
+#ifdef LW_CULLING_X86
+	case CullingPath::SSE:
+		return true;
+	case CullingPath::AVX2:
+	#ifdef _MSC_VER
+	{
+		int info[4];
+		__cpuid(info, 1);
+		const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		return osSavesAvx && (info[1] & (1 << 5));
+	}
+	#else
+		return __builtin_cpu_supports("avx2");
+	#endif
+#endif
+	default:
+		return false;
+	}
+}
+
+CullingPath CullingSystem::bestPath() {
+	if(isSupported(CullingPath::AVX2)) {
+		return CullingPath::AVX2;
+	}
+	if(isSupported(CullingPath::SSE)) {
+		return CullingPath::SSE;
+	}
+	return CullingPath::Scalar;
+}
+
+uint32_t CullingSystem::cull(const Frustum& frustum, uint32_t* visible) const {
+	return cullRange(frustum, 0, visibleCapacity(), visible);
+}
+
+void CullingSystem::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+	visible.resize(visibleCapacity());
+	visible.resize(cull(frustum, visible.data()));
+}
+
+void CullingSystem::cull(const glm::mat4& viewProjection, std::vector<uint32_t>& visible) const {
+	cull(Frustum::fromMatrix(viewProjection), visible);
+}
+
+void CullingSystem::cull(const Frustum& frustum, std::vector<uint32_t>& visible, JobSystem& jobs) const {
+	// Every job writes to the part of visible at its first object, then the parts are moved together in order.
+	const uint32_t capacity = visibleCapacity();
+	const uint32_t jobCount = (capacity + JOB_SIZE - 1) / JOB_SIZE;
+	std::vector<uint32_t> counts(jobCount);
+	visible.resize(capacity);
+
+	jobs.parallelFor(jobCount, 1, [&](uint32_t firstJob, uint32_t count) {
+		for(uint32_t job = firstJob; job != firstJob + count; ++job) {
+			const uint32_t first = job * JOB_SIZE;
+			counts[job] = cullRange(frustum, first, std::min(first + JOB_SIZE, capacity), visible.data() + first);
+		}
+	});
+
+	uint32_t visibleCount = jobCount != 0 ? counts[0] : 0;
+	for(uint32_t job = 1; job < jobCount; ++job) {
+		// Parts only move down. While every object so far was visible they are already in place, and std::copy must
+		// not write into its own source.
+		if(visibleCount != job * JOB_SIZE) {
+			const auto first = visible.begin() + job * JOB_SIZE;
+			std::copy(first, first + counts[job], visible.begin() + visibleCount);
+		}
+		visibleCount += counts[job];
+	}
+	visible.resize(visibleCount);
+}
+
+uint32_t CullingSystem::cullRange(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const {
+	switch(m_path) {
+	case CullingPath::AVX2:
+		return cullAVX2(frustum, first, end, visible);
+	case CullingPath::SSE:
+		return cullSSE(frustum, first, end, visible);
+	default:
+		return cullScalar(frustum, first, end, visible);
+	}
+}
+
+uint32_t CullingSystem::cullScalar(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const {
+	uint32_t visibleCount = 0;
+	end = std::min(end, m_count);
+	for(uint32_t i = first; i < end; ++i) {
+		bool inside = true;
+		for(const glm::vec4& plane : frustum.planes) {
+			const float distance = ((plane.x * m_centerX[i] + plane.y * m_centerY[i]) + plane.z * m_centerZ[i]) + plane.w;
+			const float radius = ((m_radius[i] + std::abs(plane.x) * m_extentX[i]) + std::abs(plane.y) * m_extentY[i]) + std::abs(plane.z) * m_extentZ[i];
+			if(distance + radius < 0.0f) {
+				inside = false;
+				break;
+			}
+		}
+		if(inside) {
+			visible[visibleCount++] = i;
+		}
+	}
+	return visibleCount;
+}
+
+#ifdef LW_CULLING_X86
+
+uint32_t CullingSystem::cullSSE(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const {
+	__m128 normalX[6], normalY[6], normalZ[6], distance[6], absX[6], absY[6], absZ[6];
+	for(int p = 0; p != 6; ++p) {
+		const glm::vec4& plane = frustum.planes[p];
+		normalX[p] = _mm_set1_ps(plane.x);
+		normalY[p] = _mm_set1_ps(plane.y);
+		normalZ[p] = _mm_set1_ps(plane.z);
+		distance[p] = _mm_set1_ps(plane.w);
+		absX[p] = _mm_set1_ps(std::abs(plane.x));
+		absY[p] = _mm_set1_ps(std::abs(plane.y));
+		absZ[p] = _mm_set1_ps(std::abs(plane.z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	uint32_t visibleCount = 0;
+	for(uint32_t i = first; i != end; i += 4) {
+		const __m128 centerX = _mm_loadu_ps(&m_centerX[i]);
+		const __m128 centerY = _mm_loadu_ps(&m_centerY[i]);
+		const __m128 centerZ = _mm_loadu_ps(&m_centerZ[i]);
+		const __m128 extentX = _mm_loadu_ps(&m_extentX[i]);
+		const __m128 extentY = _mm_loadu_ps(&m_extentY[i]);
+		const __m128 extentZ = _mm_loadu_ps(&m_extentZ[i]);
+		const __m128 radius = _mm_loadu_ps(&m_radius[i]);
+
+		__m128 outside = zero;
+		for(int p = 0; p != 6; ++p) {
+			const __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[p], centerX), _mm_mul_ps(normalY[p], centerY)),
+			                                       _mm_mul_ps(normalZ[p], centerZ)), distance[p]);
+			const __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(radius, _mm_mul_ps(absX[p], extentX)), _mm_mul_ps(absY[p], extentY)),
+			                            _mm_mul_ps(absZ[p], extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+		}
+
+		// Store every index, advance only past the visible ones.
+		const int mask = ~_mm_movemask_ps(outside);
+		for(uint32_t lane = 0; lane != 4; ++lane) {
+			visible[visibleCount] = i + lane;
+			visibleCount += (mask >> lane) & 1;
+		}
+	}
+	return visibleCount;
+}
+
+LW_TARGET_AVX2 uint32_t CullingSystem::cullAVX2(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const {
+	__m256 normalX[6], normalY[6], normalZ[6], distance[6], absX[6], absY[6], absZ[6];
+	for(int p = 0; p != 6; ++p) {
+		const glm::vec4& plane = frustum.planes[p];
+		normalX[p] = _mm256_set1_ps(plane.x);
+		normalY[p] = _mm256_set1_ps(plane.y);
+		normalZ[p] = _mm256_set1_ps(plane.z);
+		distance[p] = _mm256_set1_ps(plane.w);
+		absX[p] = _mm256_set1_ps(std::abs(plane.x));
+		absY[p] = _mm256_set1_ps(std::abs(plane.y));
+		absZ[p] = _mm256_set1_ps(std::abs(plane.z));
+	}
+	const __m256 zero = _mm256_setzero_ps();
+
+	uint32_t visibleCount = 0;
+	for(uint32_t i = first; i != end; i += BLOCK_SIZE) {
+		const __m256 centerX = _mm256_loadu_ps(&m_centerX[i]);
+		const __m256 centerY = _mm256_loadu_ps(&m_centerY[i]);
+		const __m256 centerZ = _mm256_loadu_ps(&m_centerZ[i]);
+		const __m256 extentX = _mm256_loadu_ps(&m_extentX[i]);
+		const __m256 extentY = _mm256_loadu_ps(&m_extentY[i]);
+		const __m256 extentZ = _mm256_loadu_ps(&m_extentZ[i]);
+		const __m256 radius = _mm256_loadu_ps(&m_radius[i]);
+
+		__m256 outside = zero;
+		for(int p = 0; p != 6; ++p) {
+			const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalX[p], centerX), _mm256_mul_ps(normalY[p], centerY)),
+			                                             _mm256_mul_ps(normalZ[p], centerZ)), distance[p]);
+			const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(radius, _mm256_mul_ps(absX[p], extentX)), _mm256_mul_ps(absY[p], extentY)),
+			                               _mm256_mul_ps(absZ[p], extentZ));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+		}
+
+		// Store every index, advance only past the visible ones.
+		const int mask = ~_mm256_movemask_ps(outside);
+		for(uint32_t lane = 0; lane != BLOCK_SIZE; ++lane) {
+			visible[visibleCount] = i + lane;
+			visibleCount += (mask >> lane) & 1;
+		}
+	}
+	return visibleCount;
+}
+
+#else
+
+// Not reachable, setPath() only accepts supported paths.
+uint32_t CullingSystem::cullSSE(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const {
+	return cullScalar(frustum, first, end, visible);
+}
+
+uint32_t CullingSystem::cullAVX2(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const {
+	return cullScalar(frustum, first, end, visible);
+}
+
+#endif
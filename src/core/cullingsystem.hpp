@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "frustum.hpp"
+#include "jobsystem.hpp"
+#include "mesh.hpp"
+
+//! Instruction set used by CullingSystem::cull().
+enum class CullingPath {
+	Scalar,
+	SSE,   //! 4 objects per instruction, twice per block of 8
+	AVX2   //! 8 objects per instruction
+};
+
+//! CPU frustum culling for devices without GPU culling (see CullingPass).
+//! Bounds are stored as structure of arrays: One array per component, so a block of 8 objects is tested against a
+//! plane with a few vector instructions instead of 8 dot products. Every object has a center, box extents and a
+//! radius, which covers spheres (zero extents) and axis aligned boxes (zero radius) with the same test.
+//! The fastest path the CPU supports is picked at runtime.
+class CullingSystem {
+public:
+	explicit CullingSystem(CullingPath path = bestPath());
+
+	//! @return Index of the object, reported by cull() if it is visible.
+	uint32_t add(const BoundingSphere& sphere);
+	uint32_t add(const MeshBounds& box);
+	void set(uint32_t object, const BoundingSphere& sphere);
+	void set(uint32_t object, const MeshBounds& box);
+	//! Change the number of objects. New objects are empty spheres at the origin.
+	void resize(uint32_t count);
+	void clear();
+	uint32_t size() const;
+
+	//! Write the indices of the objects that intersect the frustum to visible, in ascending order.
+	//! visible needs room for visibleCapacity() indices: The SIMD paths store a whole block and only advance past
+	//! the visible objects of it, which avoids a branch per object.
+	//! @return Number of visible objects.
+	uint32_t cull(const Frustum& frustum, uint32_t* visible) const;
+	//! Replace the content of visible with the indices of the visible objects.
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+	//! Frustum of a view projection matrix, eg. the one of the frame uniforms.
+	void cull(const glm::mat4& viewProjection, std::vector<uint32_t>& visible) const;
+	//! Cull ranges of objects as jobs, same result as the single threaded overloads.
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible, JobSystem& jobs) const;
+	uint32_t visibleCapacity() const;
+
+	CullingPath path() const;
+	//! Force a path, eg. to compare them. Throws if the CPU does not support it.
+	void setPath(CullingPath path);
+
+	static bool isSupported(CullingPath path);
+	static CullingPath bestPath();
+
+private:
+	//! Arrays are padded to a multiple of BLOCK_SIZE, the padding is never reported.
+	static constexpr uint32_t BLOCK_SIZE = 8;
+	//! Objects per job of the parallel overload.
+	static constexpr uint32_t JOB_SIZE = 16384;
+
+	//! Cull the objects [first, end), both multiples of BLOCK_SIZE.
+	uint32_t cullRange(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const;
+	uint32_t cullScalar(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const;
+	uint32_t cullSSE(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const;
+	uint32_t cullAVX2(const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible) const;
+
+private:
+	CullingPath m_path;
+	uint32_t m_count = 0;
+
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+	std::vector<float> m_radius;
+};
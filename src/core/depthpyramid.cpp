@@ -0,0 +1,253 @@
+#include "depthpyramid.hpp"
+#include "culling.hpp"
+
+#include <algorithm>
+#include <array>
+
+static bool hasStencilComponent(VkFormat format) {
+	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+}
+
+DepthPyramid::DepthPyramid(Device& device, const std::string& pathReduceShader, VkExtent2D depthExtent, uint32_t frameCount)
+	: m_device(device), m_depthExtent(depthExtent) {
+	const glm::uvec2 size = pyramidLevelSize({depthExtent.width, depthExtent.height});
+	m_extent = {size.x, size.y};
+	m_levelCount = pyramidLevelCount({depthExtent.width, depthExtent.height});
+
+	createImage();
+	createDescriptors(frameCount);
+
+	ComputePipelineInfo info{};
+	info.descriptorSetLayouts = {m_setLayout->descriptorSetLayout()};
+	info.pushConstantRanges = {{VK_SHADER_STAGE_COMPUTE_BIT, 0, 4 * sizeof(uint32_t)}};
+	m_pipeline = std::make_unique<ComputePipeline>(m_device, pathReduceShader, info);
+}
+
+DepthPyramid::~DepthPyramid() {
+	vkDestroySampler(m_device.device(), m_sampler, nullptr);
+	for(VkImageView level : m_levels) {
+		vkDestroyImageView(m_device.device(), level, nullptr);
+	}
+	vkDestroyImageView(m_device.device(), m_view, nullptr);
+	vkDestroyImage(m_device.device(), m_image, nullptr);
+	m_device.allocator().free(m_imageMemory);
+}
+
+VkDescriptorImageInfo DepthPyramid::descriptorInfo() const {
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = m_sampler;
+	imageInfo.imageView = m_view;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	return imageInfo;
+}
+
+VkExtent2D DepthPyramid::extent() const {
+	return m_extent;
+}
+
+VkExtent2D DepthPyramid::depthExtent() const {
+	return m_depthExtent;
+}
+
+uint32_t DepthPyramid::levelCount() const {
+	return m_levelCount;
+}
+
+bool DepthPyramid::isBuilt() const {
+	return m_built;
+}
+
+void DepthPyramid::createImage() {
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent = {m_extent.width, m_extent.height, 1};
+	imageInfo.mipLevels = m_levelCount;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = VK_FORMAT_R32_SFLOAT;  // Storage image support is required for this format
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if(vkCreateImage(m_device.device(), &imageInfo, nullptr, &m_image) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create depth pyramid image!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(m_device.device(), m_image, &memRequirements);
+	m_imageMemory = m_device.allocator().allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+	vkBindImageMemory(m_device.device(), m_image, m_imageMemory.memory, m_imageMemory.offset);
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = m_image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = VK_FORMAT_R32_SFLOAT;
+	viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_levelCount, 0, 1};
+	if(vkCreateImageView(m_device.device(), &viewInfo, nullptr, &m_view) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create depth pyramid image view!");
+	}
+
+	m_levels.resize(m_levelCount);
+	for(uint32_t level = 0; level != m_levelCount; ++level) {
+		viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+		if(vkCreateImageView(m_device.device(), &viewInfo, nullptr, &m_levels[level]) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create depth pyramid image view!");
+		}
+	}
+
+	// Texels are read with texelFetch, the sampler only has to exist.
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = static_cast<float>(m_levelCount);
+	if(vkCreateSampler(m_device.device(), &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create depth pyramid sampler!");
+	}
+
+	// The image stays in the general layout for its whole life.
+	VkCommandBuffer commandBuffer = m_device.beginSingleTimeCommands();
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = m_image;
+	barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_levelCount, 0, 1};
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+	                     0, nullptr, 0, nullptr, 1, &barrier);
+
+	m_device.endSingleTimeCommands(commandBuffer);
+}
+
+void DepthPyramid::createDescriptors(uint32_t frameCount) {
+	m_setLayout = DescriptorSetLayout::Builder(m_device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)  // Source
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)          // Destination
+			.build();
+
+	const uint32_t setCount = frameCount + m_levelCount - 1;
+	m_pool = DescriptorPool::Builder(m_device)
+			.setMaxSets(setCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount)
+			.build();
+
+	// The depth attachment is written into the sets of the frames by build().
+	m_depthSets.resize(frameCount);
+	for(VkDescriptorSet& set : m_depthSets) {
+		if(!m_pool->allocateDescriptorSet(m_setLayout->descriptorSetLayout(), set)) {
+			throw std::runtime_error("Failed to allocate depth pyramid descriptor set!");
+		}
+	}
+
+	m_levelSets.resize(m_levelCount - 1);
+	for(uint32_t level = 1; level != m_levelCount; ++level) {
+		VkDescriptorImageInfo sourceInfo{m_sampler, m_levels[level - 1], VK_IMAGE_LAYOUT_GENERAL};
+		VkDescriptorImageInfo destinationInfo{VK_NULL_HANDLE, m_levels[level], VK_IMAGE_LAYOUT_GENERAL};
+
+		if(!DescriptorWriter(*m_setLayout, *m_pool)
+				.writeImage(0, &sourceInfo)
+				.writeImage(1, &destinationInfo)
+				.build(m_levelSets[level - 1])) {
+			throw std::runtime_error("Failed to allocate depth pyramid descriptor set!");
+		}
+	}
+}
+
+void DepthPyramid::levelBarrier(VkCommandBuffer commandBuffer, uint32_t level) {
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = m_image;
+	barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+	                     0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void DepthPyramid::build(VkCommandBuffer commandBuffer, uint32_t frame, const DepthAttachment& depth) {
+	if(depth.extent.width != m_depthExtent.width || depth.extent.height != m_depthExtent.height) {
+		throw std::runtime_error("Failed to build depth pyramid, the size of the depth attachment changed!");
+	}
+
+	// The set of the frame is not in use anymore, its fence is signaled.
+	VkDescriptorImageInfo depthInfo{m_sampler, depth.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+	VkDescriptorImageInfo levelInfo{VK_NULL_HANDLE, m_levels[0], VK_IMAGE_LAYOUT_GENERAL};
+	DescriptorWriter(*m_setLayout, *m_pool)
+			.writeImage(0, &depthInfo)
+			.writeImage(1, &levelInfo)
+			.overwrite(m_depthSets[frame]);
+
+	const VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencilComponent(depth.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+
+	// Depth writes of the render pass before the reduction reads them.
+	// Reads of the culling before the pyramid is overwritten.
+	std::array<VkImageMemoryBarrier, 2> barriers{};
+	barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].image = depth.image;
+	barriers[0].subresourceRange = {depthAspect, 0, 1, 0, 1};
+	barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[1].image = m_image;
+	barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_levelCount, 0, 1};
+	barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+	                     static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	// One dispatch per level, each reads the level before. The barriers also make the pyramid visible to the next culling.
+	m_pipeline->bind(commandBuffer);
+	VkExtent2D source = m_depthExtent;
+	VkExtent2D size = m_extent;
+	for(uint32_t level = 0; level != m_levelCount; ++level) {
+		m_pipeline->bindDescriptorSet(commandBuffer, level == 0 ? m_depthSets[frame] : m_levelSets[level - 1]);
+
+		const uint32_t sizes[4] = {source.width, source.height, size.width, size.height};
+		m_pipeline->pushConstants(commandBuffer, 0, sizeof(sizes), sizes);
+		m_pipeline->dispatch(commandBuffer, size.width, size.height);
+		levelBarrier(commandBuffer, level);
+
+		source = size;
+		size = {std::max((size.width + 1) / 2, 1u), std::max((size.height + 1) / 2, 1u)};
+	}
+
+	// Back to the layout the render pass leaves it in. Its next use clears it.
+	VkImageMemoryBarrier depthBarrier = barriers[0];
+	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0,
+	                     0, nullptr, 0, nullptr, 1, &depthBarrier);
+
+	m_built = true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "device.hpp"
+#include "descriptor.hpp"
+#include "computepipeline.hpp"
+#include "swapchain.hpp"
+
+//! Hierarchical depth (Hi-Z) of a depth attachment for occlusion culling, built on the GPU with depthreduce.comp.
+//! R32 image with a full mip chain: Level 0 has half the size of the depth attachment, every texel of a level holds
+//! the farthest depth of the texels it covers in the level below. Matches buildDepthPyramid() of culling.hpp.
+//! The image stays in VK_IMAGE_LAYOUT_GENERAL, it is written with image stores and read with texelFetch.
+class DepthPyramid {
+public:
+	//! @param pathReduceShader SPIR-V of depthreduce.comp.
+	//! @param depthExtent Size of the depth attachment. Create a new pyramid if it changes.
+	//! @param frameCount Number of frames in flight, the depth attachment is bound once per frame.
+	DepthPyramid(Device& device, const std::string& pathReduceShader, VkExtent2D depthExtent, uint32_t frameCount);
+	~DepthPyramid();
+
+	DepthPyramid(const DepthPyramid&) = delete;
+	DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+	//! Record the reduction of the depth attachment. Call after the render pass that wrote it.
+	//! The depth attachment is read in DEPTH_STENCIL_READ_ONLY_OPTIMAL and left in DEPTH_STENCIL_ATTACHMENT_OPTIMAL.
+	//! The fence of the frame has to be signaled.
+	void build(VkCommandBuffer commandBuffer, uint32_t frame, const DepthAttachment& depth);
+
+	//! Sampler and view of all levels to read the pyramid in compute shaders.
+	VkDescriptorImageInfo descriptorInfo() const;
+	VkExtent2D extent() const;       //! Size of level 0
+	VkExtent2D depthExtent() const;  //! Size of the depth attachment it was created for
+	uint32_t levelCount() const;
+	//! True once build() was recorded; Before that the content is undefined.
+	bool isBuilt() const;
+
+private:
+	void createImage();
+	void createDescriptors(uint32_t frameCount);
+
+	// Barrier for the level that was just written, so the next dispatch can read it.
+	void levelBarrier(VkCommandBuffer commandBuffer, uint32_t level);
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	VkExtent2D m_depthExtent;
+	VkExtent2D m_extent;
+	uint32_t m_levelCount;
+	bool m_built = false;
+
+	VkImage m_image;
+	MemoryAllocation m_imageMemory;
+	VkImageView m_view;                 //! All levels, read by the culling
+	std::vector<VkImageView> m_levels;  //! One view per level, written by the reduction
+	VkSampler m_sampler;
+
+	std::unique_ptr<DescriptorSetLayout> m_setLayout;
+	std::unique_ptr<DescriptorPool> m_pool;
+	std::vector<VkDescriptorSet> m_depthSets;  //! Depth attachment to level 0, one per frame in flight
+	std::vector<VkDescriptorSet> m_levelSets;  //! Level i - 1 to level i for every i > 0, at index i - 1
+	std::unique_ptr<ComputePipeline> m_pipeline;
+};
@@ -1,18 +1,33 @@
 #include "device.hpp"
+#include "staging.hpp"
+#include "pipelinecache.hpp"
 
+#include <iostream>
 #include <set>
 
-Device::Device(Window& window) : m_window(window) {
+Device::Device(Window& window) : m_window(&window) {
+	init();
+}
+
+Device::Device() : m_window(nullptr) {
+	init();
+}
+
+void Device::init() {
 	createVulkanInstance();
-	createSurface();
+	if(m_window) {
+		createSurface();
+	}
 	pickPhysicalDevice();
 	createLogicalDevice();
 	createCommandPool();
+	m_allocator = std::make_unique<MemoryAllocator>(*this);
+	m_stagingRing = std::make_unique<StagingRing>(*this);
+	m_pipelineCache = std::make_unique<PipelineCache>(*this);
+}
 
-	// Check validation layers
-	if(m_enableValidationLayers && !checkValidationLayerSupport()) {
-		throw std::runtime_error("Validation layers requested but not available!");
-	}
+bool Device::isHeadless() const {
+	return m_window == nullptr;
 }
 
 bool Device::validationLayersEnabled() const {
@@ -43,6 +58,46 @@ VkQueue Device::presentQueue() const {
 	return m_presentQueue;
 }
 
+VkQueue Device::transferQueue() const {
+	return m_transferQueue;
+}
+
+VkCommandPool Device::transferCommandPool() const {
+	return m_transferCommandPool != VK_NULL_HANDLE ? m_transferCommandPool : m_commandPool;
+}
+
+MemoryAllocator& Device::allocator() {
+	return *m_allocator;
+}
+
+StagingRing& Device::stagingRing() {
+	return *m_stagingRing;
+}
+
+PipelineCache& Device::pipelineCache() {
+	return *m_pipelineCache;
+}
+
+const VkPhysicalDeviceFeatures& Device::enabledFeatures() const {
+	return m_enabledFeatures;
+}
+
+PFN_vkCmdDrawIndexedIndirectCountKHR Device::drawIndexedIndirectCount() const {
+	return m_drawIndexedIndirectCount;
+}
+
+float Device::timestampPeriod() const {
+	return m_timestampPeriod;
+}
+
+uint32_t Device::timestampValidBits() const {
+	return m_timestampValidBits;
+}
+
+uint32_t Device::transferTimestampValidBits() const {
+	return m_transferTimestampValidBits;
+}
+
 void Device::createVulkanInstance() {
 	// App Info
 	VkApplicationInfo appInfo{};
@@ -58,11 +113,18 @@ void Device::createVulkanInstance() {
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	createInfo.pApplicationInfo = &appInfo;
 
+	// A headless instance needs no surface extensions: GLFW is not initialized on machines without a display.
 	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	const char** glfwExtensions = m_window ? glfwGetRequiredInstanceExtensions(&glfwExtensionCount) : nullptr;
 	createInfo.enabledExtensionCount = glfwExtensionCount;
 	createInfo.ppEnabledExtensionNames = glfwExtensions;
 
+	// Debug builds validate where the layers are installed. CI images with lavapipe often lack them.
+	if(m_enableValidationLayers && !checkValidationLayerSupport()) {
+		std::cerr << "Validation layers requested but not available, continuing without them\n";
+		m_enableValidationLayers = false;
+	}
+
 	if(m_enableValidationLayers) {
 		createInfo.enabledLayerCount = static_cast<uint32_t>(m_validationLayers.size());
 		createInfo.ppEnabledLayerNames = m_validationLayers.data();
@@ -92,7 +154,7 @@ void Device::createVulkanInstance() {
 
 void Device::createSurface() {
 	// Could also be done using vulkan but would be platform specific. GLFM calls the appropriate platform specific function from vulkan.
-	if(glfwCreateWindowSurface(m_instance, m_window.handle(), nullptr, &m_surface) != VK_SUCCESS) {
+	if(glfwCreateWindowSurface(m_instance, m_window->handle(), nullptr, &m_surface) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create window surface");
 	}
 }
@@ -122,11 +184,15 @@ void Device::pickPhysicalDevice() {
 }
 
 void Device::createLogicalDevice() {
-	QueueFamilyIndices indices = findQueueFamilies();
+	m_queueFamilies = findQueueFamilies(m_physicalDevice);
+	const QueueFamilyIndices& indices = m_queueFamilies;
 
 	// Queue Create Info for every queue
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+	std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.transferFamily.value()};
+	if(indices.presentFamily.has_value()) {
+		uniqueQueueFamilies.insert(indices.presentFamily.value());
+	}
 
 	float queuePriority = 1.0f;
 	for(uint32_t queueFamily : uniqueQueueFamilies) {
@@ -140,18 +206,34 @@ void Device::createLogicalDevice() {
 	}
 
 	// Device Features
-	VkPhysicalDeviceFeatures deviceFeatures{};
-	deviceFeatures.samplerAnisotropy = VK_TRUE;
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+
+	m_enabledFeatures = {};
+	m_enabledFeatures.samplerAnisotropy = VK_TRUE;
+	m_enabledFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;  // Optional, textures fall back to uncompressed formats
+	m_enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;                // Optional, indirect draws fall back to one call per draw
+	m_enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+	std::vector<const char*> extensions;
+	if(!isHeadless()) {
+		extensions = m_deviceExtensions;
+	}
+	for(const char* extension : m_optionalDeviceExtensions) {
+		if(isExtensionSupported(m_physicalDevice, extension)) {
+			extensions.push_back(extension);
+		}
+	}
 
 	// Logical device create info
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
-	createInfo.pEnabledFeatures = &deviceFeatures;
+	createInfo.pEnabledFeatures = &m_enabledFeatures;
 
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
 
 	// This is not needed for a logical device anymore but specified for backwards compatibility
 	if(m_enableValidationLayers) {
@@ -166,7 +248,29 @@ void Device::createLogicalDevice() {
 	}
 
 	vkGetDeviceQueue(m_device, indices.graphicsFamily.value(), 0, &m_graphicsQueue);
-	vkGetDeviceQueue(m_device, indices.presentFamily.value(), 0, &m_presentQueue);
+	if(indices.presentFamily.has_value()) {
+		vkGetDeviceQueue(m_device, indices.presentFamily.value(), 0, &m_presentQueue);
+	}
+	vkGetDeviceQueue(m_device, indices.transferFamily.value(), 0, &m_transferQueue);
+
+	if(isExtensionSupported(m_physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+		m_drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(m_device, "vkCmdDrawIndexedIndirectCountKHR"));
+	}
+
+	// Timestamps: A period of 0 or no valid bits means the GPU can not be profiled.
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+	m_timestampPeriod = properties.limits.timestampPeriod;
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+	m_timestampValidBits = queueFamilies[indices.graphicsFamily.value()].timestampValidBits;
+	const VkQueueFamilyProperties& transferFamily = queueFamilies[indices.transferFamily.value()];
+	if(transferFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) {
+		m_transferTimestampValidBits = transferFamily.timestampValidBits;
+	}
 }
 
 bool Device::isDeviceSuitable(VkPhysicalDevice device) const {
@@ -184,20 +288,20 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device) const {
 
 	// Device is ok if it has a queue family that supports our required commands.
 	QueueFamilyIndices indices = findQueueFamilies(device);
-	const bool extensionsSupported = checkDeviceExtensionSupport(device);
+	const bool extensionsSupported = isHeadless() || checkDeviceExtensionSupport(device);
 
 	// Check if the device supports anisotropy; NOTE: We could also just disable anisotropy..
 	VkPhysicalDeviceFeatures supportedFeatures;
 	vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-	// Check if swap chain is ok
-	bool swapChainAdequate = false;
-	if(extensionsSupported) {
+	// Check if swap chain is ok, a headless device renders without one
+	bool swapChainAdequate = isHeadless();
+	if(extensionsSupported && !isHeadless()) {
 		SwapChainSupportDetails swapChainSupport = getSwapChainSupport(device);
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
 
-	return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+	return indices.isComplete(!isHeadless()) && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
 }
 
 bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) const {
@@ -216,8 +320,23 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) const {
 	return requiredExtensions.empty();
 }
 
-QueueFamilyIndices Device::findQueueFamilies() const {
-	return findQueueFamilies(m_physicalDevice);
+bool Device::isExtensionSupported(VkPhysicalDevice device, const char* extension) const {
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+	for(const auto& properties : availableExtensions) {
+		if(strcmp(properties.extensionName, extension) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const QueueFamilyIndices& Device::findQueueFamilies() const {
+	return m_queueFamilies;
 }
 
 QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) const {
@@ -232,7 +351,9 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) const {
 	for (const auto& queueFamily : queueFamilies) {
 		// Check if the queue family supports presenting to our surface
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &presentSupport);
+		if(m_surface != VK_NULL_HANDLE) {
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &presentSupport);
+		}
 		if(presentSupport) {
 			indices.presentFamily = i;
 		}
@@ -244,13 +365,30 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) const {
 
 		// TODO: Preferably explicitly check for *one* queue family that supports both -> slightly better performance
 		//   - This will probably already be the case but it's not a rule right now. (p. 75)
-		if(indices.isComplete()) {
+		if(indices.isComplete(!isHeadless())) {
 			break;
 		}
 
 		++i;
 	}
 
+	// Prefer a transfer only family: Copies on it run on the DMA engine next to rendering instead of in between.
+	// Uploads copy images in chunks of rows, which needs a transfer granularity of single texels.
+	for(uint32_t j = 0; j != queueFamilyCount; ++j) {
+		const VkQueueFlags flags = queueFamilies[j].queueFlags;
+		const VkExtent3D granularity = queueFamilies[j].minImageTransferGranularity;
+		const bool texelGranularity = granularity.width == 1 && granularity.height == 1 && granularity.depth == 1;
+		if((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && texelGranularity) {
+			indices.transferFamily = j;
+			if(!(flags & VK_QUEUE_COMPUTE_BIT)) {
+				break;  // Pure transfer family, compute families might be used for async compute
+			}
+		}
+	}
+	if(!indices.transferFamily.has_value()) {
+		indices.transferFamily = indices.graphicsFamily;
+	}
+
 	return indices;
 }
 
@@ -304,7 +442,7 @@ bool Device::checkValidationLayerSupport() const {
 }
 
 void Device::createCommandPool() {
-	QueueFamilyIndices queueFamilyIndices = findQueueFamilies();
+	const QueueFamilyIndices& queueFamilyIndices = findQueueFamilies();
 
 	VkCommandPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -314,6 +452,16 @@ void Device::createCommandPool() {
 	if(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create command pool!");
 	}
+
+	if(queueFamilyIndices.hasDedicatedTransfer()) {
+		// Upload command buffers are recorded once and freed after the copy finished.
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.transferFamily.value();
+
+		if(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_transferCommandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create transfer command pool!");
+		}
+	}
 }
 
 uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
@@ -330,8 +478,14 @@ uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
 	throw std::runtime_error("Failed to find suitable memory type!");
 }
 
+bool Device::isFormatSupported(VkFormat format, VkFormatFeatureFlags features) const {
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &properties);
+	return (properties.optimalTilingFeatures & features) == features;
+}
+
 void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-                          VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+                          VkBuffer& buffer, MemoryAllocation& bufferMemory)
 {
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -346,17 +500,10 @@ void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
 	VkMemoryRequirements memRequirements;
 	vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-	// NOTE: Use a custom memory allocator in larger applications! This is only ok for small memory areas. (p.177, Conclusion)
-	if(vkAllocateMemory(m_device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to allocate vertex buffer memory!");
-	}
+	// Sub allocate from a larger block instead of calling vkAllocateMemory for every buffer. (p.177, Conclusion)
+	bufferMemory = m_allocator->allocate(memRequirements, properties, true);
 
-	vkBindBufferMemory(m_device, buffer, bufferMemory, 0);
+	vkBindBufferMemory(m_device, buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
 void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
@@ -396,17 +543,34 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(m_graphicsQueue);
+	// Wait for this submission only instead of draining the whole queue.
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	VkFence fence;
+	if(vkCreateFence(m_device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create fence!");
+	}
+
+	vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, fence);
+	vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
 
+	vkDestroyFence(m_device, fence, nullptr);
 	vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
 }
 
 
 
 Device::~Device() {
-	vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+	if(m_surface != VK_NULL_HANDLE) {
+		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+	}
 	vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+	if(m_transferCommandPool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(m_device, m_transferCommandPool, nullptr);
+	}
+	m_pipelineCache.reset();  // Saves the cache to disk
+	m_stagingRing.reset();
+	m_allocator.reset();
 	vkDestroyDevice(m_device, nullptr);
 
 	vkDestroyInstance(m_instance, nullptr);
@@ -3,8 +3,13 @@
 #include <vulkan/vulkan.hpp>
 #include <vector>
 #include <optional>
+#include <memory>
 
 #include "window.hpp"
+#include "memory.hpp"
+
+class StagingRing;
+class PipelineCache;
 
 struct SwapChainSupportDetails {
 	VkSurfaceCapabilitiesKHR capabilities;       // min/max number images, min/max size image, etc
@@ -16,39 +21,69 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily;
+	//! Transfer only family if available (DMA engine) and it copies images at single texel granularity, otherwise the graphics family.
+	std::optional<uint32_t> transferFamily;
+
+	bool hasDedicatedTransfer() const {
+		return transferFamily.has_value() && transferFamily != graphicsFamily;
+	}
 
-	bool isComplete() {
-		return graphicsFamily.has_value() && presentFamily.has_value();
+	//! @param needsPresent False for a headless device, which has no surface to present to.
+	bool isComplete(bool needsPresent = true) const {
+		return graphicsFamily.has_value() && (presentFamily.has_value() || !needsPresent);
 	}
 };
 
 class Device {
 public:
 	Device(Window& window);
+	//! Headless device without a surface and present queue, eg. for servers without a display. Render into a RenderTarget.
+	Device();
 	~Device();
 
+	bool isHeadless() const;
+
 	VkDevice device() const;
-	VkSurfaceKHR surface() const;
+	VkSurfaceKHR surface() const;               //! VK_NULL_HANDLE for a headless device.
 	VkPhysicalDevice physicalDevice() const;
 	VkCommandPool commandPool() const;
 	VkQueue graphicsQueue() const;
-	VkQueue presentQueue() const;
+	VkQueue presentQueue() const;               //! VK_NULL_HANDLE for a headless device.
+	VkQueue transferQueue() const;              //! Same as graphicsQueue() without a dedicated transfer family.
+	VkCommandPool transferCommandPool() const;  //! Same as commandPool() without a dedicated transfer family.
+	MemoryAllocator& allocator();
+	StagingRing& stagingRing();  //! Shared staging memory for all uploads.
+	PipelineCache& pipelineCache();  //! Pass to every vkCreate*Pipelines call.
+	const VkPhysicalDeviceFeatures& enabledFeatures() const;  //! Features enabled on the logical device.
+	//! vkCmdDrawIndexedIndirectCountKHR if VK_KHR_draw_indirect_count is supported, nullptr otherwise.
+	PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount() const;
+	//! Nanoseconds per timestamp tick.
+	float timestampPeriod() const;
+	//! Valid bits of timestamps written on the graphics queue, 0 if it does not support timestamps.
+	uint32_t timestampValidBits() const;
+	//! Valid bits of timestamps written on the transfer queue, 0 if it does not support timestamps. Also 0 for a pure
+	//! transfer family: It can not reset queries, and Vulkan 1.0 has no host reset.
+	uint32_t transferTimestampValidBits() const;
 
 	bool validationLayersEnabled() const;
 
-	QueueFamilyIndices findQueueFamilies() const;                        //! Use selected physical device.
+	const QueueFamilyIndices& findQueueFamilies() const;                 //! Of the selected physical device, queried once.
 	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const; //! Use any device.
 
 	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+	//! True if images with optimal tiling support all of the features in this format.
+	bool isFormatSupported(VkFormat format, VkFormatFeatureFlags features) const;
 	SwapChainSupportDetails getSwapChainSupport(VkPhysicalDevice device) const;
 
-	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+	//! Create a buffer and bind it to memory of the device allocator. Free the memory with allocator().free().
+	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferMemory);
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
 	VkCommandBuffer beginSingleTimeCommands();
 	void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
 private:
+	void init();
 	void createVulkanInstance();
 	void createSurface();
 
@@ -58,27 +93,42 @@ private:
 
 	bool isDeviceSuitable(VkPhysicalDevice device) const;
 	bool checkDeviceExtensionSupport(VkPhysicalDevice device) const;
+	bool isExtensionSupported(VkPhysicalDevice device, const char* extension) const;
 	bool checkValidationLayerSupport() const;
 
 private:
 #ifdef NDEBUG
-	const bool m_enableValidationLayers = false;
+	bool m_enableValidationLayers = false;
 #else
-	const bool m_enableValidationLayers = true;
+	bool m_enableValidationLayers = true;  //! Turned off if the layers are not installed
 #endif
 
-	Window& m_window; // Not owned by this class
+	Window* m_window; // Not owned by this class, nullptr for a headless device
 
 	VkInstance m_instance;
 	VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
 	VkDevice m_device;
+	VkPhysicalDeviceFeatures m_enabledFeatures{};
 
 	VkQueue m_graphicsQueue;
-	VkQueue m_presentQueue;
+	VkQueue m_presentQueue = VK_NULL_HANDLE;
+	VkQueue m_transferQueue;
+	QueueFamilyIndices m_queueFamilies;
 
 	VkCommandPool m_commandPool;
-	VkSurfaceKHR m_surface;
+	VkCommandPool m_transferCommandPool = VK_NULL_HANDLE;  //! Only created for a dedicated transfer family.
+	VkSurfaceKHR m_surface = VK_NULL_HANDLE;
+
+	std::unique_ptr<MemoryAllocator> m_allocator;
+	std::unique_ptr<StagingRing> m_stagingRing;
+	std::unique_ptr<PipelineCache> m_pipelineCache;
+
+	PFN_vkCmdDrawIndexedIndirectCountKHR m_drawIndexedIndirectCount = nullptr;
+	float m_timestampPeriod = 0.0f;
+	uint32_t m_timestampValidBits = 0;
+	uint32_t m_transferTimestampValidBits = 0;
 
-	const std::vector<const char*> m_deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+	const std::vector<const char*> m_deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};  //! Not required by a headless device
+	const std::vector<const char*> m_optionalDeviceExtensions = {VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME};  //! Enabled if supported
 	const std::vector<const char*> m_validationLayers = {"VK_LAYER_KHRONOS_validation"};
 };
@@ -0,0 +1,93 @@
+#include "file.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	if(!file.is_open()) {
+		throw std::runtime_error("Failed to open file!");
+	}
+
+	m_buffer.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(m_buffer.data(), m_buffer.size());
+
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		throw std::runtime_error("Failed to open file!");
+	}
+
+	struct stat status{};
+	if(fstat(fd, &status) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to open file!");
+	}
+	m_size = static_cast<size_t>(status.st_size);
+
+	// Mapping an empty file is not allowed.
+	if(m_size != 0) {
+		void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapped == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("Failed to map file!");
+		}
+
+		// Files are read front to back -> Let the kernel read ahead aggressively.
+		madvise(mapped, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(mapped);
+	}
+
+	// The mapping keeps its own reference to the file.
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if(m_data) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+}
+
+#endif
+
+const char* MappedFile::data() const {
+	return m_data;
+}
+
+size_t MappedFile::size() const {
+	return m_size;
+}
+
+std::filesystem::path temporaryPath(const std::filesystem::path& path) {
+	static std::atomic<uint64_t> s_counter{0};
+#ifdef _WIN32
+	const int process = _getpid();
+#else
+	const pid_t process = getpid();
+#endif
+
+	std::filesystem::path tempPath = path;
+	tempPath += "." + std::to_string(process) + "." + std::to_string(s_counter.fetch_add(1)) + ".tmp";
+	return tempPath;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//! Read only memory mapping of a whole file. The OS pages the file in on access, no copy into the heap is made.
+//! Falls back to reading the file into memory on platforms without mmap.
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data() const;
+	size_t size() const;
+
+private:
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	std::vector<char> m_buffer;
+#endif
+};
+
+//! Name of a temporary file next to path, for writing a file and renaming it into place. Unique per process and
+//! call, so writers in other threads or other processes sharing the directory never truncate each other's file.
+std::filesystem::path temporaryPath(const std::filesystem::path& path);
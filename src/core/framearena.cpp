@@ -0,0 +1,42 @@
+#include "framearena.hpp"
+
+#include <algorithm>
+
+FrameArena::FrameArena(Device& device, uint32_t frameCount, VkDeviceSize sizePerFrame) : m_capacity(sizePerFrame) {
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.physicalDevice(), &properties);
+	m_alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+
+	m_buffers = createFrameBuffers(device, frameCount, sizePerFrame, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+}
+
+void FrameArena::beginFrame(uint32_t frame) {
+	m_frame = frame;
+	m_head = 0;
+}
+
+FrameAllocation FrameArena::allocate(VkDeviceSize size) {
+	// The alignment is a power of two (Vulkan spec).
+	const VkDeviceSize offset = (m_head + m_alignment - 1) & ~(m_alignment - 1);
+	if(offset + size > m_capacity) {
+		throw std::runtime_error("Failed to allocate from frame arena, the frame is full!");
+	}
+	m_head = offset + size;
+
+	FrameAllocation allocation;
+	allocation.mapped = static_cast<char*>(m_buffers[m_frame]->getMappedMemory()) + offset;
+	allocation.offset = static_cast<uint32_t>(offset);
+	return allocation;
+}
+
+VkDescriptorBufferInfo FrameArena::descriptorInfo(uint32_t frame, VkDeviceSize range) const {
+	return m_buffers[frame]->descriptorInfo(range, 0);
+}
+
+VkDeviceSize FrameArena::capacity() const {
+	return m_capacity;
+}
+
+VkDeviceSize FrameArena::usedBytes() const {
+	return m_head;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "buffer.hpp"
+
+//! Part of the frame arena handed out for one object.
+struct FrameAllocation {
+	void* mapped = nullptr;  //! Host pointer to the start of the allocation.
+	uint32_t offset = 0;     //! Dynamic offset for vkCmdBindDescriptorSets.
+};
+
+//! Linear allocator for data that is only used by one frame, eg. per object uniforms.
+//! Every frame in flight owns a persistently mapped buffer. Allocations move a bump pointer through the buffer of
+//! the current frame and are reset at the start of the frame, so writing data costs a memcpy and nothing else.
+//!
+//! Bind the buffer of a frame once as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC and select the allocation of an
+//! object with its dynamic offset: Any number of objects share one descriptor set per frame.
+class FrameArena {
+public:
+	static constexpr VkDeviceSize DEFAULT_SIZE = 4ull * 1024 * 1024;
+
+	//! @param frameCount Number of frames in flight, one buffer is created for each.
+	//! @param sizePerFrame Capacity of every buffer.
+	FrameArena(Device& device, uint32_t frameCount, VkDeviceSize sizePerFrame = DEFAULT_SIZE);
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	//! Start handing out memory of this frame. The fence of the frame has to be signaled, the GPU is done reading.
+	void beginFrame(uint32_t frame);
+
+	//! Reserve memory in the current frame, aligned to minUniformBufferOffsetAlignment.
+	//! Throws if the buffer of the frame is full.
+	FrameAllocation allocate(VkDeviceSize size);
+
+	//! Copy the value into the current frame.
+	//! @return Dynamic offset of the value.
+	template<typename T>
+	uint32_t push(const T& value) {
+		const FrameAllocation allocation = allocate(sizeof(T));
+		memcpy(allocation.mapped, &value, sizeof(T));
+		return allocation.offset;
+	}
+
+	//! Descriptor for a dynamic uniform buffer binding of the frame.
+	//! @param range Size of the data one dynamic offset points to, eg. sizeof the uniform block.
+	VkDescriptorBufferInfo descriptorInfo(uint32_t frame, VkDeviceSize range) const;
+
+	VkDeviceSize capacity() const;
+	VkDeviceSize usedBytes() const;  //! Bytes allocated in the current frame, including alignment padding.
+
+private:
+	std::vector<std::unique_ptr<Buffer>> m_buffers;  //! One per frame in flight
+	VkDeviceSize m_capacity;
+	VkDeviceSize m_alignment;
+
+	uint32_t m_frame = 0;
+	VkDeviceSize m_head = 0;  //! Bump pointer into the buffer of m_frame
+};
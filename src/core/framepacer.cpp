@@ -0,0 +1,102 @@
+#include "framepacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+FramePacer::FramePacer(PresentPolicy policy, uint32_t framesInFlight)
+	: m_policy(policy), m_slack(WINDOW), m_inputTimes(framesInFlight, NONE), m_latencyMs(WINDOW, 0.0) {}
+
+PresentPolicy FramePacer::policy() const {
+	return m_policy;
+}
+
+bool FramePacer::isPacing() const {
+	return m_policy == PresentPolicy::LowestLatency || m_policy == PresentPolicy::PowerSaving;
+}
+
+FramePacer::Clock::duration FramePacer::delay() const {
+	if(!isPacing() || m_slackCount == 0) {
+		return Clock::duration::zero();
+	}
+
+	const auto end = m_slack.begin() + std::min(m_slackCount, WINDOW);
+	const Clock::duration slack = *std::min_element(m_slack.begin(), end);
+	return std::max(slack - SAFETY_MARGIN, Clock::duration::zero());
+}
+
+void FramePacer::wait() {
+	delayApplied(delay());
+	if(m_appliedDelay == Clock::duration::zero()) {
+		return;
+	}
+
+	const Clock::time_point target = Clock::now() + m_appliedDelay;
+	if(m_policy == PresentPolicy::PowerSaving) {
+		std::this_thread::sleep_until(target);
+		return;
+	}
+
+	// Sleeps overshoot by up to the scheduler granularity, the last part is busy waited.
+	if(m_appliedDelay > SPIN_TIME) {
+		std::this_thread::sleep_until(target - SPIN_TIME);
+	}
+	while(Clock::now() < target) {
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::delayApplied(Clock::duration delay) {
+	m_appliedDelay = delay;
+}
+
+void FramePacer::inputSampled(Clock::time_point time) {
+	m_pendingInput = time;
+}
+
+void FramePacer::frameWaited(uint32_t frame, Clock::time_point waitBegin, Clock::time_point waitEnd) {
+	if(isInFlight(frame)) {
+		frameCompleted(frame, waitEnd);
+	}
+	m_recordingInput = m_pendingInput != NONE ? m_pendingInput : waitBegin;
+	m_pendingInput = NONE;
+
+	// A frame that did not block at all may have waited too long before: Back off instead of growing.
+	const Clock::duration blocked = waitEnd - waitBegin;
+	Clock::duration slack = m_appliedDelay + blocked;
+	if(m_appliedDelay > Clock::duration::zero() && blocked < SAFETY_MARGIN / 10) {
+		slack = std::max(m_appliedDelay - SAFETY_MARGIN, Clock::duration::zero());
+	}
+	m_slack[m_slackCount % WINDOW] = slack;
+	++m_slackCount;
+	m_appliedDelay = Clock::duration::zero();
+}
+
+void FramePacer::frameSubmitted(uint32_t frame) {
+	m_inputTimes[frame] = m_recordingInput;
+	m_recordingInput = NONE;
+}
+
+bool FramePacer::isInFlight(uint32_t frame) const {
+	return m_inputTimes[frame] != NONE;
+}
+
+void FramePacer::frameCompleted(uint32_t frame, Clock::time_point time) {
+	const double latencyMs = std::chrono::duration<double, std::milli>(time - m_inputTimes[frame]).count();
+	m_inputTimes[frame] = NONE;
+
+	m_latencyMs[m_latency.frameCount % WINDOW] = latencyMs;
+	++m_latency.frameCount;
+
+	const auto end = m_latencyMs.begin() + std::min<uint64_t>(m_latency.frameCount, WINDOW);
+	double sum = 0.0;
+	for(auto it = m_latencyMs.begin(); it != end; ++it) {
+		sum += *it;
+	}
+	m_latency.lastMs = latencyMs;
+	m_latency.averageMs = sum / static_cast<double>(end - m_latencyMs.begin());
+	m_latency.maxMs = *std::max_element(m_latencyMs.begin(), end);
+}
+
+const FrameLatencyStats& FramePacer::latency() const {
+	return m_latency;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "rendererconfig.hpp"
+
+//! Input to present latency over the last FramePacer::WINDOW frames.
+struct FrameLatencyStats {
+	double lastMs = 0.0;
+	double averageMs = 0.0;
+	double maxMs = 0.0;
+	uint64_t frameCount = 0;  //! Frames measured since the pacer was created.
+};
+
+//! Moves the time the CPU would wait for the GPU in front of input sampling: Input sampled after the wait is that much
+//! younger when the frame is presented. The wait is predicted from the last frames: The shortest recent time the CPU
+//! was blocked on a frame (fence and image acquire), minus a safety margin. Frames that were not blocked at all
+//! shorten the wait again, so a prediction that is too long costs at most a few frames.
+//!
+//! Latency is measured from input sampling to the moment the CPU sees the frame finished on the GPU: The Renderer polls
+//! the fences of the submitted frames whenever it waits for or begins a frame, so the measurement is late by at most
+//! the time between two polls. Without display timing extensions the scanout is not visible, FIFO adds up to one refresh
+//! interval on top. Holds no Vulkan objects, the Renderer reports the frames. Main thread only.
+class FramePacer {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr uint32_t WINDOW = 64;  //! Frames of the prediction and the latency statistics.
+	static constexpr Clock::duration SAFETY_MARGIN = std::chrono::microseconds(1000);
+	static constexpr Clock::duration SPIN_TIME = std::chrono::microseconds(200);  //! Busy waited end of a lowest latency wait.
+
+	FramePacer(PresentPolicy policy, uint32_t framesInFlight);
+
+	PresentPolicy policy() const;
+	//! False for VSync and Uncapped: Frames start as soon as a frame in flight is free.
+	bool isPacing() const;
+
+	//! Time the next frame should wait before sampling input.
+	Clock::duration delay() const;
+	//! Sleep for delay(). Sample input right after.
+	void wait();
+	//! The next frame waited this long before sampling input, eg. with a sleep of its own. Called by wait().
+	void delayApplied(Clock::duration delay);
+
+	//! Input of the next frame was sampled.
+	void inputSampled(Clock::time_point time);
+	//! The CPU waited from waitBegin to waitEnd until it could record the frame: The last frame that used the frame
+	//! index finished at the latest at waitEnd, it is completed then if no poll saw it before.
+	//! Without inputSampled() since the last frame, the input of the new frame counts as sampled at waitBegin.
+	void frameWaited(uint32_t frame, Clock::time_point waitBegin, Clock::time_point waitEnd);
+	//! The frame that was waited for last is submitted under this index.
+	void frameSubmitted(uint32_t frame);
+	//! True if the frame was submitted and is not completed yet: Poll its fence and call frameCompleted().
+	bool isInFlight(uint32_t frame) const;
+	//! The frame was seen finished on the GPU at this time.
+	void frameCompleted(uint32_t frame, Clock::time_point time);
+
+	const FrameLatencyStats& latency() const;
+
+private:
+	static constexpr Clock::time_point NONE{};
+
+	PresentPolicy m_policy;
+
+	Clock::duration m_appliedDelay{0};           //! Wait of the current frame
+	std::vector<Clock::duration> m_slack;        //! Applied delay plus blocked time of the last frames, ring buffer
+	uint32_t m_slackCount = 0;
+
+	Clock::time_point m_pendingInput = NONE;     //! Input of the frame that is not recorded yet
+	Clock::time_point m_recordingInput = NONE;   //! Input of the frame that is recorded, not submitted yet
+	std::vector<Clock::time_point> m_inputTimes; //! Input per frame index of the frames in flight, NONE once completed
+
+	std::vector<double> m_latencyMs;             //! Ring buffer of WINDOW frames
+	FrameLatencyStats m_latency;
+};
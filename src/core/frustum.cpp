@@ -0,0 +1,41 @@
+#include "frustum.hpp"
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection) {
+	// glm is column major: Row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]).
+	const glm::mat4 rows = glm::transpose(viewProjection);
+
+	Frustum frustum{};
+	frustum.planes[0] = rows[3] + rows[0];  // Left:   -w <= x
+	frustum.planes[1] = rows[3] - rows[0];  // Right:   x <= w
+	frustum.planes[2] = rows[3] + rows[1];  // Bottom: -w <= y
+	frustum.planes[3] = rows[3] - rows[1];  // Top:     y <= w
+	frustum.planes[4] = rows[2];            // Near:    0 <= z
+	frustum.planes[5] = rows[3] - rows[2];  // Far:     z <= w
+
+	for(glm::vec4& plane : frustum.planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return frustum;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const {
+	for(const glm::vec4& plane : planes) {
+		if(glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::intersects(const MeshBounds& box) const {
+	for(const glm::vec4& plane : planes) {
+		// Corner of the box farthest along the normal: If it is outside, the whole box is.
+		const glm::vec3 corner{plane.x >= 0.0f ? box.max.x : box.min.x,
+		                       plane.y >= 0.0f ? box.max.y : box.min.y,
+		                       plane.z >= 0.0f ? box.max.z : box.min.z};
+		if(glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
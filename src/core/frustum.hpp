@@ -0,0 +1,21 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+//! View frustum as six planes: Left, right, bottom, top, near and far.
+//! xyz of a plane is its normal pointing inside, w the distance: dot(plane.xyz, point) + plane.w >= 0 for points inside.
+struct Frustum {
+	std::array<glm::vec4, 6> planes;
+
+	//! Extract the planes of a view projection matrix in vulkan clip space, where 0 <= z <= w (Gribb/Hartmann).
+	//! Planes are normalized, so plane distances are in world units.
+	static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+	//! False if the sphere is completely outside of one plane. Spheres close to a corner can pass although they are outside.
+	bool intersects(const BoundingSphere& sphere) const;
+	//! False if the box is completely outside of one plane.
+	bool intersects(const MeshBounds& box) const;
+};
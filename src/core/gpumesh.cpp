@@ -0,0 +1,132 @@
+#include "gpumesh.hpp"
+
+MeshSource loadMeshSource(const std::string& path, JobSystem* jobs) {
+	MeshSource source;
+
+	// Warm start: The cache file is mapped and copied straight into staging memory, no parsing.
+	auto cache = std::make_unique<MeshCache>(path);
+	if(cache->load()) {
+		source.cache = std::move(cache);
+		return source;
+	}
+
+	// Only use unique vertices to save memory.
+	source.mesh = loadObj(path, jobs);
+	cache->store(source.mesh);
+	return source;
+}
+
+const Vertex* MeshSource::vertices() const {
+	return cache ? cache->vertices() : mesh.vertices.data();
+}
+
+uint32_t MeshSource::vertexCount() const {
+	return cache ? cache->vertexCount() : static_cast<uint32_t>(mesh.vertices.size());
+}
+
+const uint32_t* MeshSource::indices() const {
+	return cache ? cache->indices() : mesh.indices.data();
+}
+
+uint32_t MeshSource::indexCount() const {
+	return cache ? cache->indexCount() : static_cast<uint32_t>(mesh.indices.size());
+}
+
+MeshBounds MeshSource::bounds() const {
+	return cache ? cache->bounds() : mesh.bounds;
+}
+
+
+GpuMesh::GpuMesh(Device& device, UploadBatch& upload, const MeshSource& source, MeshPool* meshPool)
+	: m_device(device), m_bounds(source.bounds()), m_boundingSphere(::boundingSphere(m_bounds)), m_meshPool(meshPool)
+{
+	if(m_meshPool) {
+		m_meshRange = m_meshPool->add(upload, source.vertices(), source.vertexCount(), source.indices(), source.indexCount(), m_bounds);
+		return;
+	}
+
+	// We only need the data in GPU memory -> Don't keep a copy in the class.
+	if(source.vertexCount() != 0) {
+		createVertexBuffer(upload, source.vertices(), source.vertexCount());
+		createIndexBuffer(upload, source.indices(), source.indexCount());
+	}
+}
+
+void GpuMesh::createVertexBuffer(UploadBatch& upload, const Vertex* vertices, uint32_t vertexCount) {
+	uint32_t vertexSize = sizeof(Vertex);
+	VkDeviceSize bufferSize = vertexSize * vertexCount;
+
+	m_vertexBuffer = std::make_unique<Buffer>(m_device, vertexSize, vertexCount,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	upload.uploadBuffer(vertices, bufferSize, m_vertexBuffer->getBuffer());
+}
+
+void GpuMesh::createIndexBuffer(UploadBatch& upload, const uint32_t* indices, uint32_t indexCount) {
+	m_hasIndexBuffer = indexCount != 0;
+	if(!m_hasIndexBuffer) {
+		return;
+	}
+
+	uint32_t indexSize = sizeof(uint32_t);
+	VkDeviceSize bufferSize = indexSize * indexCount;
+
+	m_indexBuffer = std::make_unique<Buffer>(m_device, indexSize,indexCount,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	upload.uploadBuffer(indices, bufferSize, m_indexBuffer->getBuffer());
+}
+
+void GpuMesh::bind(VkCommandBuffer commandBuffer) const {
+	if(m_meshPool) {
+		m_meshPool->bind(commandBuffer);
+		return;
+	}
+
+	VkBuffer vertexBuffers[] = {m_vertexBuffer->getBuffer()};
+	VkDeviceSize offsets[] = {0};
+
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+	if(m_hasIndexBuffer) {
+		vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
+}
+
+void GpuMesh::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) const {
+	if(m_meshPool) {
+		vkCmdDrawIndexed(commandBuffer, m_meshRange.indexCount, instanceCount, m_meshRange.firstIndex, m_meshRange.vertexOffset, firstInstance);
+	} else if(m_hasIndexBuffer) {
+		vkCmdDrawIndexed(commandBuffer, m_indexBuffer->getInstanceCount(), instanceCount, 0, 0, firstInstance);
+	} else {
+		vkCmdDraw(commandBuffer, m_vertexBuffer->getInstanceCount(), instanceCount, 0, firstInstance);
+	}
+}
+
+MeshBounds GpuMesh::bounds() const {
+	return m_bounds;
+}
+
+BoundingSphere GpuMesh::boundingSphere() const {
+	return m_boundingSphere;
+}
+
+const MeshRange& GpuMesh::meshRange() const {
+	return m_meshRange;
+}
+
+MeshPool* GpuMesh::meshPool() const {
+	return m_meshPool;
+}
+
+VkDeviceSize GpuMesh::sizeBytes() const {
+	VkDeviceSize size = 0;
+	if(m_vertexBuffer) {
+		size += m_vertexBuffer->getBufferSize();
+	}
+	if(m_indexBuffer) {
+		size += m_indexBuffer->getBufferSize();
+	}
+	return size;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "device.hpp"
+#include "buffer.hpp"
+#include "vertex.hpp"
+#include "upload.hpp"
+#include "mesh.hpp"
+#include "meshcache.hpp"
+#include "meshpool.hpp"
+
+#include <memory>
+#include <string>
+
+//! Vertices and indices of a mesh file on the CPU: Either parsed or mapped from the mesh cache.
+struct MeshSource {
+	MeshData mesh;                     //! Parsed OBJ, empty if the mesh cache was valid.
+	std::unique_ptr<MeshCache> cache;  //! Mapped cache file if it was valid, its blobs are uploaded without a copy.
+
+	const Vertex* vertices() const;
+	uint32_t vertexCount() const;
+	const uint32_t* indices() const;
+	uint32_t indexCount() const;
+	MeshBounds bounds() const;
+};
+
+//! Read the mesh from its cache if valid, parse the OBJ and write the cache otherwise. Thread safe.
+//! @param jobs Parse on all threads of the job system, otherwise on the calling thread.
+MeshSource loadMeshSource(const std::string& path, JobSystem* jobs = nullptr);
+
+//! Vertex and index data of one mesh in GPU memory. Shared by every model drawing the mesh, see AssetCache.
+class GpuMesh {
+public:
+	//! Record the uploads into the batch. The mesh must not be drawn before the batch is complete.
+	//! @param meshPool Upload into the shared buffers of the pool instead of buffers of its own if set.
+	GpuMesh(Device& device, UploadBatch& upload, const MeshSource& source, MeshPool* meshPool = nullptr);
+
+	GpuMesh(const GpuMesh&) = delete;
+	GpuMesh& operator=(const GpuMesh&) = delete;
+
+	void bind(VkCommandBuffer commandBuffer) const;  //! Bind vertices and indices to command buffer.
+	void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;  //! Add draw command to command buffer.
+
+	//! Model space bounding box of the vertices.
+	MeshBounds bounds() const;
+	//! Model space bounding sphere, eg. for culling.
+	BoundingSphere boundingSphere() const;
+	//! Draw arguments in the mesh pool. Only valid for meshes in a mesh pool.
+	const MeshRange& meshRange() const;
+	MeshPool* meshPool() const;
+
+	//! Device memory of the own buffers. Meshes in a pool use memory of the pool and report 0.
+	VkDeviceSize sizeBytes() const;
+
+private:
+	void createVertexBuffer(UploadBatch& upload, const Vertex* vertices, uint32_t vertexCount);
+	void createIndexBuffer(UploadBatch& upload, const uint32_t* indices, uint32_t indexCount);
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	std::unique_ptr<Buffer> m_vertexBuffer;
+	std::unique_ptr<Buffer> m_indexBuffer;
+	bool m_hasIndexBuffer = false;  //! Vertices can also be drawn non indexed.
+	MeshBounds m_bounds;
+	BoundingSphere m_boundingSphere;
+
+	MeshPool* m_meshPool = nullptr;  //! Holds the vertices and indices instead of m_vertexBuffer and m_indexBuffer if set.
+	MeshRange m_meshRange;
+};
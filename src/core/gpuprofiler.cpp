@@ -0,0 +1,194 @@
+#include "gpuprofiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+double timestampDeltaMs(uint64_t begin, uint64_t end, float timestampPeriod, uint32_t validBits) {
+	const uint64_t mask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+	const uint64_t ticks = (end - begin) & mask;
+	return static_cast<double>(ticks) * static_cast<double>(timestampPeriod) / 1e6;
+}
+
+ScopeStatistics::ScopeStatistics(uint32_t history) : m_history(history) {}
+
+void ScopeStatistics::add(const std::string& name, double ms) {
+	auto it = m_index.find(name);
+	if(it == m_index.end()) {
+		it = m_index.emplace(name, m_scopes.size()).first;
+		m_scopes.push_back(History{name, std::vector<double>(m_history, 0.0), 0});
+	}
+	m_frame[it->second] += ms;
+}
+
+void ScopeStatistics::addQueryResults(const char* const* names, const uint64_t* results, uint32_t scopeCount, float timestampPeriod, uint32_t validBits) {
+	for(uint32_t scope = 0; scope != scopeCount; ++scope) {
+		const uint64_t* begin = results + 4 * scope;
+		const uint64_t* end = begin + 2;
+		if(begin[1] != 0 && end[1] != 0) {
+			add(names[scope], timestampDeltaMs(begin[0], end[0], timestampPeriod, validBits));
+		}
+	}
+}
+
+void ScopeStatistics::endFrame() {
+	for(const auto& [scope, ms] : m_frame) {
+		History& history = m_scopes[scope];
+		history.samples[history.count % m_history] = ms;
+		++history.count;
+	}
+	m_frame.clear();
+}
+
+std::vector<GpuScopeStats> ScopeStatistics::statistics() const {
+	std::vector<GpuScopeStats> result;
+	result.reserve(m_scopes.size());
+
+	std::vector<double> sorted;
+	for(const History& history : m_scopes) {
+		sorted.assign(history.samples.begin(), history.samples.begin() + std::min(history.count, m_history));
+		std::sort(sorted.begin(), sorted.end());
+
+		// Nearest rank: The smallest sample that is at least the fraction of all samples.
+		auto percentile = [&sorted](double fraction) {
+			const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+			return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+		};
+
+		GpuScopeStats stats{};
+		stats.name = history.name;
+		stats.sampleCount = static_cast<uint32_t>(sorted.size());
+		if(!sorted.empty()) {
+			double sum = 0.0;
+			for(double ms : sorted) {
+				sum += ms;
+			}
+			stats.averageMs = sum / static_cast<double>(sorted.size());
+			stats.medianMs = percentile(0.5);
+			stats.p95Ms = percentile(0.95);
+			stats.p99Ms = percentile(0.99);
+			stats.maxMs = sorted.back();
+		}
+		result.push_back(stats);
+	}
+	return result;
+}
+
+std::string ScopeStatistics::report() const {
+	std::ostringstream text;
+	text << std::fixed << std::setprecision(3);
+	text << std::left << std::setw(20) << "GPU scope" << std::right
+	     << std::setw(10) << "avg ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+	     << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << "\n";
+	for(const GpuScopeStats& stats : statistics()) {
+		text << std::left << std::setw(20) << stats.name << std::right
+		     << std::setw(10) << stats.averageMs << std::setw(10) << stats.medianMs << std::setw(10) << stats.p95Ms
+		     << std::setw(10) << stats.p99Ms << std::setw(10) << stats.maxMs << "\n";
+	}
+	return text.str();
+}
+
+GpuProfiler::GpuProfiler(Device& device, uint32_t framesInFlight)
+	: m_device(device), m_supported(device.timestampValidBits() != 0 && device.timestampPeriod() > 0.0f),
+	  m_scopeCounts(std::make_unique<std::atomic<uint32_t>[]>(framesInFlight)),
+	  m_names(framesInFlight, std::vector<const char*>(MAX_SCOPES, nullptr)), m_results(4 * MAX_SCOPES)
+{
+	for(uint32_t frame = 0; frame != framesInFlight; ++frame) {
+		m_scopeCounts[frame] = 0;
+	}
+	if(!m_supported) {
+		return;
+	}
+
+	VkQueryPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = framesInFlight * 2 * MAX_SCOPES;  // Begin and end per scope
+
+	if(vkCreateQueryPool(m_device.device(), &poolInfo, nullptr, &m_queryPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create timestamp query pool!");
+	}
+}
+
+bool GpuProfiler::isSupported() const {
+	return m_supported;
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frame) {
+	m_frame = frame;
+	if(!m_supported) {
+		m_statistics.endFrame();  // Times of addScopeTime()
+		return;
+	}
+
+	collect(frame);
+	vkCmdResetQueryPool(commandBuffer, m_queryPool, firstQuery(frame), 2 * MAX_SCOPES);
+	m_frameScope = beginScope(commandBuffer, "Frame");
+}
+
+void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+	endScope(commandBuffer, m_frameScope);
+	m_frameScope = INVALID_SCOPE;
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name) {
+	if(!m_supported) {
+		return INVALID_SCOPE;
+	}
+
+	const uint32_t scope = m_scopeCounts[m_frame].fetch_add(1, std::memory_order_relaxed);
+	if(scope >= MAX_SCOPES) {
+		return INVALID_SCOPE;
+	}
+
+	m_names[m_frame][scope] = name;
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, firstQuery(m_frame) + 2 * scope);
+	return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+	if(scope == INVALID_SCOPE) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, firstQuery(m_frame) + 2 * scope + 1);
+}
+
+void GpuProfiler::addScopeTime(const std::string& name, double ms) {
+	m_statistics.add(name, ms);
+}
+
+std::vector<GpuScopeStats> GpuProfiler::statistics() const {
+	return m_statistics.statistics();
+}
+
+std::string GpuProfiler::report() const {
+	return m_statistics.report();
+}
+
+void GpuProfiler::collect(uint32_t frame) {
+	const uint32_t scopeCount = std::min(m_scopeCounts[frame].exchange(0), MAX_SCOPES);
+	if(scopeCount != 0) {
+		// The fence of the frame is signaled, no VK_QUERY_RESULT_WAIT_BIT needed. A scope whose end was never recorded
+		// (eg. a recording job that threw) is unavailable: VK_NOT_READY, only that scope is skipped.
+		const VkResult result = vkGetQueryPoolResults(m_device.device(), m_queryPool, firstQuery(frame), 2 * scopeCount,
+		                                              4 * scopeCount * sizeof(uint64_t), m_results.data(), 2 * sizeof(uint64_t),
+		                                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if(result == VK_SUCCESS || result == VK_NOT_READY) {
+			m_statistics.addQueryResults(m_names[frame].data(), m_results.data(), scopeCount,
+			                             m_device.timestampPeriod(), m_device.timestampValidBits());
+		}
+	}
+	// Also ends a frame that only has times of addScopeTime().
+	m_statistics.endFrame();
+}
+
+uint32_t GpuProfiler::firstQuery(uint32_t frame) const {
+	return frame * 2 * MAX_SCOPES;
+}
+
+GpuProfiler::~GpuProfiler() {
+	if(m_queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(m_device.device(), m_queryPool, nullptr);
+	}
+}
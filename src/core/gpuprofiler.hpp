@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "device.hpp"
+
+//! GPU time of a named scope over the last frames.
+struct GpuScopeStats {
+	std::string name;
+	double averageMs = 0.0;
+	double medianMs = 0.0;
+	double p95Ms = 0.0;
+	double p99Ms = 0.0;
+	double maxMs = 0.0;
+	uint32_t sampleCount = 0;  //! Frames in the statistics
+};
+
+//! Milliseconds between two timestamps. Only the valid bits are compared, so a counter that wrapped around in between still works.
+double timestampDeltaMs(uint64_t begin, uint64_t end, float timestampPeriod, uint32_t validBits);
+
+//! Rolling per scope statistics of the GpuProfiler, without any Vulkan objects.
+//! Times of a scope that occurs more than once in a frame are summed up.
+class ScopeStatistics {
+public:
+	//! @param history Number of frames the statistics are computed over.
+	explicit ScopeStatistics(uint32_t history);
+
+	//! Add the time of a scope to the current frame.
+	void add(const std::string& name, double ms);
+	//! Add the scopes of a frame read with VK_QUERY_RESULT_WITH_AVAILABILITY_BIT: Per scope the begin and the end
+	//! timestamp, each followed by its availability. Scopes whose begin or end was not written are skipped.
+	void addQueryResults(const char* const* names, const uint64_t* results, uint32_t scopeCount, float timestampPeriod, uint32_t validBits);
+	//! Append the times of the current frame to the history of their scopes.
+	void endFrame();
+
+	//! Scopes in order of their first occurrence.
+	std::vector<GpuScopeStats> statistics() const;
+	//! Text table of statistics(), eg. for the log or an overlay.
+	std::string report() const;
+
+private:
+	struct History {
+		std::string name;
+		std::vector<double> samples;  //! Ring buffer
+		uint32_t count = 0;           //! Samples ever added
+	};
+
+	uint32_t m_history;
+	std::vector<History> m_scopes;
+	std::map<std::string, size_t> m_index;
+	std::map<size_t, double> m_frame;  //! Scope index -> time in the current frame
+};
+
+//! Measures GPU time of named scopes with timestamp queries. Results are read when a frame index is reused: Its fence
+//! was waited for, so the results are available and reading them never stalls. Statistics lag frames in flight behind.
+//!
+//! Every frame writes its timestamps into a range of one query pool. The Renderer calls beginFrame() and endFrame() and
+//! measures the "Frame" and the "Render pass" scopes, applications add their own. Does nothing if the graphics queue
+//! can not write timestamps, see isSupported().
+class GpuProfiler {
+public:
+	static constexpr uint32_t MAX_SCOPES = 64;  //! Per frame, further scopes are not measured
+	static constexpr uint32_t HISTORY = 120;    //! Frames of the statistics
+	static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+	GpuProfiler(Device& device, uint32_t framesInFlight);
+	~GpuProfiler();
+
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	bool isSupported() const;
+
+	//! Once per frame after the fence of the frame was waited for and the command buffer was begun. Collects the results
+	//! of the last frame with this index and records the reset of its queries, outside of a render pass.
+	void beginFrame(VkCommandBuffer commandBuffer, uint32_t frame);
+	//! Before ending the command buffer of the frame.
+	void endFrame(VkCommandBuffer commandBuffer);
+
+	//! Write the begin timestamp of a scope into a command buffer of the current frame, primary or secondary.
+	//! Thread safe, eg. for recording jobs. Scopes may nest.
+	//! @param name Has to outlive the frame, eg. a string literal.
+	//! @return Scope for endScope(), INVALID_SCOPE if the frame has no queries left.
+	uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+	//! Write the end timestamp into the same command buffer. Ignores INVALID_SCOPE.
+	void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+	//! Add a time measured outside of the frame command buffers, eg. the gpuTimeMs() of an UploadBatch. It counts
+	//! towards the next frame that is collected. Main thread only.
+	void addScopeTime(const std::string& name, double ms);
+
+	std::vector<GpuScopeStats> statistics() const;
+	std::string report() const;
+
+private:
+	void collect(uint32_t frame);
+	uint32_t firstQuery(uint32_t frame) const;
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	bool m_supported;
+	VkQueryPool m_queryPool = VK_NULL_HANDLE;
+
+	uint32_t m_frame = 0;
+	uint32_t m_frameScope = INVALID_SCOPE;
+	std::unique_ptr<std::atomic<uint32_t>[]> m_scopeCounts;  //! Scopes begun per frame index
+	std::vector<std::vector<const char*>> m_names;           //! Scope names per frame index
+	std::vector<uint64_t> m_results;  //! Timestamp and availability per query
+
+	ScopeStatistics m_statistics{HISTORY};
+};
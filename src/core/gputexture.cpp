@@ -0,0 +1,169 @@
+#include "gputexture.hpp"
+
+#include <stdexcept>
+
+#include "image.hpp"
+
+GpuTexture::GpuTexture(Device& device, UploadBatch& upload, const TextureData& data) : m_device(device) {
+	createTextureImage(upload, data);
+	createTextureImageView();
+	createTextureSampler();
+}
+
+GpuTexture::~GpuTexture() {
+	vkDestroySampler(m_device.device(), m_textureSampler, nullptr);
+
+	vkDestroyImageView(m_device.device(), m_textureImageView, nullptr);
+	vkDestroyImage(m_device.device(), m_textureImage, nullptr);
+	m_device.allocator().free(m_textureImageMemory);
+}
+
+VkDescriptorImageInfo GpuTexture::descriptorInfo() const {
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = m_textureImageView;
+	imageInfo.sampler = m_textureSampler;
+
+	return imageInfo;
+}
+
+VkFormat GpuTexture::format() const {
+	return m_textureFormat;
+}
+
+uint32_t GpuTexture::mipLevels() const {
+	return m_mipLevels;
+}
+
+VkDeviceSize GpuTexture::sizeBytes() const {
+	return m_textureImageMemory.size;
+}
+
+bool GpuTexture::canSample(const Device& device, VkFormat format) {
+	if(!isBlockCompressed(format)) {
+		return true;
+	}
+	const VkFormatFeatureFlags sampled = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return device.enabledFeatures().textureCompressionBC && device.isFormatSupported(format, sampled);
+}
+
+void GpuTexture::createTextureImage(UploadBatch& upload, const TextureData& data) {
+	// Block compressed textures are uploaded as stored. Devices that can not sample the format get them decoded.
+	const bool decode = !canSample(m_device, data.format);
+	const TextureData decoded = decode ? decompress(data) : TextureData{};
+	const TextureData& texture = decode ? decoded : data;
+	m_textureFormat = texture.format;
+
+	// Levels stored in the file are used as they are, block compressed formats can not be blitted anyway.
+	if(texture.mipLevels > 1 || isBlockCompressed(texture.format)) {
+		m_mipLevels = texture.mipLevels;
+		createImage(texture.width, texture.height, m_mipLevels, m_textureFormat, VK_IMAGE_TILING_OPTIMAL,
+		            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		            m_textureImage, m_textureImageMemory);
+
+		upload.uploadImageLevels(texture.data.data(), m_textureImage, m_textureFormat, texture.width, texture.height, m_mipLevels);
+		return;
+	}
+
+	// Full mip chain: Minified textures read from small levels instead of thrashing the texture cache.
+	m_mipLevels = mipLevelCount(texture.width, texture.height);
+
+	// Transfer source: The levels are blitted from each other.
+	createImage(texture.width, texture.height, m_mipLevels, m_textureFormat, VK_IMAGE_TILING_OPTIMAL,
+	            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	            m_textureImage, m_textureImageMemory);
+
+	// Pixels are copied to a staging buffer right away and can be freed afterwards.
+	upload.uploadImage(texture.data.data(), texture.data.size(), m_textureImage, m_textureFormat, texture.width, texture.height, m_mipLevels);
+}
+
+void GpuTexture::createTextureImageView() {
+	m_textureImageView = createImageView(m_textureImage, m_textureFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels);
+}
+
+VkImageView GpuTexture::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
+	VkImageViewCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.image = image;
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format = format;
+
+	createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+	createInfo.subresourceRange.aspectMask = aspectFlags;
+	createInfo.subresourceRange.baseMipLevel = 0;
+	createInfo.subresourceRange.levelCount = mipLevels;
+	createInfo.subresourceRange.baseArrayLayer = 0;
+	createInfo.subresourceRange.layerCount = 1;
+
+	VkImageView imageView;
+	if(vkCreateImageView(m_device.device(), &createInfo, nullptr, &imageView) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create image views!");
+	}
+
+	return imageView;
+}
+
+
+void GpuTexture::createTextureSampler() {
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+
+	samplerInfo.anisotropyEnable = VK_TRUE;  // NOTE: Turn off for better performance
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(m_device.physicalDevice(), &properties);
+	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy; // NOTE: Lower value for better performance
+
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = static_cast<float>(m_mipLevels);  // Every level of the texture
+
+	if (vkCreateSampler(m_device.device(), &samplerInfo, nullptr, &m_textureSampler) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create texture sampler!");
+	}
+}
+
+void GpuTexture::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageTiling tiling,
+                            VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
+{
+	// Create vulkan image
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = width;
+	imageInfo.extent.height = height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = format;
+	imageInfo.tiling = tiling;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = usage;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateImage(m_device.device(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create image!");
+	}
+
+	// Bind image to memory
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(m_device.device(), image, &memRequirements);
+
+	imageMemory = m_device.allocator().allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_LINEAR);
+
+	vkBindImageMemory(m_device.device(), image, imageMemory.memory, imageMemory.offset);
+}
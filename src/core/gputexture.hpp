@@ -0,0 +1,50 @@
+#pragma once
+
+#include "device.hpp"
+#include "memory.hpp"
+#include "upload.hpp"
+#include "texture.hpp"
+
+//! Sampled 2D texture in GPU memory with its view and sampler. Shared by every model using it, see AssetCache.
+class GpuTexture {
+public:
+	//! Record the upload into the batch. The texture must not be sampled before the batch is complete.
+	//! Block compressed data the device can not sample is decoded first.
+	GpuTexture(Device& device, UploadBatch& upload, const TextureData& data);
+	~GpuTexture();
+
+	GpuTexture(const GpuTexture&) = delete;
+	GpuTexture& operator=(const GpuTexture&) = delete;
+
+	//! Get descriptor information for the texture image and sampler.
+	VkDescriptorImageInfo descriptorInfo() const;
+
+	VkFormat format() const;
+	uint32_t mipLevels() const;
+	//! Device memory of the image.
+	VkDeviceSize sizeBytes() const;
+
+	//! False if textures of the format have to be decoded on the CPU before they can be sampled.
+	static bool canSample(const Device& device, VkFormat format);
+
+private:
+	// TODO: Better design.. Some functions are duplicated.
+	void createTextureSampler();
+	void createTextureImage(UploadBatch& upload, const TextureData& data);
+	void createTextureImageView();
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
+	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageTiling tiling,
+	                 VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	VkSampler m_textureSampler;
+
+	VkImage m_textureImage;
+	MemoryAllocation m_textureImageMemory;
+	VkFormat m_textureFormat = VK_FORMAT_R8G8B8A8_SRGB;
+	uint32_t m_mipLevels = 1;
+	VkImageView m_textureImageView;
+};
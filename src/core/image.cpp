@@ -0,0 +1,98 @@
+#include "image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "jobsystem.hpp"
+
+static constexpr uint32_t CHANNELS = 4;
+// Rows of a level smaller than this are not worth a job.
+static constexpr uint32_t ROWS_PER_JOB = 16;
+
+uint32_t mipLevelCount(uint32_t width, uint32_t height) {
+	uint32_t levels = 1;
+	for(uint32_t size = std::max(width, height); size > 1; size /= 2) {
+		++levels;
+	}
+	return levels;
+}
+
+uint32_t mipExtent(uint32_t size, uint32_t level) {
+	return std::max(size >> level, 1u);
+}
+
+static std::array<float, 256> srgbToLinearTable() {
+	std::array<float, 256> table{};
+	for(size_t i = 0; i != table.size(); ++i) {
+		const float c = static_cast<float>(i) / 255.0f;
+		table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+	return table;
+}
+
+static uint8_t linearToSrgb(float c) {
+	c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	return static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+
+//! Filter the rows [firstRow, firstRow + rowCount) of the level from the level above it.
+static void filterRows(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth,
+                       uint32_t firstRow, uint32_t rowCount, bool srgb) {
+	static const std::array<float, 256> toLinear = srgbToLinearTable();
+
+	for(uint32_t y = firstRow; y != firstRow + rowCount; ++y) {
+		// Odd sizes: The last row and column are clamped instead of reading past the edge.
+		const uint8_t* row0 = src + static_cast<size_t>(std::min(2 * y, srcHeight - 1)) * srcWidth * CHANNELS;
+		const uint8_t* row1 = src + static_cast<size_t>(std::min(2 * y + 1, srcHeight - 1)) * srcWidth * CHANNELS;
+
+		for(uint32_t x = 0; x != dstWidth; ++x) {
+			const size_t x0 = std::min(2 * x, srcWidth - 1) * CHANNELS;
+			const size_t x1 = std::min(2 * x + 1, srcWidth - 1) * CHANNELS;
+			uint8_t* out = dst + (static_cast<size_t>(y) * dstWidth + x) * CHANNELS;
+
+			for(uint32_t c = 0; c != CHANNELS; ++c) {
+				if(srgb && c != 3) {
+					const float sum = toLinear[row0[x0 + c]] + toLinear[row0[x1 + c]] + toLinear[row1[x0 + c]] + toLinear[row1[x1 + c]];
+					out[c] = linearToSrgb(sum * 0.25f);
+				} else {
+					out[c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+std::vector<uint8_t> generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, bool srgb, JobSystem* jobs) {
+	size_t total = 0;
+	for(uint32_t level = 1; level < mipLevels; ++level) {
+		total += static_cast<size_t>(mipExtent(width, level)) * mipExtent(height, level) * CHANNELS;
+	}
+	std::vector<uint8_t> chain(total);
+
+	const uint8_t* src = pixels;
+	uint8_t* dst = chain.data();
+	uint32_t srcWidth = width;
+	uint32_t srcHeight = height;
+
+	for(uint32_t level = 1; level < mipLevels; ++level) {
+		const uint32_t dstWidth = mipExtent(width, level);
+		const uint32_t dstHeight = mipExtent(height, level);
+
+		// Every level reads the previous one, only its rows run in parallel.
+		if(jobs != nullptr) {
+			jobs->parallelFor(dstHeight, ROWS_PER_JOB, [=](uint32_t firstRow, uint32_t rowCount) {
+				filterRows(src, srcWidth, srcHeight, dst, dstWidth, firstRow, rowCount, srgb);
+			});
+		} else {
+			filterRows(src, srcWidth, srcHeight, dst, dstWidth, 0, dstHeight, srgb);
+		}
+
+		src = dst;
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+		dst += static_cast<size_t>(dstWidth) * dstHeight * CHANNELS;
+	}
+
+	return chain;
+}
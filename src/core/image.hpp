@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+//! Number of levels of a full mip chain, down to 1x1.
+uint32_t mipLevelCount(uint32_t width, uint32_t height);
+
+//! Size of a mip level along one axis.
+uint32_t mipExtent(uint32_t size, uint32_t level);
+
+//! Mip chain of RGBA8 pixels built with a 2x2 box filter. Fallback for formats the GPU can not blit with linear filtering.
+//! @param srgb Color channels are sRGB encoded and averaged in linear space; Alpha is always linear.
+//! @param jobs Rows of every level are filtered on all threads of the job system, otherwise on the calling thread.
+//! @return Levels 1 to mipLevels - 1, tightly packed one after another.
+std::vector<uint8_t> generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, bool srgb, JobSystem* jobs = nullptr);
@@ -0,0 +1,108 @@
+#include "indirectdraw.hpp"
+
+IndirectDrawBuffer::IndirectDrawBuffer(Device& device, uint32_t frameCount, uint32_t capacity) : m_device(device), m_capacity(capacity) {
+	// Written by the CPU or by the culling shader.
+	const VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	m_commands = createFrameBuffers(m_device, frameCount, sizeof(VkDrawIndexedIndirectCommand), capacity, usage);
+	m_counts = createFrameBuffers(m_device, frameCount, sizeof(uint32_t), 1, usage);
+}
+
+void IndirectDrawBuffer::begin(uint32_t frame) {
+	m_frame = frame;
+	m_count = 0;
+	m_mapped = static_cast<VkDrawIndexedIndirectCommand*>(m_commands[frame]->getMappedMemory());
+}
+
+void IndirectDrawBuffer::add(const MeshRange& mesh, uint32_t instanceCount, uint32_t firstInstance) {
+	if(m_count == m_capacity) {
+		throw std::runtime_error("Failed to add draw, the indirect draw buffer is full!");
+	}
+
+	VkDrawIndexedIndirectCommand& command = m_mapped[m_count++];
+	command.indexCount = mesh.indexCount;
+	command.instanceCount = instanceCount;
+	command.firstIndex = mesh.firstIndex;
+	command.vertexOffset = mesh.vertexOffset;
+	command.firstInstance = firstInstance;
+}
+
+void IndirectDrawBuffer::record(VkCommandBuffer commandBuffer) {
+	*static_cast<uint32_t*>(m_counts[m_frame]->getMappedMemory()) = m_count;
+	if(m_count == 0) {
+		return;
+	}
+
+	const VkPhysicalDeviceFeatures& features = m_device.enabledFeatures();
+	const VkBuffer commands = m_commands[m_frame]->getBuffer();
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if(!features.drawIndirectFirstInstance) {
+		// Indirect draws would ignore firstInstance; Draw directly with the commands we wrote.
+		for(uint32_t i = 0; i != m_count; ++i) {
+			const VkDrawIndexedIndirectCommand& command = m_mapped[i];
+			vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+		}
+	} else if(m_device.drawIndexedIndirectCount()) {
+		m_device.drawIndexedIndirectCount()(commandBuffer, commands, 0, m_counts[m_frame]->getBuffer(), 0, m_capacity, stride);
+	} else if(features.multiDrawIndirect) {
+		vkCmdDrawIndexedIndirect(commandBuffer, commands, 0, m_count, stride);
+	} else {
+		for(uint32_t i = 0; i != m_count; ++i) {
+			vkCmdDrawIndexedIndirect(commandBuffer, commands, i * stride, 1, stride);
+		}
+	}
+}
+
+void IndirectDrawBuffer::beginGpuWritten(uint32_t frame) {
+	begin(frame);
+	*static_cast<uint32_t*>(m_counts[m_frame]->getMappedMemory()) = 0;
+}
+
+void IndirectDrawBuffer::recordGpuWritten(VkCommandBuffer commandBuffer, uint32_t maxDrawCount) {
+	if(maxDrawCount > m_capacity) {
+		throw std::runtime_error("Failed to record draws, the draw count exceeds the capacity!");
+	}
+	if(!m_device.enabledFeatures().drawIndirectFirstInstance) {
+		throw std::runtime_error("Failed to record draws, GPU written draws require drawIndirectFirstInstance!");
+	}
+	if(maxDrawCount == 0) {
+		return;
+	}
+
+	const VkBuffer commands = m_commands[m_frame]->getBuffer();
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if(m_device.drawIndexedIndirectCount()) {
+		m_device.drawIndexedIndirectCount()(commandBuffer, commands, 0, m_counts[m_frame]->getBuffer(), 0, maxDrawCount, stride);
+	} else if(m_device.enabledFeatures().multiDrawIndirect) {
+		vkCmdDrawIndexedIndirect(commandBuffer, commands, 0, maxDrawCount, stride);
+	} else {
+		for(uint32_t i = 0; i != maxDrawCount; ++i) {
+			vkCmdDrawIndexedIndirect(commandBuffer, commands, i * stride, 1, stride);
+		}
+	}
+}
+
+uint32_t IndirectDrawBuffer::gpuWrittenCount(uint32_t frame) const {
+	return *static_cast<const uint32_t*>(m_counts[frame]->getMappedMemory());
+}
+
+const VkDrawIndexedIndirectCommand* IndirectDrawBuffer::commands(uint32_t frame) const {
+	return static_cast<const VkDrawIndexedIndirectCommand*>(m_commands[frame]->getMappedMemory());
+}
+
+uint32_t IndirectDrawBuffer::count() const {
+	return m_count;
+}
+
+uint32_t IndirectDrawBuffer::capacity() const {
+	return m_capacity;
+}
+
+VkBuffer IndirectDrawBuffer::commandBuffer(uint32_t frame) const {
+	return m_commands[frame]->getBuffer();
+}
+
+VkBuffer IndirectDrawBuffer::countBuffer(uint32_t frame) const {
+	return m_counts[frame]->getBuffer();
+}
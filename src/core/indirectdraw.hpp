@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+#include "buffer.hpp"
+#include "meshpool.hpp"
+
+//! Draw commands for vkCmdDrawIndexedIndirect, written by the CPU every frame.
+//! Every frame in flight owns a persistently mapped command buffer and a draw count buffer. add() writes one
+//! VkDrawIndexedIndirectCommand straight into mapped memory; record() then submits all draws with a single call.
+//!
+//! record() uses the best path the device supports:
+//!   - vkCmdDrawIndexedIndirectCountKHR: The GPU reads the count, so later passes (eg. culling) can change it.
+//!   - vkCmdDrawIndexedIndirect with all draws (multiDrawIndirect).
+//!   - One indirect call per draw, or plain vkCmdDrawIndexed without drawIndirectFirstInstance.
+//! Draws use firstInstance to find their per object data, eg. the InstanceData at that index.
+//!
+//! The commands can also be written by the GPU, eg. by a CullingPass: beginGpuWritten() and recordGpuWritten().
+class IndirectDrawBuffer {
+public:
+	//! @param frameCount Number of frames in flight, one set of buffers is created for each.
+	//! @param capacity Maximum number of draws per frame.
+	IndirectDrawBuffer(Device& device, uint32_t frameCount, uint32_t capacity);
+
+	IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+	IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+
+	//! Start writing the draws of the frame. The fence of the frame has to be signaled, the GPU is done reading.
+	void begin(uint32_t frame);
+	//! Append a draw of the mesh. Throws if the buffer is full.
+	void add(const MeshRange& mesh, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+	//! Write the draw count and record the draws of the current frame. The mesh pool has to be bound.
+	void record(VkCommandBuffer commandBuffer);
+
+	//! Start a frame whose draws are written by the GPU. Resets the draw count of the frame to zero.
+	//! The fence of the frame has to be signaled.
+	void beginGpuWritten(uint32_t frame);
+	//! Record the draws the GPU wrote for the current frame. Requires drawIndirectFirstInstance.
+	//! With VK_KHR_draw_indirect_count the draw count written by the GPU is used. Otherwise all maxDrawCount commands
+	//! are drawn, the GPU has to write every one of them (skipped draws with zero instances).
+	void recordGpuWritten(VkCommandBuffer commandBuffer, uint32_t maxDrawCount);
+	//! Draw count the GPU wrote for the frame. Only valid once the fence of the frame is signaled.
+	uint32_t gpuWrittenCount(uint32_t frame) const;
+	//! Draw commands of the frame, eg. to check what the GPU wrote. Only valid once the fence of the frame is signaled.
+	const VkDrawIndexedIndirectCommand* commands(uint32_t frame) const;
+
+	uint32_t count() const;  //! Draws of the current frame
+	uint32_t capacity() const;
+
+	// Buffers of a frame, eg. to let a compute pass write the draws.
+	VkBuffer commandBuffer(uint32_t frame) const;
+	VkBuffer countBuffer(uint32_t frame) const;
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	std::vector<std::unique_ptr<Buffer>> m_commands;  //! One per frame in flight
+	std::vector<std::unique_ptr<Buffer>> m_counts;    //! One uint32_t per frame in flight
+	uint32_t m_capacity;
+
+	uint32_t m_frame = 0;
+	uint32_t m_count = 0;
+	VkDrawIndexedIndirectCommand* m_mapped = nullptr;  //! Commands of m_frame
+};
@@ -0,0 +1,37 @@
+#include "instancebuffer.hpp"
+
+#include <cstring>
+
+InstanceBuffer::InstanceBuffer(Device& device, uint32_t frameCount, uint32_t capacity) : m_counts(frameCount, 0), m_capacity(capacity) {
+	m_buffers = createFrameBuffers(device, frameCount, sizeof(InstanceData), capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+}
+
+InstanceData* InstanceBuffer::instances(uint32_t frame) {
+	return static_cast<InstanceData*>(m_buffers[frame]->getMappedMemory());
+}
+
+void InstanceBuffer::setCount(uint32_t frame, uint32_t count) {
+	if(count > m_capacity) {
+		throw std::runtime_error("Failed to update instances, the count exceeds the capacity!");
+	}
+	m_counts[frame] = count;
+}
+
+void InstanceBuffer::update(uint32_t frame, const InstanceData* instances, uint32_t count) {
+	setCount(frame, count);
+	memcpy(m_buffers[frame]->getMappedMemory(), instances, count * sizeof(InstanceData));
+}
+
+void InstanceBuffer::bind(VkCommandBuffer commandBuffer, uint32_t frame) const {
+	VkBuffer buffers[] = {m_buffers[frame]->getBuffer()};
+	VkDeviceSize offsets[] = {0};
+	vkCmdBindVertexBuffers(commandBuffer, Vertex::INSTANCE_BINDING, 1, buffers, offsets);
+}
+
+uint32_t InstanceBuffer::count(uint32_t frame) const {
+	return m_counts[frame];
+}
+
+uint32_t InstanceBuffer::capacity() const {
+	return m_capacity;
+}
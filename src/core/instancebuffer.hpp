@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+#include "buffer.hpp"
+#include "vertex.hpp"
+
+//! Per instance attributes for instanced draws, bound to Vertex::INSTANCE_BINDING.
+//! Every frame in flight owns a persistently mapped buffer: The scene update writes the instances of the current
+//! frame while the GPU still reads the previous one, without mapping or staging copies.
+class InstanceBuffer {
+public:
+	//! @param frameCount Number of frames in flight, one buffer is created for each.
+	//! @param capacity Maximum number of instances per frame.
+	InstanceBuffer(Device& device, uint32_t frameCount, uint32_t capacity);
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+	//! Mapped instances of the frame, write up to capacity() entries and call setCount().
+	//! The fence of the frame has to be signaled, the GPU is done reading.
+	InstanceData* instances(uint32_t frame);
+	void setCount(uint32_t frame, uint32_t count);
+	//! Copy the instances into the buffer of the frame. Throws if count exceeds capacity().
+	void update(uint32_t frame, const InstanceData* instances, uint32_t count);
+
+	void bind(VkCommandBuffer commandBuffer, uint32_t frame) const;
+
+	uint32_t count(uint32_t frame) const;
+	uint32_t capacity() const;
+
+private:
+	std::vector<std::unique_ptr<Buffer>> m_buffers;  //! One per frame in flight
+	std::vector<uint32_t> m_counts;
+	uint32_t m_capacity;
+};
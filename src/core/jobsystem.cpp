@@ -0,0 +1,359 @@
+#include "jobsystem.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Failed searches before an idle worker goes to sleep.
+static constexpr uint32_t SPIN_COUNT = 64;
+
+// Job system the current thread belongs to and its index in it.
+static thread_local const JobSystem* t_jobSystem = nullptr;
+static thread_local uint32_t t_threadIndex = 0;
+static thread_local uint32_t t_random = 0;
+
+bool JobCounter::done() const {
+	return m_count.load(std::memory_order_acquire) == 0;
+}
+
+
+// ----- Queue -----
+WorkStealingQueue::WorkStealingQueue(uint32_t capacity) : m_jobs(capacity), m_mask(capacity - 1) {
+	if(capacity == 0 || (capacity & (capacity - 1)) != 0) {
+		throw std::runtime_error("Failed to create work stealing queue, the capacity is not a power of two!");
+	}
+}
+
+bool WorkStealingQueue::push(Job* job) {
+	const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	const int64_t top = m_top.load(std::memory_order_acquire);
+	if(bottom - top > m_mask) {
+		return false;
+	}
+
+	m_jobs[bottom & m_mask].store(job, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);  // Publishes the job to thieves
+	return true;
+}
+
+Job* WorkStealingQueue::pop() {
+	// Reserve the bottom job before looking at the top, thieves see the reservation.
+	const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_seq_cst);
+
+	if(top > bottom) {
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);  // Empty
+		return nullptr;
+	}
+
+	Job* job = m_jobs[bottom & m_mask].load(std::memory_order_relaxed);
+	if(top == bottom) {
+		// Last job, race thieves for it.
+		if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* WorkStealingQueue::steal() {
+	int64_t top = m_top.load(std::memory_order_seq_cst);
+	const int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+	if(top >= bottom) {
+		return nullptr;
+	}
+
+	Job* job = m_jobs[top & m_mask].load(std::memory_order_relaxed);
+	if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	return job;
+}
+
+
+// ----- Job system -----
+JobSystem::JobSystem(uint32_t threadCount)
+	: m_threadCount(threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u)) {
+	for(uint32_t i = 0; i != m_threadCount; ++i) {
+		m_queues.push_back(std::make_unique<WorkStealingQueue>(QUEUE_CAPACITY));
+	}
+
+	t_jobSystem = this;
+	t_threadIndex = 0;
+	t_random = 1;
+
+	m_workers.reserve(m_threadCount - 1);
+	for(uint32_t thread = 1; thread < m_threadCount; ++thread) {
+		m_workers.emplace_back(&JobSystem::workerLoop, this, thread);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for(auto& worker : m_workers) {
+		worker.join();
+	}
+
+	if(t_jobSystem == this) {
+		t_jobSystem = nullptr;
+	}
+
+	// Jobs nobody waited for are dropped.
+	for(auto& queue : m_queues) {
+		while(Job* job = queue->pop()) {
+			delete job;
+		}
+	}
+	for(Job* job : m_injected) {
+		delete job;
+	}
+	for(Job* job : m_mainJobs) {
+		delete job;
+	}
+}
+
+uint32_t JobSystem::threadCount() const {
+	return m_threadCount;
+}
+
+uint32_t JobSystem::threadIndex() const {
+	const uint32_t thread = currentThread();
+	if(thread == m_threadCount) {
+		throw std::runtime_error("Failed to get thread index, the thread is not part of the job system!");
+	}
+	return thread;
+}
+
+uint32_t JobSystem::currentThread() const {
+	return t_jobSystem == this ? t_threadIndex : m_threadCount;
+}
+
+void JobSystem::submit(std::function<void()> function, JobCounter* counter) {
+	if(counter) {
+		counter->m_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	push(new Job{std::move(function), counter});
+}
+
+void JobSystem::submitAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter) {
+	if(counter) {
+		counter->m_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	Job* job = new Job{std::move(function), counter};
+
+	{
+		// finish() takes the continuations under the same lock, the job is either queued here or submitted there.
+		std::lock_guard<std::mutex> lock(dependency.m_mutex);
+		if(dependency.m_count.load(std::memory_order_acquire) != 0) {
+			dependency.m_continuations.push_back(job);
+			return;
+		}
+	}
+	push(job);
+}
+
+void JobSystem::submitMain(std::function<void()> function, JobCounter* counter) {
+	if(counter) {
+		counter->m_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mainMutex);
+	m_mainJobs.push_back(new Job{std::move(function), counter});
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t first, uint32_t count)>& function) {
+	if(count == 0) {
+		return;
+	}
+
+	// A few chunks per thread, so threads that finish early can steal the rest.
+	const uint32_t maxChunks = std::max((count + grainSize - 1) / std::max(grainSize, 1u), 1u);
+	const uint32_t chunkCount = std::min(maxChunks, 4 * m_threadCount);
+	const uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	JobCounter counter;
+	for(uint32_t first = 0; first < count; first += chunkSize) {
+		const uint32_t size = std::min(chunkSize, count - first);
+		submit([&function, first, size]() { function(first, size); }, &counter);
+	}
+	wait(counter);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+	const uint32_t thread = currentThread();
+	while(!counter.done()) {
+		if(thread == m_threadCount || !runOneJob(thread)) {
+			std::this_thread::yield();
+		}
+	}
+
+	// The last finish() may still hold the lock, the counter must not be destroyed before it is released.
+	std::lock_guard<std::mutex> lock(counter.m_mutex);
+	if(counter.m_error) {
+		std::exception_ptr error = counter.m_error;
+		counter.m_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void JobSystem::runMainThreadJobs() {
+	if(currentThread() != 0) {
+		throw std::runtime_error("Failed to run main thread jobs, not called on the main thread!");
+	}
+
+	while(true) {
+		Job* job = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_mainMutex);
+			if(m_mainJobs.empty()) {
+				return;
+			}
+			job = m_mainJobs.front();
+			m_mainJobs.pop_front();
+		}
+		execute(job);
+	}
+}
+
+void JobSystem::workerLoop(uint32_t thread) {
+	t_jobSystem = this;
+	t_threadIndex = thread;
+	t_random = thread * 2654435761u + 1;
+
+	uint32_t idle = 0;
+	while(!m_stop.load(std::memory_order_relaxed)) {
+		// Read before searching: A job submitted after a failed search changes the epoch.
+		const uint64_t epoch = m_epoch.load();
+		if(runOneJob(thread)) {
+			idle = 0;
+			continue;
+		}
+		if(++idle < SPIN_COUNT) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleeping.fetch_add(1);
+		m_wake.wait(lock, [&]() { return m_stop.load() || m_epoch.load() != epoch; });
+		m_sleeping.fetch_sub(1);
+		idle = 0;
+	}
+}
+
+bool JobSystem::runOneJob(uint32_t thread) {
+	Job* job = findJob(thread);
+	if(!job && thread == 0) {
+		std::lock_guard<std::mutex> lock(m_mainMutex);
+		if(!m_mainJobs.empty()) {
+			job = m_mainJobs.front();
+			m_mainJobs.pop_front();
+		}
+	}
+	if(!job) {
+		return false;
+	}
+
+	execute(job);
+	return true;
+}
+
+Job* JobSystem::findJob(uint32_t thread) {
+	if(Job* job = m_queues[thread]->pop()) {
+		return job;
+	}
+
+	if(m_injectedCount.load(std::memory_order_acquire) != 0) {
+		std::lock_guard<std::mutex> lock(m_injectedMutex);
+		if(!m_injected.empty()) {
+			Job* job = m_injected.front();
+			m_injected.pop_front();
+			m_injectedCount.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	// Start at a random victim, so thieves do not all line up at the same queue.
+	t_random ^= t_random << 13;
+	t_random ^= t_random >> 17;
+	t_random ^= t_random << 5;
+	const uint32_t start = t_random % m_threadCount;
+	for(uint32_t i = 0; i != m_threadCount; ++i) {
+		const uint32_t victim = (start + i) % m_threadCount;
+		if(victim == thread) {
+			continue;
+		}
+		if(Job* job = m_queues[victim]->steal()) {
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::execute(Job* job) {
+	try {
+		job->function();
+	} catch(...) {
+		if(!job->counter) {
+			throw;  // Nobody to report it to
+		}
+		std::lock_guard<std::mutex> lock(job->counter->m_mutex);
+		if(!job->counter->m_error) {
+			job->counter->m_error = std::current_exception();
+		}
+	}
+
+	if(job->counter) {
+		finish(*job->counter);
+	}
+	delete job;
+}
+
+void JobSystem::finish(JobCounter& counter) {
+	// Only the last job locks: Waiters may destroy the counter as soon as it reached zero and the lock is free.
+	uint32_t count = counter.m_count.load(std::memory_order_relaxed);
+	while(count > 1) {
+		if(counter.m_count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+			return;
+		}
+	}
+
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter.m_mutex);
+		if(counter.m_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+			return;  // Jobs were added meanwhile
+		}
+		continuations.swap(counter.m_continuations);
+	}
+
+	for(Job* job : continuations) {
+		push(job);
+	}
+}
+
+void JobSystem::push(Job* job) {
+	const uint32_t thread = currentThread();
+	if(thread == m_threadCount) {
+		std::lock_guard<std::mutex> lock(m_injectedMutex);
+		m_injected.push_back(job);
+		m_injectedCount.fetch_add(1, std::memory_order_release);
+	} else if(!m_queues[thread]->push(job)) {
+		execute(job);  // Queue is full
+		return;
+	}
+	wakeWorker();
+}
+
+void JobSystem::wakeWorker() {
+	m_epoch.fetch_add(1);
+	if(m_sleeping.load() != 0) {
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wake.notify_one();
+	}
+}
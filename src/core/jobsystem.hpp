@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+//! Function run by a worker of the job system.
+struct Job {
+	std::function<void()> function;
+	class JobCounter* counter = nullptr;  //! Decremented when the job finished, may be nullptr.
+};
+
+//! Number of unfinished jobs submitted with this counter. Wait for it with JobSystem::wait() or use it as
+//! dependency of other jobs. A counter can be reused once it reached zero.
+class JobCounter {
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool done() const;
+
+private:
+	friend class JobSystem;
+
+	std::atomic<uint32_t> m_count{0};
+	std::mutex m_mutex;
+	std::vector<Job*> m_continuations;  //! Submitted when the count reaches zero.
+	std::exception_ptr m_error;         //! First exception of a job, rethrown by JobSystem::wait().
+};
+
+//! Chase-Lev work stealing deque with a fixed capacity (Lê et al., "Correct and Efficient Work-Stealing for Weak
+//! Memory Models"). The owning thread pushes and pops at the bottom without locking, other threads steal the oldest
+//! job at the top. Accesses that need a total order are sequentially consistent instead of using fences.
+class WorkStealingQueue {
+public:
+	explicit WorkStealingQueue(uint32_t capacity);
+
+	//! Owner only. @return False if the queue is full.
+	bool push(Job* job);
+	//! Owner only. @return Newest job or nullptr.
+	Job* pop();
+	//! Any thread. @return Oldest job or nullptr if the queue is empty or another thread won the race.
+	Job* steal();
+
+private:
+	std::atomic<int64_t> m_top{0};
+	std::atomic<int64_t> m_bottom{0};
+	std::vector<std::atomic<Job*>> m_jobs;
+	int64_t m_mask;
+};
+
+//! Work stealing task scheduler, the threading backbone of the engine.
+//! Every worker owns a WorkStealingQueue. Jobs submitted on a worker go to its own queue and run there unless an idle
+//! worker steals them, so related work stays on one core and there is no shared queue to contend on. Threads that
+//! wait for a counter run other jobs meanwhile, nested parallelFor() calls do not block a worker.
+//!
+//! The thread that creates the job system is thread 0: It takes part in running jobs while it waits and is the only
+//! thread running jobs of the main thread queue (submitMain()), eg. work that has to use the graphics queue.
+//! Other threads that are not part of the job system can submit jobs and wait, but never run them: Without workers,
+//! their jobs only run while thread 0 waits.
+class JobSystem {
+public:
+	//! Capacity of the queue of every thread. Submitting to a full queue runs the job immediately.
+	static constexpr uint32_t QUEUE_CAPACITY = 4096;
+
+	//! @param threadCount Number of threads running jobs including the creating thread. 0 uses every core.
+	explicit JobSystem(uint32_t threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	//! Run the function on any thread. Exceptions are rethrown by wait() on the counter, jobs without counter must not throw.
+	void submit(std::function<void()> function, JobCounter* counter = nullptr);
+	//! Run the function once the dependency reached zero.
+	void submitAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter = nullptr);
+	//! Run the function on thread 0 in runMainThreadJobs() or while thread 0 waits.
+	void submitMain(std::function<void()> function, JobCounter* counter = nullptr);
+
+	//! Call function(first, count) for ranges covering [0, count) on all threads, returns when every range is done.
+	//! @param grainSize Smallest range worth a job.
+	void parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t first, uint32_t count)>& function);
+
+	//! Run jobs until the counter reached zero. Rethrows the first exception of its jobs.
+	void wait(JobCounter& counter);
+	//! Run the jobs of the main thread queue. Thread 0 only, eg. once per frame.
+	void runMainThreadJobs();
+
+	uint32_t threadCount() const;
+	//! Index of the calling thread in [0, threadCount()), eg. to select per thread resources in a job.
+	//! Throws for threads that are not part of the job system.
+	uint32_t threadIndex() const;
+
+private:
+	void workerLoop(uint32_t thread);
+	//! @return False if no job was found.
+	bool runOneJob(uint32_t thread);
+	Job* findJob(uint32_t thread);
+	void execute(Job* job);
+	void finish(JobCounter& counter);
+	void push(Job* job);
+	void wakeWorker();
+
+	//! Index of the calling thread or threadCount() for threads outside of this job system.
+	uint32_t currentThread() const;
+
+private:
+	uint32_t m_threadCount;
+	std::vector<std::unique_ptr<WorkStealingQueue>> m_queues;  //! One per thread
+	std::vector<std::thread> m_workers;                        //! Thread i + 1
+
+	std::mutex m_injectedMutex;
+	std::deque<Job*> m_injected;  //! Submitted by threads outside of the job system
+	std::atomic<uint32_t> m_injectedCount{0};
+
+	std::mutex m_mainMutex;
+	std::deque<Job*> m_mainJobs;
+
+	// Idle workers sleep until the epoch changes, submit() increments it.
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<uint64_t> m_epoch{0};
+	std::atomic<uint32_t> m_sleeping{0};
+	std::atomic<bool> m_stop{false};
+};
@@ -0,0 +1,303 @@
+#include "memory.hpp"
+#include "device.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) {
+	return alignment > 1 ? value / alignment * alignment : value;
+}
+
+
+// ----- Free List Block -----
+FreeListBlock::FreeListBlock(VkDeviceSize size) : m_size(size) {
+	m_freeRanges[0] = size;
+}
+
+bool FreeListBlock::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+	if(size == 0) {
+		return false;
+	}
+
+	// Best fit: Use the smallest free range that can hold the aligned allocation -> keeps large ranges intact.
+	auto best = m_freeRanges.end();
+	VkDeviceSize bestOffset = 0;
+	for(auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+		const VkDeviceSize alignedOffset = alignUp(it->first, alignment);
+		const VkDeviceSize padding = alignedOffset - it->first;
+		if(padding + size > it->second) {
+			continue;
+		}
+
+		if(best == m_freeRanges.end() || it->second < best->second) {
+			best = it;
+			bestOffset = alignedOffset;
+			if(it->second == padding + size) {
+				break;  // Perfect fit
+			}
+		}
+	}
+
+	if(best == m_freeRanges.end()) {
+		return false;
+	}
+
+	const VkDeviceSize rangeOffset = best->first;
+	const VkDeviceSize rangeSize = best->second;
+	m_freeRanges.erase(best);
+
+	// Keep the alignment padding in front and the remainder behind the allocation as free ranges.
+	if(bestOffset > rangeOffset) {
+		m_freeRanges[rangeOffset] = bestOffset - rangeOffset;
+	}
+	const VkDeviceSize end = bestOffset + size;
+	if(end < rangeOffset + rangeSize) {
+		m_freeRanges[end] = rangeOffset + rangeSize - end;
+	}
+
+	m_usedBytes += size;
+	++m_allocationCount;
+	offset = bestOffset;
+	return true;
+}
+
+void FreeListBlock::free(VkDeviceSize offset, VkDeviceSize size) {
+	assert(offset + size <= m_size && "Freed range is not inside the block");
+	assert(m_allocationCount > 0 && "Freed more ranges than allocated");
+
+	m_usedBytes -= size;
+	--m_allocationCount;
+
+	auto it = m_freeRanges.emplace(offset, size).first;
+
+	// Merge with the following free range.
+	auto next = std::next(it);
+	if(next != m_freeRanges.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		m_freeRanges.erase(next);
+	}
+
+	// Merge with the preceding free range.
+	if(it != m_freeRanges.begin()) {
+		auto prev = std::prev(it);
+		if(prev->first + prev->second == it->first) {
+			prev->second += it->second;
+			m_freeRanges.erase(it);
+		}
+	}
+}
+
+VkDeviceSize FreeListBlock::size() const {
+	return m_size;
+}
+
+VkDeviceSize FreeListBlock::usedBytes() const {
+	return m_usedBytes;
+}
+
+VkDeviceSize FreeListBlock::largestFreeRange() const {
+	VkDeviceSize largest = 0;
+	for(const auto& range : m_freeRanges) {
+		largest = std::max(largest, range.second);
+	}
+	return largest;
+}
+
+uint32_t FreeListBlock::freeRangeCount() const {
+	return static_cast<uint32_t>(m_freeRanges.size());
+}
+
+uint32_t FreeListBlock::allocationCount() const {
+	return m_allocationCount;
+}
+
+bool FreeListBlock::empty() const {
+	return m_allocationCount == 0;
+}
+
+
+// ----- Memory Allocator -----
+MemoryAllocator::MemoryAllocator(Device& device) : m_device(device) {
+	vkGetPhysicalDeviceMemoryProperties(m_device.physicalDevice(), &m_memoryProperties);
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(m_device.physicalDevice(), &properties);
+	m_nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+}
+
+VkDeviceSize MemoryAllocator::blockSize(uint32_t memoryType) const {
+	const uint32_t heapIndex = m_memoryProperties.memoryTypes[memoryType].heapIndex;
+	const VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[heapIndex].size;
+
+	// Small heaps (eg. the 256MB host visible device local heap without resizable BAR) should not be filled by one block.
+	return heapSize <= 1024ull * 1024 * 1024 ? std::min(DEFAULT_BLOCK_SIZE, heapSize / 8) : DEFAULT_BLOCK_SIZE;
+}
+
+uint32_t MemoryAllocator::createBlock(uint32_t memoryType, VkDeviceSize size, bool linear, bool dedicated) {
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryType;
+
+	VkDeviceMemory memory;
+	if(vkAllocateMemory(m_device.device(), &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate memory block!");
+	}
+
+	// Host visible blocks stay mapped for their whole lifetime. Mapping the same memory twice is not allowed
+	// so the sub allocations can not map themselves.
+	void* mapped = nullptr;
+	if(m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		if(vkMapMemory(m_device.device(), memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+			vkFreeMemory(m_device.device(), memory, nullptr);
+			throw std::runtime_error("Failed to map memory block!");
+		}
+	}
+
+	auto block = std::unique_ptr<Block>(new Block{memory, mapped, memoryType, linear, dedicated, FreeListBlock(size)});
+
+	// Reuse slots of destroyed blocks to keep the indices of existing allocations stable.
+	for(uint32_t i = 0; i != m_blocks.size(); ++i) {
+		if(!m_blocks[i]) {
+			m_blocks[i] = std::move(block);
+			return i;
+		}
+	}
+
+	m_blocks.push_back(std::move(block));
+	return static_cast<uint32_t>(m_blocks.size() - 1);
+}
+
+void MemoryAllocator::destroyBlock(uint32_t blockIndex) {
+	Block& block = *m_blocks[blockIndex];
+	if(block.mapped) {
+		vkUnmapMemory(m_device.device(), block.memory);
+	}
+	vkFreeMemory(m_device.device(), block.memory, nullptr);
+
+	m_blocks[blockIndex].reset();
+}
+
+MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear) {
+	const uint32_t memoryType = m_device.findMemoryType(requirements.memoryTypeBits, properties);
+	const VkDeviceSize defaultSize = blockSize(memoryType);
+
+	// Host visible memory has to respect nonCoherentAtomSize so flushing one allocation never touches another.
+	VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+	VkDeviceSize size = requirements.size;
+	if(m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		alignment = std::max(alignment, m_nonCoherentAtomSize);
+		size = alignUp(size, m_nonCoherentAtomSize);
+	}
+
+	MemoryAllocation allocation{};
+	allocation.size = size;
+
+	auto finish = [&](uint32_t blockIndex, VkDeviceSize offset) {
+		const Block& block = *m_blocks[blockIndex];
+		allocation.memory = block.memory;
+		allocation.offset = offset;
+		allocation.blockIndex = blockIndex;
+		allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+		return allocation;
+	};
+
+	// Large resources get their own block. Placing them in a regular block would waste most of it.
+	if(size > defaultSize / 2) {
+		const uint32_t blockIndex = createBlock(memoryType, size, linear, true);
+		VkDeviceSize offset = 0;
+		m_blocks[blockIndex]->ranges.allocate(size, alignment, offset);
+		return finish(blockIndex, offset);
+	}
+
+	for(uint32_t i = 0; i != m_blocks.size(); ++i) {
+		Block* block = m_blocks[i].get();
+		if(!block || block->dedicated || block->memoryType != memoryType || block->linear != linear) {
+			continue;
+		}
+
+		VkDeviceSize offset = 0;
+		if(block->ranges.allocate(size, alignment, offset)) {
+			return finish(i, offset);
+		}
+	}
+
+	// No existing block has space left.
+	const uint32_t blockIndex = createBlock(memoryType, defaultSize, linear, false);
+	VkDeviceSize offset = 0;
+	m_blocks[blockIndex]->ranges.allocate(size, alignment, offset);
+	return finish(blockIndex, offset);
+}
+
+void MemoryAllocator::free(MemoryAllocation& allocation) {
+	if(allocation.memory == VK_NULL_HANDLE) {
+		return;
+	}
+
+	assert(allocation.blockIndex < m_blocks.size() && m_blocks[allocation.blockIndex] && "Freed allocation of unknown block");
+	Block& block = *m_blocks[allocation.blockIndex];
+	block.ranges.free(allocation.offset, allocation.size);
+
+	// Regular blocks are kept for future allocations; call trim() to release them.
+	if(block.dedicated) {
+		destroyBlock(allocation.blockIndex);
+	}
+
+	allocation = MemoryAllocation{};
+}
+
+void MemoryAllocator::trim() {
+	for(uint32_t i = 0; i != m_blocks.size(); ++i) {
+		if(m_blocks[i] && m_blocks[i]->ranges.empty()) {
+			destroyBlock(i);
+		}
+	}
+}
+
+VkMappedMemoryRange MemoryAllocator::mappedRange(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const {
+	if(size == VK_WHOLE_SIZE) {
+		size = allocation.size - offset;
+	}
+
+	// Allocations of host visible memory are atom aligned, so widening the range stays inside the allocation.
+	const VkDeviceSize begin = alignDown(allocation.offset + offset, m_nonCoherentAtomSize);
+	const VkDeviceSize end = std::min(alignUp(allocation.offset + offset + size, m_nonCoherentAtomSize), allocation.offset + allocation.size);
+
+	VkMappedMemoryRange mappedRange{};
+	mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	mappedRange.memory = allocation.memory;
+	mappedRange.offset = begin;
+	mappedRange.size = end - begin;
+
+	return mappedRange;
+}
+
+MemoryStats MemoryAllocator::stats() const {
+	MemoryStats stats{};
+	for(const auto& block : m_blocks) {
+		if(!block) {
+			continue;
+		}
+
+		++stats.blockCount;
+		stats.allocationCount += block->ranges.allocationCount();
+		stats.reservedBytes += block->ranges.size();
+		stats.usedBytes += block->ranges.usedBytes();
+		stats.freeBytes += block->ranges.size() - block->ranges.usedBytes();
+		stats.largestFreeRange = std::max(stats.largestFreeRange, block->ranges.largestFreeRange());
+	}
+
+	return stats;
+}
+
+MemoryAllocator::~MemoryAllocator() {
+	for(uint32_t i = 0; i != m_blocks.size(); ++i) {
+		if(m_blocks[i]) {
+			destroyBlock(i);
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// Overview:
+// Every buffer and image used to call vkAllocateMemory directly. Drivers only guarantee a small number of allocations
+// (maxMemoryAllocationCount, often 4096) and each allocation is expensive.
+// The MemoryAllocator instead allocates large blocks per memory type and places resources inside these blocks.
+//
+// FreeListBlock: Offset bookkeeping of one block (no vulkan calls -> can be tested without a device).
+// MemoryAllocator: Owns the VkDeviceMemory blocks, hands out MemoryAllocations and keeps host visible blocks mapped.
+
+#include <vulkan/vulkan.hpp>
+#include <map>
+#include <memory>
+#include <vector>
+
+class Device;
+
+//! Range inside a memory block that a buffer or image is bound to.
+struct MemoryAllocation {
+	VkDeviceMemory memory = VK_NULL_HANDLE;  //! Memory block that contains the range.
+	VkDeviceSize offset = 0;                 //! Offset of the range inside the memory block.
+	VkDeviceSize size = 0;                   //! Size of the range in bytes.
+	void* mapped = nullptr;                  //! Host pointer to the start of the range. Only set for host visible memory.
+	uint32_t blockIndex = 0;                 //! Block index inside the allocator.
+};
+
+//! Snapshot of the allocator usage.
+struct MemoryStats {
+	uint32_t blockCount = 0;           //! Number of vkAllocateMemory calls currently alive.
+	uint32_t allocationCount = 0;      //! Number of sub allocations currently alive.
+	VkDeviceSize reservedBytes = 0;    //! Sum of all block sizes.
+	VkDeviceSize usedBytes = 0;        //! Bytes handed out to sub allocations (including alignment padding).
+	VkDeviceSize freeBytes = 0;        //! Bytes that can still be handed out without allocating new blocks.
+	VkDeviceSize largestFreeRange = 0; //! Largest contiguous free range of all blocks.
+
+	//! 0 if all free memory is contiguous, approaches 1 if free memory is split into many small ranges.
+	float fragmentation() const {
+		return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes);
+	}
+};
+
+
+// ----- Free List Block -----
+//! Manages the free ranges of a single memory block. Uses best fit placement and merges neighbouring free ranges.
+class FreeListBlock {
+public:
+	explicit FreeListBlock(VkDeviceSize size);
+
+	//! Find a free range for the requested size and alignment. Returns false if the block has no suitable range.
+	bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	//! Return a range previously returned by allocate.
+	void free(VkDeviceSize offset, VkDeviceSize size);
+
+	VkDeviceSize size() const;
+	VkDeviceSize usedBytes() const;
+	VkDeviceSize largestFreeRange() const;
+	uint32_t freeRangeCount() const;
+	uint32_t allocationCount() const;
+	bool empty() const;
+
+private:
+	VkDeviceSize m_size;
+	VkDeviceSize m_usedBytes = 0;
+	uint32_t m_allocationCount = 0;
+
+	std::map<VkDeviceSize, VkDeviceSize> m_freeRanges;  //! Offset -> size of every free range, sorted by offset.
+};
+
+
+// ----- Memory Allocator -----
+class MemoryAllocator {
+public:
+	MemoryAllocator(Device& device);
+	~MemoryAllocator();
+
+	MemoryAllocator(const MemoryAllocator&) = delete;
+	MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+	//! Sub allocate memory that satisfies the requirements.
+	//! @param linear True for buffers and linear images, false for optimal tiling images.
+	//!               Both are kept in separate blocks so we never have to respect bufferImageGranularity.
+	MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+	void free(MemoryAllocation& allocation);
+
+	//! Release all blocks that do not contain any allocations.
+	void trim();
+
+	//! Create a range for vkFlush/vkInvalidateMappedMemoryRanges that respects nonCoherentAtomSize.
+	VkMappedMemoryRange mappedRange(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+	MemoryStats stats() const;
+
+public:
+	//! Size of a regular memory block. Smaller heaps use an eighth of the heap size.
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+private:
+	struct Block {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mapped = nullptr;
+		uint32_t memoryType = 0;
+		bool linear = true;
+		bool dedicated = false;  //! Block only holds a single allocation that was too large for regular blocks.
+		FreeListBlock ranges;
+	};
+
+	VkDeviceSize blockSize(uint32_t memoryType) const;
+	uint32_t createBlock(uint32_t memoryType, VkDeviceSize size, bool linear, bool dedicated);
+	void destroyBlock(uint32_t blockIndex);
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+	VkDeviceSize m_nonCoherentAtomSize = 1;
+
+	std::vector<std::unique_ptr<Block>> m_blocks;  //! Destroyed blocks leave a nullptr slot that is reused.
+};
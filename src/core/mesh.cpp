@@ -0,0 +1,202 @@
+#include "mesh.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "file.hpp"
+#include "objparser.hpp"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tol/tiny_obj_loader.h"
+
+// Vertices are hashed and compared as raw bytes -> There must not be any padding.
+static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must be tightly packed");
+
+//! Replace -0.0 with 0.0, so equal vertices have equal bytes.
+static Vertex normalize(const Vertex& vertex) {
+	uint32_t words[8];
+	memcpy(words, &vertex, sizeof(words));
+	for(auto& word : words) {
+		if(word == 0x80000000u) {
+			word = 0;
+		}
+	}
+
+	Vertex result;
+	memcpy(&result, words, sizeof(words));
+	return result;
+}
+
+static uint64_t mix(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+static uint64_t hashBytes(const Vertex& vertex) {
+	uint64_t words[4];
+	memcpy(words, &vertex, sizeof(words));
+
+	uint64_t h = 0x9e3779b97f4a7c15ull;
+	for(uint64_t word : words) {
+		h = (h ^ mix(word)) * 0x9e3779b97f4a7c15ull;
+	}
+	return mix(h);
+}
+
+VertexDeduplicator::VertexDeduplicator(size_t expectedVertices) {
+	size_t capacity = 16;
+	while(capacity * 7 / 10 < expectedVertices) {
+		capacity *= 2;
+	}
+
+	m_slots.assign(capacity, Slot{0, EMPTY});
+	m_mask = capacity - 1;
+	m_mesh.vertices.reserve(expectedVertices);
+}
+
+uint64_t VertexDeduplicator::hash(const Vertex& vertex) {
+	return hashBytes(normalize(vertex));
+}
+
+void VertexDeduplicator::add(const Vertex& vertex) {
+	const Vertex normalized = normalize(vertex);
+	const uint64_t h = hashBytes(normalized);
+	const uint32_t shortHash = static_cast<uint32_t>(h >> 32);  // Low bits select the slot, high bits filter
+
+	for(size_t i = h & m_mask;; i = (i + 1) & m_mask) {
+		Slot& slot = m_slots[i];
+		if(slot.index == EMPTY) {
+			slot.hash = shortHash;
+			slot.index = static_cast<uint32_t>(m_mesh.vertices.size());
+
+			m_mesh.indices.push_back(slot.index);
+			m_mesh.vertices.push_back(normalized);
+
+			// Keep the load factor below 0.7; Linear probing gets slow on long clusters.
+			if(m_mesh.vertices.size() * 10 > m_slots.size() * 7) {
+				grow();
+			}
+			return;
+		}
+
+		if(slot.hash == shortHash && memcmp(&m_mesh.vertices[slot.index], &normalized, sizeof(Vertex)) == 0) {
+			m_mesh.indices.push_back(slot.index);
+			return;
+		}
+	}
+}
+
+void VertexDeduplicator::grow() {
+	std::vector<Slot> old = std::move(m_slots);
+	m_slots.assign(old.size() * 2, Slot{0, EMPTY});
+	m_mask = m_slots.size() - 1;
+
+	// Positions need the full hash, the stored part is not enough for tables above 2^32 slots.
+	for(const Slot& slot : old) {
+		if(slot.index == EMPTY) {
+			continue;
+		}
+
+		size_t i = hashBytes(m_mesh.vertices[slot.index]) & m_mask;
+		while(m_slots[i].index != EMPTY) {
+			i = (i + 1) & m_mask;
+		}
+		m_slots[i] = slot;
+	}
+}
+
+MeshData& VertexDeduplicator::mesh() {
+	return m_mesh;
+}
+
+
+MeshBounds computeBounds(const Vertex* vertices, size_t vertexCount) {
+	MeshBounds bounds{};
+	if(vertexCount == 0) {
+		return bounds;
+	}
+
+	bounds.min = bounds.max = vertices[0].pos;
+	for(size_t i = 1; i != vertexCount; ++i) {
+		bounds.min = glm::min(bounds.min, vertices[i].pos);
+		bounds.max = glm::max(bounds.max, vertices[i].pos);
+	}
+	return bounds;
+}
+
+BoundingSphere boundingSphere(const MeshBounds& bounds) {
+	BoundingSphere sphere;
+	sphere.center = 0.5f * (bounds.min + bounds.max);
+	sphere.radius = 0.5f * glm::length(bounds.max - bounds.min);
+	return sphere;
+}
+
+BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& transform) {
+	const float scale = glm::sqrt(glm::max(glm::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+	                                                glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+	                                       glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+
+	BoundingSphere transformed;
+	transformed.center = glm::vec3(transform * glm::vec4(sphere.center, 1.0f));
+	transformed.radius = sphere.radius * scale;
+	return transformed;
+}
+
+MeshData loadObj(const std::string& path, JobSystem* jobs) {
+	const MappedFile file(path);
+
+	MeshData mesh;
+	if(parseObj(file.data(), file.size(), mesh, jobs)) {
+		return mesh;
+	}
+	return loadObjTinyobj(path);
+}
+
+MeshData loadObjTinyobj(const std::string& path) {
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str())) {
+		throw std::runtime_error(warn + err);
+	}
+
+	size_t indexCount = 0;
+	for (const auto& shape : shapes) {
+		indexCount += shape.mesh.indices.size();
+	}
+
+	// Typical meshes share every vertex between ~4-6 triangle corners.
+	VertexDeduplicator deduplicator{indexCount / 4};
+	deduplicator.mesh().indices.reserve(indexCount);
+
+	for (const auto& shape : shapes) {
+		for (const auto& index : shape.mesh.indices) {
+			Vertex vertex{};
+			vertex.pos = {
+					attrib.vertices[3 * index.vertex_index + 0],
+					attrib.vertices[3 * index.vertex_index + 1],
+					attrib.vertices[3 * index.vertex_index + 2]
+			};
+			if (index.texcoord_index >= 0) {
+				vertex.texCoord = {
+						attrib.texcoords[2 * index.texcoord_index + 0],
+						1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+				};
+			}
+			vertex.color = {1.0f, 1.0f, 1.0f};
+
+			deduplicator.add(vertex);
+		}
+	}
+
+	MeshData& mesh = deduplicator.mesh();
+	mesh.bounds = computeBounds(mesh.vertices.data(), mesh.vertices.size());
+	return std::move(mesh);
+}
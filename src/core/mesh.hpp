@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vertex.hpp"
+
+class JobSystem;
+
+//! Axis aligned bounding box in model space.
+struct MeshBounds {
+	glm::vec3 min{0.0f};
+	glm::vec3 max{0.0f};
+};
+
+//! Sphere around a mesh, cheaper to test than a box (eg. for culling).
+struct BoundingSphere {
+	glm::vec3 center{0.0f};
+	float radius = 0.0f;
+};
+
+//! Indexed geometry on the CPU side, ready to be uploaded.
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	MeshBounds bounds;
+};
+
+MeshBounds computeBounds(const Vertex* vertices, size_t vertexCount);
+//! Sphere around the box: Its center and half of its diagonal.
+BoundingSphere boundingSphere(const MeshBounds& bounds);
+//! Sphere around the transformed sphere. The radius is scaled by the largest scale of the transform.
+BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& transform);
+
+//! Builds indexed geometry from a stream of vertices: Every vertex is stored once and referenced by its index.
+//! Uses an open addressing hash table (linear probing) over the vertex bytes instead of std::unordered_map,
+//! which needs one heap allocation per entry and chases pointers on every lookup.
+class VertexDeduplicator {
+public:
+	//! @param expectedVertices Number of unique vertices to reserve space for. The table grows if needed.
+	explicit VertexDeduplicator(size_t expectedVertices = 0);
+
+	//! Append the index of the vertex to the mesh. The vertex itself is only appended if it was not seen before.
+	void add(const Vertex& vertex);
+
+	MeshData& mesh();
+
+	//! Hash of the vertex bytes. -0.0 and 0.0 compare equal and therefore hash equal.
+	static uint64_t hash(const Vertex& vertex);
+
+private:
+	struct Slot {
+		uint32_t hash;   //! High bits of the hash, avoids comparing vertices for most collisions
+		uint32_t index;  //! Index into the vertices of the mesh, EMPTY if unused
+	};
+	static constexpr uint32_t EMPTY = ~0u;
+
+	void grow();
+
+private:
+	MeshData m_mesh;
+	std::vector<Slot> m_slots;  //! Size is a power of two
+	size_t m_mask = 0;
+};
+
+//! Load an OBJ file into deduplicated, indexed vertices.
+//! Uses parseObj() and falls back to loadObjTinyobj() for files it does not support.
+//! @param jobs Parse on all threads of the job system, otherwise on the calling thread.
+MeshData loadObj(const std::string& path, JobSystem* jobs = nullptr);
+//! Load an OBJ file with tinyobjloader. Supports every feature of the format, but is single threaded.
+MeshData loadObjTinyobj(const std::string& path);
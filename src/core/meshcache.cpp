@@ -0,0 +1,224 @@
+#include "meshcache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+struct MeshCache::Header {
+	char magic[4];
+	uint32_t version;
+
+	// Key: The cache is stale if any of these differ from the source file.
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	uint32_t sourcePathLength;  //! Stored path catches collisions of the file name hash
+
+	// Vertex layout
+	uint32_t vertexStride;
+	uint32_t attributeCount;
+	uint32_t indexSize;
+
+	uint64_t vertexCount;
+	uint64_t indexCount;
+
+	// Byte offsets from the start of the file
+	uint64_t attributeOffset;
+	uint64_t pathOffset;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+struct CachedAttribute {
+	uint32_t location;
+	uint32_t format;
+	uint32_t offset;
+};
+
+static constexpr char MAGIC[4] = {'L', 'W', 'M', 'C'};
+static constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static std::vector<CachedAttribute> vertexLayout() {
+	std::vector<CachedAttribute> layout;
+	for(const auto& attribute : Vertex::getAttributeDescriptions()) {
+		layout.push_back({attribute.location, static_cast<uint32_t>(attribute.format), attribute.offset});
+	}
+	return layout;
+}
+
+MeshCache::MeshCache(const std::string& sourcePath, const std::filesystem::path& directory) {
+	std::error_code error;
+	m_sourcePath = std::filesystem::absolute(sourcePath, error).string();
+	m_sourceSize = std::filesystem::file_size(m_sourcePath, error);
+	m_sourceTime = static_cast<int64_t>(std::filesystem::last_write_time(m_sourcePath, error).time_since_epoch().count());
+
+	// FNV-1a of the path as file name.
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for(char c : m_sourcePath) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.lwmesh", static_cast<unsigned long long>(hash));
+	m_cachePath = directory / name;
+}
+
+std::filesystem::path MeshCache::defaultDirectory() {
+	std::error_code error;
+	return std::filesystem::temp_directory_path(error) / "lwEngine" / "meshes";
+}
+
+const std::filesystem::path& MeshCache::path() const {
+	return m_cachePath;
+}
+
+bool MeshCache::load() {
+	m_header = nullptr;
+	m_file.reset();
+
+	std::error_code error;
+	if(!std::filesystem::is_regular_file(m_cachePath, error)) {
+		return false;
+	}
+
+	try {
+		m_file = std::make_unique<MappedFile>(m_cachePath.string());
+	} catch(const std::runtime_error&) {
+		return false;
+	}
+
+	const char* data = m_file->data();
+	const uint64_t fileSize = m_file->size();
+	if(fileSize < sizeof(Header)) {
+		m_file.reset();
+		return false;
+	}
+
+	const Header* header = reinterpret_cast<const Header*>(data);
+	const std::vector<CachedAttribute> layout = vertexLayout();
+
+	auto inside = [fileSize](uint64_t offset, uint64_t size) {
+		return offset <= fileSize && size <= fileSize - offset;
+	};
+
+	bool valid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+	             && header->version == VERSION
+	             && header->sourceSize == m_sourceSize
+	             && header->sourceTime == m_sourceTime
+	             && header->sourcePathLength == m_sourcePath.size()
+	             && header->vertexStride == sizeof(Vertex)
+	             && header->attributeCount == layout.size()
+	             && header->indexSize == sizeof(uint32_t)
+	             && header->vertexCount <= UINT32_MAX
+	             && header->indexCount <= UINT32_MAX
+	             && inside(header->attributeOffset, layout.size() * sizeof(CachedAttribute))
+	             && inside(header->pathOffset, header->sourcePathLength)
+	             && inside(header->vertexOffset, header->vertexCount * sizeof(Vertex))
+	             && inside(header->indexOffset, header->indexCount * sizeof(uint32_t));
+
+	valid = valid
+	        && memcmp(data + header->attributeOffset, layout.data(), layout.size() * sizeof(CachedAttribute)) == 0
+	        && memcmp(data + header->pathOffset, m_sourcePath.data(), m_sourcePath.size()) == 0;
+
+	if(!valid) {
+		m_file.reset();
+		return false;
+	}
+
+	m_header = header;
+	return true;
+}
+
+bool MeshCache::store(const MeshData& mesh) const {
+	const std::vector<CachedAttribute> layout = vertexLayout();
+
+	Header header{};
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sourceSize = m_sourceSize;
+	header.sourceTime = m_sourceTime;
+	header.sourcePathLength = static_cast<uint32_t>(m_sourcePath.size());
+	header.vertexStride = sizeof(Vertex);
+	header.attributeCount = static_cast<uint32_t>(layout.size());
+	header.indexSize = sizeof(uint32_t);
+	header.vertexCount = mesh.vertices.size();
+	header.indexCount = mesh.indices.size();
+
+	header.attributeOffset = sizeof(Header);
+	header.pathOffset = header.attributeOffset + layout.size() * sizeof(CachedAttribute);
+	header.vertexOffset = alignUp(header.pathOffset + m_sourcePath.size(), BLOB_ALIGNMENT);
+	header.indexOffset = alignUp(header.vertexOffset + mesh.vertices.size() * sizeof(Vertex), BLOB_ALIGNMENT);
+
+	for(int i = 0; i != 3; ++i) {
+		header.boundsMin[i] = mesh.bounds.min[i];
+		header.boundsMax[i] = mesh.bounds.max[i];
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(m_cachePath.parent_path(), error);
+
+	// Write to a temporary file first: A crash while writing must not leave a broken cache behind.
+	// Every writer has its own, decode jobs may store the same mesh at once (eg. one model with two textures).
+	const std::filesystem::path tempPath = temporaryPath(m_cachePath);
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if(!file.is_open()) {
+			return false;
+		}
+
+		const char padding[BLOB_ALIGNMENT] = {};
+		auto pad = [&](uint64_t offset) {
+			file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+		};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(layout.data()), static_cast<std::streamsize>(layout.size() * sizeof(CachedAttribute)));
+		file.write(m_sourcePath.data(), static_cast<std::streamsize>(m_sourcePath.size()));
+		pad(header.vertexOffset);
+		file.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(mesh.vertices.size() * sizeof(Vertex)));
+		pad(header.indexOffset);
+		file.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(uint32_t)));
+
+		if(!file.good()) {
+			file.close();
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, m_cachePath, error);
+	if(error) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+const Vertex* MeshCache::vertices() const {
+	return reinterpret_cast<const Vertex*>(m_file->data() + m_header->vertexOffset);
+}
+
+uint32_t MeshCache::vertexCount() const {
+	return static_cast<uint32_t>(m_header->vertexCount);
+}
+
+const uint32_t* MeshCache::indices() const {
+	return reinterpret_cast<const uint32_t*>(m_file->data() + m_header->indexOffset);
+}
+
+uint32_t MeshCache::indexCount() const {
+	return static_cast<uint32_t>(m_header->indexCount);
+}
+
+MeshBounds MeshCache::bounds() const {
+	MeshBounds bounds{};
+	bounds.min = {m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]};
+	bounds.max = {m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]};
+	return bounds;
+}
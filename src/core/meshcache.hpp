@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "file.hpp"
+#include "mesh.hpp"
+
+//! Binary copy of an imported mesh, so warm starts skip the OBJ parser.
+//!
+//! The cache file is keyed by the absolute source path and only valid while size and modification time of the
+//! source match. It holds a versioned header, the vertex layout, the vertex and index blobs and the bounds.
+//! Loading maps the file; The blobs can be copied straight into staging memory.
+class MeshCache {
+public:
+	static constexpr uint32_t VERSION = 1;
+
+	//! @param directory Where cache files are stored, one per source file.
+	explicit MeshCache(const std::string& sourcePath, const std::filesystem::path& directory = defaultDirectory());
+
+	//! Map the cache file.
+	//! @return False if there is no cache file or it is stale (source changed, other version or vertex layout).
+	bool load();
+	//! Write the mesh to the cache file. Replaces the file atomically so readers never see a partial file.
+	//! Several writers of the same file may run at once, each writes its own temporary file.
+	//! @return False if the cache file could not be written; The cache is an optimization, so this is not fatal.
+	bool store(const MeshData& mesh) const;
+
+	// Valid after a successful load().
+	const Vertex* vertices() const;
+	uint32_t vertexCount() const;
+	const uint32_t* indices() const;
+	uint32_t indexCount() const;
+	MeshBounds bounds() const;
+
+	const std::filesystem::path& path() const;
+
+	//! Temporary directory of the system.
+	static std::filesystem::path defaultDirectory();
+
+private:
+	struct Header;
+
+private:
+	std::string m_sourcePath;
+	std::filesystem::path m_cachePath;
+	uint64_t m_sourceSize = 0;
+	int64_t m_sourceTime = 0;
+
+	std::unique_ptr<MappedFile> m_file;
+	const Header* m_header = nullptr;
+};
@@ -0,0 +1,57 @@
+#include "meshpool.hpp"
+
+MeshPool::MeshPool(Device& device, uint32_t vertexCapacity, uint32_t indexCapacity) {
+	m_vertexBuffer = std::make_unique<Buffer>(device, sizeof(Vertex), vertexCapacity,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	m_indexBuffer = std::make_unique<Buffer>(device, sizeof(uint32_t), indexCapacity,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+MeshRange MeshPool::add(UploadBatch& upload, const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const MeshBounds& bounds) {
+	if(vertexCount > m_vertexBuffer->getInstanceCount() - m_vertexCount || indexCount > m_indexBuffer->getInstanceCount() - m_indexCount) {
+		throw std::runtime_error("Failed to add mesh, the mesh pool is full!");
+	}
+
+	MeshRange range;
+	range.firstIndex = m_indexCount;
+	range.indexCount = indexCount;
+	range.vertexOffset = static_cast<int32_t>(m_vertexCount);
+	range.bounds = bounds;
+
+	if(vertexCount != 0) {
+		upload.uploadBuffer(vertices, static_cast<VkDeviceSize>(vertexCount) * sizeof(Vertex), m_vertexBuffer->getBuffer(),
+		                    static_cast<VkDeviceSize>(m_vertexCount) * sizeof(Vertex));
+	}
+	if(indexCount != 0) {
+		upload.uploadBuffer(indices, static_cast<VkDeviceSize>(indexCount) * sizeof(uint32_t), m_indexBuffer->getBuffer(),
+		                    static_cast<VkDeviceSize>(m_indexCount) * sizeof(uint32_t));
+	}
+
+	m_vertexCount += vertexCount;
+	m_indexCount += indexCount;
+	return range;
+}
+
+MeshRange MeshPool::add(UploadBatch& upload, const MeshData& mesh) {
+	return add(upload, mesh.vertices.data(), static_cast<uint32_t>(mesh.vertices.size()),
+	           mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()), mesh.bounds);
+}
+
+void MeshPool::bind(VkCommandBuffer commandBuffer) const {
+	VkBuffer vertexBuffers[] = {m_vertexBuffer->getBuffer()};
+	VkDeviceSize offsets[] = {0};
+
+	vkCmdBindVertexBuffers(commandBuffer, Vertex::VERTEX_BINDING, 1, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+}
+
+uint32_t MeshPool::vertexCount() const {
+	return m_vertexCount;
+}
+
+uint32_t MeshPool::indexCount() const {
+	return m_indexCount;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+
+#include "buffer.hpp"
+#include "mesh.hpp"
+#include "upload.hpp"
+
+//! Place of one mesh inside a MeshPool, the arguments of its indexed draw.
+struct MeshRange {
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	int32_t vertexOffset = 0;  //! Added to every index: Indices stay relative to the mesh.
+	MeshBounds bounds;
+};
+
+//! Mega buffer: The vertices and indices of many meshes share one vertex and one index buffer.
+//! All meshes are drawn after a single bind, which allows to draw them with one indirect draw (see IndirectDrawBuffer).
+//! Meshes are appended and live as long as the pool.
+class MeshPool {
+public:
+	MeshPool(Device& device, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+	MeshPool(const MeshPool&) = delete;
+	MeshPool& operator=(const MeshPool&) = delete;
+
+	//! Record the copies of the mesh into the batch. The mesh can be drawn once the batch is complete.
+	//! Throws if the pool is full.
+	MeshRange add(UploadBatch& upload, const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const MeshBounds& bounds);
+	MeshRange add(UploadBatch& upload, const MeshData& mesh);
+
+	void bind(VkCommandBuffer commandBuffer) const;  //! Bind the shared vertex and index buffer.
+
+	uint32_t vertexCount() const;  //! Vertices in use
+	uint32_t indexCount() const;   //! Indices in use
+
+private:
+	std::unique_ptr<Buffer> m_vertexBuffer;
+	std::unique_ptr<Buffer> m_indexBuffer;
+	uint32_t m_vertexCount = 0;
+	uint32_t m_indexCount = 0;
+};
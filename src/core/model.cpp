@@ -1,349 +1,103 @@
 #include "model.hpp"
 
-#include <exception>
-#include <unordered_map>
+#include <cassert>
 #include <filesystem>
 
-#include "vertex.hpp"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tol/tiny_obj_loader.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb/stb_image.h"
-
 Model::Model(Device& device, const std::string pathModel, const std::string pathTexture)
-	: m_device(device), m_pathModel(pathModel), m_pathTexture(pathTexture)
+	: m_pathModel(pathModel), m_pathTexture(pathTexture)
 {
-	assert(std::filesystem::is_regular_file(pathModel));
-	assert(std::filesystem::is_regular_file(pathTexture));
+	// Record all copies into one command buffer and wait once instead of stalling the queue for every copy.
+	UploadBatch upload{device};
+	load(device, upload, nullptr);
 
-	createTextureImage();
-	createTextureImageView();
-	createTextureSampler();
-
-	loadModel();
+	upload.submit();
+	upload.wait();
 }
 
-VkDescriptorImageInfo Model::descriptorInfo() {
-	VkDescriptorImageInfo imageInfo{};
-	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imageInfo.imageView = m_textureImageView;
-	imageInfo.sampler = m_textureSampler;
-
-	return imageInfo;
+Model::Model(Device& device, UploadBatch& upload, const std::string pathModel, const std::string pathTexture)
+	: m_pathModel(pathModel), m_pathTexture(pathTexture)
+{
+	load(device, upload, nullptr);
 }
 
-void Model::loadModel() {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
-
-	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, m_pathModel.c_str())) {
-		throw std::runtime_error(warn + err);
-	}
-
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-
-	// Only use unique vertices to same memory.
-	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-	for (const auto& shape : shapes) {
-		for (const auto& index : shape.mesh.indices) {
-			Vertex vertex{};
-			vertex.pos = {
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-			};
-			vertex.texCoord = {
-					attrib.texcoords[2 * index.texcoord_index + 0],
-					1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-			};
-			vertex.color = {1.0f, 1.0f, 1.0f};
-
-			if (uniqueVertices.find(vertex) == uniqueVertices.end()) {
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				// vertices.push_back(vertex); // TODO: Only using unique verices does not work for some reason..
-			}
-			vertices.push_back(vertex);
-			indices.push_back(indices.size());
-		}
-	}
+Model::Model(Device& device, MeshPool& meshPool, const std::string pathModel, const std::string pathTexture)
+	: m_pathModel(pathModel), m_pathTexture(pathTexture)
+{
+	UploadBatch upload{device};
+	load(device, upload, &meshPool);
 
-	// We only need the data in GPU memory -> Don't keep a copy in the class.
-	if(!vertices.empty()) {
-		createVertexBuffer(vertices);
-		createIndexBuffer(indices);
-	}
+	upload.submit();
+	upload.wait();
 }
 
-void Model::createVertexBuffer(std::vector<Vertex>& vertices) {
-	uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
-	uint32_t vertexSize = sizeof(vertices[0]);
-	VkDeviceSize bufferSize = vertexSize * vertexCount;
+Model::Model(Device& device, UploadBatch& upload, const ModelData& data, MeshPool* meshPool)
+	: m_pathModel(data.pathModel), m_pathTexture(data.pathTexture),
+	  m_mesh(std::make_shared<GpuMesh>(device, upload, data.mesh, meshPool)),
+	  m_texture(std::make_shared<GpuTexture>(device, upload, data.texture))
+{}
 
-	Buffer stagingBuffer{m_device, vertexSize,vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	};
-
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer((void *)vertices.data());
-
-	m_vertexBuffer = std::make_unique<Buffer>(m_device, vertexSize, vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	m_device.copyBuffer(stagingBuffer.getBuffer(), m_vertexBuffer->getBuffer(), bufferSize);
+Model::Model(std::shared_ptr<GpuMesh> mesh, std::shared_ptr<GpuTexture> texture)
+	: m_mesh(std::move(mesh)), m_texture(std::move(texture))
+{
+	assert(m_mesh && m_texture);
 }
 
-void Model::createIndexBuffer(std::vector<uint32_t>& indices) {
-	m_hasIndexBuffer = !indices.empty();
-	if(!m_hasIndexBuffer) {
-		return;
-	}
-
-	uint32_t indexCount = static_cast<uint32_t>(indices.size());
-	uint32_t indexSize = sizeof(indices[0]);
-	VkDeviceSize bufferSize = indexSize * indexCount;
-
-	Buffer stagingBuffer{m_device,indexSize,indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	};
-
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer((void *)indices.data());
+void Model::load(Device& device, UploadBatch& upload, MeshPool* meshPool) {
+	assert(std::filesystem::is_regular_file(m_pathModel));
+	assert(std::filesystem::is_regular_file(m_pathTexture));
 
-	m_indexBuffer = std::make_unique<Buffer>(m_device, indexSize,indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	m_device.copyBuffer(stagingBuffer.getBuffer(), m_indexBuffer->getBuffer(), bufferSize);
+	const ModelData data = loadModelData(m_pathModel, m_pathTexture);
+	m_mesh = std::make_shared<GpuMesh>(device, upload, data.mesh, meshPool);
+	m_texture = std::make_shared<GpuTexture>(device, upload, data.texture);
 }
 
-void Model::createTextureImage() {
-	// Read image
-	int texWidth, texHeight, texChannels;
-	stbi_uc* pixels = stbi_load(m_pathTexture.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = texWidth * texHeight * 4;  // 4 Bytes per pixel
-	if(!pixels) {
-		throw std::runtime_error("Failed to load texture image!");
-	}
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	m_device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-	void* data = nullptr;
-	vkMapMemory(m_device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(m_device.device(), stagingBufferMemory);
-
-	stbi_image_free(pixels);
-
-	createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-	            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-	            m_textureImage, m_textureImageMemory);
-
-	transitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	copyBufferToImage(stagingBuffer, m_textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-
-	// Prepare for use in shader.
-	transitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-	// Cleanup
-	vkDestroyBuffer(m_device.device(), stagingBuffer, nullptr);
-	vkFreeMemory(m_device.device(), stagingBufferMemory, nullptr);
+ModelData loadModelData(const std::string& pathModel, const std::string& pathTexture) {
+	ModelData data;
+	data.pathModel = pathModel;
+	data.pathTexture = pathTexture;
+	data.texture = loadTexture(pathTexture);
+	data.mesh = loadMeshSource(pathModel);
+	return data;
 }
 
-void Model::bind(VkCommandBuffer commandBuffer) {
-	VkBuffer vertexBuffers[] = {m_vertexBuffer->getBuffer()};
-	VkDeviceSize offsets[] = {0};
-
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-	if(m_hasIndexBuffer) {
-		vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-	}
+MeshBounds Model::bounds() const {
+	return m_mesh->bounds();
 }
 
-void Model::draw(VkCommandBuffer commandBuffer) {
-	if(m_hasIndexBuffer) {
-		vkCmdDrawIndexed(commandBuffer, m_indexBuffer->getInstanceCount(), 1, 0, 0, 0);
-	} else {
-		vkCmdDraw(commandBuffer, m_vertexBuffer->getInstanceCount(), 1, 0, 0);
-	}
+BoundingSphere Model::boundingSphere() const {
+	return m_mesh->boundingSphere();
 }
 
-void Model::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
-	VkCommandBuffer commandBuffer = m_device.beginSingleTimeCommands();
-
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-
-	// Handle different transition types
-	VkPipelineStageFlags sourceStage;
-	VkPipelineStageFlags destinationStage;
-
-	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-		barrier.srcAccessMask = 0;
-		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	} else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	} else {
-		throw std::invalid_argument("Unsupported layout transition!");
-	}
-
-	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-	m_device.endSingleTimeCommands(commandBuffer);
+const MeshRange& Model::meshRange() const {
+	return m_mesh->meshRange();
 }
 
-void Model::createTextureImageView() {
-	m_textureImageView = createImageView(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+const std::shared_ptr<GpuMesh>& Model::mesh() const {
+	return m_mesh;
 }
 
-VkImageView Model::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
-	VkImageViewCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	createInfo.image = image;
-	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	createInfo.format = format;
-
-	createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-	createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-	createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-	createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-
-	createInfo.subresourceRange.aspectMask = aspectFlags;
-	createInfo.subresourceRange.baseMipLevel = 0;
-	createInfo.subresourceRange.levelCount = 1;
-	createInfo.subresourceRange.baseArrayLayer = 0;
-	createInfo.subresourceRange.layerCount = 1;
-
-	VkImageView imageView;
-	if(vkCreateImageView(m_device.device(), &createInfo, nullptr, &imageView) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create image views!");
-	}
-
-	return imageView;
+const std::shared_ptr<GpuTexture>& Model::texture() const {
+	return m_texture;
 }
 
-
-void Model::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-	VkCommandBuffer commandBuffer = m_device.beginSingleTimeCommands();
-
-	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
-	region.bufferRowLength = 0;
-	region.bufferImageHeight = 0;
-
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount = 1;
-
-	region.imageOffset = {0, 0, 0};
-	region.imageExtent = {width, height, 1};
-
-	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	m_device.endSingleTimeCommands(commandBuffer);
+VkDescriptorImageInfo Model::descriptorInfo() {
+	return m_texture->descriptorInfo();
 }
 
-void Model::createTextureSampler() {
-	VkSamplerCreateInfo samplerInfo{};
-	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-	samplerInfo.magFilter = VK_FILTER_LINEAR;
-	samplerInfo.minFilter = VK_FILTER_LINEAR;
-	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-
-	samplerInfo.anisotropyEnable = VK_TRUE;  // NOTE: Turn off for better performance
-	VkPhysicalDeviceProperties properties{};
-	vkGetPhysicalDeviceProperties(m_device.physicalDevice(), &properties);
-	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy; // NOTE: Lower value for better performance
-
-	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-	samplerInfo.unnormalizedCoordinates = VK_FALSE;
-	samplerInfo.compareEnable = VK_FALSE;
-	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-	samplerInfo.mipLodBias = 0.0f;
-	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = 0.0f;
-
-	if (vkCreateSampler(m_device.device(), &samplerInfo, nullptr, &m_textureSampler) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to create texture sampler!");
-	}
+void Model::bind(VkCommandBuffer commandBuffer) {
+	m_mesh->bind(commandBuffer);
 }
 
-void Model::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-                            VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
-{
-	// Create vulkan image
-	VkImageCreateInfo imageInfo{};
-	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-	imageInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageInfo.extent.width = width;
-	imageInfo.extent.height = height;
-	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
-	imageInfo.arrayLayers = 1;
-	imageInfo.format = format;
-	imageInfo.tiling = tiling;
-	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageInfo.usage = usage;
-	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	if (vkCreateImage(m_device.device(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create image!");
-	}
-
-	// Bind image to memory
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(m_device.device(), image, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = m_device.findMemoryType(memRequirements.memoryTypeBits, properties);
+void Model::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) {
+	m_mesh->draw(commandBuffer, instanceCount, firstInstance);
+}
 
-	if (vkAllocateMemory(m_device.device(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-		throw std::runtime_error("failed to allocate image memory!");
+void Model::drawInstanced(VkCommandBuffer commandBuffer, const InstanceBuffer& instances, uint32_t frame) {
+	if(instances.count(frame) == 0) {
+		return;
 	}
 
-	vkBindImageMemory(m_device.device(), image, imageMemory, 0);
+	bind(commandBuffer);
+	instances.bind(commandBuffer, frame);
+	draw(commandBuffer, instances.count(frame));
 }
-
-
-Model::~Model() {
-	vkDestroySampler(m_device.device(), m_textureSampler, nullptr);
-
-	vkDestroyImageView(m_device.device(), m_textureImageView, nullptr);
-	vkDestroyImage(m_device.device(), m_textureImage, nullptr);
-	vkFreeMemory(m_device.device(), m_textureImageMemory, nullptr);
-}
\ No newline at end of file
@@ -1,55 +1,72 @@
 #pragma once
 
 #include "device.hpp"
-#include "buffer.hpp"
-#include "vertex.hpp"
+#include "upload.hpp"
+#include "mesh.hpp"
+#include "instancebuffer.hpp"
+#include "meshpool.hpp"
+#include "gpumesh.hpp"
+#include "gputexture.hpp"
+#include "texture.hpp"
 
 #include <string>
 #include <vector>
 #include <memory>
 
+//! Files of a model read and decoded on the CPU, see loadModelData(). Holds no Vulkan objects.
+struct ModelData {
+	std::string pathModel;
+	std::string pathTexture;
+	MeshSource mesh;
+	TextureData texture;
+};
+
+//! Read the mesh (from its cache if valid) and decode the texture. Thread safe, eg. for worker threads.
+ModelData loadModelData(const std::string& pathModel, const std::string& pathTexture);
+
+//! Mesh drawn with a texture. Both are GPU resources of their own, models loaded through an AssetCache share them
+//! with every other model using the same files.
 class Model {
 public:
+	//! Upload the model and block until it is in GPU memory.
 	Model(Device& device, const std::string pathModel, const std::string pathTexture);
-	~Model();
+	//! Record the uploads into the batch of the caller to stream models in while rendering.
+	//! The model must not be drawn before the batch is complete.
+	Model(Device& device, UploadBatch& upload, const std::string pathModel, const std::string pathTexture);
+	//! Upload the mesh into the shared buffers of the pool instead of buffers of its own, and block until it is in GPU memory.
+	//! All models of a pool can be drawn after one bind, eg. with an IndirectDrawBuffer and meshRange().
+	Model(Device& device, MeshPool& meshPool, const std::string pathModel, const std::string pathTexture);
+	//! Create the GPU resources of data loaded before, eg. on a worker thread. Records the uploads into the batch.
+	//! @param meshPool Upload the mesh into the pool if set.
+	Model(Device& device, UploadBatch& upload, const ModelData& data, MeshPool* meshPool = nullptr);
+	//! Draw resources that already exist, eg. from an AssetCache.
+	Model(std::shared_ptr<GpuMesh> mesh, std::shared_ptr<GpuTexture> texture);
 
 	void bind(VkCommandBuffer commandBuffer);  //! Bind vertices and indices to command buffer.
-	void draw(VkCommandBuffer commandBuffer);  //! Add draw command to command buffer.
+	void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);  //! Add draw command to command buffer.
+	//! Bind the instances of the frame and draw all of them with one draw command. Requires an instanced pipeline.
+	void drawInstanced(VkCommandBuffer commandBuffer, const InstanceBuffer& instances, uint32_t frame);
 
 	//! Get descriptor information for the texture image and sampler.
 	VkDescriptorImageInfo descriptorInfo();
 
-private:
-	//! Load model files and write to GPU buffers.
-	void loadModel();
-
-	void createVertexBuffer(std::vector<Vertex>& vertices);
-	void createIndexBuffer(std::vector<uint32_t>& indices);
-
-	// Texture TODO: Better design.. Should this be in here? Some functions are duplicated.
-	void createTextureSampler();
-	void createTextureImage();
-	void createTextureImageView();
-	void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-	                 VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+	//! Model space bounding box of the vertices.
+	MeshBounds bounds() const;
+	//! Model space bounding sphere, eg. for culling.
+	BoundingSphere boundingSphere() const;
+	//! Draw arguments in the mesh pool. Only valid for models in a mesh pool.
+	const MeshRange& meshRange() const;
+
+	const std::shared_ptr<GpuMesh>& mesh() const;
+	const std::shared_ptr<GpuTexture>& texture() const;
 
 private:
-	// Owned by application
-	Device& m_device;
+	void load(Device& device, UploadBatch& upload, MeshPool* meshPool);
 
+private:
 	std::string m_pathModel;
 	std::string m_pathTexture;
 
-	std::unique_ptr<Buffer> m_vertexBuffer;
-	std::unique_ptr<Buffer> m_indexBuffer;
-	bool m_hasIndexBuffer = false;  //! Vertices can also be drawn non indexed.
-
-	VkSampler m_textureSampler;
-
-	VkImage m_textureImage;
-	VkDeviceMemory m_textureImageMemory;
-	VkImageView m_textureImageView;
+	std::shared_ptr<GpuMesh> m_mesh;
+	std::shared_ptr<GpuTexture> m_texture;
 };
@@ -0,0 +1,529 @@
+#include "objparser.hpp"
+#include "jobsystem.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <string>
+
+// Chunks smaller than this are not worth a job.
+static constexpr size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+enum class ObjRecord {
+	Ignored,
+	Position,
+	TexCoord,
+	Face,
+	Unsupported
+};
+
+struct ObjCorner {
+	int32_t position;
+	int32_t texCoord;  //! -1 if the face has no texture coordinates
+};
+
+struct ObjChunk {
+	const char* begin = nullptr;
+	const char* end = nullptr;  //! Behind a line break
+	std::string tail;           //! Last line of the file if it does not end with a line break
+
+	// First pass
+	size_t positionCount = 0;
+	size_t texCoordCount = 0;
+	size_t faceCount = 0;
+	bool supported = true;
+
+	// Index of the first position and texture coordinate of the chunk in the whole file
+	size_t positionBase = 0;
+	size_t texCoordBase = 0;
+
+	// Second pass
+	std::vector<ObjCorner> corners;  //! Triangles in file order
+	std::vector<size_t> quads;       //! Offset of the two triangles of every quad in corners
+};
+
+static bool isSpace(char c) {
+	return c == ' ' || c == '\t';
+}
+
+static bool isNewLine(char c) {
+	return c == '\r' || c == '\n' || c == '\0';
+}
+
+static bool isDigit(char c) {
+	return static_cast<unsigned int>(c - '0') < 10u;
+}
+
+static const char* skipSpaces(const char* token) {
+	while(isSpace(*token)) {
+		++token;
+	}
+	return token;
+}
+
+//! Call function for every line of the chunk. It gets the start of the line and returns how far it has read,
+//! the rest of the line is skipped. Every line ends with '\n', '\r' or '\0', so parsers never read past it.
+template<typename Function>
+static void forEachLine(const ObjChunk& chunk, Function function) {
+	const char* position = chunk.begin;
+	while(position != chunk.end) {
+		position = function(position);
+		while(*position != '\n' && *position != '\r') {
+			++position;
+		}
+		++position;
+	}
+
+	if(!chunk.tail.empty()) {
+		function(chunk.tail.c_str());
+	}
+}
+
+//! Call function(i) for every chunk, in parallel on the job system or on the calling thread without one.
+template<typename Function>
+static void parallelFor(JobSystem* jobs, size_t count, Function function) {
+	if(jobs == nullptr) {
+		for(size_t i = 0; i != count; ++i) {
+			function(i);
+		}
+		return;
+	}
+
+	jobs->parallelFor(static_cast<uint32_t>(count), 1, [&function](uint32_t first, uint32_t rangeCount) {
+		for(uint32_t i = first; i != first + rangeCount; ++i) {
+			function(i);
+		}
+	});
+}
+
+//! Moves the token behind the keyword of the records we parse.
+static ObjRecord classify(const char*& token) {
+	token = skipSpaces(token);
+
+	if(token[0] == 'v') {
+		if(isSpace(token[1])) {
+			token += 2;
+			return ObjRecord::Position;
+		}
+		if(token[1] == 't' && isSpace(token[2])) {
+			token += 3;
+			return ObjRecord::TexCoord;
+		}
+		if(token[1] == 'w' && isSpace(token[2])) {
+			return ObjRecord::Unsupported;
+		}
+		return ObjRecord::Ignored;
+	}
+
+	if(token[0] == 'f' && isSpace(token[1])) {
+		token += 2;
+		return ObjRecord::Face;
+	}
+
+	// The full loader rejects lines and points with invalid indices, so they have to go through it.
+	if((token[0] == 'l' || token[0] == 'p') && isSpace(token[1])) {
+		return ObjRecord::Unsupported;
+	}
+
+	return ObjRecord::Ignored;
+}
+
+//! Port of tryParseDouble() of tinyobjloader: The results have to be bit identical, so no strtod or other
+//! correctly rounding parser. Greedy, end is the end of the token and must point to a readable character.
+static bool parseDouble(const char* s, const char* end, double& result) {
+	if(s >= end) {
+		return false;
+	}
+
+	static constexpr double POW_LUT[] = {1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001};
+	static constexpr int LUT_ENTRIES = sizeof(POW_LUT) / sizeof(POW_LUT[0]);
+
+	double mantissa = 0.0;
+	int exponent = 0;  // Base 10
+	char sign = '+';
+	const char* current = s;
+	bool leadingDot = false;
+
+	if(*current == '+' || *current == '-') {
+		sign = *current;
+		++current;
+		leadingDot = current != end && *current == '.';
+	} else if(*current == '.') {
+		leadingDot = true;
+	} else if(!isDigit(*current)) {
+		return false;
+	}
+
+	// Integer part
+	if(!leadingDot) {
+		int read = 0;
+		while(current != end && isDigit(*current)) {
+			mantissa *= 10;
+			mantissa += static_cast<int>(*current - '0');
+			++current;
+			++read;
+		}
+		if(read == 0) {
+			return false;
+		}
+	}
+
+	if(current != end && (*current == '.' || *current == 'e' || *current == 'E')) {
+		// Decimal part
+		if(*current == '.') {
+			++current;
+			int read = 1;
+			while(current != end && isDigit(*current)) {
+				mantissa += static_cast<int>(*current - '0') * (read < LUT_ENTRIES ? POW_LUT[read] : std::pow(10.0, -read));
+				++read;
+				++current;
+			}
+		}
+
+		// Exponent part
+		if(current != end && (*current == 'e' || *current == 'E')) {
+			++current;
+			char exponentSign = '+';
+			if(current != end && (*current == '+' || *current == '-')) {
+				exponentSign = *current;
+				++current;
+			} else if(!isDigit(*current)) {
+				return false;
+			}
+
+			int read = 0;
+			while(current != end && isDigit(*current)) {
+				if(exponent > INT_MAX / 10) {
+					return false;
+				}
+				exponent *= 10;
+				exponent += static_cast<int>(*current - '0');
+				++current;
+				++read;
+			}
+			exponent *= exponentSign == '+' ? 1 : -1;
+			if(read == 0) {
+				return false;
+			}
+		}
+	}
+
+	result = (sign == '+' ? 1 : -1) * (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+	return true;
+}
+
+//! Invalid numbers are 0 like in the full loader.
+static float parseFloat(const char*& token) {
+	token = skipSpaces(token);
+	const char* end = token;
+	while(!isSpace(*end) && !isNewLine(*end)) {
+		++end;
+	}
+
+	double value = 0.0;
+	parseDouble(token, end, value);
+	token = end;
+	return static_cast<float>(value);
+}
+
+//! atoi() which stays on the current line.
+//! @return False on overflow: atoi() does not define the result, so the full loader has to decide.
+static bool parseInt(const char* token, int& value) {
+	while(*token == ' ' || *token == '\t' || *token == '\v' || *token == '\f') {
+		++token;
+	}
+
+	bool negative = false;
+	if(*token == '+' || *token == '-') {
+		negative = *token == '-';
+		++token;
+	}
+
+	int64_t result = 0;
+	while(isDigit(*token)) {
+		result = result * 10 + (*token - '0');
+		if(result > INT_MAX) {
+			return false;
+		}
+		++token;
+	}
+
+	value = static_cast<int>(negative ? -result : result);
+	return true;
+}
+
+//! One based index or relative to the count of elements before the line (negative). 0 is invalid.
+static bool parseIndex(const char* token, size_t count, int32_t& index) {
+	int value = 0;
+	if(!parseInt(token, value) || value == 0) {
+		return false;
+	}
+
+	const int64_t resolved = value > 0 ? value - 1 : static_cast<int64_t>(count) + value;
+	if(resolved < 0) {
+		return false;
+	}
+	index = static_cast<int32_t>(resolved);
+	return true;
+}
+
+static const char* skipIndex(const char* token) {
+	while(*token != '/' && !isSpace(*token) && !isNewLine(*token)) {
+		++token;
+	}
+	return token;
+}
+
+//! Corner of a face: v, v/vt, v//vn or v/vt/vn. Normals are not used but have to be valid.
+static bool parseCorner(const char*& token, size_t positionCount, size_t texCoordCount, ObjCorner& corner) {
+	int normal = 0;
+	corner.texCoord = -1;
+
+	if(!parseIndex(token, positionCount, corner.position)) {
+		return false;
+	}
+	token = skipIndex(token);
+	if(*token != '/') {
+		return true;
+	}
+	++token;
+
+	if(*token != '/') {
+		if(!parseIndex(token, texCoordCount, corner.texCoord)) {
+			return false;
+		}
+		token = skipIndex(token);
+		if(*token != '/') {
+			return true;
+		}
+	}
+	++token;
+
+	if(!parseInt(token, normal) || normal == 0) {
+		return false;
+	}
+	token = skipIndex(token);
+	return true;
+}
+
+//! Triangles are stored as they are, quads split later when all positions are known.
+static bool parseFace(const char*& token, size_t positionCount, size_t texCoordCount, ObjChunk& chunk) {
+	ObjCorner face[4];
+	size_t cornerCount = 0;
+
+	token = skipSpaces(token);
+	while(!isNewLine(*token)) {
+		// Polygons need the ear clipping of the full loader.
+		if(cornerCount == 4) {
+			return false;
+		}
+		if(!parseCorner(token, positionCount, texCoordCount, face[cornerCount])) {
+			return false;
+		}
+		++cornerCount;
+		token = skipSpaces(token);
+	}
+
+	if(cornerCount == 3) {
+		chunk.corners.insert(chunk.corners.end(), face, face + 3);
+	} else if(cornerCount == 4) {
+		// The full loader splits quads when the face group is exported and only sees the positions defined until
+		// then. Positions defined before the face are always visible.
+		for(const ObjCorner& corner : face) {
+			if(static_cast<size_t>(corner.position) >= positionCount) {
+				return false;
+			}
+		}
+
+		chunk.quads.push_back(chunk.corners.size());
+		const ObjCorner triangles[6] = {face[0], face[1], face[2], face[0], face[2], face[3]};
+		chunk.corners.insert(chunk.corners.end(), triangles, triangles + 6);
+	}
+
+	// Faces with less than three corners are skipped.
+	return true;
+}
+
+//! Split along the shorter diagonal, same arithmetic as the full loader.
+static void splitQuad(ObjCorner* corners, const std::vector<float>& positions) {
+	const float* v0 = &positions[3 * static_cast<size_t>(corners[0].position)];
+	const float* v1 = &positions[3 * static_cast<size_t>(corners[1].position)];
+	const float* v2 = &positions[3 * static_cast<size_t>(corners[2].position)];
+	const float* v3 = &positions[3 * static_cast<size_t>(corners[5].position)];
+
+	const float e02x = v2[0] - v0[0];
+	const float e02y = v2[1] - v0[1];
+	const float e02z = v2[2] - v0[2];
+	const float e13x = v3[0] - v1[0];
+	const float e13y = v3[1] - v1[1];
+	const float e13z = v3[2] - v1[2];
+
+	const float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+	const float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+
+	// Stored as [0, 1, 2], [0, 2, 3]
+	if(!(sqr02 < sqr13)) {
+		const ObjCorner c0 = corners[0], c1 = corners[1], c2 = corners[2], c3 = corners[5];
+		const ObjCorner triangles[6] = {c0, c1, c3, c1, c2, c3};
+		std::copy(triangles, triangles + 6, corners);
+	}
+}
+
+bool parseObj(const char* data, size_t size, MeshData& mesh, JobSystem* jobs) {
+	const size_t threadCount = jobs != nullptr ? jobs->threadCount() : 1;
+	const size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, threadCount);
+
+	// Line aligned chunks. Without a line break at the end the last line is copied: Parsers need a terminator.
+	const char* bodyEnd = data + size;
+	while(bodyEnd != data && bodyEnd[-1] != '\n' && bodyEnd[-1] != '\r') {
+		--bodyEnd;
+	}
+
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* begin = data;
+	for(size_t i = 0; i != chunkCount; ++i) {
+		const char* end = bodyEnd;
+		if(i + 1 != chunkCount) {
+			end = std::clamp(data + size / chunkCount * (i + 1), begin, bodyEnd);
+			while(end != bodyEnd && end != data && end[-1] != '\n' && end[-1] != '\r') {
+				++end;
+			}
+		}
+
+		chunks[i].begin = begin;
+		chunks[i].end = end;
+		begin = end;
+	}
+	chunks.back().tail.assign(bodyEnd, data + size);
+
+	// First pass: Count the records, relative indices and the output positions depend on the chunks before.
+	parallelFor(jobs, chunkCount, [&chunks](size_t i) {
+		ObjChunk& chunk = chunks[i];
+		forEachLine(chunk, [&chunk](const char* token) {
+			switch(classify(token)) {
+				case ObjRecord::Position:
+					++chunk.positionCount;
+					break;
+				case ObjRecord::TexCoord:
+					++chunk.texCoordCount;
+					break;
+				case ObjRecord::Face:
+					++chunk.faceCount;
+					break;
+				case ObjRecord::Unsupported:
+					chunk.supported = false;
+					break;
+				case ObjRecord::Ignored:
+					break;
+			}
+			return token;
+		});
+	});
+
+	size_t positionCount = 0;
+	size_t texCoordCount = 0;
+	for(ObjChunk& chunk : chunks) {
+		if(!chunk.supported) {
+			return false;
+		}
+		chunk.positionBase = positionCount;
+		chunk.texCoordBase = texCoordCount;
+		positionCount += chunk.positionCount;
+		texCoordCount += chunk.texCoordCount;
+	}
+	if(positionCount > INT_MAX || texCoordCount > INT_MAX) {
+		return false;
+	}
+
+	std::vector<float> positions(3 * positionCount);
+	std::vector<float> texCoords(2 * texCoordCount);
+
+	// Second pass: Parse. Every chunk writes its own range of the attributes.
+	parallelFor(jobs, chunkCount, [&chunks, &positions, &texCoords](size_t i) {
+		ObjChunk& chunk = chunks[i];
+		chunk.corners.reserve(3 * chunk.faceCount);
+
+		float* position = positions.data() + 3 * chunk.positionBase;
+		float* texCoord = texCoords.data() + 2 * chunk.texCoordBase;
+
+		// Elements defined before the current line
+		size_t positionsBefore = chunk.positionBase;
+		size_t texCoordsBefore = chunk.texCoordBase;
+
+		forEachLine(chunk, [&](const char* token) {
+			switch(classify(token)) {
+				case ObjRecord::Position:
+					*position++ = parseFloat(token);
+					*position++ = parseFloat(token);
+					*position++ = parseFloat(token);
+					++positionsBefore;
+					break;
+				case ObjRecord::TexCoord:
+					*texCoord++ = parseFloat(token);
+					*texCoord++ = parseFloat(token);
+					++texCoordsBefore;
+					break;
+				case ObjRecord::Face:
+					if(chunk.supported && !parseFace(token, positionsBefore, texCoordsBefore, chunk)) {
+						chunk.supported = false;
+					}
+					break;
+				case ObjRecord::Unsupported:
+				case ObjRecord::Ignored:
+					break;
+			}
+			return token;
+		});
+	});
+
+	// Third pass: Validate the indices and split the quads.
+	parallelFor(jobs, chunkCount, [&chunks, &positions, positionCount, texCoordCount](size_t i) {
+		ObjChunk& chunk = chunks[i];
+		for(const ObjCorner& corner : chunk.corners) {
+			if(static_cast<size_t>(corner.position) >= positionCount
+			   || (corner.texCoord >= 0 && static_cast<size_t>(corner.texCoord) >= texCoordCount)) {
+				chunk.supported = false;
+				return;
+			}
+		}
+
+		for(size_t quad : chunk.quads) {
+			splitQuad(&chunk.corners[quad], positions);
+		}
+	});
+
+	size_t indexCount = 0;
+	for(const ObjChunk& chunk : chunks) {
+		if(!chunk.supported) {
+			return false;
+		}
+		indexCount += chunk.corners.size();
+	}
+
+	// Merge in file order. Same vertices and deduplication as the full loader -> Same indices.
+	VertexDeduplicator deduplicator{indexCount / 4};
+	deduplicator.mesh().indices.reserve(indexCount);
+
+	for(ObjChunk& chunk : chunks) {
+		for(const ObjCorner& corner : chunk.corners) {
+			const size_t p = 3 * static_cast<size_t>(corner.position);
+
+			Vertex vertex{};
+			vertex.pos = {positions[p + 0], positions[p + 1], positions[p + 2]};
+			if(corner.texCoord >= 0) {
+				const size_t t = 2 * static_cast<size_t>(corner.texCoord);
+				vertex.texCoord = {texCoords[t + 0], 1.0f - texCoords[t + 1]};
+			}
+			vertex.color = {1.0f, 1.0f, 1.0f};
+
+			deduplicator.add(vertex);
+		}
+
+		// Release early, the corners of big files take more memory than the result.
+		std::vector<ObjCorner>().swap(chunk.corners);
+	}
+
+	mesh = std::move(deduplicator.mesh());
+	mesh.bounds = computeBounds(mesh.vertices.data(), mesh.vertices.size());
+	return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mesh.hpp"
+
+class JobSystem;
+
+//! Parallel parser for the part of the OBJ format used by meshes: v, vt and triangle or quad faces.
+//!
+//! The file is split into line aligned chunks which are parsed in parallel, the results are merged in file order.
+//! Numbers, relative indices and quad triangulation follow tinyobjloader exactly, so the mesh is bit identical
+//! to loadObjTinyobj().
+//! @param jobs Parses the chunks on all threads of the job system, may be called from one of its jobs.
+//!             Without one the file is parsed on the calling thread.
+//! @return False if the file needs the full loader: Polygons with more than four corners, lines, points,
+//!         skin weights, quads referencing vertices defined after them, invalid or out of range indices.
+bool parseObj(const char* data, size_t size, MeshData& mesh, JobSystem* jobs = nullptr);
@@ -0,0 +1,128 @@
+#include "parallelrecorder.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+ParallelRecorder::ParallelRecorder(Device& device, JobSystem& jobs, uint32_t frameCount) : m_device(device), m_jobs(jobs) {
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;  // Reset as a whole every frame
+	poolInfo.queueFamilyIndex = m_device.findQueueFamilies().graphicsFamily.value();
+
+	m_pools.resize(frameCount, std::vector<ThreadPool>(m_jobs.threadCount()));
+	for(auto& framePools : m_pools) {
+		for(ThreadPool& threadPool : framePools) {
+			if(vkCreateCommandPool(m_device.device(), &poolInfo, nullptr, &threadPool.pool) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create recording command pool!");
+			}
+		}
+	}
+}
+
+ParallelRecorder::~ParallelRecorder() {
+	// Command buffers are freed with their pool.
+	for(auto& framePools : m_pools) {
+		for(ThreadPool& threadPool : framePools) {
+			vkDestroyCommandPool(m_device.device(), threadPool.pool, nullptr);
+		}
+	}
+}
+
+uint32_t ParallelRecorder::threadCount() const {
+	return m_jobs.threadCount();
+}
+
+void ParallelRecorder::beginFrame(uint32_t frame, const RenderPassTarget& target) {
+	m_frame = frame;
+	m_target = target;
+	m_recorded.clear();
+
+	for(ThreadPool& threadPool : m_pools[m_frame]) {
+		vkResetCommandPool(m_device.device(), threadPool.pool, 0);
+		threadPool.usedCount = 0;
+	}
+}
+
+void ParallelRecorder::record(uint32_t itemCount, const RecordFunction& function) {
+	if(itemCount == 0) {
+		return;
+	}
+
+	const uint32_t chunkCount = std::min(m_jobs.threadCount(), (itemCount + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+	if(chunkCount == 1) {
+		m_recorded.push_back(recordChunk(0, itemCount, function));
+		return;
+	}
+
+	// Even split, the first chunks take one item more if it does not divide.
+	const uint32_t base = itemCount / chunkCount;
+	const uint32_t remainder = itemCount % chunkCount;
+	m_chunkBuffers.assign(chunkCount, VK_NULL_HANDLE);
+	m_jobs.parallelFor(chunkCount, 1, [&](uint32_t firstChunk, uint32_t count) {
+		for(uint32_t chunk = firstChunk; chunk != firstChunk + count; ++chunk) {
+			const uint32_t first = chunk * base + std::min(chunk, remainder);
+			m_chunkBuffers[chunk] = recordChunk(first, base + (chunk < remainder ? 1 : 0), function);
+		}
+	});
+	m_recorded.insert(m_recorded.end(), m_chunkBuffers.begin(), m_chunkBuffers.end());
+}
+
+void ParallelRecorder::execute(VkCommandBuffer primaryCommandBuffer) {
+	if(!m_recorded.empty()) {
+		vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(m_recorded.size()), m_recorded.data());
+	}
+}
+
+VkCommandBuffer ParallelRecorder::recordChunk(uint32_t first, uint32_t count, const RecordFunction& function) {
+	VkCommandBuffer commandBuffer = beginSecondary(m_pools[m_frame][m_jobs.threadIndex()]);
+	function(commandBuffer, first, count);
+	if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to record secondary command buffer!");
+	}
+	return commandBuffer;
+}
+
+VkCommandBuffer ParallelRecorder::beginSecondary(ThreadPool& threadPool) {
+	if(threadPool.usedCount == threadPool.commandBuffers.size()) {
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = threadPool.pool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if(vkAllocateCommandBuffers(m_device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate secondary command buffer!");
+		}
+		threadPool.commandBuffers.push_back(commandBuffer);
+	}
+	VkCommandBuffer commandBuffer = threadPool.commandBuffers[threadPool.usedCount++];
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = m_target.renderPass;
+	inheritanceInfo.subpass = m_target.subpass;
+	inheritanceInfo.framebuffer = m_target.framebuffer;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to begin recording secondary command buffer!");
+	}
+
+	// Dynamic state is not inherited from the primary command buffer.
+	VkViewport viewport{};
+	viewport.width = static_cast<float>(m_target.extent.width);
+	viewport.height = static_cast<float>(m_target.extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	VkRect2D scissor{{0, 0}, m_target.extent};
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	return commandBuffer;
+}
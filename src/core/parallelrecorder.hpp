@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <functional>
+#include <vector>
+
+#include "device.hpp"
+#include "jobsystem.hpp"
+
+//! Render pass instance secondary command buffers continue, see Renderer::swapchainRenderPassTarget().
+struct RenderPassTarget {
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	VkExtent2D extent{};
+	uint32_t subpass = 0;
+};
+
+//! Records the draws of a render pass on the threads of the job system.
+//! Command pools cannot be used by two threads at once, so every thread of the job system owns one pool per frame in
+//! flight. Work is split into chunks, each chunk is recorded into a secondary command buffer that continues the render
+//! pass, and the primary command buffer executes them in chunk order: The draw order is the same as with one thread.
+//!
+//! Usage per frame:
+//!   recorder.beginFrame(frame, renderer.swapchainRenderPassTarget());
+//!   renderer.beginSwapchainRenderPass(primary, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+//!   recorder.record(objectCount, [&](VkCommandBuffer commandBuffer, uint32_t first, uint32_t count) { ... });
+//!   recorder.execute(primary);
+//!   renderer.endSwapchainRenderPass(primary);
+class ParallelRecorder {
+public:
+	//! Records a range of items. Pipelines, descriptor sets and push constants are not inherited from the primary
+	//! command buffer or other chunks, bind them in every call. Viewport and scissor are already set.
+	using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)>;
+
+	//! Chunks smaller than this are not worth the synchronization.
+	static constexpr uint32_t MIN_CHUNK_SIZE = 64;
+
+	ParallelRecorder(Device& device, JobSystem& jobs, uint32_t frameCount);
+	~ParallelRecorder();
+
+	ParallelRecorder(const ParallelRecorder&) = delete;
+	ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+	//! Reset the command pools of the frame. The fence of the frame has to be signaled.
+	void beginFrame(uint32_t frame, const RenderPassTarget& target);
+
+	//! Split itemCount items into chunks and record them as jobs, returns when every chunk is recorded.
+	//! A single chunk is recorded on the calling thread: Use itemCount 1 for work that cannot be split.
+	//! Call on a thread of the job system. Exceptions of a chunk are rethrown here.
+	void record(uint32_t itemCount, const RecordFunction& function);
+
+	//! Execute the secondary command buffers recorded since beginFrame() in the order they were recorded.
+	//! The render pass has to be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+	void execute(VkCommandBuffer primaryCommandBuffer);
+
+	//! Threads recording in parallel.
+	uint32_t threadCount() const;
+
+private:
+	//! Command buffers of one thread for one frame in flight.
+	struct ThreadPool {
+		VkCommandPool pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> commandBuffers;  //! Allocated on demand, reused every frame.
+		uint32_t usedCount = 0;
+	};
+
+	//! Record a chunk on the calling thread with the pool of the thread.
+	VkCommandBuffer recordChunk(uint32_t first, uint32_t count, const RecordFunction& function);
+	VkCommandBuffer beginSecondary(ThreadPool& pool);
+
+private:
+	Device& m_device;
+	JobSystem& m_jobs;
+
+	std::vector<std::vector<ThreadPool>> m_pools;  //! [frame][thread]
+	uint32_t m_frame = 0;
+	RenderPassTarget m_target;
+	std::vector<VkCommandBuffer> m_recorded;       //! Secondary command buffers of the frame in execution order.
+	std::vector<VkCommandBuffer> m_chunkBuffers;   //! Of the current record() call
+};
@@ -1,6 +1,8 @@
 #include "pipeline.hpp"
 #include "vertex.hpp"
+#include "pipelinecache.hpp"
 
+#include <chrono>
 #include <fstream>
 #include <cstring>
 
@@ -17,6 +19,10 @@ void Pipeline::bind(VkCommandBuffer commandBuffer) {
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
 }
 
+void Pipeline::pushConstants(VkCommandBuffer commandBuffer, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data) {
+	vkCmdPushConstants(commandBuffer, m_pipelineLayout, stages, offset, size, data);
+}
+
 std::vector<char> Pipeline::readFile(const std::string& filename) {
 	std::ifstream file(filename, std::ios::ate | std::ios::binary);
 	if(!file.is_open()) {
@@ -71,13 +77,13 @@ void Pipeline::createGraphicsPipeline(const std::string& pathVertexFile, const s
 	VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
 	// Get vertex data
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	auto bindingDescriptions = Vertex::getBindingDescriptions(info.instanced);
+	auto attributeDescriptions = Vertex::getAttributeDescriptions(info.instanced);
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
@@ -159,8 +165,8 @@ void Pipeline::createGraphicsPipeline(const std::string& pathVertexFile, const s
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = 1;
 	pipelineLayoutInfo.pSetLayouts = info.descriptorSetLayout;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
-	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(info.pushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = info.pushConstantRanges.empty() ? nullptr : info.pushConstantRanges.data();
 
 	if(vkCreatePipelineLayout(m_device.device(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create pipeline layout!");
@@ -184,9 +190,12 @@ void Pipeline::createGraphicsPipeline(const std::string& pathVertexFile, const s
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	if(vkCreateGraphicsPipelines(m_device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS) {
+	PipelineCache& cache = m_device.pipelineCache();
+	const auto start = std::chrono::steady_clock::now();
+	if(vkCreateGraphicsPipelines(m_device.device(), cache.handle(), 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create graphics pipeline!");
 	}
+	cache.recordCreation(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
 
 	vkDestroyShaderModule(m_device.device(), fragShaderModule, nullptr);
 	vkDestroyShaderModule(m_device.device(), vertShaderModule, nullptr);
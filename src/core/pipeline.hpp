@@ -9,6 +9,8 @@
 struct PipelineInfo {
 	VkRenderPass renderPass;
 	VkDescriptorSetLayout* descriptorSetLayout;
+	std::vector<VkPushConstantRange> pushConstantRanges;  //! Small per draw data, eg. the model matrix.
+	bool instanced = false;  //! Read InstanceData from the second vertex binding.
 };
 
 class Pipeline {
@@ -18,6 +20,8 @@ public:
 
 	VkPipelineLayout layout() const;
 	void bind(VkCommandBuffer commandBuffer);
+	//! Record push constants. The range has to be inside one of PipelineInfo::pushConstantRanges with the same stages.
+	void pushConstants(VkCommandBuffer commandBuffer, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
 
 private:
 	void createGraphicsPipeline(const std::string& pathVertexFile, const std::string& pathFragmentFile, const PipelineInfo& info);
@@ -0,0 +1,137 @@
+#include "pipelinecache.hpp"
+#include "device.hpp"
+#include "file.hpp"
+
+#include <cstring>
+#include <fstream>
+
+PipelineCache::PipelineCache(Device& device, const std::filesystem::path& path) : m_device(device), m_path(path) {
+	const std::vector<char> data = loadData();
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	VkResult result = vkCreatePipelineCache(m_device.device(), &createInfo, nullptr, &m_cache);
+	if(result != VK_SUCCESS && !data.empty()) {
+		// The driver rejected the data even though the header matched, start with an empty cache.
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(m_device.device(), &createInfo, nullptr, &m_cache);
+	} else {
+		m_statistics.warm = !data.empty();
+	}
+
+	if(result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create pipeline cache!");
+	}
+}
+
+PipelineCache::~PipelineCache() {
+	save();
+	vkDestroyPipelineCache(m_device.device(), m_cache, nullptr);
+}
+
+VkPipelineCache PipelineCache::handle() const {
+	return m_cache;
+}
+
+void PipelineCache::recordCreation(double milliseconds) {
+	++m_statistics.pipelineCount;
+	m_statistics.creationMilliseconds += milliseconds;
+}
+
+const PipelineCacheStatistics& PipelineCache::statistics() const {
+	return m_statistics;
+}
+
+std::filesystem::path PipelineCache::defaultPath() {
+	std::error_code error;
+	return std::filesystem::temp_directory_path(error) / "lwEngine" / "pipeline.cache";
+}
+
+bool PipelineCache::isCompatible(const char* data, size_t size, const VkPhysicalDeviceProperties& properties) {
+	if(size < HEADER_SIZE) {
+		return false;
+	}
+
+	// VkPipelineCacheHeaderVersionOne, the fields are always stored least significant byte first.
+	auto readUint32 = [data](size_t offset) {
+		const auto* bytes = reinterpret_cast<const unsigned char*>(data + offset);
+		return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8
+		       | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+	};
+
+	const uint32_t headerSize = readUint32(0);
+	const uint32_t headerVersion = readUint32(4);
+	const uint32_t vendorID = readUint32(8);
+	const uint32_t deviceID = readUint32(12);
+
+	return headerSize >= HEADER_SIZE && headerSize <= size
+	       && headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+	       && vendorID == properties.vendorID
+	       && deviceID == properties.deviceID
+	       && memcmp(data + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::vector<char> PipelineCache::loadData() const {
+	std::ifstream file(m_path, std::ios::ate | std::ios::binary);
+	if(!file.is_open()) {
+		return {};
+	}
+
+	std::vector<char> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(data.data(), static_cast<std::streamsize>(data.size()));
+	if(!file.good()) {
+		return {};
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(m_device.physicalDevice(), &properties);
+	if(!isCompatible(data.data(), data.size(), properties)) {
+		return {};  // Other GPU or driver version
+	}
+	return data;
+}
+
+bool PipelineCache::save() const {
+	size_t size = 0;
+	if(vkGetPipelineCacheData(m_device.device(), m_cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+		return false;
+	}
+
+	std::vector<char> data(size);
+	if(vkGetPipelineCacheData(m_device.device(), m_cache, &size, data.data()) != VK_SUCCESS) {
+		return false;
+	}
+	data.resize(size);
+
+	std::error_code error;
+	std::filesystem::create_directories(m_path.parent_path(), error);
+
+	// Write to a temporary file first: A crash while writing must not leave a broken cache behind.
+	// Engines sharing the cache directory, eg. parallel headless jobs, save at the same time.
+	const std::filesystem::path tempPath = temporaryPath(m_path);
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if(!file.is_open()) {
+			return false;
+		}
+
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+		if(!file.good()) {
+			file.close();
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, m_path, error);
+	if(error) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
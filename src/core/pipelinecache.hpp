@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <filesystem>
+#include <vector>
+
+class Device;
+
+//! Time spent in pipeline creation, to compare starts with a cold and a warm cache.
+struct PipelineCacheStatistics {
+	bool warm = false;             //! Cache data was loaded from disk.
+	uint32_t pipelineCount = 0;
+	double creationMilliseconds = 0.0;
+};
+
+//! VkPipelineCache that is loaded from disk when the device is created and written back on destruction,
+//! so pipelines are only compiled from SPIR-V on the first start.
+//!
+//! Cache data is only used if its header matches the physical device (vendor, device and cache UUID); A driver
+//! update changes the UUID and the stale file is replaced on the next save.
+class PipelineCache {
+public:
+	//! Size of VkPipelineCacheHeaderVersionOne as written by the driver.
+	static constexpr size_t HEADER_SIZE = 16 + VK_UUID_SIZE;
+
+	//! @param path File the cache data is read from and saved to.
+	PipelineCache(Device& device, const std::filesystem::path& path = defaultPath());
+	~PipelineCache();  //! Saves the cache.
+
+	PipelineCache(const PipelineCache&) = delete;
+	PipelineCache& operator=(const PipelineCache&) = delete;
+
+	VkPipelineCache handle() const;
+
+	//! Write the cache data to disk. Replaces the file atomically so a crash never leaves a partial file.
+	//! @return False if the file could not be written; The cache is an optimization, so this is not fatal.
+	bool save() const;
+
+	//! Called by pipelines with the duration of their vkCreate*Pipelines call.
+	void recordCreation(double milliseconds);
+	const PipelineCacheStatistics& statistics() const;
+
+	//! True if the data starts with a header written by a driver for this physical device.
+	static bool isCompatible(const char* data, size_t size, const VkPhysicalDeviceProperties& properties);
+	//! File in the temporary directory of the system.
+	static std::filesystem::path defaultPath();
+
+private:
+	std::vector<char> loadData() const;
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	std::filesystem::path m_path;
+	VkPipelineCache m_cache = VK_NULL_HANDLE;
+	PipelineCacheStatistics m_statistics;
+};
@@ -1,44 +1,83 @@
 #include "renderer.hpp"
 
-Renderer::Renderer(Device &device, Window &window) : m_device(device), m_window(window) {
+Renderer::Renderer(Device &device, Window &window, const RendererConfig& config)
+	: m_device(device), m_window(&window), m_config(config), m_pacer(config.presentPolicy, config.framesInFlight)
+{
+	if(m_config.framesInFlight == 0) {
+		throw std::runtime_error("Failed to create renderer, at least one frame in flight is required!");
+	}
+	m_swapchain = std::make_unique<Swapchain>(window, m_device, m_config);
+	m_profiler = std::make_unique<GpuProfiler>(m_device, m_config.framesInFlight);
+	createCommandBuffers();
+}
+
+Renderer::Renderer(Device& device, VkExtent2D extent, const RendererConfig& config)
+	: m_device(device), m_window(nullptr), m_config(config), m_pacer(config.presentPolicy, config.framesInFlight)
+{
+	if(m_config.framesInFlight == 0) {
+		throw std::runtime_error("Failed to create renderer, at least one frame in flight is required!");
+	}
+	m_renderTarget = std::make_unique<RenderTarget>(m_device, extent, m_config.framesInFlight);
+	m_profiler = std::make_unique<GpuProfiler>(m_device, m_config.framesInFlight);
 	createCommandBuffers();
 }
 
+bool Renderer::isHeadless() const {
+	return m_renderTarget != nullptr;
+}
+
+RenderTarget* Renderer::renderTarget() {
+	return m_renderTarget.get();
+}
+
 uint32_t Renderer::currentImageIndex() const {
 	return m_currentImageIndex;
 }
 
+uint32_t Renderer::maxFramesInFlight() const {
+	return m_config.framesInFlight;
+}
+
+const RendererConfig& Renderer::config() const {
+	return m_config;
+}
+
 uint32_t Renderer::currentSwapchainFrame() const {
-	return m_swapchain->currentFrame();
+	return m_renderTarget ? m_renderTarget->currentFrame() : m_swapchain->currentFrame();
 }
 
 VkCommandBuffer& Renderer::commandBuffer() {
-	return m_commandBuffers[m_swapchain->currentFrame()];
+	return m_commandBuffers[currentSwapchainFrame()];
 }
 
 VkExtent2D Renderer::swapchainExtent() const {
-	return m_swapchain->extent();
+	return m_renderTarget ? m_renderTarget->extent() : m_swapchain->extent();
 }
 
 VkRenderPass Renderer::swapchainRenderPass() const {
-	return m_swapchain->renderPass();
+	return m_renderTarget ? m_renderTarget->renderPass() : m_swapchain->renderPass();
 }
 
-void Renderer::recreateSwapchain() {
-	// TODO: Pass old swapchain to new object to be copied and then delete it.
-	// Swapchain* oldSwapchain = m_swapchain.release();
-	// m_swapchain.reset(nullptr);
-	// m_swapchain = std::make_unique<Swapchain>(m_window, m_device, oldSwapchain);
+DepthAttachment Renderer::depthAttachment() const {
+	return m_renderTarget ? m_renderTarget->depthAttachment() : m_swapchain->depthAttachment();
+}
 
-	m_window.stopWhileMinimized();
-	vkDeviceWaitIdle(m_device.device());
+RenderPassTarget Renderer::swapchainRenderPassTarget() const {
+	RenderPassTarget target{};
+	target.renderPass = swapchainRenderPass();
+	target.framebuffer = m_renderTarget ? m_renderTarget->frameBuffer(m_currentImageIndex) : m_swapchain->frameBuffer(m_currentImageIndex);
+	target.extent = swapchainExtent();
+	return target;
+}
 
-	m_swapchain.reset(nullptr);
-	m_swapchain = std::make_unique<Swapchain>(m_window, m_device);
+void Renderer::recreateSwapchain() {
+	// Frames in flight keep rendering into the old images, the swapchain destroys them once the frames completed.
+	m_window->stopWhileMinimized();
+	m_renderPassChanged = m_swapchain->recreate() || m_renderPassChanged;
 }
 
 void Renderer::createCommandBuffers() {
-	m_commandBuffers.resize(Swapchain::MAX_FRAMES_IN_FLIGHT);
+	m_commandBuffers.resize(m_config.framesInFlight);
 
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -51,9 +90,46 @@ void Renderer::createCommandBuffers() {
 	}
 }
 
+void Renderer::waitForNextFrame() {
+	pollCompletedFrames();
+	m_pacer.wait();
+	pollCompletedFrames();
+	m_pacer.inputSampled(FramePacer::Clock::now());
+}
+
+void Renderer::pollCompletedFrames() {
+	for(uint32_t frame = 0; frame != maxFramesInFlight(); ++frame) {
+		if(!m_pacer.isInFlight(frame)) {
+			continue;
+		}
+
+		const VkFence fence = m_renderTarget ? m_renderTarget->inFlightFence(frame) : m_swapchain->inFlightFence(frame);
+		if(vkGetFenceStatus(m_device.device(), fence) == VK_SUCCESS) {
+			m_pacer.frameCompleted(frame, FramePacer::Clock::now());
+		}
+	}
+}
+
+const FrameLatencyStats& Renderer::latency() const {
+	return m_pacer.latency();
+}
+
+GpuProfiler& Renderer::profiler() {
+	return *m_profiler;
+}
+
+bool Renderer::renderPassChanged() const {
+	return m_renderPassChanged;
+}
+
 VkCommandBuffer Renderer::beginFrame() {
+	m_renderPassChanged = false;
+	const uint32_t frame = currentSwapchainFrame();
+	pollCompletedFrames();
+	const FramePacer::Clock::time_point waitBegin = FramePacer::Clock::now();
+
 	// Get next swapchain image
-	const VkResult result = m_swapchain->getNextImage(m_currentImageIndex);
+	const VkResult result = m_renderTarget ? m_renderTarget->getNextImage(m_currentImageIndex) : m_swapchain->getNextImage(m_currentImageIndex);
 
 	if(result == VK_ERROR_OUT_OF_DATE_KHR) {
 		recreateSwapchain();
@@ -62,6 +138,7 @@ VkCommandBuffer Renderer::beginFrame() {
 		// Suboptimal swap chain is also ok.. Recreate after presenting the image.
 		throw std::runtime_error("Failed to acquire swap chain image!");
 	}
+	m_pacer.frameWaited(frame, waitBegin, FramePacer::Clock::now());
 
 	vkResetCommandBuffer(commandBuffer(), 0);
 
@@ -73,31 +150,46 @@ VkCommandBuffer Renderer::beginFrame() {
 	if(vkBeginCommandBuffer(commandBuffer(), &beginInfo) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to begin recording command buffer!");
 	}
+	m_profiler->beginFrame(commandBuffer(), frame);
 
 	return commandBuffer();
 }
 
 void Renderer::endFrame() {
+	m_profiler->endFrame(commandBuffer());
+	if(m_renderTarget) {
+		m_renderTarget->recordReadback(commandBuffer(), m_currentImageIndex);
+	}
+
 	if(vkEndCommandBuffer(commandBuffer()) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to record command buffer!");
 	}
 
+	const uint32_t frame = currentSwapchainFrame();
+	if(m_renderTarget) {
+		m_renderTarget->submitCommandBuffer(commandBuffer(), m_currentImageIndex);
+		m_pacer.frameSubmitted(frame);
+		return;
+	}
+
 	// Submit command buffer
 	const VkResult result = m_swapchain->submitCommandBuffer(commandBuffer(), m_currentImageIndex);
-	if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.resized()) {
+	m_pacer.frameSubmitted(frame);
+	if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window->resized()) {
 		recreateSwapchain();
 	} else if (result != VK_SUCCESS) {
 		throw std::runtime_error("Failed to present swap chain image!");
 	}
 }
 
-void Renderer::beginSwapchainRenderPass(VkCommandBuffer commandBuffer) {
+void Renderer::beginSwapchainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = m_swapchain->renderPass();
-	renderPassInfo.framebuffer = m_swapchain->frameBuffer(m_currentImageIndex);
+	const RenderPassTarget target = swapchainRenderPassTarget();
+	renderPassInfo.renderPass = target.renderPass;
+	renderPassInfo.framebuffer = target.framebuffer;
 	renderPassInfo.renderArea.offset = {0,0};
-	renderPassInfo.renderArea.extent = m_swapchain->extent();
+	renderPassInfo.renderArea.extent = target.extent;
 
 	std::array<VkClearValue, 2> clearValues{};
 	clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
@@ -106,7 +198,11 @@ void Renderer::beginSwapchainRenderPass(VkCommandBuffer commandBuffer) {
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassInfo.pClearValues = clearValues.data();
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	m_renderPassScope = m_profiler->beginScope(commandBuffer, "Render pass");
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+	if(contents != VK_SUBPASS_CONTENTS_INLINE) {
+		return;
+	}
 
 	// NOTE: Setup viewport and scissor here instead of in the pipeline directly:
 	//       this is less efficient than creating the graphics pipeline with this information directly but it saves
@@ -114,14 +210,14 @@ void Renderer::beginSwapchainRenderPass(VkCommandBuffer commandBuffer) {
 	VkViewport viewport{};
 	viewport.x = 0.0f;
 	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(m_swapchain->extent().width);
-	viewport.height = static_cast<float>(m_swapchain->extent().height);
+	viewport.width = static_cast<float>(target.extent.width);
+	viewport.height = static_cast<float>(target.extent.height);
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
 	VkRect2D scissor{};
 	scissor.offset = {0, 0};
-	scissor.extent = m_swapchain->extent();
+	scissor.extent = target.extent;
 
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
@@ -129,6 +225,8 @@ void Renderer::beginSwapchainRenderPass(VkCommandBuffer commandBuffer) {
 
 void Renderer::endSwapchainRenderPass(VkCommandBuffer commandBuffer) {
 	vkCmdEndRenderPass(commandBuffer);
+	m_profiler->endScope(commandBuffer, m_renderPassScope);
+	m_renderPassScope = GpuProfiler::INVALID_SCOPE;
 }
 
 Renderer::~Renderer() {
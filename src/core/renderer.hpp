@@ -7,37 +7,79 @@
 #include "device.hpp"
 #include "window.hpp"
 #include "swapchain.hpp"
+#include "framepacer.hpp"
+#include "gpuprofiler.hpp"
+#include "rendererconfig.hpp"
+#include "rendertarget.hpp"
+#include "parallelrecorder.hpp"
 
 class Renderer {
 public:
-	Renderer(Device& device, Window& window);
+	Renderer(Device& device, Window& window, const RendererConfig& config = {});
+	//! Headless renderer: Frames render into a RenderTarget of the extent instead of a swapchain and are never presented.
+	//! The "swapchain" getters and render pass functions use the render target.
+	Renderer(Device& device, VkExtent2D extent, const RendererConfig& config = {});
 	~Renderer();
 
+	bool isHeadless() const;
+	//! Offscreen images and readback of a headless renderer, nullptr otherwise.
+	RenderTarget* renderTarget();
+
 	// Getters
 	uint32_t currentImageIndex() const;
 	uint32_t currentSwapchainFrame() const;
 	VkCommandBuffer& commandBuffer();
 	VkExtent2D swapchainExtent() const;
 	VkRenderPass swapchainRenderPass() const;
-	uint16_t maxFramesInFlight() const;
+	DepthAttachment depthAttachment() const;
+	//! Render pass and framebuffer of the current image, for secondary command buffers (see ParallelRecorder).
+	RenderPassTarget swapchainRenderPassTarget() const;
+	//! Size per frame resources like descriptor sets and uniform buffers with this, frame indices are below it.
+	uint32_t maxFramesInFlight() const;
+	const RendererConfig& config() const;
+
+	//! Frame pacing of the present policy: Sleep until the next frame should start, then sample input. Call before
+	//! polling input, without it latency is measured from beginFrame(). Returns at once for VSync and Uncapped.
+	void waitForNextFrame();
+	//! Input to present latency of the last frames, see FramePacer.
+	const FrameLatencyStats& latency() const;
+	//! GPU time of the frames: Measures the "Frame" and the "Render pass" scopes, add more with beginScope().
+	GpuProfiler& profiler();
+
+	//! Check before beginFrame(): True if the last beginFrame() or endFrame() recreated the swapchain with a new render
+	//! pass (the surface format changed). Pipelines created for the old swapchainRenderPass() have to be recreated,
+	//! secondary command buffers inherit the new one from swapchainRenderPassTarget(). Reset by beginFrame().
+	bool renderPassChanged() const;
 
 	VkCommandBuffer beginFrame();
+	//! Headless: Records the readback of the frame (see RenderTarget::recordReadback()) before submitting.
 	void endFrame();
 
-	void beginSwapchainRenderPass(VkCommandBuffer commandBuffer);
+	//! With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS only vkCmdExecuteCommands may be recorded until the end of
+	//! the pass, the secondary command buffers set viewport and scissor themselves.
+	void beginSwapchainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 	void endSwapchainRenderPass(VkCommandBuffer commandBuffer);
 
 private:
 	void createCommandBuffers();
 	void recreateSwapchain();
+	//! Report the submitted frames whose fence is signaled as completed to the frame pacer.
+	void pollCompletedFrames();
 
 private:
 	// Owned by application
 	Device& m_device;
-	Window& m_window;
+	Window* m_window;  //! nullptr if headless
+
+	RendererConfig m_config;
+	FramePacer m_pacer;
+	std::unique_ptr<GpuProfiler> m_profiler;
+	uint32_t m_renderPassScope = GpuProfiler::INVALID_SCOPE;
 
-	std::unique_ptr<Swapchain> m_swapchain{std::make_unique<Swapchain>(m_window, m_device)};
+	std::unique_ptr<Swapchain> m_swapchain;        //! Either the swapchain
+	std::unique_ptr<RenderTarget> m_renderTarget;  //! or the offscreen images of a headless renderer.
 	std::vector<VkCommandBuffer> m_commandBuffers;
 
 	uint32_t m_currentImageIndex = static_cast<uint32_t>(-1);
+	bool m_renderPassChanged = false;
 };
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+//! Present mode and frame pacing, see FramePacer.
+enum class PresentPolicy : uint8_t {
+	LowestLatency,  //! MAILBOX, else IMMEDIATE, else FIFO. CPU work starts as late as possible before the GPU needs it.
+	VSync,          //! FIFO. Frames queue up to the frames in flight: Smooth, but input waits in the queue.
+	PowerSaving,    //! FIFO. The CPU sleeps instead of waiting for the GPU, no busy waiting.
+	Uncapped        //! IMMEDIATE, else MAILBOX, else FIFO. No pacing: Maximum frame rate, may tear.
+};
+
+//! Per deployment trade off between latency and throughput, set once when creating the Renderer.
+struct RendererConfig {
+	static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+	//! Frames the CPU records while the GPU still works on earlier ones. Every per frame resource (command buffers,
+	//! sync objects, descriptor sets, uniform buffers) exists this many times. 1 for the lowest latency, 3 for GPU bound work.
+	uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+	//! Requested swapchain images, clamped to the limits of the surface. 0 asks for one more than the surface minimum.
+	uint32_t swapchainImageCount = 0;
+	PresentPolicy presentPolicy = PresentPolicy::LowestLatency;
+};
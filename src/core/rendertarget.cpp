@@ -0,0 +1,387 @@
+#include "rendertarget.hpp"
+
+#include <array>
+
+static VkDeviceSize texelSize(VkFormat format) {
+	switch(format) {
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			return 4;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			return 8;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			throw std::runtime_error("Failed to create render target, unsupported color format!");
+	}
+}
+
+RenderTarget::RenderTarget(Device& device, VkExtent2D extent, uint32_t framesInFlight, VkFormat colorFormat)
+	: m_framesInFlight(framesInFlight), m_device(device), m_extent(extent), m_colorFormat(colorFormat)
+{
+	createColorResources();
+	createRenderPass();
+	createDepthResources();
+	createFramebuffers();
+	createReadbackBuffers();
+	createSyncObjects();
+}
+
+VkExtent2D RenderTarget::extent() const {
+	return m_extent;
+}
+
+uint32_t RenderTarget::currentFrame() const {
+	return m_currentFrame;
+}
+
+uint32_t RenderTarget::framesInFlight() const {
+	return m_framesInFlight;
+}
+
+VkFence RenderTarget::inFlightFence(uint32_t frame) const {
+	return m_inFlightFences[frame];
+}
+
+VkRenderPass RenderTarget::renderPass() const {
+	return m_renderPass;
+}
+
+VkFramebuffer RenderTarget::frameBuffer(uint32_t imageIndex) const {
+	return m_framebuffers[imageIndex];
+}
+
+DepthAttachment RenderTarget::depthAttachment() const {
+	return {m_depthImage, m_depthImageView, m_depthFormat, m_extent};
+}
+
+VkFormat RenderTarget::colorFormat() const {
+	return m_colorFormat;
+}
+
+VkImage RenderTarget::colorImage(uint32_t imageIndex) const {
+	return m_colorImages[imageIndex];
+}
+
+VkResult RenderTarget::getNextImage(uint32_t& imageIndex) {
+	// No image to acquire: The frame owns its image once its last submission finished.
+	vkWaitForFences(m_device.device(), 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+
+	imageIndex = m_currentFrame;
+	m_readbackReady[imageIndex] = false;
+	m_readbackPending = false;
+	return VK_SUCCESS;
+}
+
+VkResult RenderTarget::submitCommandBuffer(VkCommandBuffer& commandBuffer, uint32_t& imageIndex) {
+	vkResetFences(m_device.device(), 1, &m_inFlightFences[m_currentFrame]);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	if(vkQueueSubmit(m_device.graphicsQueue(), 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to submit draw command buffer!");
+	}
+
+	m_readbackReady[imageIndex] = m_readbackPending;
+	m_readbackPending = false;
+	m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+	return VK_SUCCESS;
+}
+
+void RenderTarget::setReadbackEnabled(bool enabled) {
+	m_readbackEnabled = enabled;
+}
+
+bool RenderTarget::readbackEnabled() const {
+	return m_readbackEnabled;
+}
+
+void RenderTarget::recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+	if(!m_readbackEnabled) {
+		return;
+	}
+
+	// The render pass left the image in TRANSFER_SRC_OPTIMAL, its outgoing dependency orders the copy after the writes.
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;  // Tightly packed
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = {0, 0, 0};
+	region.imageExtent = {m_extent.width, m_extent.height, 1};
+
+	vkCmdCopyImageToBuffer(commandBuffer, m_colorImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                       m_readbackBuffers[imageIndex]->getBuffer(), 1, &region);
+
+	// Make the copy visible to the host once the fence of the frame signaled.
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = m_readbackBuffers[imageIndex]->getBuffer();
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+	                     0, nullptr, 1, &barrier, 0, nullptr);
+
+	m_readbackPending = true;
+}
+
+const uint8_t* RenderTarget::readback(uint32_t imageIndex) {
+	if(!m_readbackReady[imageIndex]) {
+		return nullptr;
+	}
+
+	vkWaitForFences(m_device.device(), 1, &m_inFlightFences[imageIndex], VK_TRUE, UINT64_MAX);
+	return static_cast<const uint8_t*>(m_readbackBuffers[imageIndex]->getMappedMemory());
+}
+
+VkDeviceSize RenderTarget::readbackSize() const {
+	return static_cast<VkDeviceSize>(m_extent.width) * m_extent.height * texelSize(m_colorFormat);
+}
+
+void RenderTarget::createColorResources() {
+	m_colorImages.resize(m_framesInFlight);
+	m_colorImageMemory.resize(m_framesInFlight);
+	m_colorImageViews.resize(m_framesInFlight);
+
+	for(size_t i = 0; i != m_framesInFlight; ++i) {
+		createImage(m_colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, m_colorImages[i], m_colorImageMemory[i]);
+		m_colorImageViews[i] = createImageView(m_colorImages[i], m_colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+	}
+}
+
+void RenderTarget::createRenderPass() {
+	// Compatible with the swapchain render pass, only the final layout of the color image differs: It is copied, not presented.
+	VkAttachmentDescription colorAttachment{};
+	colorAttachment.format = m_colorFormat;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentRef{};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	m_depthFormat = findDepthFormat();
+
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = m_depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;  // Read after the pass, eg. for the depth pyramid of occlusion culling
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+	std::array<VkSubpassDependency, 2> dependencies{};
+	// Copy of the previous frame in the image before clearing it
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = 0;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	// Color writes before the readback copy
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+
+	if(vkCreateRenderPass(m_device.device(), &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create render pass!");
+	}
+}
+
+void RenderTarget::createDepthResources() {
+	createImage(m_depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, m_depthImage, m_depthImageMemory);
+	m_depthImageView = createImageView(m_depthImage, m_depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+}
+
+void RenderTarget::createFramebuffers() {
+	m_framebuffers.resize(m_colorImageViews.size());
+
+	for(size_t i = 0; i != m_colorImageViews.size(); ++i) {
+		std::array<VkImageView, 2> attachments = {m_colorImageViews[i], m_depthImageView};
+
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = m_renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		framebufferInfo.pAttachments = attachments.data();
+		framebufferInfo.width = m_extent.width;
+		framebufferInfo.height = m_extent.height;
+		framebufferInfo.layers = 1;
+
+		if(vkCreateFramebuffer(m_device.device(), &framebufferInfo, nullptr, &m_framebuffers[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create framebuffer!");
+		}
+	}
+}
+
+void RenderTarget::createReadbackBuffers() {
+	const VkMemoryPropertyFlags properties = readbackMemoryProperties();
+
+	m_readbackBuffers.resize(m_framesInFlight);
+	m_readbackReady.resize(m_framesInFlight, false);
+	for(auto& buffer : m_readbackBuffers) {
+		buffer = std::make_unique<Buffer>(m_device, readbackSize(), 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties);
+		if(buffer->map() != VK_SUCCESS) {
+			throw std::runtime_error("Failed to map readback buffer!");
+		}
+	}
+}
+
+void RenderTarget::createSyncObjects() {
+	m_inFlightFences.resize(m_framesInFlight);
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Immediately signaled so we can draw first frame
+
+	for(size_t i = 0; i != m_framesInFlight; ++i) {
+		if(vkCreateFence(m_device.device(), &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create fences!");
+		}
+	}
+}
+
+VkFormat RenderTarget::findDepthFormat() const {
+	for(VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT}) {
+		if(m_device.isFormatSupported(format, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+			return format;
+		}
+	}
+
+	throw std::runtime_error("Failed to find supported format!");
+}
+
+VkMemoryPropertyFlags RenderTarget::readbackMemoryProperties() const {
+	const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+	VkPhysicalDeviceMemoryProperties memProperties{};
+	vkGetPhysicalDeviceMemoryProperties(m_device.physicalDevice(), &memProperties);
+	for(uint32_t i = 0; i != memProperties.memoryTypeCount; ++i) {
+		if((memProperties.memoryTypes[i].propertyFlags & cached) == cached) {
+			return cached;
+		}
+	}
+	return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+VkImageView RenderTarget::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
+	VkImageViewCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.image = image;
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format = format;
+
+	createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+	createInfo.subresourceRange.aspectMask = aspectFlags;
+	createInfo.subresourceRange.baseMipLevel = 0;
+	createInfo.subresourceRange.levelCount = 1;
+	createInfo.subresourceRange.baseArrayLayer = 0;
+	createInfo.subresourceRange.layerCount = 1;
+
+	VkImageView imageView;
+	if(vkCreateImageView(m_device.device(), &createInfo, nullptr, &imageView) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create image views!");
+	}
+
+	return imageView;
+}
+
+void RenderTarget::createImage(VkFormat format, VkImageUsageFlags usage, VkImage& image, MemoryAllocation& imageMemory) {
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = m_extent.width;
+	imageInfo.extent.height = m_extent.height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = format;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = usage;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if(vkCreateImage(m_device.device(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create image!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(m_device.device(), image, &memRequirements);
+
+	imageMemory = m_device.allocator().allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+
+	vkBindImageMemory(m_device.device(), image, imageMemory.memory, imageMemory.offset);
+}
+
+
+RenderTarget::~RenderTarget() {
+	m_readbackBuffers.clear();
+
+	vkDestroyImageView(m_device.device(), m_depthImageView, nullptr);
+	vkDestroyImage(m_device.device(), m_depthImage, nullptr);
+	m_device.allocator().free(m_depthImageMemory);
+
+	for(auto framebuffer : m_framebuffers) {
+		vkDestroyFramebuffer(m_device.device(), framebuffer, nullptr);
+	}
+	vkDestroyRenderPass(m_device.device(), m_renderPass, nullptr);
+
+	for(size_t i = 0; i != m_colorImages.size(); ++i) {
+		vkDestroyImageView(m_device.device(), m_colorImageViews[i], nullptr);
+		vkDestroyImage(m_device.device(), m_colorImages[i], nullptr);
+		m_device.allocator().free(m_colorImageMemory[i]);
+	}
+
+	for(auto fence : m_inFlightFences) {
+		vkDestroyFence(m_device.device(), fence, nullptr);
+	}
+}
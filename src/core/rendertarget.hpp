@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <vector>
+
+#include "buffer.hpp"
+#include "device.hpp"
+#include "rendererconfig.hpp"
+#include "swapchain.hpp"
+
+//! Offscreen replacement of the Swapchain for a headless device: Frames render into color and depth images of their
+//! own and are never presented, so nothing waits for a display or vsync.
+//! Every frame in flight owns a color image, the image index is the frame index. The color image of a frame can be
+//! copied into a mapped host buffer after its render pass, see recordReadback() and readback().
+class RenderTarget {
+public:
+	//! @param framesInFlight See RendererConfig.
+	//! @param colorFormat Default matches the preferred swapchain format, so pipelines work with either render pass.
+	RenderTarget(Device& device, VkExtent2D extent, uint32_t framesInFlight = RendererConfig::DEFAULT_FRAMES_IN_FLIGHT,
+	             VkFormat colorFormat = VK_FORMAT_B8G8R8A8_SRGB);
+	~RenderTarget();
+
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator=(const RenderTarget&) = delete;
+
+	VkExtent2D extent() const;
+	uint32_t currentFrame() const;
+	uint32_t framesInFlight() const;
+	VkRenderPass renderPass() const;
+	VkFramebuffer frameBuffer(uint32_t imageIndex) const;
+	DepthAttachment depthAttachment() const;
+	//! Signaled once the last submission of the frame finished on the GPU.
+	VkFence inFlightFence(uint32_t frame) const;
+	VkFormat colorFormat() const;
+	VkImage colorImage(uint32_t imageIndex) const;
+
+	//! Wait until the current frame finished on the GPU and write its image index to the variable.
+	VkResult getNextImage(uint32_t& imageIndex);
+	//! Submit a command buffer to the graphics queue. Signals the fence of the frame, there is nothing to present.
+	VkResult submitCommandBuffer(VkCommandBuffer& commandBuffer, uint32_t& imageIndex);
+
+	//! Read back frames? Without readback the images are only rendered, eg. for throughput benchmarks.
+	void setReadbackEnabled(bool enabled);
+	bool readbackEnabled() const;
+	//! Record the copy of the color image into the readback buffer of the frame. After the render pass, before submitting.
+	//! Does nothing if readback is disabled.
+	void recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+	//! Pixels of the last frame rendered into the image: Rows of extent().width texels of the color format, tightly packed.
+	//! Blocks until the frame finished on the GPU. With more than one frame in flight, the pixels of a frame are ready
+	//! without blocking once the next frame began. They stay valid until getNextImage() returns the image again.
+	//! @return nullptr if the last frame in the image was not read back or is not submitted yet.
+	const uint8_t* readback(uint32_t imageIndex);
+	//! Size of the pixels returned by readback().
+	VkDeviceSize readbackSize() const;
+
+private:
+	void createColorResources();
+	void createRenderPass();
+	void createDepthResources();
+	void createFramebuffers();
+	void createReadbackBuffers();
+	void createSyncObjects();
+
+	VkFormat findDepthFormat() const;
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+	void createImage(VkFormat format, VkImageUsageFlags usage, VkImage& image, MemoryAllocation& imageMemory);
+	//! Host visible memory for the readback buffers, cached if available: Reads of uncached memory are slow on the CPU.
+	VkMemoryPropertyFlags readbackMemoryProperties() const;
+
+private:
+	uint32_t m_currentFrame = 0;
+	uint32_t m_framesInFlight;
+
+	// Owned by application
+	Device& m_device;
+
+	VkExtent2D m_extent;
+	VkFormat m_colorFormat;
+	VkRenderPass m_renderPass;
+
+	std::vector<VkImage> m_colorImages;
+	std::vector<MemoryAllocation> m_colorImageMemory;
+	std::vector<VkImageView> m_colorImageViews;
+	std::vector<VkFramebuffer> m_framebuffers;
+
+	// Depth Image
+	VkFormat m_depthFormat;
+	VkImage m_depthImage;
+	MemoryAllocation m_depthImageMemory;
+	VkImageView m_depthImageView;
+
+	// Readback
+	bool m_readbackEnabled = true;
+	std::vector<std::unique_ptr<Buffer>> m_readbackBuffers;
+	bool m_readbackPending = false;       //! Copy recorded into the command buffer of the current frame.
+	std::vector<bool> m_readbackReady;    //! Submitted frame of the image copies into its readback buffer.
+
+	std::vector<VkFence> m_inFlightFences;
+};
@@ -0,0 +1,78 @@
+#include "resourcecache.hpp"
+
+#include <stdexcept>
+#include <tuple>
+
+bool AssetKey::operator<(const AssetKey& other) const {
+	return std::tie(type, path, target) < std::tie(other.type, other.path, other.target);
+}
+
+ResourceCache::ResourceCache(VkDeviceSize budget, uint32_t retireFrames) : m_budget(budget), m_retireFrames(retireFrames) {}
+
+std::shared_ptr<void> ResourceCache::find(const AssetKey& key) {
+	auto it = m_index.find(key);
+	if(it == m_index.end()) {
+		++m_stats.misses;
+		return nullptr;
+	}
+
+	// The caller may release it again before endFrame() sees the reference: Its frames in flight start over anyway.
+	++m_stats.hits;
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	it->second->unusedSince = IN_USE;
+	return it->second->resource;
+}
+
+void ResourceCache::insert(const AssetKey& key, std::shared_ptr<void> resource, VkDeviceSize size) {
+	if(m_index.count(key) != 0) {
+		throw std::runtime_error("Failed to insert resource " + key.path + ", it is already cached!");
+	}
+
+	m_entries.push_front(Entry{key, std::move(resource), size, IN_USE});
+	m_index.emplace(key, m_entries.begin());
+	++m_stats.entryCount;
+	m_stats.residentBytes += size;
+}
+
+uint32_t ResourceCache::endFrame() {
+	++m_frame;
+
+	// The cache holds the only reference of unused resources. A resource released during the last frame may still be
+	// read by retireFrames frames including the current one.
+	for(Entry& entry : m_entries) {
+		if(entry.resource.use_count() > 1) {
+			entry.unusedSince = IN_USE;
+		} else if(entry.unusedSince == IN_USE) {
+			entry.unusedSince = m_frame;
+		}
+	}
+
+	uint32_t evicted = 0;
+	for(auto it = m_entries.end(); it != m_entries.begin() && m_stats.residentBytes > m_budget; ) {
+		--it;
+		if(it->size == 0 || it->unusedSince == IN_USE || m_frame - it->unusedSince + 1 < m_retireFrames) {
+			continue;
+		}
+
+		m_stats.residentBytes -= it->size;
+		--m_stats.entryCount;
+		++m_stats.evictions;
+		++evicted;
+
+		m_index.erase(it->key);
+		it = m_entries.erase(it);
+	}
+	return evicted;
+}
+
+void ResourceCache::setBudget(VkDeviceSize budget) {
+	m_budget = budget;
+}
+
+VkDeviceSize ResourceCache::budget() const {
+	return m_budget;
+}
+
+const ResourceCacheStats& ResourceCache::stats() const {
+	return m_stats;
+}
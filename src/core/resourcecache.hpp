@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+//! Identifies a GPU resource: The same file loaded with the same options.
+struct AssetKey {
+	enum class Type : uint8_t {
+		Mesh,
+		Texture
+	};
+
+	Type type;
+	std::string path;              //! Canonical path of the source file.
+	const void* target = nullptr;  //! Resource the asset is placed in (eg. a mesh pool), nullptr for resources of its own.
+
+	bool operator<(const AssetKey& other) const;
+};
+
+struct ResourceCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	uint32_t entryCount = 0;         //! Resources in the cache, used or not.
+	VkDeviceSize residentBytes = 0;  //! Device memory of all entries.
+};
+
+//! Keeps resources alive after their last user released them and evicts the least recently used ones once the
+//! resident bytes exceed the budget. A resource is in use while a shared_ptr outside of the cache references it,
+//! resources in use are never evicted: The budget only limits what is kept for later.
+//! Holds no Vulkan objects itself, see AssetCache for meshes and textures. Not thread safe.
+class ResourceCache {
+public:
+	//! @param retireFrames Frames in flight: Frames that may still read a resource after its last user released it.
+	ResourceCache(VkDeviceSize budget, uint32_t retireFrames);
+
+	//! @return Resource or nullptr on a miss. A hit makes the entry the most recently used one.
+	std::shared_ptr<void> find(const AssetKey& key);
+	//! Add a resource loaded after a miss as the most recently used one.
+	//! Entries of 0 bytes are never evicted, eg. meshes in an append only pool: Evicting them frees nothing.
+	void insert(const AssetKey& key, std::shared_ptr<void> resource, VkDeviceSize size);
+
+	//! Once per frame: Evict unused resources, least recently used first, until the resident bytes fit the budget.
+	//! @return Number of evicted resources.
+	uint32_t endFrame();
+
+	void setBudget(VkDeviceSize budget);
+	VkDeviceSize budget() const;
+	const ResourceCacheStats& stats() const;
+
+private:
+	static constexpr uint64_t IN_USE = UINT64_MAX;
+
+	struct Entry {
+		AssetKey key;
+		std::shared_ptr<void> resource;
+		VkDeviceSize size;
+		uint64_t unusedSince;  //! First frame without a user or IN_USE.
+	};
+
+private:
+	VkDeviceSize m_budget;
+	uint32_t m_retireFrames;
+	uint64_t m_frame = 0;
+
+	std::list<Entry> m_entries;  //! Most recently used first.
+	std::map<AssetKey, std::list<Entry>::iterator> m_index;
+	ResourceCacheStats m_stats;
+};
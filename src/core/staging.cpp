@@ -0,0 +1,196 @@
+#include "staging.hpp"
+#include "device.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+StagingRing::StagingRing(Device& device, VkDeviceSize size) : m_device(device), m_capacity(size), m_thread(std::this_thread::get_id()) {
+	m_buffer = std::make_unique<Buffer>(m_device, size, 1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	// The allocator keeps host visible memory mapped, so the ring never maps or unmaps.
+	if(m_buffer->map() != VK_SUCCESS) {
+		throw std::runtime_error("Failed to map staging ring!");
+	}
+	m_mapped = static_cast<char*>(m_buffer->getMappedMemory());
+}
+
+VkDeviceSize StagingRing::capacity() const {
+	return m_capacity;
+}
+
+VkDeviceSize StagingRing::usedBytes() const {
+	if(m_regions.empty()) {
+		return 0;
+	}
+
+	const VkDeviceSize tail = m_regions.front().begin;
+	const VkDeviceSize head = m_regions.back().end;
+	return m_regions.back().begin < tail ? m_capacity - tail + head : head - tail;
+}
+
+void StagingRing::assertThread() const {
+	assert(std::this_thread::get_id() == m_thread && "Staging ring used from another thread than the one that created the device");
+}
+
+uint32_t StagingRing::addWriter(FlushCallback flush) {
+	assertThread();
+	m_writers.emplace(m_nextWriter, std::move(flush));
+	return m_nextWriter++;
+}
+
+void StagingRing::removeWriter(uint32_t writer) {
+	m_writers.erase(writer);
+}
+
+StagingRing::Region& StagingRing::region(uint64_t id) {
+	assert(id >= m_frontId && id - m_frontId < m_regions.size() && "Unknown staging region");
+	return m_regions[id - m_frontId];
+}
+
+bool StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t writer, StagingRegion& result) {
+	assertThread();
+	if(size == 0 || size > m_capacity) {
+		return false;
+	}
+
+	for(;;) {
+		reclaim();
+
+		// Free space is behind the newest region and, if the ring did not wrap yet, in front of the oldest one.
+		bool fits = false;
+		VkDeviceSize begin = 0;
+		if(m_regions.empty()) {
+			fits = true;
+		} else {
+			const VkDeviceSize tail = m_regions.front().begin;
+			const VkDeviceSize head = alignUp(m_regions.back().end, alignment);
+			const bool wrapped = m_regions.back().begin < tail;
+
+			if(!wrapped && head + size <= m_capacity) {
+				begin = head;
+				fits = true;
+			} else if(!wrapped && size <= tail) {
+				begin = 0;
+				fits = true;
+			} else if(wrapped && head + size <= tail) {
+				begin = head;
+				fits = true;
+			}
+		}
+
+		if(fits) {
+			m_regions.push_back(Region{begin, begin + size, 0, false, writer});
+
+			result.buffer = m_buffer->getBuffer();
+			result.offset = begin;
+			result.size = size;
+			result.mapped = m_mapped + begin;
+			result.id = m_frontId + m_regions.size() - 1;
+			return true;
+		}
+
+		// Regions are reclaimed in order -> An unsubmitted region blocks the ring: Have its writer submit it.
+		if(!m_regions.front().submitted) {
+			const auto blocking = m_writers.find(m_regions.front().writer);
+			if(blocking == m_writers.end()) {
+				return false;
+			}
+			blocking->second();
+			if(!m_regions.front().submitted) {
+				return false;
+			}
+		}
+		wait(m_regions.front().ticket);
+	}
+}
+
+VkFence StagingRing::submit(const std::vector<StagingRegion>& regions, uint64_t& ticket) {
+	assertThread();
+	VkFence fence;
+	if(!m_freeFences.empty()) {
+		fence = m_freeFences.back();
+		m_freeFences.pop_back();
+	} else {
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if(vkCreateFence(m_device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create staging fence!");
+		}
+	}
+
+	ticket = m_nextTicket++;
+	for(const auto& stagingRegion : regions) {
+		Region& r = region(stagingRegion.id);
+		r.ticket = ticket;
+		r.submitted = true;
+	}
+
+	m_pendingFences.push_back({ticket, fence});
+	return fence;
+}
+
+void StagingRing::release(const std::vector<StagingRegion>& regions) {
+	for(const auto& stagingRegion : regions) {
+		Region& r = region(stagingRegion.id);
+		r.ticket = 0;
+		r.submitted = true;
+	}
+}
+
+void StagingRing::pollFences() {
+	for(auto it = m_pendingFences.begin(); it != m_pendingFences.end();) {
+		if(vkGetFenceStatus(m_device.device(), it->fence) == VK_SUCCESS) {
+			vkResetFences(m_device.device(), 1, &it->fence);
+			m_freeFences.push_back(it->fence);
+			it = m_pendingFences.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void StagingRing::reclaim() {
+	pollFences();
+
+	auto pending = [this](uint64_t ticket) {
+		return std::any_of(m_pendingFences.begin(), m_pendingFences.end(),
+		                   [ticket](const PendingFence& p) { return p.ticket == ticket; });
+	};
+
+	while(!m_regions.empty() && m_regions.front().submitted && !pending(m_regions.front().ticket)) {
+		m_regions.pop_front();
+		++m_frontId;
+	}
+}
+
+bool StagingRing::isComplete(uint64_t ticket) {
+	pollFences();
+	return std::none_of(m_pendingFences.begin(), m_pendingFences.end(),
+	                    [ticket](const PendingFence& p) { return p.ticket == ticket; });
+}
+
+void StagingRing::wait(uint64_t ticket) {
+	for(const auto& p : m_pendingFences) {
+		if(p.ticket == ticket) {
+			vkWaitForFences(m_device.device(), 1, &p.fence, VK_TRUE, UINT64_MAX);
+			break;
+		}
+	}
+	pollFences();
+}
+
+StagingRing::~StagingRing() {
+	for(const auto& p : m_pendingFences) {
+		vkWaitForFences(m_device.device(), 1, &p.fence, VK_TRUE, UINT64_MAX);
+		vkDestroyFence(m_device.device(), p.fence, nullptr);
+	}
+	for(VkFence fence : m_freeFences) {
+		vkDestroyFence(m_device.device(), fence, nullptr);
+	}
+}
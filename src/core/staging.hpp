@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "buffer.hpp"
+
+class Device;
+
+//! Part of the staging ring handed out for one copy.
+struct StagingRegion {
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	void* mapped = nullptr;  //! Host pointer to the start of the region.
+	uint64_t id = 0;
+};
+
+//! Persistently mapped staging buffer that is reused for all uploads. Regions are handed out in a ring and
+//! reclaimed once the fence of the submission that read them signaled, so steady streaming allocates nothing.
+//!
+//! Regions are reclaimed in allocation order, so a region that is never submitted would block the ring. Every writer
+//! (an UploadBatch) registers a flush callback: If its regions block an allocation, the ring has it submit them and
+//! waits for the copies instead of failing or allocating more memory.
+//!
+//! Usage: addWriter() -> allocate() -> write to region.mapped and record copies -> submit() and signal the returned fence.
+//! Main thread only: Upload batches are recorded on the thread that created the device (eg. in AssetManager::update()),
+//! like the command pools of the device are used. Checked by asserts in debug builds.
+class StagingRing {
+public:
+	static constexpr VkDeviceSize DEFAULT_SIZE = 32ull * 1024 * 1024;
+
+	//! Submits the regions of a writer that were allocated but not submitted yet.
+	using FlushCallback = std::function<void()>;
+
+	StagingRing(Device& device, VkDeviceSize size = DEFAULT_SIZE);
+	~StagingRing();
+
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+
+	//! @return Id of the writer for allocate().
+	uint32_t addWriter(FlushCallback flush);
+	//! The writer submitted or released all of its regions.
+	void removeWriter(uint32_t writer);
+
+	//! Reserve a region. If the ring is full, waits for submitted regions and flushes writers whose regions block it.
+	//! @return False if the size exceeds capacity() or the writer of a blocking region did not submit it.
+	bool allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t writer, StagingRegion& region);
+
+	//! Regions are read by the next queue submission. Signal the returned fence with that vkQueueSubmit.
+	//! @param ticket Identifies the submission for isComplete() and wait().
+	VkFence submit(const std::vector<StagingRegion>& regions, uint64_t& ticket);
+	//! Give back regions that will never be submitted.
+	void release(const std::vector<StagingRegion>& regions);
+
+	bool isComplete(uint64_t ticket);
+	void wait(uint64_t ticket);
+
+	VkDeviceSize capacity() const;
+	VkDeviceSize usedBytes() const;  //! Bytes between the oldest and newest region that are not reclaimed yet.
+
+private:
+	struct Region {
+		VkDeviceSize begin;
+		VkDeviceSize end;
+		uint64_t ticket;  //! 0: Completed or released
+		bool submitted;
+		uint32_t writer;
+	};
+
+	struct PendingFence {
+		uint64_t ticket;
+		VkFence fence;
+	};
+
+	Region& region(uint64_t id);
+	void assertThread() const;
+	void pollFences();
+	void reclaim();
+
+private:
+	// Owned by application
+	Device& m_device;
+
+	std::unique_ptr<Buffer> m_buffer;
+	char* m_mapped;
+	VkDeviceSize m_capacity;
+
+	std::deque<Region> m_regions;  //! In allocation order; The front is the oldest region still in use.
+	uint64_t m_frontId = 0;        //! Id of m_regions.front()
+
+	std::vector<PendingFence> m_pendingFences;
+	std::vector<VkFence> m_freeFences;  //! Signaled fences are reset and reused.
+	uint64_t m_nextTicket = 1;
+
+	std::map<uint32_t, FlushCallback> m_writers;
+	uint32_t m_nextWriter = 0;
+	std::thread::id m_thread;  //! Thread that created the ring, the only one allowed to use it.
+};
@@ -1,8 +1,9 @@
 #include "swapchain.hpp"
 
+#include <algorithm>
 #include <limits>
 
-Swapchain::Swapchain(Window& window, Device& device) : m_window(window), m_device(device) {
+Swapchain::Swapchain(Window& window, Device& device, const RendererConfig& config) : m_config(config), m_window(window), m_device(device) {
 	createSwapChain();
 	createImageViews();
 	createRenderPass();
@@ -19,17 +20,63 @@ uint32_t Swapchain::currentFrame() const {
 	return m_currentFrame;
 }
 
+uint32_t Swapchain::framesInFlight() const {
+	return m_config.framesInFlight;
+}
+
+VkFence Swapchain::inFlightFence(uint32_t frame) const {
+	return m_inFlightFences[frame];
+}
+
+uint32_t Swapchain::imageCount() const {
+	return static_cast<uint32_t>(m_images.size());
+}
+
 VkRenderPass Swapchain::renderPass() const {
 	return m_renderPass;
 }
 
+DepthAttachment Swapchain::depthAttachment() const {
+	return {m_depthImage, m_depthImageView, m_depthFormat, m_extent};
+}
+
 VkFramebuffer Swapchain::frameBuffer(uint32_t imageIndex) const {
 	return m_framebuffers[imageIndex];
 }
 
+bool Swapchain::recreate() {
+	Retired retired{};
+	retired.swapChain = m_swapChain;
+	retired.imageViews = std::move(m_imageViews);
+	retired.framebuffers = std::move(m_framebuffers);
+	retired.depthImage = m_depthImage;
+	retired.depthImageMemory = m_depthImageMemory;
+	retired.depthImageView = m_depthImageView;
+	// Every frame submitted so far may still render into or present the old images.
+	retired.frames.assign(m_config.framesInFlight, RetiredFrame::Presenting);
+
+	const VkFormat oldFormat = m_imageFormat;
+	createSwapChain();  // Retires the old swapchain, the driver may reuse its resources
+	createImageViews();
+
+	// A render pass only depends on the formats, it is compatible with the new images unless the format changed.
+	const bool renderPassChanged = m_imageFormat != oldFormat;
+	if(renderPassChanged) {
+		retired.renderPass = m_renderPass;
+		createRenderPass();
+	}
+
+	createDepthResources();
+	createFramebuffers();
+
+	m_retired.push_back(std::move(retired));
+	return renderPassChanged;
+}
+
 VkResult Swapchain::getNextImage(uint32_t& imageIndex) {
 	// Make sure only one image is added to the command buffer at once. (p.137ff)
 	vkWaitForFences(m_device.device(), 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+	releaseRetired(m_currentFrame);
 
 	const VkResult result = vkAcquireNextImageKHR(m_device.device(), m_swapChain, UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
 
@@ -58,6 +105,11 @@ VkResult Swapchain::submitCommandBuffer(VkCommandBuffer& commandBuffer, uint32_t
 	if(vkQueueSubmit(m_device.graphicsQueue(), 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to submit draw command buffer!");
 	}
+	for(Retired& retired : m_retired) {
+		if(retired.frames[m_currentFrame] == RetiredFrame::Presenting) {
+			retired.frames[m_currentFrame] = RetiredFrame::Signaled;
+		}
+	}
 
 	// Presentation
 	VkPresentInfoKHR presentInfo{};
@@ -72,7 +124,7 @@ VkResult Swapchain::submitCommandBuffer(VkCommandBuffer& commandBuffer, uint32_t
 	presentInfo.pResults = nullptr;
 
 	const VkResult result = vkQueuePresentKHR(m_device.presentQueue(), &presentInfo);
-	m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	m_currentFrame = (m_currentFrame + 1) % m_config.framesInFlight;
 	return result;
 }
 
@@ -83,7 +135,9 @@ void Swapchain::createSwapChain() {
 	VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
 	VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+	// More images let the CPU run ahead of the display at the cost of latency, the driver may create more than requested.
+	uint32_t imageCount = m_config.swapchainImageCount != 0 ? m_config.swapchainImageCount : swapChainSupport.capabilities.minImageCount + 1;
+	imageCount = std::max(imageCount, swapChainSupport.capabilities.minImageCount);
 	if(swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
 		imageCount = swapChainSupport.capabilities.maxImageCount;
 	}
@@ -98,7 +152,7 @@ void Swapchain::createSwapChain() {
 	createInfo.imageArrayLayers = 1;
 	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-	QueueFamilyIndices indices = m_device.findQueueFamilies();
+	const QueueFamilyIndices& indices = m_device.findQueueFamilies();
 	uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
 	if(indices.graphicsFamily != indices.presentFamily) {
@@ -117,7 +171,7 @@ void Swapchain::createSwapChain() {
 
 	createInfo.presentMode = presentMode;
 	createInfo.clipped = VK_TRUE;  // We don't care about color of pixels that are obscured
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	createInfo.oldSwapchain = m_swapChain;  // VK_NULL_HANDLE unless recreating
 
 	if(vkCreateSwapchainKHR(m_device.device(), &createInfo, nullptr, &m_swapChain) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create swap chain!");
@@ -144,14 +198,27 @@ VkSurfaceFormatKHR Swapchain::chooseSwapSurfaceFormat(const std::vector<VkSurfac
 }
 
 VkPresentModeKHR Swapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) const {
-	for(const auto& availablePresentMode : availablePresentModes) {
-		// Different options good for dirrent scenarios (check p.83f)
-		if(availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-			return availablePresentMode;
+	// Different options good for dirrent scenarios (check p.83f)
+	std::vector<VkPresentModeKHR> preferred;
+	switch(m_config.presentPolicy) {
+		case PresentPolicy::LowestLatency:
+			preferred = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+			break;
+		case PresentPolicy::Uncapped:
+			preferred = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+			break;
+		case PresentPolicy::VSync:
+		case PresentPolicy::PowerSaving:
+			break;
+	}
+
+	for(VkPresentModeKHR mode : preferred) {
+		if(std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end()) {
+			return mode;
 		}
 	}
 
-	return VK_PRESENT_MODE_FIFO_KHR;
+	return VK_PRESENT_MODE_FIFO_KHR;  // Always supported
 }
 
 VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) const {
@@ -188,7 +255,7 @@ void Swapchain::createRenderPass() {
 	depthAttachment.format = findDepthFormat();
 	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;  // Read after the pass, eg. for the depth pyramid of occlusion culling
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -251,9 +318,9 @@ void Swapchain::createFramebuffers() {
 }
 
 void Swapchain::createSyncObjects() {
-	m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+	m_imageAvailableSemaphores.resize(m_config.framesInFlight);
+	m_renderFinishedSemaphores.resize(m_config.framesInFlight);
+	m_inFlightFences.resize(m_config.framesInFlight);
 
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -262,7 +329,7 @@ void Swapchain::createSyncObjects() {
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Immediately signaled so we can draw first frame (p.141)
 
-	for(size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i) {
+	for(size_t i = 0; i != m_config.framesInFlight; ++i) {
 		if(vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS
 		   || vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS
 		   || vkCreateFence(m_device.device(), &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
@@ -325,20 +392,20 @@ VkFormat Swapchain::findDepthFormat() const {
 	return findSupportedFormat(
 			{VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
 			VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
 	);
 }
 
 void Swapchain::createDepthResources() {
-	VkFormat depthFormat = findDepthFormat();
+	m_depthFormat = findDepthFormat();
 
-	createImage(m_extent.width, m_extent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL,
-				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthImage, m_depthImageMemory);
-	m_depthImageView = createImageView(m_depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+	createImage(m_extent.width, m_extent.height, m_depthFormat, VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthImage, m_depthImageMemory);
+	m_depthImageView = createImageView(m_depthImage, m_depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
 void Swapchain::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-							  VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+							  VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
 {
 	// Create vulkan image
 	VkImageCreateInfo imageInfo{};
@@ -364,23 +431,51 @@ void Swapchain::createImage(uint32_t width, uint32_t height, VkFormat format, Vk
 	VkMemoryRequirements memRequirements;
 	vkGetImageMemoryRequirements(m_device.device(), image, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = m_device.findMemoryType(memRequirements.memoryTypeBits, properties);
+	imageMemory = m_device.allocator().allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_LINEAR);
 
-	if (vkAllocateMemory(m_device.device(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-		throw std::runtime_error("failed to allocate image memory!");
+	vkBindImageMemory(m_device.device(), image, imageMemory.memory, imageMemory.offset);
+}
+void Swapchain::releaseRetired(uint32_t frame) {
+	for(auto it = m_retired.begin(); it != m_retired.end(); ) {
+		if(it->frames[frame] == RetiredFrame::Signaled) {
+			it->frames[frame] = RetiredFrame::Done;
+		}
+		if(std::all_of(it->frames.begin(), it->frames.end(), [](RetiredFrame state) { return state == RetiredFrame::Done; })) {
+			destroyRetired(*it);
+			it = m_retired.erase(it);
+		} else {
+			++it;
+		}
 	}
+}
+
+void Swapchain::destroyRetired(Retired& retired) {
+	vkDestroyImageView(m_device.device(), retired.depthImageView, nullptr);
+	vkDestroyImage(m_device.device(), retired.depthImage, nullptr);
+	m_device.allocator().free(retired.depthImageMemory);
 
-	vkBindImageMemory(m_device.device(), image, imageMemory, 0);
+	for(auto framebuffer : retired.framebuffers) {
+		vkDestroyFramebuffer(m_device.device(), framebuffer, nullptr);
+	}
+	if(retired.renderPass != VK_NULL_HANDLE) {
+		vkDestroyRenderPass(m_device.device(), retired.renderPass, nullptr);
+	}
+
+	for(auto imageView : retired.imageViews) {
+		vkDestroyImageView(m_device.device(), imageView, nullptr);
+	}
+	vkDestroySwapchainKHR(m_device.device(), retired.swapChain, nullptr);
 }
 
 
 Swapchain::~Swapchain() {
+	for(Retired& retired : m_retired) {
+		destroyRetired(retired);
+	}
+
 	vkDestroyImageView(m_device.device(), m_depthImageView, nullptr);
 	vkDestroyImage(m_device.device(), m_depthImage, nullptr);
-	vkFreeMemory(m_device.device(), m_depthImageMemory, nullptr);
+	m_device.allocator().free(m_depthImageMemory);
 
 	for(auto framebuffer : m_framebuffers) {
 		vkDestroyFramebuffer(m_device.device(), framebuffer, nullptr);
@@ -392,7 +487,7 @@ Swapchain::~Swapchain() {
 	}
 	vkDestroySwapchainKHR(m_device.device(), m_swapChain, nullptr);
 
-	for(size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i) {
+	for(size_t i = 0; i != m_config.framesInFlight; ++i) {
 		vkDestroySemaphore(m_device.device(), m_imageAvailableSemaphores[i], nullptr);
 		vkDestroySemaphore(m_device.device(), m_renderFinishedSemaphores[i], nullptr);
 		vkDestroyFence(m_device.device(), m_inFlightFences[i], nullptr);
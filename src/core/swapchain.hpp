@@ -4,17 +4,38 @@
 #include <vector>
 
 #include "device.hpp"
+#include "rendererconfig.hpp"
 #include "window.hpp"
 
+//! Depth attachment of the swapchain render pass. Its content is stored after the pass and can be sampled, eg. to build a DepthPyramid.
+struct DepthAttachment {
+	VkImage image;
+	VkImageView view;
+	VkFormat format;
+	VkExtent2D extent;
+};
+
 class Swapchain {
 public:
-	Swapchain(Window& window, Device& device);
+	Swapchain(Window& window, Device& device, const RendererConfig& config = {});
 	~Swapchain();
 
 	VkExtent2D extent() const;
 	uint32_t currentFrame() const;
+	uint32_t framesInFlight() const;
+	uint32_t imageCount() const;
 	VkRenderPass renderPass() const;
 	VkFramebuffer frameBuffer(uint32_t imageIndex) const;
+	DepthAttachment depthAttachment() const;
+	//! Signaled once the last submission of the frame finished on the GPU.
+	VkFence inFlightFence(uint32_t frame) const;
+
+	//! Recreate the images for the current window extent without waiting for the device: The old swapchain is passed to
+	//! the driver and its images, framebuffers and depth image are destroyed once the frames in flight that used them
+	//! completed and their presents are past the render finished semaphores (see RetiredFrame). Render pass and sync
+	//! objects are kept, the render pass is only replaced if the surface format changed.
+	//! @return True if the render pass was replaced: Pipelines created for the old one have to be recreated.
+	bool recreate();
 
 	//! Get the next image and write image index to variable.
 	VkResult getNextImage(uint32_t& imageIndex);
@@ -24,6 +45,34 @@ public:
 	VkResult submitCommandBuffer(VkCommandBuffer& commandBuffer, uint32_t& imageIndex);
 
 private:
+	//! Use of the old swapchain by a frame index. Its fence only covers the submission: The present of the old image waits
+	//! on the render finished semaphore of the index after it. A later submission can only signal that semaphore again
+	//! once the present consumed it, so the index is done when the fence of such a submission was waited for.
+	//! The present engine may still read the image after that; Only VK_EXT_swapchain_maintenance1 present fences
+	//! would tell, they are not used.
+	enum class RetiredFrame : uint8_t {
+		Presenting,  //! No submission signaled the semaphore of the index since the swapchain was replaced
+		Signaled,    //! Submitted a frame that signals it again, its fence was not waited for yet
+		Done
+	};
+
+	//! Resources of a replaced swapchain that frames in flight may still use.
+	struct Retired {
+		VkSwapchainKHR swapChain;
+		std::vector<VkImageView> imageViews;
+		std::vector<VkFramebuffer> framebuffers;
+		VkImage depthImage;
+		MemoryAllocation depthImageMemory;
+		VkImageView depthImageView;
+		VkRenderPass renderPass = VK_NULL_HANDLE;  //! Only set if the format changed
+		std::vector<RetiredFrame> frames;          //! Per frame index
+	};
+
+private:
+	//! The fence of the frame was waited for: Destroy retired resources no frame or present uses anymore.
+	void releaseRetired(uint32_t frame);
+	void destroyRetired(Retired& retired);
+
 	void createSwapChain();
 	void createImageViews();
 	void createRenderPass();
@@ -41,20 +90,17 @@ private:
 
 	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
 	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-					 VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-
-public:
-	//! How many images to work on at the same time.
-	static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+					 VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
 
 private:
 	uint32_t m_currentFrame = 0;
+	RendererConfig m_config;
 
 	// Owned by application
 	Window& m_window;
 	Device& m_device;
 
-	VkSwapchainKHR m_swapChain;
+	VkSwapchainKHR m_swapChain = VK_NULL_HANDLE;
 	VkRenderPass m_renderPass;
 
 	VkFormat m_imageFormat;
@@ -65,12 +111,15 @@ private:
 	std::vector<VkFramebuffer> m_framebuffers;
 
 	// Depth Image
+	VkFormat m_depthFormat;
 	VkImage m_depthImage;
-	VkDeviceMemory m_depthImageMemory;
+	MemoryAllocation m_depthImageMemory;
 	VkImageView m_depthImageView;
 
 	// Sync objects
 	std::vector<VkSemaphore> m_imageAvailableSemaphores;
 	std::vector<VkSemaphore> m_renderFinishedSemaphores;
 	std::vector<VkFence> m_inFlightFences;
+
+	std::vector<Retired> m_retired;
 };
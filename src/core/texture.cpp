@@ -0,0 +1,448 @@
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "blockcompression.hpp"
+#include "file.hpp"
+#include "image.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+// ----- KTX 2.0 -----
+static constexpr uint8_t KTX2_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+struct Ktx2Header {
+	uint8_t identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must not be padded");
+
+struct Ktx2Level {
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+
+// Khronos data format descriptor values (khr_df.h).
+static constexpr uint32_t DF_MODEL_RGBSDA = 1;
+static constexpr uint32_t DF_MODEL_BC1A = 128;
+static constexpr uint32_t DF_MODEL_BC3 = 130;
+static constexpr uint32_t DF_MODEL_BC7 = 134;
+static constexpr uint32_t DF_PRIMARIES_BT709 = 1;
+static constexpr uint32_t DF_TRANSFER_LINEAR = 1;
+static constexpr uint32_t DF_TRANSFER_SRGB = 2;
+static constexpr uint32_t DF_CHANNEL_ALPHA = 15;
+static constexpr uint32_t DF_SAMPLE_LINEAR = 0x10;  //! Alpha of sRGB formats is linear.
+
+// ----- DDS -----
+static constexpr uint32_t DDS_MAGIC = 0x20534444;  // "DDS "
+static constexpr uint32_t DDS_PIXEL_FORMAT_FOURCC = 0x4;
+static constexpr uint32_t DDS_PIXEL_FORMAT_RGB = 0x40;
+static constexpr uint32_t DDS_CAPS2_CUBEMAP = 0x200;
+static constexpr uint32_t DDS_CAPS2_VOLUME = 0x200000;
+static constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+static constexpr uint32_t fourCC(char a, char b, char c, char d) {
+	return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+}
+
+struct DdsPixelFormat {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t rBitMask;
+	uint32_t gBitMask;
+	uint32_t bBitMask;
+	uint32_t aBitMask;
+};
+
+struct DdsHeader {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DdsPixelFormat pixelFormat;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+static_assert(sizeof(DdsHeader) == 124, "DDS header must not be padded");
+
+struct DdsHeaderDx10 {
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+
+VkDeviceSize TextureData::levelOffset(uint32_t level) const {
+	VkDeviceSize offset = 0;
+	for(uint32_t i = 0; i != level; ++i) {
+		offset += levelSize(i);
+	}
+	return offset;
+}
+
+VkDeviceSize TextureData::levelSize(uint32_t level) const {
+	return imageSize(format, mipExtent(width, level), mipExtent(height, level));
+}
+
+FormatBlock formatBlock(VkFormat format) {
+	switch(format) {
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return {1, 4};
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return {4, 8};
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return {4, 16};
+		default:
+			throw std::invalid_argument("Unsupported texture format!");
+	}
+}
+
+bool isBlockCompressed(VkFormat format) {
+	return formatBlock(format).extent != 1;
+}
+
+bool isSrgbFormat(VkFormat format) {
+	switch(format) {
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return true;
+		default:
+			return false;
+	}
+}
+
+VkDeviceSize imageSize(VkFormat format, uint32_t width, uint32_t height) {
+	const FormatBlock block = formatBlock(format);
+	const VkDeviceSize blocksWide = (width + block.extent - 1) / block.extent;
+	const VkDeviceSize blocksHigh = (height + block.extent - 1) / block.extent;
+	return blocksWide * blocksHigh * block.bytes;
+}
+
+TextureData loadTexture(const std::string& path) {
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+	if(extension == ".ktx2") {
+		return loadKtx2(path);
+	}
+	if(extension == ".dds") {
+		return loadDds(path);
+	}
+	return loadImage(path);
+}
+
+TextureData loadImage(const std::string& path) {
+	int texWidth, texHeight, texChannels;
+	stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+	if(!pixels) {
+		throw std::runtime_error("Failed to load texture image!");
+	}
+
+	TextureData texture;
+	texture.format = VK_FORMAT_R8G8B8A8_SRGB;
+	texture.width = static_cast<uint32_t>(texWidth);
+	texture.height = static_cast<uint32_t>(texHeight);
+	texture.mipLevels = 1;
+	texture.data.assign(pixels, pixels + static_cast<size_t>(texWidth) * texHeight * 4);  // 4 Bytes per pixel
+
+	stbi_image_free(pixels);
+	return texture;
+}
+
+TextureData loadKtx2(const std::string& path) {
+	MappedFile file{path};
+
+	Ktx2Header header;
+	if(file.size() < sizeof(header)) {
+		throw std::runtime_error("Failed to load texture, KTX2 file is truncated!");
+	}
+	memcpy(&header, file.data(), sizeof(header));
+
+	if(memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+		throw std::runtime_error("Failed to load texture, not a KTX2 file!");
+	}
+	if(header.supercompressionScheme != 0) {
+		throw std::runtime_error("Failed to load texture, supercompressed KTX2 files are not supported!");
+	}
+	if(header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0) {
+		throw std::runtime_error("Failed to load texture, only 2D KTX2 textures are supported!");
+	}
+
+	TextureData texture;
+	texture.format = static_cast<VkFormat>(header.vkFormat);
+	texture.width = header.pixelWidth;
+	texture.height = header.pixelHeight;
+	texture.mipLevels = std::max(header.levelCount, 1u);  // 0: The loader should generate the levels
+	formatBlock(texture.format);
+
+	const size_t indexEnd = sizeof(header) + texture.mipLevels * sizeof(Ktx2Level);
+	if(file.size() < indexEnd || texture.mipLevels > mipLevelCount(texture.width, texture.height)) {
+		throw std::runtime_error("Failed to load texture, KTX2 level index is invalid!");
+	}
+
+	texture.data.resize(texture.levelOffset(texture.mipLevels));
+	for(uint32_t level = 0; level != texture.mipLevels; ++level) {
+		Ktx2Level entry;
+		memcpy(&entry, file.data() + sizeof(header) + level * sizeof(Ktx2Level), sizeof(entry));
+
+		if(entry.byteLength != texture.levelSize(level) || entry.byteOffset > file.size() || entry.byteLength > file.size() - entry.byteOffset) {
+			throw std::runtime_error("Failed to load texture, KTX2 level data is invalid!");
+		}
+		memcpy(texture.data.data() + texture.levelOffset(level), file.data() + entry.byteOffset, entry.byteLength);
+	}
+
+	return texture;
+}
+
+//! Basic data format descriptor block with one sample per channel (or one for the color of a block).
+static std::vector<uint32_t> dataFormatDescriptor(VkFormat format) {
+	struct Sample {
+		uint32_t bitOffset;
+		uint32_t bitLength;
+		uint32_t channel;
+		uint32_t upper;
+	};
+
+	const bool srgb = isSrgbFormat(format);
+	const uint32_t alpha = DF_CHANNEL_ALPHA | (srgb ? DF_SAMPLE_LINEAR : 0);
+
+	uint32_t model;
+	std::vector<Sample> samples;
+	switch(format) {
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			model = DF_MODEL_RGBSDA;
+			samples = {{0, 8, 0, 255}, {8, 8, 1, 255}, {16, 8, 2, 255}, {24, 8, alpha, 255}};
+			break;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = DF_MODEL_BC1A;
+			samples = {{0, 64, 0, UINT32_MAX}};
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			model = DF_MODEL_BC1A;
+			samples = {{0, 64, 1, UINT32_MAX}};  // Channel 1: Alpha present
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			model = DF_MODEL_BC3;
+			samples = {{0, 64, alpha, UINT32_MAX}, {64, 64, 0, UINT32_MAX}};
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			model = DF_MODEL_BC7;
+			samples = {{0, 128, 0, UINT32_MAX}};
+			break;
+		default:
+			throw std::invalid_argument("Unsupported texture format!");
+	}
+
+	const FormatBlock block = formatBlock(format);
+	const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+	std::vector<uint32_t> dfd = {
+			4 + blockSize,  // Total size
+			0,              // Vendor Khronos, basic descriptor
+			2 | blockSize << 16,
+			model | DF_PRIMARIES_BT709 << 8 | (srgb ? DF_TRANSFER_SRGB : DF_TRANSFER_LINEAR) << 16,
+			(block.extent - 1) | (block.extent - 1) << 8,
+			block.bytes,
+			0
+	};
+	for(const Sample& sample : samples) {
+		dfd.push_back(sample.bitOffset | (sample.bitLength - 1) << 16 | sample.channel << 24);
+		dfd.push_back(0);  // Sample position
+		dfd.push_back(0);  // Lower
+		dfd.push_back(sample.upper);
+	}
+	return dfd;
+}
+
+void writeKtx2(const std::string& path, const TextureData& texture) {
+	const std::vector<uint32_t> dfd = dataFormatDescriptor(texture.format);
+	const VkDeviceSize alignment = std::max<VkDeviceSize>(formatBlock(texture.format).bytes, 4);  // lcm(block size, 4)
+
+	Ktx2Header header{};
+	memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+	header.vkFormat = static_cast<uint32_t>(texture.format);
+	header.typeSize = 1;
+	header.pixelWidth = texture.width;
+	header.pixelHeight = texture.height;
+	header.faceCount = 1;
+	header.levelCount = texture.mipLevels;
+	header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + texture.mipLevels * sizeof(Ktx2Level));
+	header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+	// Smallest level first, so streaming readers get a usable texture early.
+	std::vector<Ktx2Level> levels(texture.mipLevels);
+	VkDeviceSize offset = header.dfdByteOffset + header.dfdByteLength;
+	for(uint32_t level = texture.mipLevels; level-- != 0;) {
+		offset = (offset + alignment - 1) / alignment * alignment;
+		levels[level] = {offset, texture.levelSize(level), texture.levelSize(level)};
+		offset += texture.levelSize(level);
+	}
+
+	std::vector<char> file(offset, 0);
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + sizeof(header), levels.data(), levels.size() * sizeof(Ktx2Level));
+	memcpy(file.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+	for(uint32_t level = 0; level != texture.mipLevels; ++level) {
+		memcpy(file.data() + levels[level].byteOffset, texture.data.data() + texture.levelOffset(level), levels[level].byteLength);
+	}
+
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	if(!stream.write(file.data(), static_cast<std::streamsize>(file.size()))) {
+		throw std::runtime_error("Failed to write KTX2 file!");
+	}
+}
+
+static VkFormat ddsFormat(const DdsHeader& header, const DdsHeaderDx10* dx10) {
+	if(dx10) {
+		switch(dx10->dxgiFormat) {
+			case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+			case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+			case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+			case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+			case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+			case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+			default: return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	const DdsPixelFormat& pixelFormat = header.pixelFormat;
+	if(pixelFormat.flags & DDS_PIXEL_FORMAT_FOURCC) {
+		if(pixelFormat.fourCC == fourCC('D', 'X', 'T', '1')) {
+			return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		}
+		if(pixelFormat.fourCC == fourCC('D', 'X', 'T', '5')) {
+			return VK_FORMAT_BC3_SRGB_BLOCK;
+		}
+	} else if((pixelFormat.flags & DDS_PIXEL_FORMAT_RGB) && pixelFormat.rgbBitCount == 32
+	          && pixelFormat.rBitMask == 0x000000FF && pixelFormat.gBitMask == 0x0000FF00 && pixelFormat.bBitMask == 0x00FF0000) {
+		return VK_FORMAT_R8G8B8A8_SRGB;
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+TextureData loadDds(const std::string& path) {
+	MappedFile file{path};
+
+	uint32_t magic = 0;
+	DdsHeader header;
+	if(file.size() < sizeof(magic) + sizeof(header)) {
+		throw std::runtime_error("Failed to load texture, DDS file is truncated!");
+	}
+	memcpy(&magic, file.data(), sizeof(magic));
+	memcpy(&header, file.data() + sizeof(magic), sizeof(header));
+
+	if(magic != DDS_MAGIC || header.size != sizeof(header)) {
+		throw std::runtime_error("Failed to load texture, not a DDS file!");
+	}
+	if(header.caps2 & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME)) {
+		throw std::runtime_error("Failed to load texture, only 2D DDS textures are supported!");
+	}
+
+	size_t dataOffset = sizeof(magic) + sizeof(header);
+	DdsHeaderDx10 dx10{};
+	const bool hasDx10 = (header.pixelFormat.flags & DDS_PIXEL_FORMAT_FOURCC) && header.pixelFormat.fourCC == fourCC('D', 'X', '1', '0');
+	if(hasDx10) {
+		if(file.size() < dataOffset + sizeof(dx10)) {
+			throw std::runtime_error("Failed to load texture, DDS file is truncated!");
+		}
+		memcpy(&dx10, file.data() + dataOffset, sizeof(dx10));
+		dataOffset += sizeof(dx10);
+
+		if(dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10.arraySize > 1) {
+			throw std::runtime_error("Failed to load texture, only 2D DDS textures are supported!");
+		}
+	}
+
+	TextureData texture;
+	texture.format = ddsFormat(header, hasDx10 ? &dx10 : nullptr);
+	texture.width = header.width;
+	texture.height = header.height;
+	texture.mipLevels = std::max(header.mipMapCount, 1u);
+	if(texture.format == VK_FORMAT_UNDEFINED) {
+		throw std::runtime_error("Failed to load texture, unsupported DDS format!");
+	}
+	if(texture.width == 0 || texture.height == 0 || texture.mipLevels > mipLevelCount(texture.width, texture.height)) {
+		throw std::runtime_error("Failed to load texture, DDS header is invalid!");
+	}
+
+	// Levels follow the header, largest first and tightly packed.
+	const VkDeviceSize size = texture.levelOffset(texture.mipLevels);
+	if(file.size() - dataOffset < size) {
+		throw std::runtime_error("Failed to load texture, DDS file is truncated!");
+	}
+	texture.data.assign(file.data() + dataOffset, file.data() + dataOffset + size);
+
+	return texture;
+}
+
+TextureData decompress(const TextureData& texture) {
+	if(!isBlockCompressed(texture.format)) {
+		return texture;
+	}
+
+	TextureData result;
+	result.format = isSrgbFormat(texture.format) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	result.width = texture.width;
+	result.height = texture.height;
+	result.mipLevels = texture.mipLevels;
+	result.data.reserve(result.levelOffset(result.mipLevels));
+
+	for(uint32_t level = 0; level != texture.mipLevels; ++level) {
+		const std::vector<uint8_t> pixels = decompressImage(texture.data.data() + texture.levelOffset(level),
+		                                                    mipExtent(texture.width, level), mipExtent(texture.height, level), texture.format);
+		result.data.insert(result.data.end(), pixels.begin(), pixels.end());
+	}
+
+	return result;
+}
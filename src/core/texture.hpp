@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! Texel block of a format: Block compressed formats store 4x4 texels in 8 or 16 bytes, others one texel.
+struct FormatBlock {
+	uint32_t extent;  //! Width and height in texels.
+	uint32_t bytes;
+};
+
+//! Pixels of a 2D texture with all of its stored mip levels, level 0 first and tightly packed.
+struct TextureData {
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipLevels = 0;
+	std::vector<uint8_t> data;
+
+	VkDeviceSize levelOffset(uint32_t level) const;
+	VkDeviceSize levelSize(uint32_t level) const;
+};
+
+//! Formats supported by the texture loaders: RGBA8, BC1, BC3 and BC7, each in UNORM and SRGB.
+//! Throws for any other format.
+FormatBlock formatBlock(VkFormat format);
+bool isBlockCompressed(VkFormat format);
+bool isSrgbFormat(VkFormat format);
+//! Bytes of one image of the format, padded to whole blocks.
+VkDeviceSize imageSize(VkFormat format, uint32_t width, uint32_t height);
+
+//! Load a texture by file extension: .ktx2 and .dds keep their format and levels, other images are decoded by
+//! stb_image into a single RGBA8 sRGB level.
+TextureData loadTexture(const std::string& path);
+TextureData loadImage(const std::string& path);
+//! KTX 2.0 files without supercompression.
+TextureData loadKtx2(const std::string& path);
+//! DDS files with DXT1, DXT5 or DX10 headers. Legacy DXT1 and DXT5 files have no color space and are loaded as sRGB.
+TextureData loadDds(const std::string& path);
+
+//! Write a KTX 2.0 file with a basic data format descriptor, levels are stored smallest first.
+void writeKtx2(const std::string& path, const TextureData& texture);
+
+//! Decode a block compressed texture on the CPU into RGBA8 with the same color space and levels.
+//! Fallback for devices that can not sample the format.
+TextureData decompress(const TextureData& texture);
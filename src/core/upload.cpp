@@ -0,0 +1,544 @@
+#include "upload.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "gpuprofiler.hpp"
+#include "image.hpp"
+#include "texture.hpp"
+
+// Stages that read uploaded data on the graphics queue.
+static constexpr VkPipelineStageFlags UPLOAD_CONSUMER_STAGES =
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+static VkImageMemoryBarrier imageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t baseMipLevel, uint32_t levelCount) {
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = baseMipLevel;
+	barrier.subresourceRange.levelCount = levelCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	return barrier;
+}
+
+UploadBatch::UploadBatch(Device& device, JobSystem* jobs) : m_device(device), m_jobs(jobs) {
+	const QueueFamilyIndices& indices = m_device.findQueueFamilies();
+	m_graphicsFamily = indices.graphicsFamily.value();
+	m_transferFamily = indices.transferFamily.value();
+	m_dedicatedTransfer = indices.hasDedicatedTransfer();
+	m_stagingWriter = m_device.stagingRing().addWriter([this]() { flush(); });
+
+	if(m_dedicatedTransfer) {
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		if(vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &m_transferSemaphore) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create upload semaphore!");
+		}
+	}
+
+	if(m_device.transferTimestampValidBits() != 0 && m_device.timestampPeriod() > 0.0f) {
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = 2;
+
+		if(vkCreateQueryPool(m_device.device(), &poolInfo, nullptr, &m_queryPool) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create upload query pool!");
+		}
+	}
+
+	beginCommandBuffer();
+
+	// Command buffers flushed early run before the last one on the same queue: The timestamps enclose all of them.
+	if(m_queryPool != VK_NULL_HANDLE) {
+		vkCmdResetQueryPool(m_commandBuffer, m_queryPool, 0, 2);
+		vkCmdWriteTimestamp(m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+	}
+}
+
+void UploadBatch::beginCommandBuffer() {
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = m_device.transferCommandPool();
+	allocInfo.commandBufferCount = 1;
+
+	if(vkAllocateCommandBuffers(m_device.device(), &allocInfo, &m_commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate upload command buffer!");
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(m_commandBuffer, &beginInfo);
+}
+
+VkDeviceSize UploadBatch::uploadedBytes() const {
+	return m_uploadedBytes;
+}
+
+std::optional<double> UploadBatch::gpuTimeMs() const {
+	if(m_queryPool == VK_NULL_HANDLE || !m_complete) {
+		return std::nullopt;
+	}
+
+	uint64_t results[4];  // Timestamp and availability of begin and end
+	const VkResult result = vkGetQueryPoolResults(m_device.device(), m_queryPool, 0, 2, sizeof(results), results, 2 * sizeof(uint64_t),
+	                                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if((result != VK_SUCCESS && result != VK_NOT_READY) || results[1] == 0 || results[3] == 0) {
+		return std::nullopt;
+	}
+	return timestampDeltaMs(results[0], results[2], m_device.timestampPeriod(), m_device.transferTimestampValidBits());
+}
+
+StagingRegion UploadBatch::reserve(VkDeviceSize size) {
+	assert(!m_submitted && "Recorded into an upload batch after submitting it");
+
+	// 16 Bytes satisfy the offset alignment of buffer copies and of image copies for every texel and block size.
+	StagingRegion region;
+	if(!m_device.stagingRing().allocate(size, 16, m_stagingWriter, region)) {
+		throw std::runtime_error("Failed to reserve staging memory!");
+	}
+	m_regions.push_back(region);
+	return region;
+}
+
+void UploadBatch::uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+	const char* src = static_cast<const char*>(data);
+
+	// Chunks of half the ring let the CPU fill one half while the GPU copies from the other.
+	const VkDeviceSize chunkSize = m_device.stagingRing().capacity() / 2;
+
+	for(VkDeviceSize done = 0; done < size;) {
+		const VkDeviceSize chunk = std::min(size - done, chunkSize);
+
+		const StagingRegion region = reserve(chunk);
+		memcpy(region.mapped, src + done, chunk);
+		copyBuffer(region.buffer, dstBuffer, chunk, region.offset, dstOffset + done);
+		done += chunk;
+	}
+}
+
+void UploadBatch::uploadImage(const void* pixels, VkDeviceSize size, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels) {
+	const char* src = static_cast<const char*>(pixels);
+	const VkDeviceSize texelSize = size / (static_cast<VkDeviceSize>(width) * height);
+	const FormatBlock texel{1, static_cast<uint32_t>(texelSize)};
+
+	transitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+	uploadImageLevel(src, texel, image, width, height, 0);
+	m_uploadedBytes += size;
+
+	if(mipLevels > 1 && supportsLinearBlit(format)) {
+		m_mipChains.push_back({image, width, height, mipLevels});
+
+		// Blits need a graphics queue -> Hand all levels over in the transfer layout, the chain is built after the acquire.
+		if(m_dedicatedTransfer) {
+			VkImageMemoryBarrier barrier = imageBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, mipLevels);
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.srcQueueFamilyIndex = m_transferFamily;
+			barrier.dstQueueFamilyIndex = m_graphicsFamily;
+			m_imageTransfers.push_back(barrier);
+		}
+		return;
+	}
+
+	if(mipLevels > 1) {
+		if(texelSize != 4) {
+			throw std::runtime_error("Failed to generate mip levels, the image format can not be blitted!");
+		}
+
+		const std::vector<uint8_t> chain = generateMipChain(static_cast<const uint8_t*>(pixels), width, height, mipLevels, isSrgbFormat(format), m_jobs);
+		const char* level = reinterpret_cast<const char*>(chain.data());
+		for(uint32_t mipLevel = 1; mipLevel < mipLevels; ++mipLevel) {
+			const uint32_t levelWidth = mipExtent(width, mipLevel);
+			const uint32_t levelHeight = mipExtent(height, mipLevel);
+			uploadImageLevel(level, texel, image, levelWidth, levelHeight, mipLevel);
+			level += texelSize * levelWidth * levelHeight;
+		}
+		m_uploadedBytes += chain.size();
+	}
+
+	// Prepare for use in shader.
+	transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
+}
+
+void UploadBatch::uploadImageLevels(const void* data, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels) {
+	const FormatBlock block = formatBlock(format);
+	const char* level = static_cast<const char*>(data);
+
+	transitionImageLayout(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+	for(uint32_t mipLevel = 0; mipLevel != mipLevels; ++mipLevel) {
+		const uint32_t levelWidth = mipExtent(width, mipLevel);
+		const uint32_t levelHeight = mipExtent(height, mipLevel);
+		uploadImageLevel(level, block, image, levelWidth, levelHeight, mipLevel);
+
+		const VkDeviceSize levelSize = imageSize(format, levelWidth, levelHeight);
+		level += levelSize;
+		m_uploadedBytes += levelSize;
+	}
+	transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
+}
+
+void UploadBatch::uploadImageLevel(const char* pixels, FormatBlock block, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel) {
+	// Images are split into chunks of whole rows of blocks (a block is one texel for uncompressed formats).
+	const uint32_t blockRows = (height + block.extent - 1) / block.extent;
+	const VkDeviceSize rowPitch = static_cast<VkDeviceSize>(block.bytes) * ((width + block.extent - 1) / block.extent);
+	const uint32_t rowsPerChunk = static_cast<uint32_t>(std::max<VkDeviceSize>(m_device.stagingRing().capacity() / 2 / rowPitch, 1));
+
+	for(uint32_t row = 0; row < blockRows;) {
+		const uint32_t rows = std::min(blockRows - row, rowsPerChunk);
+
+		// The last row of blocks may extend past the image; The copy is clamped to the image extent.
+		const uint32_t firstTexelRow = row * block.extent;
+		const uint32_t texelRows = std::min(rows * block.extent, height - firstTexelRow);
+
+		const StagingRegion region = reserve(rows * rowPitch);
+		memcpy(region.mapped, pixels + row * rowPitch, rows * rowPitch);
+		copyBufferToImage(region.buffer, image, width, texelRows, region.offset, firstTexelRow, mipLevel);
+		row += rows;
+	}
+}
+
+bool UploadBatch::supportsLinearBlit(VkFormat format) const {
+	return m_device.isFormatSupported(format, VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+}
+
+void UploadBatch::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
+	assert(!m_submitted && "Recorded into an upload batch after submitting it");
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = srcOffset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(m_commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+	m_hasBufferCopies = true;
+	m_uploadedBytes += size;
+
+	if(m_dedicatedTransfer) {
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		barrier.srcQueueFamilyIndex = m_transferFamily;
+		barrier.dstQueueFamilyIndex = m_graphicsFamily;
+		barrier.buffer = dstBuffer;
+		barrier.offset = dstOffset;
+		barrier.size = size;
+
+		m_bufferTransfers.push_back(barrier);
+	}
+}
+
+void UploadBatch::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize bufferOffset, uint32_t firstRow, uint32_t mipLevel) {
+	assert(!m_submitted && "Recorded into an upload batch after submitting it");
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = bufferOffset;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = mipLevel;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+
+	region.imageOffset = {0, static_cast<int32_t>(firstRow), 0};
+	region.imageExtent = {width, height, 1};
+
+	vkCmdCopyBufferToImage(m_commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
+void UploadBatch::transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) {
+	assert(!m_submitted && "Recorded into an upload batch after submitting it");
+
+	VkImageMemoryBarrier barrier = imageBarrier(image, oldLayout, newLayout, 0, mipLevels);
+
+	// Handle different transition types
+	VkPipelineStageFlags sourceStage;
+	VkPipelineStageFlags destinationStage;
+
+	if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	} else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		// The image is read on the graphics queue -> The layout transition becomes part of the ownership transfer.
+		if(m_dedicatedTransfer) {
+			barrier.srcQueueFamilyIndex = m_transferFamily;
+			barrier.dstQueueFamilyIndex = m_graphicsFamily;
+			m_imageTransfers.push_back(barrier);
+			return;
+		}
+	} else {
+		throw std::invalid_argument("Unsupported layout transition!");
+	}
+
+	vkCmdPipelineBarrier(m_commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void UploadBatch::keepAlive(std::unique_ptr<Buffer> buffer) {
+	m_stagingBuffers.push_back(std::move(buffer));
+}
+
+void UploadBatch::recordMipChains(VkCommandBuffer commandBuffer) {
+	for(const MipChain& chain : m_mipChains) {
+		int32_t width = static_cast<int32_t>(chain.width);
+		int32_t height = static_cast<int32_t>(chain.height);
+
+		for(uint32_t level = 1; level < chain.mipLevels; ++level) {
+			// The level above was written by the copy or the previous blit and is the source now.
+			VkImageMemoryBarrier barrier = imageBarrier(chain.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, level - 1, 1);
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			                     0, nullptr, 0, nullptr, 1, &barrier);
+
+			const int32_t levelWidth = std::max(width / 2, 1);
+			const int32_t levelHeight = std::max(height / 2, 1);
+
+			VkImageBlit blit{};
+			blit.srcOffsets[0] = {0, 0, 0};
+			blit.srcOffsets[1] = {width, height, 1};
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.dstOffsets[0] = {0, 0, 0};
+			blit.dstOffsets[1] = {levelWidth, levelHeight, 1};
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+
+			vkCmdBlitImage(commandBuffer, chain.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, chain.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			               1, &blit, VK_FILTER_LINEAR);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			                     0, nullptr, 0, nullptr, 1, &barrier);
+
+			width = levelWidth;
+			height = levelHeight;
+		}
+
+		// The last level is never a blit source.
+		VkImageMemoryBarrier barrier = imageBarrier(chain.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, chain.mipLevels - 1, 1);
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+		                     0, nullptr, 0, nullptr, 1, &barrier);
+	}
+}
+
+VkPipelineStageFlags UploadBatch::acquireStages() const {
+	return m_mipChains.empty() ? UPLOAD_CONSUMER_STAGES : UPLOAD_CONSUMER_STAGES | VK_PIPELINE_STAGE_TRANSFER_BIT;
+}
+
+void UploadBatch::recordOwnershipTransfers() {
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = m_device.commandPool();
+	allocInfo.commandBufferCount = 1;
+
+	if(vkAllocateCommandBuffers(m_device.device(), &allocInfo, &m_acquireCommandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate upload acquire command buffer!");
+	}
+
+	// Release: Only the source half of the barrier is executed on the transfer queue.
+	std::vector<VkBufferMemoryBarrier> bufferReleases = m_bufferTransfers;
+	std::vector<VkImageMemoryBarrier> imageReleases = m_imageTransfers;
+	for(auto& barrier : bufferReleases) {
+		barrier.dstAccessMask = 0;
+	}
+	for(auto& barrier : imageReleases) {
+		barrier.dstAccessMask = 0;
+	}
+
+	vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+	                     0, nullptr,
+	                     static_cast<uint32_t>(bufferReleases.size()), bufferReleases.data(),
+	                     static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+
+	// Acquire: Only the destination half is executed on the graphics queue, after the semaphore wait.
+	for(auto& barrier : m_bufferTransfers) {
+		barrier.srcAccessMask = 0;
+	}
+	for(auto& barrier : m_imageTransfers) {
+		barrier.srcAccessMask = 0;
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(m_acquireCommandBuffer, &beginInfo);
+	vkCmdPipelineBarrier(m_acquireCommandBuffer, acquireStages(), acquireStages(), 0,
+	                     0, nullptr,
+	                     static_cast<uint32_t>(m_bufferTransfers.size()), m_bufferTransfers.data(),
+	                     static_cast<uint32_t>(m_imageTransfers.size()), m_imageTransfers.data());
+	recordMipChains(m_acquireCommandBuffer);
+
+	if(vkEndCommandBuffer(m_acquireCommandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to record upload acquire command buffer!");
+	}
+}
+
+void UploadBatch::submit() {
+	assert(!m_submitted && "Upload batch submitted twice");
+
+	if(m_dedicatedTransfer) {
+		recordOwnershipTransfers();
+	} else if(m_hasBufferCopies) {
+		// Make the copied buffer data visible to every stage that reads vertex, index or uniform data.
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, UPLOAD_CONSUMER_STAGES,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	// Without a dedicated transfer family this is a graphics queue already.
+	if(!m_dedicatedTransfer) {
+		recordMipChains(m_commandBuffer);
+	}
+
+	if(m_queryPool != VK_NULL_HANDLE) {
+		vkCmdWriteTimestamp(m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 1);
+	}
+
+	if(vkEndCommandBuffer(m_commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to record upload command buffer!");
+	}
+
+	// The last submission signals the staging fence; It completes after all copies of the batch.
+	uint64_t ticket = 0;
+	VkFence fence = m_device.stagingRing().submit(m_regions, ticket);
+	m_regions.clear();
+	m_tickets.push_back(ticket);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_commandBuffer;
+
+	if(!m_dedicatedTransfer) {
+		if(vkQueueSubmit(m_device.graphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to submit upload command buffer!");
+		}
+		m_submitted = true;
+		return;
+	}
+
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_transferSemaphore;
+
+	if(vkQueueSubmit(m_device.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to submit upload command buffer!");
+	}
+
+	// The acquire waits on the GPU; Frames submitted to the graphics queue before it are not blocked by the copies.
+	VkPipelineStageFlags waitStage = acquireStages();
+	VkSubmitInfo acquireInfo{};
+	acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	acquireInfo.waitSemaphoreCount = 1;
+	acquireInfo.pWaitSemaphores = &m_transferSemaphore;
+	acquireInfo.pWaitDstStageMask = &waitStage;
+	acquireInfo.commandBufferCount = 1;
+	acquireInfo.pCommandBuffers = &m_acquireCommandBuffer;
+
+	if(vkQueueSubmit(m_device.graphicsQueue(), 1, &acquireInfo, fence) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to submit upload acquire command buffer!");
+	}
+	m_submitted = true;
+}
+
+void UploadBatch::flush() {
+	if(vkEndCommandBuffer(m_commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to record upload command buffer!");
+	}
+
+	uint64_t ticket = 0;
+	VkFence fence = m_device.stagingRing().submit(m_regions, ticket);
+	m_regions.clear();
+	m_tickets.push_back(ticket);
+
+	// Ownership is released in the last command buffer. Its barrier covers these copies since they are
+	// earlier in submission order on the same queue.
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_commandBuffer;
+
+	if(vkQueueSubmit(m_device.transferQueue(), 1, &submitInfo, fence) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to submit upload command buffer!");
+	}
+
+	m_flushedCommandBuffers.push_back(m_commandBuffer);
+	beginCommandBuffer();
+}
+
+bool UploadBatch::isComplete() {
+	if(!m_complete && m_submitted) {
+		StagingRing& ring = m_device.stagingRing();
+		m_complete = std::all_of(m_tickets.begin(), m_tickets.end(), [&ring](uint64_t ticket) { return ring.isComplete(ticket); });
+	}
+	return m_complete;
+}
+
+void UploadBatch::wait() {
+	assert(m_submitted && "Waited for an upload batch that was never submitted");
+
+	if(!m_complete) {
+		for(uint64_t ticket : m_tickets) {
+			m_device.stagingRing().wait(ticket);
+		}
+		m_complete = true;
+	}
+}
+
+UploadBatch::~UploadBatch() {
+	// Resources used by the batch can only be released once the GPU is done with them. Early flushed
+	// copies are in flight even if the batch itself was never submitted.
+	for(uint64_t ticket : m_tickets) {
+		m_device.stagingRing().wait(ticket);
+	}
+	m_device.stagingRing().release(m_regions);
+	m_device.stagingRing().removeWriter(m_stagingWriter);
+
+	m_flushedCommandBuffers.push_back(m_commandBuffer);
+	vkFreeCommandBuffers(m_device.device(), m_device.transferCommandPool(),
+	                     static_cast<uint32_t>(m_flushedCommandBuffers.size()), m_flushedCommandBuffers.data());
+
+	if(m_acquireCommandBuffer != VK_NULL_HANDLE) {
+		vkFreeCommandBuffers(m_device.device(), m_device.commandPool(), 1, &m_acquireCommandBuffer);
+	}
+	if(m_transferSemaphore != VK_NULL_HANDLE) {
+		vkDestroySemaphore(m_device.device(), m_transferSemaphore, nullptr);
+	}
+	if(m_queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(m_device.device(), m_queryPool, nullptr);
+	}
+}
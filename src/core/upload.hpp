@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "device.hpp"
+#include "buffer.hpp"
+#include "staging.hpp"
+#include "texture.hpp"
+
+class JobSystem;
+
+//! Records many copies and layout transitions into a single command buffer and submits them once with a fence.
+//! Replaces the single time command buffers that stalled the whole graphics queue for every copy.
+//!
+//! With a dedicated transfer queue the copies run there, next to rendering. Ownership of the written buffers and
+//! images is then released to the graphics family and acquired by a small command buffer on the graphics queue,
+//! which waits on a semaphore of the transfer submit.
+//!
+//! Data is staged in the staging ring of the device, the batch never allocates staging memory of its own. Uploads
+//! larger than the ring are split into chunks; when the ring is full of recorded but unsubmitted copies (of this batch
+//! or another one), these are submitted early to free it up.
+//!
+//! Usage: Record commands -> submit() -> poll isComplete() or wait(). The batch can not be reused after submitting.
+//! Main thread only, like the staging ring.
+class UploadBatch {
+public:
+	//! @param jobs Generates the mip levels the GPU can not blit on all threads of the job system. The batch is still
+	//!             used on the main thread only.
+	UploadBatch(Device& device, JobSystem* jobs = nullptr);
+	~UploadBatch();
+
+	UploadBatch(const UploadBatch&) = delete;
+	UploadBatch& operator=(const UploadBatch&) = delete;
+
+	//! Copy data into the staging ring and record a copy to the destination buffer.
+	void uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+	//! Copy pixel data into the staging ring and record the transitions and copy to make it readable by shaders.
+	//! @param pixels Level 0. The other levels are generated: Blits on the graphics queue if the format supports
+	//!               linear filtering (the image needs TRANSFER_SRC usage), a box filter on the CPU otherwise.
+	void uploadImage(const void* pixels, VkDeviceSize size, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels = 1);
+	//! Upload mip levels that are already stored, eg. block compressed textures. Nothing is generated.
+	//! @param data Levels 0 to mipLevels - 1, tightly packed one after another (see TextureData).
+	void uploadImageLevels(const void* data, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+	//! Copy the rows [firstRow, firstRow + height) of the image from tightly packed buffer data.
+	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize bufferOffset = 0, uint32_t firstRow = 0, uint32_t mipLevel = 0);
+	//! Transition the levels [0, mipLevels) of the image.
+	void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1);
+
+	//! Keep a buffer alive until the GPU finished executing the batch (eg. staging buffers).
+	void keepAlive(std::unique_ptr<Buffer> buffer);
+
+	//! Submit all recorded commands to the transfer queue. Does not block.
+	void submit();
+	//! True once the GPU finished executing the batch.
+	bool isComplete();
+	//! Block until the GPU finished executing the batch.
+	void wait();
+
+	//! Bytes of buffer copies and staged images recorded into this batch.
+	VkDeviceSize uploadedBytes() const;
+	//! GPU time from the first to the last copy, including copies flushed early, once the batch is complete. Empty if
+	//! the transfer queue can not write timestamps (see Device::transferTimestampValidBits()) or the batch is running.
+	//! Mip chains blitted after the ownership transfer to the graphics queue are not included.
+	//! Pass it to GpuProfiler::addScopeTime() to see uploads next to the frame scopes.
+	std::optional<double> gpuTimeMs() const;
+
+private:
+	void beginCommandBuffer();
+	//! Reserve staging memory. The ring flushes batches whose recorded copies block it.
+	StagingRegion reserve(VkDeviceSize size);
+	//! Submit the copies recorded so far without ownership transfers and continue in a new command buffer.
+	void flush();
+	void recordOwnershipTransfers();
+
+	//! Stage one mip level of an image in chunks of whole rows of texel blocks.
+	void uploadImageLevel(const char* pixels, FormatBlock block, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel);
+	bool supportsLinearBlit(VkFormat format) const;
+	//! Blit every level from the one above and make all levels readable by shaders. Needs a graphics queue.
+	void recordMipChains(VkCommandBuffer commandBuffer);
+	//! Stages of the graphics queue waiting for the transfer queue.
+	VkPipelineStageFlags acquireStages() const;
+
+private:
+	struct MipChain {
+		VkImage image;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+	};
+
+private:
+	// Owned by application
+	Device& m_device;
+	JobSystem* m_jobs;
+
+	uint32_t m_graphicsFamily;
+	uint32_t m_transferFamily;
+	bool m_dedicatedTransfer;
+	uint32_t m_stagingWriter;  //! Id in the staging ring.
+
+	VkCommandBuffer m_commandBuffer;                            //! Copies, from the transfer pool.
+	std::vector<VkCommandBuffer> m_flushedCommandBuffers;       //! Copies that were submitted early.
+	VkCommandBuffer m_acquireCommandBuffer = VK_NULL_HANDLE;  //! Ownership acquire, from the graphics pool.
+	VkSemaphore m_transferSemaphore = VK_NULL_HANDLE;
+	VkQueryPool m_queryPool = VK_NULL_HANDLE;  //! Begin and end timestamp of the copies, if the transfer queue can write them.
+
+	std::vector<StagingRegion> m_regions;  //! Staging memory read by m_commandBuffer.
+	std::vector<uint64_t> m_tickets;       //! Staging ring tickets of all submissions.
+
+	// Acquire barriers for the graphics queue; the matching release barriers are recorded on submit.
+	std::vector<VkBufferMemoryBarrier> m_bufferTransfers;
+	std::vector<VkImageMemoryBarrier> m_imageTransfers;
+
+	std::vector<MipChain> m_mipChains;  //! Images with level 0 uploaded, the other levels are blitted on submit.
+
+	bool m_submitted = false;
+	bool m_complete = false;
+	bool m_hasBufferCopies = false;  //! Buffer copies need a memory barrier before their data is read.
+	VkDeviceSize m_uploadedBytes = 0;
+
+	std::vector<std::unique_ptr<Buffer>> m_stagingBuffers;
+};
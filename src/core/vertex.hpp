@@ -4,40 +4,69 @@
 #include <array>
 #include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+
+//! Per instance attributes, read from the second vertex binding when a pipeline is instanced.
+struct InstanceData {
+    glm::mat4 transform;  //! Model matrix, takes four attribute locations.
+    glm::vec4 color;
+    glm::vec4 custom;     //! Free for the shaders of the application.
+};
 
 struct Vertex {
     glm::vec3 pos;
     glm::vec3 color;
     glm::vec2 texCoord;
 
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    static constexpr uint32_t VERTEX_BINDING = 0;
+    static constexpr uint32_t INSTANCE_BINDING = 1;
+    static constexpr uint32_t FIRST_INSTANCE_LOCATION = 3;  //! Locations 3-6: transform, 7: color, 8: custom
+
+    //! @param instanced Add the per instance binding.
+    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(bool instanced = false) {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(instanced ? 2 : 1);
+        bindingDescriptions[0].binding = VERTEX_BINDING;
+        bindingDescriptions[0].stride = sizeof(Vertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-        return bindingDescription;
+        if(instanced) {
+            bindingDescriptions[1].binding = INSTANCE_BINDING;
+            bindingDescriptions[1].stride = sizeof(InstanceData);
+            bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        }
+
+        return bindingDescriptions;
     }
 
-    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-        attributeDescriptions[0].binding = 0;
+    //! @param instanced Add the attributes of InstanceData.
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(bool instanced = false) {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
+        attributeDescriptions[0].binding = VERTEX_BINDING;
         attributeDescriptions[0].location = 0;
         attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
         attributeDescriptions[0].offset = offsetof(Vertex, pos);
 
-        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].binding = VERTEX_BINDING;
         attributeDescriptions[1].location = 1;
         attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
         attributeDescriptions[1].offset = offsetof(Vertex, color);
 
-        attributeDescriptions[2].binding = 0;
+        attributeDescriptions[2].binding = VERTEX_BINDING;
         attributeDescriptions[2].location = 2;
         attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
         attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
 
+        if(instanced) {
+            // A mat4 attribute is passed as four vec4 columns.
+            for(uint32_t column = 0; column != 4; ++column) {
+                attributeDescriptions.push_back({FIRST_INSTANCE_LOCATION + column, INSTANCE_BINDING, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                                 static_cast<uint32_t>(offsetof(InstanceData, transform) + column * sizeof(glm::vec4))});
+            }
+            attributeDescriptions.push_back({FIRST_INSTANCE_LOCATION + 4, INSTANCE_BINDING, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                             static_cast<uint32_t>(offsetof(InstanceData, color))});
+            attributeDescriptions.push_back({FIRST_INSTANCE_LOCATION + 5, INSTANCE_BINDING, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                             static_cast<uint32_t>(offsetof(InstanceData, custom))});
+        }
+
         return attributeDescriptions;
     }
 
@@ -46,14 +75,6 @@ struct Vertex {
 	}
 };
 
-namespace std {
-template<> struct hash<Vertex> {
-	size_t operator()(Vertex const& vertex) const {
-		return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
-	}
-};
-}
-
 /*
 const std::vector<Vertex> vertices = {
     {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
@@ -73,9 +94,13 @@ const std::vector<uint16_t> indices = {
 };
 */
 
+//! Per frame data, shared by all objects.
 struct UniformBufferObject {
-	alignas(16) glm::mat4 model;
 	alignas(16) glm::mat4 view;
 	alignas(16) glm::mat4 proj;
-	alignas(16) glm::vec3 offset;
+};
+
+//! Per draw data, pushed with vkCmdPushConstants. Stays below the 128 bytes every device supports.
+struct ObjectPushConstants {
+	alignas(16) glm::mat4 model;
 };
\ No newline at end of file
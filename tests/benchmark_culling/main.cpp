@@ -0,0 +1,79 @@
+#include "lwEngine/cullingsystem.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// CPU frustum culling of bounding spheres with every path the CPU supports, single threaded and as jobs.
+// Usage: Benchmark_Culling [--benchmark_filter=<regex>]. Test_Culling checks that all paths agree.
+
+//! Camera at the origin looking down -z with a 90 degree field of view.
+static Frustum makeFrustum() {
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.0f;
+
+	glm::mat4 projection(0.0f);
+	projection[0][0] = 1.0f;
+	projection[1][1] = 1.0f;
+	projection[2][2] = farPlane / (nearPlane - farPlane);
+	projection[2][3] = -1.0f;
+	projection[3][2] = nearPlane * farPlane / (nearPlane - farPlane);
+	return Frustum::fromMatrix(projection);
+}
+
+//! Objects all around the camera, roughly a sixth of them is visible.
+static void fillScene(CullingSystem& culling, uint32_t objectCount) {
+	std::mt19937 random(objectCount);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> radius(0.1f, 2.0f);
+	culling.resize(objectCount);
+	for(uint32_t i = 0; i != objectCount; ++i) {
+		culling.set(i, BoundingSphere{{position(random), position(random), position(random)}, radius(random)});
+	}
+}
+
+static void BM_Cull(benchmark::State& state, CullingPath path) {
+	if(!CullingSystem::isSupported(path)) {
+		state.SkipWithError("Not supported by the CPU");
+		return;
+	}
+
+	const uint32_t objectCount = static_cast<uint32_t>(state.range(0));
+	CullingSystem culling(path);
+	fillScene(culling, objectCount);
+	const Frustum frustum = makeFrustum();
+	std::vector<uint32_t> visible(culling.visibleCapacity());
+
+	uint32_t visibleCount = 0;
+	for(auto _ : state) {
+		visibleCount = culling.cull(frustum, visible.data());
+		benchmark::DoNotOptimize(visible.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * objectCount);
+	state.counters["visible"] = visibleCount;
+}
+BENCHMARK_CAPTURE(BM_Cull, Scalar, CullingPath::Scalar)->RangeMultiplier(10)->Range(10000, 1000000);
+BENCHMARK_CAPTURE(BM_Cull, SSE, CullingPath::SSE)->RangeMultiplier(10)->Range(10000, 1000000);
+BENCHMARK_CAPTURE(BM_Cull, AVX2, CullingPath::AVX2)->RangeMultiplier(10)->Range(10000, 1000000);
+
+//! Best path on all threads of the job system.
+static void BM_CullJobs(benchmark::State& state) {
+	const uint32_t objectCount = static_cast<uint32_t>(state.range(0));
+	CullingSystem culling(CullingSystem::bestPath());
+	fillScene(culling, objectCount);
+	const Frustum frustum = makeFrustum();
+	JobSystem jobs;
+	std::vector<uint32_t> visible;
+
+	for(auto _ : state) {
+		culling.cull(frustum, visible, jobs);
+		benchmark::DoNotOptimize(visible.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * objectCount);
+	state.counters["threads"] = jobs.threadCount();
+}
+BENCHMARK(BM_CullJobs)->RangeMultiplier(10)->Range(10000, 1000000)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,105 @@
+#include "lwEngine/mesh.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+
+// Vertex deduplication of OBJ files: open addressing table vs the previous std::unordered_map.
+// Usage: Benchmark_Dedup [model.obj ...]
+
+struct LegacyVertexHash {
+	size_t operator()(Vertex const& vertex) const {
+		return ((std::hash<glm::vec3>()(vertex.pos) ^ (std::hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (std::hash<glm::vec2>()(vertex.texCoord) << 1);
+	}
+};
+
+static constexpr int REPETITIONS = 5;
+
+template<typename Function>
+static double bestTimeMs(Function function) {
+	double best = 1e30;
+	for(int i = 0; i != REPETITIONS; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+static bool benchmark(const std::string& path) {
+	const auto loadStart = std::chrono::steady_clock::now();
+	const MeshData mesh = loadObj(path);
+	const auto loadEnd = std::chrono::steady_clock::now();
+
+	// Expand back to one vertex per triangle corner: The stream the OBJ loader deduplicates.
+	std::vector<Vertex> corners;
+	corners.reserve(mesh.indices.size());
+	for(uint32_t index : mesh.indices) {
+		corners.push_back(mesh.vertices[index]);
+	}
+
+	MeshData deduplicated;
+	const double openAddressingMs = bestTimeMs([&]() {
+		VertexDeduplicator deduplicator{corners.size() / 4};
+		deduplicator.mesh().indices.reserve(corners.size());
+		for(const Vertex& vertex : corners) {
+			deduplicator.add(vertex);
+		}
+		deduplicated = std::move(deduplicator.mesh());
+	});
+
+	size_t legacyVertexCount = 0;
+	const double unorderedMapMs = bestTimeMs([&]() {
+		std::unordered_map<Vertex, uint32_t, LegacyVertexHash> uniqueVertices{};
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		indices.reserve(corners.size());
+		for(const Vertex& vertex : corners) {
+			auto inserted = uniqueVertices.emplace(vertex, static_cast<uint32_t>(vertices.size()));
+			if(inserted.second) {
+				vertices.push_back(vertex);
+			}
+			indices.push_back(inserted.first->second);
+		}
+		legacyVertexCount = vertices.size();
+	});
+
+	const size_t vertexBytes = deduplicated.vertices.size() * sizeof(Vertex) + deduplicated.indices.size() * sizeof(uint32_t);
+	std::cout << path << "\n"
+	          << "  load (parse + dedup):    " << std::chrono::duration<double, std::milli>(loadEnd - loadStart).count() << " ms\n"
+	          << "  corners:                 " << corners.size() << " (" << corners.size() * sizeof(Vertex) / 1024 << " KiB non indexed)\n"
+	          << "  unique vertices:         " << deduplicated.vertices.size() << "\n"
+	          << "  indices:                 " << deduplicated.indices.size() << " (" << vertexBytes / 1024 << " KiB indexed)\n"
+	          << "  open addressing:         " << openAddressingMs << " ms\n"
+	          << "  std::unordered_map:      " << unorderedMapMs << " ms\n";
+
+	// Both must find the same vertices and every corner has to be restored by its index.
+	bool ok = legacyVertexCount == deduplicated.vertices.size() && deduplicated.indices.size() == corners.size();
+	for(size_t i = 0; ok && i != corners.size(); ++i) {
+		ok = deduplicated.vertices[deduplicated.indices[i]] == corners[i];
+	}
+	if(!ok) {
+		std::cerr << "  Deduplication result is wrong!\n";
+	}
+	return ok;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> paths(argv + 1, argv + argc);
+	if(paths.empty()) {
+		paths.push_back(RESOURCE_PATH_VIKING_MODEL);
+	}
+
+	bool ok = true;
+	for(const auto& path : paths) {
+		ok = benchmark(path) && ok;
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
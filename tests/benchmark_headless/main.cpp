@@ -0,0 +1,57 @@
+#include "lwEngine/device.hpp"
+#include "lwEngine/renderer.hpp"
+#include "common/headless.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+// Frame rate of headless rendering at 1080p, with and without reading the frames back.
+// Frames are never presented, the rate is only limited by the GPU. Needs a vulkan device but no display.
+// Usage: Benchmark_Headless [--benchmark_filter=<regex>]. Test_Headless checks the readback.
+
+static void renderFrame(Renderer& renderer) {
+	VkCommandBuffer commandBuffer = renderer.beginFrame();
+	renderer.beginSwapchainRenderPass(commandBuffer);
+	renderer.endSwapchainRenderPass(commandBuffer);
+	renderer.endFrame();
+}
+
+static void BM_Frames(benchmark::State& state, Device& device, bool readback) {
+	Renderer renderer(device, {1920, 1080});
+	renderer.renderTarget()->setReadbackEnabled(readback);
+
+	for(auto _ : state) {
+		renderFrame(renderer);
+	}
+	vkDeviceWaitIdle(device.device());
+
+	// items/s are frames/s
+	state.SetItemsProcessed(state.iterations());
+}
+
+int main(int argc, char** argv) {
+	benchmark::Initialize(&argc, argv);
+
+	if(!hasVulkanDevice()) {
+		std::cout << "Skipped, no vulkan device\n";
+		return 0;
+	}
+
+	std::unique_ptr<Device> device;
+	try {
+		device = std::make_unique<Device>();
+	} catch(const std::exception& e) {
+		std::cerr << "Failed to create the headless device: " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	benchmark::RegisterBenchmark("BM_Frames/1080p", BM_Frames, std::ref(*device), false)->UseRealTime()->Unit(benchmark::kMillisecond);
+	benchmark::RegisterBenchmark("BM_Frames/1080pReadback", BM_Frames, std::ref(*device), true)->UseRealTime()->Unit(benchmark::kMillisecond);
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
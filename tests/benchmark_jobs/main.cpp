@@ -0,0 +1,121 @@
+#include "lwEngine/jobsystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Job system overhead and scaling:
+//   spawn:   Empty jobs submitted by the main thread, cost per job.
+//   tree:    Jobs that submit two child jobs each, every job after the first is spawned on a worker and stolen.
+//   scaling: Compute bound parallelFor with 1, 2, 4, ... threads.
+// Usage: Benchmark_Jobs
+
+static constexpr int REPETITIONS = 5;
+
+template<typename Function>
+static double bestTimeMs(Function function) {
+	double best = 1e30;
+	for(int i = 0; i != REPETITIONS; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+static void spawnTree(JobSystem& jobs, JobCounter& counter, std::atomic<uint32_t>& leaves, uint32_t depth) {
+	if(depth == 0) {
+		leaves.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	for(int i = 0; i != 2; ++i) {
+		jobs.submit([&jobs, &counter, &leaves, depth]() { spawnTree(jobs, counter, leaves, depth - 1); }, &counter);
+	}
+}
+
+static bool benchmarkOverhead(uint32_t threadCount) {
+	JobSystem jobs(threadCount);
+	bool ok = true;
+
+	const uint32_t jobCount = 100000;
+	std::atomic<uint32_t> ran{0};
+	const double spawnMs = bestTimeMs([&]() {
+		JobCounter counter;
+		for(uint32_t i = 0; i != jobCount; ++i) {
+			jobs.submit([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		}
+		jobs.wait(counter);
+	});
+	ok = ok && ran.load() == REPETITIONS * jobCount;
+
+	const uint32_t depth = 16;
+	std::atomic<uint32_t> leaves{0};
+	const double treeMs = bestTimeMs([&]() {
+		JobCounter counter;
+		spawnTree(jobs, counter, leaves, depth);
+		jobs.wait(counter);
+	});
+	const uint32_t treeJobs = (2u << depth) - 2;
+	ok = ok && leaves.load() == REPETITIONS * (1u << depth);
+
+	std::cout << jobs.threadCount() << " threads\n"
+	          << "  spawn:  " << spawnMs * 1e6 / jobCount << " ns per job (" << jobCount << " jobs)\n"
+	          << "  tree:   " << treeMs * 1e6 / treeJobs << " ns per job (" << treeJobs << " jobs)\n";
+	return ok;
+}
+
+static bool benchmarkScaling(const std::vector<float>& input) {
+	const uint32_t count = static_cast<uint32_t>(input.size());
+	std::vector<float> output(count);
+	double singleThreadMs = 0.0;
+	bool ok = true;
+
+	std::cout << "scaling (" << count << " elements)\n";
+	const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for(uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreads)) {
+		JobSystem jobs(threadCount);
+		const double ms = bestTimeMs([&]() {
+			jobs.parallelFor(count, 4096, [&](uint32_t first, uint32_t size) {
+				for(uint32_t i = first; i != first + size; ++i) {
+					output[i] = std::sqrt(std::sin(input[i]) * std::sin(input[i]) + std::cos(input[i]));
+				}
+			});
+		});
+		if(threadCount == 1) {
+			singleThreadMs = ms;
+		}
+		std::cout << "  " << threadCount << " threads: " << ms << " ms, speedup " << singleThreadMs / ms << "\n";
+
+		if(threadCount == maxThreads) {
+			break;
+		}
+	}
+
+	for(uint32_t i = 0; i < count; i += 997) {
+		ok = ok && output[i] == std::sqrt(std::sin(input[i]) * std::sin(input[i]) + std::cos(input[i]));
+	}
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	for(uint32_t threadCount : {1u, 0u}) {
+		ok = benchmarkOverhead(threadCount) && ok;
+	}
+
+	std::vector<float> input(1 << 22);
+	for(size_t i = 0; i != input.size(); ++i) {
+		input[i] = static_cast<float>(i % 1000) * 0.001f;
+	}
+	ok = benchmarkScaling(input) && ok;
+
+	if(!ok) {
+		std::cerr << "Jobs did not run exactly once!\n";
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,134 @@
+#include "lwEngine/jobsystem.hpp"
+#include "lwEngine/mesh.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+// OBJ parser on all threads of the job system vs tinyobjloader. Both have to produce the same mesh, byte for byte.
+// Usage: Benchmark_Obj [faceCount | model.obj ...]
+// A face count generates a synthetic mesh with that many faces, e.g. 1000000 50000000.
+
+static constexpr size_t DEFAULT_FACE_COUNT = 1000000;
+
+//! Grid of triangles and quads with texture coordinates. Every third cell is a quad (two faces), rows alternate
+//! between absolute and relative indices.
+static std::filesystem::path generateObj(size_t faceCount) {
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / ("lwEngineBenchmark" + std::to_string(faceCount) + ".obj");
+
+	size_t side = 1;
+	while(2 * side * side < faceCount) {
+		++side;
+	}
+	const size_t points = side + 1;
+
+	FILE* file = fopen(path.string().c_str(), "wb");
+	if(!file) {
+		std::cerr << "Failed to create " << path << "\n";
+		std::exit(EXIT_FAILURE);
+	}
+
+	fprintf(file, "# Synthetic grid, %zu faces\no grid\n", faceCount);
+	for(size_t y = 0; y != points; ++y) {
+		for(size_t x = 0; x != points; ++x) {
+			const double u = static_cast<double>(x) / side;
+			const double v = static_cast<double>(y) / side;
+			// Some height, so quads are not planar and the diagonal matters.
+			fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\n", u * 2.0 - 1.0, 0.1 * ((x * 7 + y * 13) % 5), v * 2.0 - 1.0, u, v);
+		}
+	}
+
+	const long long count = static_cast<long long>(points * points);
+	size_t written = 0;
+	for(size_t y = 0; y != side && written < faceCount; ++y) {
+		const bool relative = y % 2 == 1;
+		for(size_t x = 0; x != side && written < faceCount; ++x) {
+			long long corners[4] = {
+					static_cast<long long>(y * points + x + 1),
+					static_cast<long long>(y * points + x + 2),
+					static_cast<long long>((y + 1) * points + x + 2),
+					static_cast<long long>((y + 1) * points + x + 1)
+			};
+			if(relative) {
+				for(auto& corner : corners) {
+					corner = corner - 1 - count;
+				}
+			}
+
+			if(x % 3 == 0) {
+				fprintf(file, "f %lld/%lld %lld/%lld %lld/%lld %lld/%lld\n", corners[0], corners[0], corners[1], corners[1],
+				        corners[2], corners[2], corners[3], corners[3]);
+				written += 1;
+			} else {
+				fprintf(file, "f %lld/%lld %lld/%lld %lld/%lld\nf %lld/%lld %lld/%lld %lld/%lld\n",
+				        corners[0], corners[0], corners[1], corners[1], corners[2], corners[2],
+				        corners[0], corners[0], corners[2], corners[2], corners[3], corners[3]);
+				written += 2;
+			}
+		}
+	}
+
+	fclose(file);
+	return path;
+}
+
+template<typename Function>
+static double loadMs(Function load, const std::string& path, MeshData& mesh) {
+	const auto start = std::chrono::steady_clock::now();
+	mesh = load(path);
+	const auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static bool benchmark(const std::string& path, JobSystem& jobs) {
+	MeshData parsed;
+	MeshData reference;
+	const double parsedMs = loadMs([&jobs](const std::string& file) { return loadObj(file, &jobs); }, path, parsed);
+	const double referenceMs = loadMs(loadObjTinyobj, path, reference);
+
+	const double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+	std::cout << path << " (" << megabytes << " MiB)\n"
+	          << "  vertices:       " << parsed.vertices.size() << "\n"
+	          << "  indices:        " << parsed.indices.size() << "\n"
+	          << "  loadObj:        " << parsedMs << " ms (" << megabytes / parsedMs * 1000.0 << " MiB/s)\n"
+	          << "  tinyobjloader:  " << referenceMs << " ms (" << megabytes / referenceMs * 1000.0 << " MiB/s)\n";
+
+	const bool ok = parsed.vertices.size() == reference.vertices.size()
+	                && parsed.indices == reference.indices
+	                && memcmp(parsed.vertices.data(), reference.vertices.data(), parsed.vertices.size() * sizeof(Vertex)) == 0
+	                && parsed.bounds.min == reference.bounds.min
+	                && parsed.bounds.max == reference.bounds.max;
+	if(!ok) {
+		std::cerr << "  Mesh differs from tinyobjloader!\n";
+	}
+	return ok;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+	if(arguments.empty()) {
+		arguments.push_back(RESOURCE_PATH_VIKING_MODEL);
+		arguments.push_back(std::to_string(DEFAULT_FACE_COUNT));
+	}
+
+	JobSystem jobs;
+	bool ok = true;
+	for(const auto& argument : arguments) {
+		char* end = nullptr;
+		const unsigned long long faceCount = strtoull(argument.c_str(), &end, 10);
+		if(*end != '\0' || faceCount == 0) {
+			ok = benchmark(argument, jobs) && ok;
+			continue;
+		}
+
+		const std::filesystem::path path = generateObj(faceCount);
+		ok = benchmark(path.string(), jobs) && ok;
+		std::filesystem::remove(path);
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
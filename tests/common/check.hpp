@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Minimal checks shared by the tests: A failed check is reported and counted, the test continues.
+
+inline int g_failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if(!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": Check failed: " #condition "\n"; \
+			++g_failures; \
+		} \
+	} while(0)
+
+//! Exit code of a test: Reports the number of failed checks.
+inline int checkResult(const char* name) {
+	if(g_failures != 0) {
+		std::cerr << g_failures << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "All " << name << " checks passed\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// Tests needing a vulkan device are skipped on machines without one, every other failure fails them.
+
+//! Exit code ctest reports as skipped, see SKIP_RETURN_CODE in tests/CMakeLists.txt.
+constexpr int SKIPPED = 77;
+
+//! Whether the vulkan loader finds a driver exposing at least one physical device.
+inline bool hasVulkanDevice() {
+	VkApplicationInfo appInfo{};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+
+	VkInstanceCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	createInfo.pApplicationInfo = &appInfo;
+
+	// Without any installed driver the loader fails instance creation with VK_ERROR_INCOMPATIBLE_DRIVER
+	VkInstance instance;
+	if(vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+		return false;
+	}
+
+	uint32_t deviceCount = 0;
+	const VkResult result = vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+	vkDestroyInstance(instance, nullptr);
+	return result == VK_SUCCESS && deviceCount != 0;
+}
@@ -0,0 +1,84 @@
+#include "lwEngine/memory.hpp"
+#include "common/check.hpp"
+
+#include <vector>
+
+// Placement logic of the device memory allocator. Runs without a vulkan device.
+
+static void testAlignment() {
+	FreeListBlock block{1024};
+
+	VkDeviceSize a = 0, b = 0;
+	CHECK(block.allocate(10, 1, a));
+	CHECK(block.allocate(16, 256, b));
+	CHECK(a == 0);
+	CHECK(b == 256);
+
+	// The padding between both allocations is still usable.
+	VkDeviceSize c = 0;
+	CHECK(block.allocate(200, 4, c));
+	CHECK(c == 12);
+	CHECK(block.usedBytes() == 226);
+}
+
+static void testCoalescing() {
+	FreeListBlock block{400};
+
+	std::vector<VkDeviceSize> offsets(4);
+	for(auto& offset : offsets) {
+		CHECK(block.allocate(100, 1, offset));
+	}
+
+	VkDeviceSize none = 0;
+	CHECK(!block.allocate(1, 1, none));
+
+	// Free out of order: ranges have to merge back into one.
+	block.free(offsets[1], 100);
+	block.free(offsets[3], 100);
+	CHECK(block.freeRangeCount() == 2);
+	CHECK(block.largestFreeRange() == 100);
+
+	block.free(offsets[2], 100);
+	CHECK(block.freeRangeCount() == 1);
+	CHECK(block.largestFreeRange() == 300);
+
+	block.free(offsets[0], 100);
+	CHECK(block.empty());
+	CHECK(block.largestFreeRange() == 400);
+}
+
+static void testBestFit() {
+	FreeListBlock block{1000};
+
+	VkDeviceSize a = 0, b = 0, c = 0, d = 0;
+	block.allocate(300, 1, a);
+	block.allocate(100, 1, b);
+	block.allocate(50, 1, c);
+	block.allocate(100, 1, d);
+	block.free(a, 300);  // Free range of 300 at the front
+	block.free(c, 50);   // Free range of 50 in the middle
+
+	// Smallest range that fits is used, the large one stays intact.
+	VkDeviceSize e = 0;
+	CHECK(block.allocate(40, 1, e));
+	CHECK(e == c);
+	CHECK(block.largestFreeRange() == 450);
+}
+
+static void testStats() {
+	MemoryStats stats{};
+	CHECK(stats.fragmentation() == 0.0f);
+
+	stats.freeBytes = 200;
+	stats.largestFreeRange = 50;
+	CHECK(stats.fragmentation() == 0.75f);
+}
+
+int main() {
+	testAlignment();
+	testCoalescing();
+	testBestFit();
+	testStats();
+
+	return checkResult("allocator");
+}
@@ -0,0 +1,120 @@
+#include "lwEngine/resourcecache.hpp"
+#include "common/check.hpp"
+
+#include <memory>
+
+// Sharing and LRU eviction of the resource cache behind the asset cache. Runs without a vulkan device.
+
+static AssetKey meshKey(const std::string& path, const void* target = nullptr) {
+	return AssetKey{AssetKey::Type::Mesh, path, target};
+}
+
+static AssetKey textureKey(const std::string& path) {
+	return AssetKey{AssetKey::Type::Texture, path, nullptr};
+}
+
+static void testSharing() {
+	ResourceCache cache(1000, 2);
+	CHECK(cache.find(meshKey("room.obj")) == nullptr);
+
+	auto mesh = std::make_shared<int>(1);
+	cache.insert(meshKey("room.obj"), mesh, 100);
+
+	// Every user gets the same resource, the memory is counted once.
+	CHECK(cache.find(meshKey("room.obj")) == mesh);
+	CHECK(cache.find(meshKey("room.obj")) == mesh);
+	CHECK(cache.stats().residentBytes == 100);
+	CHECK(cache.stats().entryCount == 1);
+	CHECK(cache.stats().hits == 2);
+	CHECK(cache.stats().misses == 1);
+
+	// Same path with other options or of another type is another resource.
+	int pool = 0;
+	CHECK(cache.find(meshKey("room.obj", &pool)) == nullptr);
+	CHECK(cache.find(textureKey("room.obj")) == nullptr);
+
+	bool threw = false;
+	try {
+		cache.insert(meshKey("room.obj"), std::make_shared<int>(2), 100);
+	} catch(const std::runtime_error&) {
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+static void testEviction() {
+	ResourceCache cache(250, 2);
+	auto a = std::make_shared<int>(0);
+	auto b = std::make_shared<int>(1);
+	auto c = std::make_shared<int>(2);
+	cache.insert(meshKey("a"), a, 100);
+	cache.insert(meshKey("b"), b, 100);
+	cache.insert(meshKey("c"), c, 100);
+
+	// Over the budget, but everything is in use.
+	CHECK(cache.endFrame() == 0);
+	CHECK(cache.stats().residentBytes == 300);
+
+	// Unused resources are kept for the frames in flight, then the least recently used one goes.
+	cache.find(meshKey("a"));  // a is now more recently used than b
+	a.reset();
+	b.reset();
+	CHECK(cache.endFrame() == 0);
+	CHECK(cache.endFrame() == 1);
+	CHECK(cache.find(meshKey("b")) == nullptr);
+	CHECK(cache.find(meshKey("a")) != nullptr);
+	CHECK(cache.stats().residentBytes == 200);
+	CHECK(cache.stats().evictions == 1);
+
+	// Under the budget nothing is evicted.
+	CHECK(cache.endFrame() == 0);
+	CHECK(cache.stats().entryCount == 2);
+
+	// A lower budget evicts the rest that is unused, resources in use stay.
+	cache.setBudget(0);
+	CHECK(cache.endFrame() == 1);
+	CHECK(cache.find(meshKey("c")) == c);
+	CHECK(cache.stats().residentBytes == 100);
+}
+
+static void testReuse() {
+	ResourceCache cache(0, 2);
+	auto a = std::make_shared<int>(0);
+	cache.insert(meshKey("a"), a, 100);
+	a.reset();
+	CHECK(cache.endFrame() == 0);
+
+	// Used again before its retirement: The frames in flight start over once it is released.
+	auto again = std::static_pointer_cast<int>(cache.find(meshKey("a")));
+	CHECK(again != nullptr);
+	CHECK(cache.endFrame() == 0);
+	again.reset();
+	CHECK(cache.endFrame() == 0);
+	CHECK(cache.endFrame() == 1);
+
+	// Used and released within one frame: The frame may still read it.
+	cache.insert(meshKey("b"), std::make_shared<int>(1), 100);
+	CHECK(cache.endFrame() == 0);
+	cache.find(meshKey("b"));
+	CHECK(cache.endFrame() == 0);
+	CHECK(cache.endFrame() == 1);
+}
+
+static void testUnaccounted() {
+	// Meshes in an append only pool free nothing when evicted and stay.
+	ResourceCache cache(0, 1);
+	cache.insert(meshKey("pooled"), std::make_shared<int>(0), 0);
+	for(int i = 0; i != 3; ++i) {
+		CHECK(cache.endFrame() == 0);
+	}
+	CHECK(cache.find(meshKey("pooled")) != nullptr);
+}
+
+int main() {
+	testSharing();
+	testEviction();
+	testReuse();
+	testUnaccounted();
+
+	return checkResult("asset cache");
+}
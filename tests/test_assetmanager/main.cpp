@@ -0,0 +1,97 @@
+#include "lwEngine/assetmanager.hpp"
+#include "lwEngine/texture.hpp"
+#include "common/check.hpp"
+#include "common/headless.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+// Asynchronous model loading of the asset manager, with and without worker threads. Needs a vulkan device but no
+// display, eg. lavapipe in CI. Skipped if no device is available.
+
+static void writeFiles(const std::string& pathModel, const std::string& pathTexture) {
+	std::ofstream(pathModel, std::ios::binary | std::ios::trunc) << "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 0 1\nf 1/1 2/2 3/3\n";
+
+	TextureData texture;
+	texture.format = VK_FORMAT_R8G8B8A8_SRGB;
+	texture.width = 4;
+	texture.height = 4;
+	texture.mipLevels = 1;
+	texture.data.assign(4 * 4 * 4, 0xFF);
+	writeKtx2(pathTexture, texture);
+}
+
+static void testRequests(Device& device, JobSystem& jobs, const std::string& pathModel, const std::string& pathTexture) {
+	AssetCache cache(device);
+	AssetManager assets(device, jobs, cache);
+
+	// Requests of a model still loading share it and count once.
+	const ModelHandle first = assets.loadModelAsync(pathModel, pathTexture);
+	const ModelHandle second = assets.loadModelAsync(pathModel, pathTexture);
+	CHECK(first.state() == AssetState::Loading);
+	CHECK(first.get() == nullptr);
+	CHECK(assets.pendingCount() == 1);
+
+	// Missing files only fail their model.
+	const ModelHandle missing = assets.loadModelAsync(pathModel + ".missing", pathTexture);
+	CHECK(assets.pendingCount() == 2);
+
+	assets.waitAll();
+	CHECK(assets.pendingCount() == 0);
+
+	CHECK(first.isReady() && first.get() != nullptr);
+	CHECK(first.get() == second.get());
+	CHECK(first.error().empty());
+
+	CHECK(missing.state() == AssetState::Failed);
+	CHECK(missing.get() == nullptr);
+	CHECK(!missing.error().empty());
+}
+
+static void testDestroyed(Device& device, JobSystem& jobs, const std::string& pathModel, const std::string& pathTexture) {
+	AssetCache cache(device);
+	ModelHandle handle;
+	{
+		AssetManager assets(device, jobs, cache);
+		handle = assets.loadModelAsync(pathModel, pathTexture);
+	}
+
+	// Never uploaded without update(): The handle fails instead of loading forever.
+	CHECK(handle.state() == AssetState::Failed);
+	CHECK(!handle.error().empty());
+}
+
+int main() {
+	if(!hasVulkanDevice()) {
+		std::cout << "Skipped, no vulkan device\n";
+		return SKIPPED;
+	}
+
+	std::unique_ptr<Device> device;
+	try {
+		device = std::make_unique<Device>();
+	} catch(const std::exception& e) {
+		std::cerr << "Failed to create the headless device: " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "lwEngineTestAssetManager";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	const std::string pathModel = (directory / "triangle.obj").string();
+	const std::string pathTexture = (directory / "white.ktx2").string();
+	writeFiles(pathModel, pathTexture);
+
+	// A job system without workers decodes in update() instead of in jobs.
+	for(uint32_t threadCount : {1u, 4u}) {
+		JobSystem jobs(threadCount);
+		testRequests(*device, jobs, pathModel, pathTexture);
+		testDestroyed(*device, jobs, pathModel, pathTexture);
+	}
+
+	std::filesystem::remove_all(directory);
+
+	return checkResult("asset manager");
+}
@@ -0,0 +1,228 @@
+#include "lwEngine/culling.hpp"
+#include "lwEngine/cullingsystem.hpp"
+#include "lwEngine/frustum.hpp"
+#include "common/check.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Frustum planes, depth pyramid and the CPU reference of the GPU culling. Runs without a vulkan device.
+
+static const float NEAR_PLANE = 0.1f;
+static const float FAR_PLANE = 10.0f;
+
+//! Camera at the origin looking down -z with a 90 degree field of view. Depth range [0, 1].
+static glm::mat4 makeViewProjection() {
+	glm::mat4 projection(0.0f);
+	projection[0][0] = 1.0f;
+	projection[1][1] = 1.0f;
+	projection[2][2] = FAR_PLANE / (NEAR_PLANE - FAR_PLANE);
+	projection[2][3] = -1.0f;
+	projection[3][2] = NEAR_PLANE * FAR_PLANE / (NEAR_PLANE - FAR_PLANE);
+	return projection;
+}
+
+//! Depth a point at distance in front of the camera ends up with in the depth buffer.
+static float depthAt(float distance) {
+	const glm::vec4 clip = makeViewProjection() * glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+	return clip.z / clip.w;
+}
+
+static CullObject makeObject(glm::vec3 center, float radius, uint32_t index) {
+	return {glm::vec4(center, radius), 36, 6 * index, static_cast<int32_t>(index), index};
+}
+
+static void testFrustum() {
+	const Frustum frustum = Frustum::fromMatrix(makeViewProjection());
+
+	for(const glm::vec4& plane : frustum.planes) {
+		CHECK(std::abs(glm::length(glm::vec3(plane)) - 1.0f) < 1e-5f);
+	}
+
+	CHECK(frustum.intersects(BoundingSphere{{0.0f, 0.0f, -5.0f}, 1.0f}));
+	CHECK(!frustum.intersects(BoundingSphere{{0.0f, 0.0f, 5.0f}, 1.0f}));     // Behind the camera
+	CHECK(!frustum.intersects(BoundingSphere{{20.0f, 0.0f, -5.0f}, 1.0f}));   // Right
+	CHECK(frustum.intersects(BoundingSphere{{5.5f, 0.0f, -5.0f}, 1.0f}));     // Crosses the right plane
+	CHECK(!frustum.intersects(BoundingSphere{{0.0f, -9.0f, -5.0f}, 1.0f}));   // Below
+	CHECK(!frustum.intersects(BoundingSphere{{0.0f, 0.0f, -12.0f}, 1.0f}));   // Behind the far plane
+	CHECK(frustum.intersects(BoundingSphere{{0.0f, 0.0f, -12.0f}, 3.0f}));
+
+	CHECK(frustum.intersects(MeshBounds{{-1.0f, -1.0f, -6.0f}, {1.0f, 1.0f, -4.0f}}));
+	CHECK(!frustum.intersects(MeshBounds{{-1.0f, -1.0f, 1.0f}, {1.0f, 1.0f, 2.0f}}));
+	CHECK(frustum.intersects(MeshBounds{{4.0f, -1.0f, -6.0f}, {8.0f, 1.0f, -4.0f}}));
+}
+
+static void testSpheres() {
+	const BoundingSphere sphere = boundingSphere(MeshBounds{{-1.0f, -2.0f, -2.0f}, {1.0f, 2.0f, 2.0f}});
+	CHECK(sphere.center.x == 0.0f && sphere.center.y == 0.0f && sphere.center.z == 0.0f);
+	CHECK(std::abs(sphere.radius - 3.0f) < 1e-5f);
+
+	glm::mat4 transform(1.0f);
+	transform[1][1] = 2.0f;                        // Scale y
+	transform[3] = glm::vec4(5.0f, 0.0f, 0.0f, 1.0f);  // Translate x
+	const BoundingSphere transformed = transformSphere(sphere, transform);
+	CHECK(transformed.center.x == 5.0f);
+	CHECK(std::abs(transformed.radius - 6.0f) < 1e-5f);
+}
+
+static void testPyramid() {
+	const uint32_t width = 5;
+	const uint32_t height = 3;
+	std::vector<float> depth(width * height);
+	for(uint32_t i = 0; i != depth.size(); ++i) {
+		depth[i] = static_cast<float>((i * 7) % 11) / 10.0f;
+	}
+
+	CHECK(pyramidLevelCount({width, height}) == 3);
+	const DepthPyramidData pyramid = buildDepthPyramid(depth.data(), width, height);
+	CHECK(pyramid.levels.size() == 3);
+	CHECK(pyramid.sizes[0].x == 3 && pyramid.sizes[0].y == 2);
+	CHECK(pyramid.sizes[1].x == 2 && pyramid.sizes[1].y == 1);
+	CHECK(pyramid.sizes[2].x == 1 && pyramid.sizes[2].y == 1);
+	CHECK(pyramid.levels[2][0] == *std::max_element(depth.begin(), depth.end()));
+
+	// Conservative: A texel is never closer than a depth texel it covers.
+	for(uint32_t y = 0; y != height; ++y) {
+		for(uint32_t x = 0; x != width; ++x) {
+			const uint32_t px = (x * pyramid.sizes[0].x) / width;
+			const uint32_t py = (y * pyramid.sizes[0].y) / height;
+			CHECK(pyramid.levels[0][py * pyramid.sizes[0].x + px] >= depth[y * width + x]);
+		}
+	}
+}
+
+static void testOcclusion() {
+	// A wall two units in front of the camera covers the left half of the screen, the right half is empty.
+	const uint32_t size = 64;
+	std::vector<float> depth(size * size, 1.0f);
+	for(uint32_t y = 0; y != size; ++y) {
+		for(uint32_t x = 0; x != size / 2; ++x) {
+			depth[y * size + x] = depthAt(2.0f);
+		}
+	}
+	const DepthPyramidData pyramid = buildDepthPyramid(depth.data(), size, size);
+
+	const glm::uvec2 pyramidSize = pyramid.sizes[0];
+	const uint32_t levels = static_cast<uint32_t>(pyramid.levels.size());
+	const CullUniforms occlusion = makeCullUniforms(makeViewProjection(), 4, CULL_FRUSTUM | CULL_OCCLUSION, pyramidSize, levels);
+	const CullUniforms frustumOnly = makeCullUniforms(makeViewProjection(), 4, CULL_FRUSTUM, pyramidSize, levels);
+
+	const CullObject hidden = makeObject({-2.0f, 0.0f, -6.0f}, 0.5f, 0);    // Behind the wall
+	const CullObject inFront = makeObject({-0.5f, 0.0f, -1.0f}, 0.2f, 1);  // In front of the wall
+	const CullObject right = makeObject({2.0f, 0.0f, -6.0f}, 0.5f, 2);     // Nothing in front of it
+	const CullObject outside = makeObject({0.0f, 0.0f, 6.0f}, 0.5f, 3);    // Behind the camera
+
+	CHECK(!isObjectVisible(hidden, occlusion, &pyramid));
+	CHECK(isObjectVisible(hidden, frustumOnly, &pyramid));
+	CHECK(isObjectVisible(hidden, occlusion, nullptr));
+	CHECK(isObjectVisible(inFront, occlusion, &pyramid));
+	CHECK(isObjectVisible(right, occlusion, &pyramid));
+	CHECK(!isObjectVisible(outside, frustumOnly, &pyramid));
+
+	// The reference emits the draws of the visible objects in object order, like a compacted indirect buffer.
+	const CullObject objects[] = {hidden, inFront, right, outside};
+	const std::vector<VkDrawIndexedIndirectCommand> commands = cullObjects(objects, 4, occlusion, &pyramid);
+	CHECK(commands.size() == 2);
+	if(commands.size() == 2) {
+		CHECK(commands[0].firstInstance == 1 && commands[1].firstInstance == 2);
+		CHECK(commands[1].indexCount == 36 && commands[1].firstIndex == 12 && commands[1].vertexOffset == 2);
+		CHECK(commands[0].instanceCount == 1);
+	}
+}
+
+static void testCullingSystem() {
+	const Frustum frustum = Frustum::fromMatrix(makeViewProjection());
+
+	// Spheres and boxes around the frustum, the count is not a multiple of a SIMD block.
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-12.0f, 12.0f);
+	std::uniform_real_distribution<float> size(0.0f, 2.0f);
+	CullingSystem culling(CullingPath::Scalar);
+	std::vector<bool> expected;
+	for(uint32_t i = 0; i != 1003; ++i) {
+		const glm::vec3 center(position(random), position(random), position(random));
+		if(i % 3 == 0) {
+			const glm::vec3 extent(size(random), size(random), size(random));
+			const MeshBounds box{center - extent, center + extent};
+			culling.add(box);
+			expected.push_back(frustum.intersects(box));
+		} else {
+			const BoundingSphere sphere{center, size(random)};
+			culling.add(sphere);
+			expected.push_back(frustum.intersects(sphere));
+		}
+	}
+	CHECK(culling.size() == 1003);
+
+	std::vector<uint32_t> scalar;
+	culling.cull(frustum, scalar);
+	CHECK(std::is_sorted(scalar.begin(), scalar.end()));
+	CHECK(!scalar.empty() && scalar.size() < culling.size());
+	size_t visibleCount = 0;
+	for(bool visible : expected) {
+		visibleCount += visible;
+	}
+	CHECK(scalar.size() == visibleCount);
+	for(uint32_t index : scalar) {
+		CHECK(index < expected.size() && expected[index]);
+	}
+
+	// Every path the CPU supports reports exactly the same objects.
+	for(CullingPath path : {CullingPath::SSE, CullingPath::AVX2}) {
+		if(!CullingSystem::isSupported(path)) {
+			continue;
+		}
+		culling.setPath(path);
+		std::vector<uint32_t> visible;
+		culling.cull(frustum, visible);
+		CHECK(visible == scalar);
+	}
+
+	// Jobs cull ranges of objects, the result is the same.
+	culling.resize(50003);
+	for(uint32_t i = 1003; i != culling.size(); ++i) {
+		culling.set(i, BoundingSphere{{position(random), position(random), position(random)}, size(random)});
+	}
+	std::vector<uint32_t> single;
+	culling.cull(frustum, single);
+	JobSystem jobs(4);
+	std::vector<uint32_t> parallel;
+	culling.cull(frustum, parallel, jobs);
+	CHECK(parallel == single);
+	CHECK(std::equal(scalar.begin(), scalar.end(), single.begin()));
+
+	// All visible: The parts of the jobs are already in place.
+	std::uniform_real_distribution<float> inside(-1.0f, 1.0f);
+	for(uint32_t i = 0; i != culling.size(); ++i) {
+		culling.set(i, BoundingSphere{{inside(random), inside(random), -5.0f}, 0.5f});
+	}
+	culling.cull(frustum, parallel, jobs);
+	CHECK(parallel.size() == culling.size());
+	bool ordered = true;
+	for(uint32_t i = 0; i != parallel.size(); ++i) {
+		ordered = ordered && parallel[i] == i;
+	}
+	CHECK(ordered);
+
+	culling.resize(2);
+	culling.set(0, BoundingSphere{{0.0f, 0.0f, -5.0f}, 1.0f});
+	culling.set(1, BoundingSphere{{0.0f, 0.0f, 5.0f}, 1.0f});
+	std::vector<uint32_t> visible;
+	culling.cull(makeViewProjection(), visible);
+	CHECK(visible.size() == 1 && visible[0] == 0);
+
+	culling.clear();
+	culling.cull(frustum, visible);
+	CHECK(visible.empty());
+}
+
+int main() {
+	testFrustum();
+	testSpheres();
+	testPyramid();
+	testOcclusion();
+	testCullingSystem();
+
+	return checkResult("culling");
+}
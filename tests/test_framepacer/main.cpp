@@ -0,0 +1,99 @@
+#include "lwEngine/framepacer.hpp"
+#include "common/check.hpp"
+
+// Wait prediction and latency measurement of the frame pacer. Runs without a vulkan device.
+
+using namespace std::chrono_literals;
+using Clock = FramePacer::Clock;
+
+//! One frame of a GPU bound loop: Wait like the renderer would, then block until the GPU is done. Nothing sleeps, the
+//! predicted delay is only added to the simulated time.
+static void simulateFrame(FramePacer& pacer, uint32_t frame, Clock::time_point& now, Clock::duration blocked) {
+	const Clock::duration delay = pacer.delay();
+	pacer.delayApplied(delay);
+	now += delay;
+	pacer.inputSampled(now);
+	pacer.frameWaited(frame, now, now + blocked);
+	now += blocked;
+	pacer.frameSubmitted(frame);
+}
+
+static void testPrediction() {
+	FramePacer pacer(PresentPolicy::LowestLatency, 2);
+	CHECK(pacer.isPacing());
+	CHECK(pacer.delay() == Clock::duration::zero());
+
+	// The GPU takes 5 ms longer than the CPU per frame: The wait moves in front of input sampling.
+	Clock::time_point now = Clock::time_point{} + 1s;
+	simulateFrame(pacer, 0, now, 5ms);
+	CHECK(pacer.delay() == 5ms - FramePacer::SAFETY_MARGIN);
+
+	// Waiting the predicted time leaves the safety margin blocked, the prediction stays.
+	simulateFrame(pacer, 1, now, FramePacer::SAFETY_MARGIN);
+	CHECK(pacer.delay() == 5ms - FramePacer::SAFETY_MARGIN);
+
+	// A frame that did not block may have waited too long: Back off.
+	simulateFrame(pacer, 0, now, 0ms);
+	CHECK(pacer.delay() < 5ms - FramePacer::SAFETY_MARGIN);
+}
+
+static void testNoPacing() {
+	for(PresentPolicy policy : {PresentPolicy::VSync, PresentPolicy::Uncapped}) {
+		FramePacer pacer(policy, 2);
+		CHECK(!pacer.isPacing());
+
+		Clock::time_point now = Clock::time_point{} + 1s;
+		simulateFrame(pacer, 0, now, 8ms);
+		CHECK(pacer.delay() == Clock::duration::zero());
+	}
+}
+
+static void testLatency() {
+	FramePacer pacer(PresentPolicy::VSync, 2);
+	const Clock::time_point start = Clock::time_point{} + 1s;  // The clock epoch marks "no input"
+
+	// Input of frame 0 at 0 ms, a poll sees it finished at 7 ms.
+	pacer.inputSampled(start);
+	pacer.frameWaited(0, start + 1ms, start + 2ms);
+	CHECK(!pacer.isInFlight(0));
+	pacer.frameSubmitted(0);
+	CHECK(pacer.isInFlight(0));
+	pacer.inputSampled(start + 4ms);
+	pacer.frameWaited(1, start + 5ms, start + 6ms);
+	pacer.frameSubmitted(1);
+	CHECK(pacer.latency().frameCount == 0);
+
+	pacer.frameCompleted(0, start + 7ms);
+	CHECK(!pacer.isInFlight(0));
+	CHECK(pacer.latency().frameCount == 1);
+	CHECK(pacer.latency().lastMs == 7.0);
+
+	// Waiting for the index again does not count the completed frame twice.
+	pacer.inputSampled(start + 10ms);
+	pacer.frameWaited(0, start + 11ms, start + 12ms);
+	pacer.frameSubmitted(0);
+	CHECK(pacer.latency().frameCount == 1);
+
+	// Not polled: The frame finished at the latest when the wait for its index ended.
+	// Without inputSampled() the input of the new frame counts from the begin of the wait.
+	pacer.frameWaited(1, start + 15ms, start + 20ms);
+	pacer.frameSubmitted(1);
+	CHECK(pacer.latency().frameCount == 2);
+	CHECK(pacer.latency().lastMs == 16.0);   // Input at 4 ms
+	CHECK(pacer.latency().averageMs == 11.5);
+	CHECK(pacer.latency().maxMs == 16.0);
+
+	pacer.frameCompleted(0, start + 21ms);
+	CHECK(pacer.latency().lastMs == 11.0);  // Input at 10 ms
+	pacer.frameCompleted(1, start + 24ms);
+	CHECK(pacer.latency().lastMs == 9.0);   // Wait begin at 15 ms
+	CHECK(!pacer.isInFlight(0) && !pacer.isInFlight(1));
+}
+
+int main() {
+	testPrediction();
+	testNoPacing();
+	testLatency();
+
+	return checkResult("frame pacer");
+}
@@ -0,0 +1,188 @@
+#include "lwEngine/device.hpp"
+#include "lwEngine/renderer.hpp"
+#include "lwEngine/cullingpass.hpp"
+#include "lwEngine/depthpyramid.hpp"
+#include "lwEngine/indirectdraw.hpp"
+#include "common/check.hpp"
+#include "common/headless.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// CullingPass and DepthPyramid on a vulkan device, compared with the CPU reference of culling.hpp.
+// Needs a vulkan device but no display, eg. lavapipe in CI. Skipped if no device is available.
+
+static const VkExtent2D EXTENT{64, 64};
+static const float NEAR_PLANE = 0.1f;
+static const float FAR_PLANE = 10.0f;
+
+//! Camera at the origin looking down -z with a 90 degree field of view. Depth range [0, 1].
+static glm::mat4 makeViewProjection() {
+	glm::mat4 projection(0.0f);
+	projection[0][0] = 1.0f;
+	projection[1][1] = 1.0f;
+	projection[2][2] = FAR_PLANE / (NEAR_PLANE - FAR_PLANE);
+	projection[2][3] = -1.0f;
+	projection[3][2] = NEAR_PLANE * FAR_PLANE / (NEAR_PLANE - FAR_PLANE);
+	return projection;
+}
+
+//! Grid of small spheres at z = -5, the outer ones outside of the frustum, plus a few behind the camera and the far plane.
+//! No sphere is close to a frustum plane or the middle of the screen, so the CPU and the GPU cannot round differently.
+static std::vector<CullObject> makeScene() {
+	std::vector<CullObject> objects;
+	const auto add = [&objects](glm::vec3 center) {
+		const uint32_t index = static_cast<uint32_t>(objects.size());
+		objects.push_back({glm::vec4(center, 0.3f), 36, 6 * index, static_cast<int32_t>(index), index});
+	};
+
+	for(int y = -4; y <= 4; ++y) {
+		for(int x = -4; x <= 4; ++x) {
+			add({1.5f * x, 1.5f * y, -5.0f});
+		}
+	}
+	add({0.0f, 0.0f, 5.0f});
+	add({2.0f, 1.0f, -20.0f});
+	return objects;
+}
+
+//! Depth the test writes: The left half is at the near plane and hides everything, the right half is cleared to far.
+static std::vector<float> makeDepth() {
+	std::vector<float> depth(EXTENT.width * EXTENT.height, 1.0f);
+	for(uint32_t y = 0; y != EXTENT.height; ++y) {
+		std::fill_n(depth.begin() + y * EXTENT.width, EXTENT.width / 2, 0.0f);
+	}
+	return depth;
+}
+
+//! Write the depth of makeDepth() into the depth attachment of the render pass.
+static void writeDepth(VkCommandBuffer commandBuffer) {
+	VkClearAttachment attachment{};
+	attachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	attachment.clearValue.depthStencil = {0.0f, 0};
+
+	VkClearRect rect{};
+	rect.rect = {{0, 0}, {EXTENT.width / 2, EXTENT.height}};
+	rect.baseArrayLayer = 0;
+	rect.layerCount = 1;
+	vkCmdClearAttachments(commandBuffer, 1, &attachment, 1, &rect);
+}
+
+static bool lessByInstance(const VkDrawIndexedIndirectCommand& a, const VkDrawIndexedIndirectCommand& b) {
+	return a.firstInstance < b.firstInstance;
+}
+
+//! Visible draws the GPU wrote for the frame, ordered by object.
+static std::vector<VkDrawIndexedIndirectCommand> readDraws(const IndirectDrawBuffer& draws, const CullingPass& pass, uint32_t frame) {
+	const VkDrawIndexedIndirectCommand* commands = draws.commands(frame);
+	std::vector<VkDrawIndexedIndirectCommand> visible;
+	if(pass.compacts()) {
+		const uint32_t count = draws.gpuWrittenCount(frame);
+		CHECK(count <= pass.count(frame));
+		visible.assign(commands, commands + std::min(count, pass.count(frame)));
+	} else {
+		// Every object has a command, hidden ones with zero instances.
+		for(uint32_t i = 0; i != pass.count(frame); ++i) {
+			CHECK(commands[i].instanceCount <= 1);
+			if(commands[i].instanceCount != 0) {
+				visible.push_back(commands[i]);
+			}
+		}
+	}
+
+	std::sort(visible.begin(), visible.end(), lessByInstance);
+	return visible;
+}
+
+static bool equalDraws(const std::vector<VkDrawIndexedIndirectCommand>& gpu, const std::vector<VkDrawIndexedIndirectCommand>& cpu) {
+	if(gpu.size() != cpu.size()) {
+		std::cerr << "GPU wrote " << gpu.size() << " draws, the CPU reference " << cpu.size() << "\n";
+		return false;
+	}
+
+	for(size_t i = 0; i != gpu.size(); ++i) {
+		const VkDrawIndexedIndirectCommand& a = gpu[i];
+		const VkDrawIndexedIndirectCommand& b = cpu[i];
+		if(a.indexCount != b.indexCount || a.instanceCount != b.instanceCount || a.firstIndex != b.firstIndex
+		   || a.vertexOffset != b.vertexOffset || a.firstInstance != b.firstInstance) {
+			std::cerr << "Draw of object " << a.firstInstance << " differs from the CPU reference\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+static void testCulling(Device& device) {
+	RendererConfig config{};
+	config.framesInFlight = 1;
+	Renderer renderer(device, EXTENT, config);
+
+	const std::vector<CullObject> objects = makeScene();
+	const uint32_t objectCount = static_cast<uint32_t>(objects.size());
+	const glm::mat4 viewProjection = makeViewProjection();
+
+	IndirectDrawBuffer draws(device, 1, objectCount);
+	CullingPass pass(device, SHADER_PATH_CULL, draws, 1);
+	DepthPyramid pyramid(device, SHADER_PATH_DEPTH_REDUCE, EXTENT, 1);
+
+	// Two frames: The first culls against the frustum only and builds the pyramid, the second also against its depth.
+	std::vector<VkDrawIndexedIndirectCommand> frustumDraws;
+	for(bool occlusion : {false, true}) {
+		const uint32_t frame = renderer.currentSwapchainFrame();
+		VkCommandBuffer commandBuffer = renderer.beginFrame();
+		pass.update(frame, objects.data(), objectCount);
+		pass.dispatch(commandBuffer, frame, viewProjection, pyramid);
+
+		renderer.beginSwapchainRenderPass(commandBuffer);
+		writeDepth(commandBuffer);
+		renderer.endSwapchainRenderPass(commandBuffer);
+		pyramid.build(commandBuffer, frame, renderer.depthAttachment());
+		renderer.endFrame();
+		vkDeviceWaitIdle(device.device());
+
+		const CullUniforms& uniforms = pass.uniforms(frame);
+		CHECK(((uniforms.flags & CULL_OCCLUSION) != 0) == occlusion);
+		CHECK(uniforms.objectCount == objectCount);
+
+		const std::vector<float> depth = makeDepth();
+		const DepthPyramidData cpuPyramid = buildDepthPyramid(depth.data(), EXTENT.width, EXTENT.height);
+		CHECK(uniforms.pyramidLevels == cpuPyramid.levels.size());
+
+		const std::vector<VkDrawIndexedIndirectCommand> expected = cullObjects(objects.data(), objectCount, uniforms, &cpuPyramid);
+		const std::vector<VkDrawIndexedIndirectCommand> gpu = readDraws(draws, pass, frame);
+		CHECK(equalDraws(gpu, expected));
+
+		// The scene has to exercise both tests: Some spheres are outside, some hidden, some visible.
+		CHECK(!expected.empty() && expected.size() < objectCount);
+		if(occlusion) {
+			CHECK(expected.size() < frustumDraws.size());
+		}
+		frustumDraws = expected;
+	}
+}
+
+int main() {
+	if(!hasVulkanDevice()) {
+		std::cout << "Skipped, no vulkan device\n";
+		return SKIPPED;
+	}
+
+	std::unique_ptr<Device> device;
+	try {
+		device = std::make_unique<Device>();
+	} catch(const std::exception& e) {
+		std::cerr << "Failed to create the headless device: " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	if(!CullingPass::isSupported(*device)) {
+		std::cout << "Skipped, drawIndirectFirstInstance is not supported\n";
+		return SKIPPED;
+	}
+
+	testCulling(*device);
+
+	return checkResult("GPU culling");
+}
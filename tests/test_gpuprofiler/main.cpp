@@ -0,0 +1,125 @@
+#include "lwEngine/gpuprofiler.hpp"
+#include "common/check.hpp"
+
+#include <cmath>
+
+// Statistics and timestamp conversion of the GpuProfiler. Needs no vulkan device.
+
+static bool near(double a, double b) {
+	return std::abs(a - b) < 1e-9;
+}
+
+static void testTimestampDelta() {
+	// 1 ns per tick.
+	CHECK(near(timestampDeltaMs(1000, 3'001'000, 1.0f, 64), 3.0));
+	// 10 ns per tick.
+	CHECK(near(timestampDeltaMs(0, 100'000, 10.0f, 64), 1.0));
+
+	// A 36 bit counter wrapped around between begin and end.
+	const uint64_t max36 = (uint64_t(1) << 36) - 1;
+	CHECK(near(timestampDeltaMs(max36 - 499'999, 500'000, 1.0f, 36), 1.0));
+	// Bits above the valid bits are undefined and ignored.
+	CHECK(near(timestampDeltaMs(uint64_t(0xF) << 36, (uint64_t(0xA) << 36) + 2'000'000, 1.0f, 36), 2.0));
+}
+
+static void testPercentiles() {
+	ScopeStatistics statistics(100);
+	for(int frame = 1; frame <= 100; ++frame) {
+		statistics.add("Frame", frame);
+		statistics.endFrame();
+	}
+
+	const std::vector<GpuScopeStats> stats = statistics.statistics();
+	CHECK(stats.size() == 1);
+	if(stats.size() != 1) {
+		return;
+	}
+	CHECK(stats[0].name == "Frame");
+	CHECK(stats[0].sampleCount == 100);
+	CHECK(near(stats[0].averageMs, 50.5));
+	CHECK(near(stats[0].medianMs, 50.0));
+	CHECK(near(stats[0].p95Ms, 95.0));
+	CHECK(near(stats[0].p99Ms, 99.0));
+	CHECK(near(stats[0].maxMs, 100.0));
+}
+
+static void testHistory() {
+	// Only the last 4 frames count.
+	ScopeStatistics statistics(4);
+	for(int frame = 1; frame <= 10; ++frame) {
+		statistics.add("Frame", frame);
+		statistics.endFrame();
+	}
+
+	const std::vector<GpuScopeStats> stats = statistics.statistics();
+	CHECK(stats.size() == 1 && stats[0].sampleCount == 4);
+	CHECK(stats.size() == 1 && near(stats[0].averageMs, 8.5));
+	CHECK(stats.size() == 1 && near(stats[0].maxMs, 10.0));
+}
+
+static void testScopes() {
+	ScopeStatistics statistics(8);
+
+	// Scopes keep the order of their first occurrence, repeated scopes in one frame are summed.
+	statistics.add("Shadow", 1.0);
+	statistics.add("Culling", 0.25);
+	statistics.add("Shadow", 2.0);
+	statistics.endFrame();
+
+	// A scope missing in a frame does not get a sample.
+	statistics.add("Culling", 0.75);
+	statistics.endFrame();
+
+	const std::vector<GpuScopeStats> stats = statistics.statistics();
+	CHECK(stats.size() == 2);
+	if(stats.size() != 2) {
+		return;
+	}
+	CHECK(stats[0].name == "Shadow" && stats[0].sampleCount == 1 && near(stats[0].maxMs, 3.0));
+	CHECK(stats[1].name == "Culling" && stats[1].sampleCount == 2 && near(stats[1].averageMs, 0.5));
+
+	const std::string report = statistics.report();
+	CHECK(report.find("Shadow") != std::string::npos);
+	CHECK(report.find("Culling") != std::string::npos);
+	CHECK(report.find("Shadow") < report.find("Culling"));
+}
+
+static void testQueryResults() {
+	ScopeStatistics statistics(8);
+
+	// Timestamp and availability of begin and end per scope, 1 ns per tick. The end of "Culling" was never written.
+	const char* names[] = {"Frame", "Culling", "Shadow"};
+	const uint64_t results[] = {
+		1'000'000, 1, 5'000'000, 1,
+		2'000'000, 1, 0, 0,
+		3'000'000, 1, 3'500'000, 1,
+	};
+	statistics.addQueryResults(names, results, 3, 1.0f, 64);
+	statistics.endFrame();
+
+	// Only the incomplete scope is skipped, not the frame.
+	const std::vector<GpuScopeStats> stats = statistics.statistics();
+	CHECK(stats.size() == 2);
+	if(stats.size() != 2) {
+		return;
+	}
+	CHECK(stats[0].name == "Frame" && near(stats[0].maxMs, 4.0));
+	CHECK(stats[1].name == "Shadow" && near(stats[1].maxMs, 0.5));
+}
+
+static void testEmpty() {
+	ScopeStatistics statistics(8);
+	statistics.endFrame();
+	CHECK(statistics.statistics().empty());
+}
+
+int main() {
+	testTimestampDelta();
+	testPercentiles();
+	testHistory();
+	testScopes();
+	testQueryResults();
+	testEmpty();
+
+	return checkResult("gpu profiler");
+}
@@ -0,0 +1,83 @@
+#include "lwEngine/device.hpp"
+#include "lwEngine/renderer.hpp"
+#include "common/check.hpp"
+#include "common/headless.hpp"
+
+#include <iostream>
+#include <memory>
+
+// Headless rendering into a RenderTarget and readback of the frames. Needs a vulkan device but no display,
+// eg. lavapipe in CI. Skipped if no device is available.
+
+static void renderFrame(Renderer& renderer) {
+	VkCommandBuffer commandBuffer = renderer.beginFrame();
+	renderer.beginSwapchainRenderPass(commandBuffer);
+	renderer.endSwapchainRenderPass(commandBuffer);
+	renderer.endFrame();
+}
+
+static void testReadback(Device& device, uint32_t framesInFlight) {
+	const VkExtent2D extent{64, 32};
+	RendererConfig config{};
+	config.framesInFlight = framesInFlight;
+	Renderer renderer(device, extent, config);
+	CHECK(renderer.maxFramesInFlight() == framesInFlight);
+	CHECK(renderer.isHeadless());
+	CHECK(renderer.renderTarget() != nullptr);
+	CHECK(renderer.swapchainExtent().width == extent.width && renderer.swapchainExtent().height == extent.height);
+
+	RenderTarget& target = *renderer.renderTarget();
+	CHECK(target.readbackSize() == 64 * 32 * 4);
+
+	for(uint32_t i = 0; i != framesInFlight + 2; ++i) {
+		const uint32_t frame = renderer.currentSwapchainFrame();
+		CHECK(frame == i % framesInFlight);
+		renderFrame(renderer);
+
+		// The render pass clears to opaque black, the default format is BGRA.
+		const uint8_t* pixels = target.readback(frame);
+		CHECK(pixels != nullptr);
+		if(pixels == nullptr) {
+			continue;
+		}
+
+		bool cleared = true;
+		for(VkDeviceSize texel = 0; texel != target.readbackSize() / 4; ++texel) {
+			const uint8_t* bgra = pixels + texel * 4;
+			cleared = cleared && bgra[0] == 0 && bgra[1] == 0 && bgra[2] == 0 && bgra[3] == 255;
+		}
+		CHECK(cleared);
+	}
+
+	// Not read back: Only rendered.
+	target.setReadbackEnabled(false);
+	const uint32_t frame = renderer.currentSwapchainFrame();
+	renderFrame(renderer);
+	CHECK(target.readback(frame) == nullptr);
+
+	vkDeviceWaitIdle(device.device());
+}
+
+int main() {
+	if(!hasVulkanDevice()) {
+		std::cout << "Skipped, no vulkan device\n";
+		return SKIPPED;
+	}
+
+	std::unique_ptr<Device> device;
+	try {
+		device = std::make_unique<Device>();
+	} catch(const std::exception& e) {
+		std::cerr << "Failed to create the headless device: " << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	CHECK(device->isHeadless());
+	CHECK(device->surface() == VK_NULL_HANDLE);
+
+	// Per frame resources are sized from the config: 1 frame for low latency up to 3 for throughput.
+	for(uint32_t framesInFlight = 1; framesInFlight != 4; ++framesInFlight) {
+		testReadback(*device, framesInFlight);
+	}
+
+	return checkResult("headless");
+}
@@ -0,0 +1,226 @@
+#include "lwEngine/jobsystem.hpp"
+#include "common/check.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Work stealing queue and job system: Ranges, dependencies, main thread jobs and exceptions.
+
+static void testQueue() {
+	WorkStealingQueue queue(4);
+	Job jobs[5];
+
+	CHECK(queue.pop() == nullptr);
+	CHECK(queue.steal() == nullptr);
+	for(int i = 0; i != 4; ++i) {
+		CHECK(queue.push(&jobs[i]));
+	}
+	CHECK(!queue.push(&jobs[4]));  // Full
+
+	// The owner takes the newest job, thieves the oldest.
+	CHECK(queue.pop() == &jobs[3]);
+	CHECK(queue.steal() == &jobs[0]);
+	CHECK(queue.push(&jobs[4]));
+	CHECK(queue.pop() == &jobs[4]);
+	CHECK(queue.pop() == &jobs[2]);
+	CHECK(queue.steal() == &jobs[1]);
+	CHECK(queue.pop() == nullptr);
+}
+
+static void testConcurrentQueue() {
+	// Owner pushes and pops while thieves steal: Every job is taken exactly once.
+	const uint32_t jobCount = 100000;
+	std::vector<Job> jobs(jobCount);
+	std::vector<std::atomic<uint32_t>> taken(jobCount);
+	WorkStealingQueue queue(1024);
+	std::atomic<bool> done{false};
+
+	auto take = [&](Job* job) {
+		taken[static_cast<size_t>(job - jobs.data())].fetch_add(1);
+	};
+
+	std::vector<std::thread> thieves;
+	for(int i = 0; i != 3; ++i) {
+		thieves.emplace_back([&]() {
+			while(!done.load()) {
+				if(Job* job = queue.steal()) {
+					take(job);
+				}
+			}
+		});
+	}
+
+	for(uint32_t i = 0; i != jobCount; ++i) {
+		while(!queue.push(&jobs[i])) {
+			if(Job* job = queue.pop()) {
+				take(job);
+			}
+		}
+		if(i % 3 == 0) {
+			if(Job* job = queue.pop()) {
+				take(job);
+			}
+		}
+	}
+	while(Job* job = queue.pop()) {
+		take(job);
+	}
+	done = true;
+	for(auto& thief : thieves) {
+		thief.join();
+	}
+
+	uint32_t wrong = 0;
+	for(auto& count : taken) {
+		wrong += count.load() != 1;
+	}
+	CHECK(wrong == 0);
+}
+
+static void testParallelFor(JobSystem& jobs) {
+	const uint32_t count = 100003;
+	std::vector<std::atomic<uint32_t>> hits(count);
+	std::atomic<uint32_t> maxThread{0};
+
+	jobs.parallelFor(count, 64, [&](uint32_t first, uint32_t size) {
+		const uint32_t thread = jobs.threadIndex();
+		uint32_t expected = maxThread.load();
+		while(thread > expected && !maxThread.compare_exchange_weak(expected, thread)) {}
+
+		for(uint32_t i = first; i != first + size; ++i) {
+			hits[i].fetch_add(1);
+		}
+	});
+
+	uint32_t wrong = 0;
+	for(auto& hit : hits) {
+		wrong += hit.load() != 1;
+	}
+	CHECK(wrong == 0);
+	CHECK(maxThread.load() < jobs.threadCount());
+
+	// Nested ranges: Waiting threads run other jobs instead of blocking.
+	std::atomic<uint32_t> sum{0};
+	jobs.parallelFor(16, 1, [&](uint32_t, uint32_t outer) {
+		for(uint32_t i = 0; i != outer; ++i) {
+			jobs.parallelFor(100, 10, [&](uint32_t, uint32_t size) { sum.fetch_add(size); });
+		}
+	});
+	CHECK(sum.load() == 1600);
+
+	bool called = false;
+	jobs.parallelFor(0, 1, [&](uint32_t, uint32_t) { called = true; });
+	CHECK(!called);
+}
+
+static void testDependencies(JobSystem& jobs) {
+	// Second stage only starts once the whole first stage finished.
+	std::atomic<uint32_t> firstStage{0};
+	std::atomic<uint32_t> seenBySecond{0};
+	JobCounter first;
+	JobCounter second;
+	for(int i = 0; i != 64; ++i) {
+		jobs.submit([&]() {
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+			firstStage.fetch_add(1);
+		}, &first);
+	}
+	for(int i = 0; i != 8; ++i) {
+		jobs.submitAfter(first, [&]() { seenBySecond.fetch_add(firstStage.load()); }, &second);
+	}
+	jobs.wait(second);
+	CHECK(first.done());
+	CHECK(seenBySecond.load() == 8 * 64);
+
+	// A dependency that already finished does not hold the job back.
+	std::atomic<bool> ran{false};
+	jobs.submitAfter(first, [&]() { ran = true; }, &second);
+	jobs.wait(second);
+	CHECK(ran.load());
+}
+
+static void testMainThread(JobSystem& jobs) {
+	const std::thread::id mainThread = std::this_thread::get_id();
+	std::atomic<uint32_t> onMain{0};
+
+	JobCounter counter;
+	for(int i = 0; i != 10; ++i) {
+		jobs.submit([&]() {
+			// Workers hand work to the main thread, eg. to use the graphics queue.
+			jobs.submitMain([&]() { onMain.fetch_add(std::this_thread::get_id() == mainThread); }, &counter);
+		}, &counter);
+	}
+	jobs.wait(counter);  // Runs the main thread jobs while waiting
+	CHECK(onMain.load() == 10);
+
+	bool ran = false;
+	jobs.submitMain([&]() { ran = true; });
+	CHECK(!ran);
+	jobs.runMainThreadJobs();
+	CHECK(ran);
+}
+
+static void testExternalThreads(JobSystem& jobs) {
+	// Threads outside of the job system can submit and wait, the jobs run on the workers.
+	if(jobs.threadCount() == 1) {
+		return;  // No worker, thread 0 blocks in join()
+	}
+	std::atomic<uint32_t> sum{0};
+	std::thread external([&]() {
+		JobCounter counter;
+		for(int i = 0; i != 100; ++i) {
+			jobs.submit([&]() { sum.fetch_add(1); }, &counter);
+		}
+		jobs.wait(counter);
+	});
+	external.join();
+	CHECK(sum.load() == 100);
+
+	bool threw = false;
+	std::thread([&]() {
+		try {
+			jobs.threadIndex();
+		} catch(const std::runtime_error&) {
+			threw = true;
+		}
+	}).join();
+	CHECK(threw);
+}
+
+static void testExceptions(JobSystem& jobs) {
+	bool caught = false;
+	try {
+		jobs.parallelFor(1000, 10, [](uint32_t first, uint32_t) {
+			if(first == 0) {
+				throw std::runtime_error("Job failed!");
+			}
+		});
+	} catch(const std::runtime_error&) {
+		caught = true;
+	}
+	CHECK(caught);
+
+	// The job system keeps working.
+	std::atomic<uint32_t> count{0};
+	jobs.parallelFor(1000, 10, [&](uint32_t, uint32_t size) { count.fetch_add(size); });
+	CHECK(count.load() == 1000);
+}
+
+int main() {
+	testQueue();
+	testConcurrentQueue();
+
+	for(uint32_t threadCount : {1u, 4u, 0u}) {
+		JobSystem jobs(threadCount);
+		testParallelFor(jobs);
+		testDependencies(jobs);
+		testMainThread(jobs);
+		testExternalThreads(jobs);
+		testExceptions(jobs);
+	}
+
+	return checkResult("job system");
+}
@@ -0,0 +1,128 @@
+#include "lwEngine/meshcache.hpp"
+#include "common/check.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// Round trip and invalidation of the binary mesh cache. Runs without a vulkan device.
+
+static MeshData makeMesh() {
+	MeshData mesh;
+	for(int i = 0; i != 4; ++i) {
+		Vertex vertex{};
+		vertex.pos = {static_cast<float>(i), static_cast<float>(-i), 0.5f};
+		vertex.color = {1.0f, 1.0f, 1.0f};
+		vertex.texCoord = {0.25f * i, 1.0f};
+		mesh.vertices.push_back(vertex);
+	}
+	mesh.indices = {0, 1, 2, 2, 3, 0};
+	mesh.bounds = computeBounds(mesh.vertices.data(), mesh.vertices.size());
+	return mesh;
+}
+
+static void writeSource(const std::filesystem::path& path, const std::string& content) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << content;
+}
+
+static void testRoundTrip(const std::filesystem::path& directory, const std::filesystem::path& source) {
+	writeSource(source, "v 0 0 0\n");
+	const MeshData mesh = makeMesh();
+
+	MeshCache cache{source.string(), directory};
+	CHECK(!cache.load());
+	CHECK(cache.store(mesh));
+	CHECK(cache.load());
+
+	CHECK(cache.vertexCount() == mesh.vertices.size());
+	CHECK(cache.indexCount() == mesh.indices.size());
+	for(uint32_t i = 0; i != cache.vertexCount(); ++i) {
+		CHECK(cache.vertices()[i] == mesh.vertices[i]);
+	}
+	for(uint32_t i = 0; i != cache.indexCount(); ++i) {
+		CHECK(cache.indices()[i] == mesh.indices[i]);
+	}
+	CHECK(cache.bounds().min == mesh.bounds.min);
+	CHECK(cache.bounds().max == mesh.bounds.max);
+
+	// Blobs are aligned for direct copies.
+	CHECK(reinterpret_cast<uintptr_t>(cache.vertices()) % 16 == 0);
+	CHECK(reinterpret_cast<uintptr_t>(cache.indices()) % 16 == 0);
+}
+
+static void testStaleSource(const std::filesystem::path& directory, const std::filesystem::path& source) {
+	writeSource(source, "v 0 0 0\n");
+	MeshCache{source.string(), directory}.store(makeMesh());
+
+	// Different size of the source -> Cache must not be used.
+	writeSource(source, "v 0 0 0\nv 1 1 1\n");
+	MeshCache cache{source.string(), directory};
+	CHECK(!cache.load());
+}
+
+static void testCorruptFile(const std::filesystem::path& directory, const std::filesystem::path& source) {
+	writeSource(source, "v 0 0 0\n");
+	MeshCache cache{source.string(), directory};
+	cache.store(makeMesh());
+
+	// Truncated file
+	std::filesystem::resize_file(cache.path(), 20);
+	CHECK(!cache.load());
+}
+
+static void testConcurrentStore(const std::filesystem::path& directory, const std::filesystem::path& source) {
+	writeSource(source, "v 0 0 0\n");
+	const MeshData mesh = makeMesh();
+
+	// Writers of the same cache file do not share a temporary file, the last rename wins.
+	std::vector<std::thread> threads;
+	std::vector<char> stored(8, 0);
+	for(size_t i = 0; i != stored.size(); ++i) {
+		threads.emplace_back([&, i]() {
+			stored[i] = MeshCache{source.string(), directory}.store(mesh);
+		});
+	}
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	CHECK(std::count(stored.begin(), stored.end(), 1) != 0);
+	MeshCache cache{source.string(), directory};
+	CHECK(cache.load());
+	CHECK(cache.vertexCount() == mesh.vertices.size() && cache.indexCount() == mesh.indices.size());
+
+	size_t leftovers = 0;
+	for(const auto& entry : std::filesystem::directory_iterator(directory)) {
+		leftovers += entry.path().extension() == ".tmp";
+	}
+	CHECK(leftovers == 0);
+}
+
+static void testTemporaryPath(const std::filesystem::path& directory) {
+	// Shared by the mesh and the pipeline cache: Every call gets its own file next to the target.
+	const std::filesystem::path target = directory / "pipeline.cache";
+	const std::filesystem::path first = temporaryPath(target);
+	const std::filesystem::path second = temporaryPath(target);
+	CHECK(first != second);
+	CHECK(first.parent_path() == directory && second.parent_path() == directory);
+	CHECK(first.extension() == ".tmp" && first.filename().string().rfind("pipeline.cache.", 0) == 0);
+}
+
+int main() {
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "lwEngineTestMeshCache";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	const std::filesystem::path source = directory / "source.obj";
+
+	testRoundTrip(directory, source);
+	testStaleSource(directory, source);
+	testCorruptFile(directory, source);
+	testConcurrentStore(directory, source);
+	testTemporaryPath(directory);
+
+	std::filesystem::remove_all(directory);
+
+	return checkResult("mesh cache");
+}
@@ -0,0 +1,74 @@
+#include "lwEngine/image.hpp"
+#include "lwEngine/jobsystem.hpp"
+#include "common/check.hpp"
+
+// Mip chain sizes and the CPU box filter used when a format can not be blitted. Runs without a vulkan device.
+
+static void testLevelCount() {
+	CHECK(mipLevelCount(1, 1) == 1);
+	CHECK(mipLevelCount(2, 1) == 2);
+	CHECK(mipLevelCount(1024, 1024) == 11);
+	CHECK(mipLevelCount(1024, 16) == 11);
+	CHECK(mipLevelCount(1000, 600) == 10);
+
+	CHECK(mipExtent(1000, 3) == 125);
+	CHECK(mipExtent(5, 3) == 1);
+}
+
+static void testUniform() {
+	// A uniform image must stay uniform on every level, in both color spaces.
+	std::vector<uint8_t> pixels(7 * 5 * 4);
+	for(size_t i = 0; i != pixels.size(); ++i) {
+		pixels[i] = static_cast<uint8_t>(40 + i % 4 * 50);
+	}
+
+	for(bool srgb : {false, true}) {
+		const uint32_t levels = mipLevelCount(7, 5);
+		const std::vector<uint8_t> chain = generateMipChain(pixels.data(), 7, 5, levels, srgb);
+		CHECK(chain.size() == (3 * 2 + 1 * 1) * 4);
+		for(size_t i = 0; i != chain.size(); ++i) {
+			CHECK(chain[i] == 40 + i % 4 * 50);
+		}
+	}
+}
+
+static void testAverage() {
+	// 2x2 black and white -> 1x1 grey. sRGB averages the light, not the encoded values.
+	const uint8_t pixels[16] = {
+			0, 0, 0, 0,          255, 255, 255, 255,
+			255, 255, 255, 255,  0, 0, 0, 0
+	};
+
+	const std::vector<uint8_t> linear = generateMipChain(pixels, 2, 2, 2, false);
+	CHECK(linear.size() == 4);
+	CHECK(linear[0] == 128 && linear[3] == 128);
+
+	const std::vector<uint8_t> srgb = generateMipChain(pixels, 2, 2, 2, true);
+	CHECK(srgb[0] == 188 && srgb[1] == 188 && srgb[2] == 188);
+	CHECK(srgb[3] == 128);
+}
+
+static void testJobs() {
+	// Rows filtered on the job system give the same chain as on one thread.
+	const uint32_t width = 300;
+	const uint32_t height = 77;
+	std::vector<uint8_t> pixels(width * height * 4);
+	for(size_t i = 0; i != pixels.size(); ++i) {
+		pixels[i] = static_cast<uint8_t>(i * 7 % 251);
+	}
+
+	JobSystem jobs(4);
+	for(bool srgb : {false, true}) {
+		const uint32_t levels = mipLevelCount(width, height);
+		CHECK(generateMipChain(pixels.data(), width, height, levels, srgb, &jobs) == generateMipChain(pixels.data(), width, height, levels, srgb));
+	}
+}
+
+int main() {
+	testLevelCount();
+	testUniform();
+	testAverage();
+	testJobs();
+
+	return checkResult("mipmap");
+}
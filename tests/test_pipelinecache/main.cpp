@@ -0,0 +1,85 @@
+#include "lwEngine/pipelinecache.hpp"
+#include "common/check.hpp"
+
+#include <cstring>
+#include <vector>
+
+// Header validation of pipeline cache data loaded from disk. Runs without a vulkan device.
+
+static VkPhysicalDeviceProperties makeProperties() {
+	VkPhysicalDeviceProperties properties{};
+	properties.vendorID = 0x10de;
+	properties.deviceID = 0x2684;
+	for(uint8_t i = 0; i != VK_UUID_SIZE; ++i) {
+		properties.pipelineCacheUUID[i] = static_cast<uint8_t>(i * 7 + 1);
+	}
+	return properties;
+}
+
+//! Header like a driver writes it, followed by some opaque driver data.
+static std::vector<char> makeData(const VkPhysicalDeviceProperties& properties) {
+	std::vector<char> data(PipelineCache::HEADER_SIZE + 64, 'x');
+	auto writeUint32 = [&data](size_t offset, uint32_t value) {
+		for(int i = 0; i != 4; ++i) {
+			data[offset + i] = static_cast<char>(value >> (i * 8));
+		}
+	};
+
+	writeUint32(0, static_cast<uint32_t>(PipelineCache::HEADER_SIZE));
+	writeUint32(4, VK_PIPELINE_CACHE_HEADER_VERSION_ONE);
+	writeUint32(8, properties.vendorID);
+	writeUint32(12, properties.deviceID);
+	memcpy(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	return data;
+}
+
+static void testCompatible() {
+	const VkPhysicalDeviceProperties properties = makeProperties();
+	const std::vector<char> data = makeData(properties);
+	CHECK(PipelineCache::isCompatible(data.data(), data.size(), properties));
+
+	// Only the header is required.
+	CHECK(PipelineCache::isCompatible(data.data(), PipelineCache::HEADER_SIZE, properties));
+}
+
+static void testIncompatible() {
+	const VkPhysicalDeviceProperties properties = makeProperties();
+	const std::vector<char> data = makeData(properties);
+
+	CHECK(!PipelineCache::isCompatible(data.data(), 0, properties));
+	CHECK(!PipelineCache::isCompatible(data.data(), PipelineCache::HEADER_SIZE - 1, properties));
+
+	// Other GPU
+	VkPhysicalDeviceProperties other = properties;
+	other.vendorID = 0x1002;
+	CHECK(!PipelineCache::isCompatible(data.data(), data.size(), other));
+
+	other = properties;
+	other.deviceID += 1;
+	CHECK(!PipelineCache::isCompatible(data.data(), data.size(), other));
+
+	// Driver update
+	other = properties;
+	other.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 0xff;
+	CHECK(!PipelineCache::isCompatible(data.data(), data.size(), other));
+
+	// Broken header fields
+	std::vector<char> broken = data;
+	broken[4] = 2;  // Header version
+	CHECK(!PipelineCache::isCompatible(broken.data(), broken.size(), properties));
+
+	broken = data;
+	broken[0] = 8;  // Header smaller than the fields
+	CHECK(!PipelineCache::isCompatible(broken.data(), broken.size(), properties));
+
+	broken = data;
+	broken[1] = 1;  // Header larger than the data
+	CHECK(!PipelineCache::isCompatible(broken.data(), broken.size(), properties));
+}
+
+int main() {
+	testCompatible();
+	testIncompatible();
+
+	return checkResult("pipeline cache");
+}
@@ -0,0 +1,270 @@
+#include "lwEngine/blockcompression.hpp"
+#include "lwEngine/jobsystem.hpp"
+#include "lwEngine/texture.hpp"
+#include "common/check.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Block compression and the KTX2 and DDS containers. Runs without a vulkan device.
+
+static std::vector<uint8_t> makeGradient(uint32_t width, uint32_t height) {
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+	for(uint32_t y = 0; y != height; ++y) {
+		for(uint32_t x = 0; x != width; ++x) {
+			// Colors of a block lie on a line, like they do for most blocks of real textures.
+			const uint32_t t = x + y;
+			uint8_t* pixel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+			pixel[0] = static_cast<uint8_t>(40 + t * 8);
+			pixel[1] = static_cast<uint8_t>(230 - t * 6);
+			pixel[2] = static_cast<uint8_t>(90 + t * 2);
+			pixel[3] = static_cast<uint8_t>(255 - t * 10);
+		}
+	}
+	return pixels;
+}
+
+static int maxError(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, uint32_t channels) {
+	int error = 0;
+	for(size_t i = 0; i != a.size(); ++i) {
+		if(i % 4 < channels) {
+			error = std::max(error, std::abs(a[i] - b[i]));
+		}
+	}
+	return error;
+}
+
+static void testSizes() {
+	CHECK(imageSize(VK_FORMAT_R8G8B8A8_SRGB, 5, 5) == 100);
+	CHECK(imageSize(VK_FORMAT_BC1_RGB_SRGB_BLOCK, 5, 5) == 4 * 8);
+	CHECK(imageSize(VK_FORMAT_BC7_SRGB_BLOCK, 1, 1) == 16);
+	CHECK(isBlockCompressed(VK_FORMAT_BC3_UNORM_BLOCK) && !isBlockCompressed(VK_FORMAT_R8G8B8A8_UNORM));
+
+	TextureData texture;
+	texture.format = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	texture.width = 16;
+	texture.height = 8;
+	CHECK(texture.levelOffset(2) == 8 * 8 + 2 * 8);  // 4x2 blocks, then 2x1 blocks
+	CHECK(texture.levelSize(4) == 8);
+}
+
+static void testCodecs() {
+	// Odd sizes: Edge blocks are padded by repeating the last row and column.
+	const uint32_t width = 13;
+	const uint32_t height = 10;
+	const std::vector<uint8_t> pixels = makeGradient(width, height);
+
+	const std::vector<uint8_t> bc1 = decompressImage(compressImage(pixels.data(), width, height, VK_FORMAT_BC1_RGB_UNORM_BLOCK).data(),
+	                                                 width, height, VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+	CHECK(bc1.size() == pixels.size());
+	CHECK(maxError(pixels, bc1, 3) <= 12);
+
+	const std::vector<uint8_t> bc3 = decompressImage(compressImage(pixels.data(), width, height, VK_FORMAT_BC3_UNORM_BLOCK).data(),
+	                                                 width, height, VK_FORMAT_BC3_UNORM_BLOCK);
+	CHECK(maxError(pixels, bc3, 3) <= 12);
+	CHECK(maxError(pixels, bc3, 4) <= 12);
+
+	const std::vector<uint8_t> bc7 = decompressImage(compressImage(pixels.data(), width, height, VK_FORMAT_BC7_UNORM_BLOCK).data(),
+	                                                 width, height, VK_FORMAT_BC7_UNORM_BLOCK);
+	CHECK(maxError(pixels, bc7, 4) <= 8);
+
+	// Rows of blocks encoded on the job system give the same blocks.
+	JobSystem jobs(4);
+	CHECK(compressImage(pixels.data(), width, height, VK_FORMAT_BC7_UNORM_BLOCK, &jobs)
+	      == compressImage(pixels.data(), width, height, VK_FORMAT_BC7_UNORM_BLOCK));
+}
+
+static void testUniformBlock() {
+	// A uniform block only loses the precision of the end points.
+	uint8_t texels[64];
+	for(int i = 0; i != 16; ++i) {
+		texels[i * 4 + 0] = 37;
+		texels[i * 4 + 1] = 150;
+		texels[i * 4 + 2] = 201;
+		texels[i * 4 + 3] = 128;
+	}
+
+	uint8_t block[16];
+	uint8_t decoded[64];
+
+	encodeBC7Block(texels, block);
+	decodeBC7Block(block, decoded);
+	CHECK(maxError({texels, texels + 64}, {decoded, decoded + 64}, 4) <= 1);
+
+	encodeBC1Block(texels, block);
+	decodeBC1Block(block, decoded);
+	CHECK(maxError({texels, texels + 64}, {decoded, decoded + 64}, 3) <= 4);
+	CHECK(decoded[3] == 255);
+
+	encodeBC3Block(texels, block);
+	decodeBC3Block(block, decoded);
+	CHECK(decoded[3] == 128 && decoded[63] == 128);
+}
+
+//! Little endian bit writer for hand made BC7 blocks.
+struct BitWriter {
+	uint8_t* block;
+	uint32_t position = 0;
+
+	void write(uint32_t value, uint32_t bits) {
+		for(uint32_t i = 0; i != bits; ++i, ++position) {
+			block[position / 8] |= static_cast<uint8_t>(((value >> i) & 1u) << (position % 8));
+		}
+	}
+};
+
+static bool texelIs(const uint8_t* rgba, uint32_t texel, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	const uint8_t* t = rgba + texel * 4;
+	return t[0] == r && t[1] == g && t[2] == b && t[3] == a;
+}
+
+static void testPartitionedBC7() {
+	uint8_t decoded[64];
+
+	// Mode 1, partition 13: The upper two rows are subset 0 (black), the lower two rows subset 1 (white).
+	// 6 bit endpoints with a p-bit per subset expand to 8 bits. All indices 0.
+	uint8_t mode1[16] = {};
+	BitWriter bits1{mode1};
+	bits1.write(1u << 1, 2);
+	bits1.write(13, 6);
+	for(int c = 0; c != 3; ++c) {
+		bits1.write(0, 6);
+		bits1.write(0, 6);
+		bits1.write(63, 6);
+		bits1.write(63, 6);
+	}
+	bits1.write(0, 1);
+	bits1.write(1, 1);
+
+	decodeBC7Block(mode1, decoded);
+	bool split = true;
+	for(uint32_t texel = 0; texel != 16; ++texel) {
+		split = split && (texel < 8 ? texelIs(decoded, texel, 0, 0, 0, 255) : texelIs(decoded, texel, 255, 255, 255, 255));
+	}
+	CHECK(split);
+
+	// Mode 2, partition 8: Rows 0 and 1 are subset 0, row 2 subset 1 and row 3 subset 2. Endpoints are stored channel
+	// by channel: Subset 1 is red, subset 2 green. All indices 0.
+	uint8_t mode2[16] = {};
+	BitWriter bits2{mode2};
+	bits2.write(1u << 2, 3);
+	bits2.write(8, 6);
+	const uint32_t channels[3][3] = {{0, 31, 0}, {0, 0, 31}, {0, 0, 0}};  // [channel][subset]
+	for(int c = 0; c != 3; ++c) {
+		for(int subset = 0; subset != 3; ++subset) {
+			bits2.write(channels[c][subset], 5);
+			bits2.write(channels[c][subset], 5);
+		}
+	}
+
+	decodeBC7Block(mode2, decoded);
+	CHECK(texelIs(decoded, 0, 0, 0, 0, 255) && texelIs(decoded, 7, 0, 0, 0, 255));
+	CHECK(texelIs(decoded, 8, 255, 0, 0, 255) && texelIs(decoded, 11, 255, 0, 0, 255));
+	CHECK(texelIs(decoded, 12, 0, 255, 0, 255) && texelIs(decoded, 15, 0, 255, 0, 255));
+}
+
+static TextureData makeTexture(VkFormat format) {
+	const std::vector<uint8_t> pixels = makeGradient(8, 4);
+
+	TextureData texture;
+	texture.format = format;
+	texture.width = 8;
+	texture.height = 4;
+	texture.mipLevels = 2;
+	texture.data = compressImage(pixels.data(), 8, 4, format);
+	const std::vector<uint8_t> level1 = compressImage(pixels.data(), 4, 2, format);
+	texture.data.insert(texture.data.end(), level1.begin(), level1.end());
+	return texture;
+}
+
+static void testKtx2(const std::filesystem::path& directory) {
+	const std::string path = (directory / "texture.ktx2").string();
+
+	for(VkFormat format : {VK_FORMAT_BC1_RGB_SRGB_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK}) {
+		const TextureData texture = makeTexture(format);
+		writeKtx2(path, texture);
+
+		const TextureData loaded = loadTexture(path);
+		CHECK(loaded.format == format);
+		CHECK(loaded.width == 8 && loaded.height == 4 && loaded.mipLevels == 2);
+		CHECK(loaded.data == texture.data);
+	}
+
+	auto throws = [&path]() {
+		try {
+			loadKtx2(path);
+		} catch(const std::runtime_error&) {
+			return true;
+		}
+		return false;
+	};
+
+	// Not a KTX2 file
+	std::ofstream(path, std::ios::binary | std::ios::trunc) << std::string(128, 'x');
+	CHECK(throws());
+
+	// An empty image: pixelWidth and pixelHeight follow the identifier, vkFormat and typeSize.
+	for(std::streamoff offset : {20, 24}) {
+		writeKtx2(path, makeTexture(VK_FORMAT_BC1_RGB_SRGB_BLOCK));
+		const uint32_t zero = 0;
+		std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(offset);
+		file.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+		file.close();
+		CHECK(throws());
+	}
+}
+
+static void testDds(const std::filesystem::path& directory) {
+	const std::string path = (directory / "texture.dds").string();
+	const TextureData texture = makeTexture(VK_FORMAT_BC1_RGBA_SRGB_BLOCK);
+
+	uint32_t header[32] = {};
+	header[0] = 0x20534444;  // "DDS "
+	header[1] = 124;
+	header[3] = texture.height;
+	header[4] = texture.width;
+	header[7] = texture.mipLevels;
+	header[19] = 32;          // Pixel format size
+	header[20] = 0x4;         // FourCC
+	memcpy(&header[21], "DXT1", 4);
+
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+	}
+
+	const TextureData loaded = loadTexture(path);
+	CHECK(loaded.format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK);
+	CHECK(loaded.mipLevels == 2);
+	CHECK(loaded.data == texture.data);
+}
+
+static void testDecompress() {
+	const TextureData texture = makeTexture(VK_FORMAT_BC7_SRGB_BLOCK);
+	const TextureData decoded = decompress(texture);
+
+	CHECK(decoded.format == VK_FORMAT_R8G8B8A8_SRGB);
+	CHECK(decoded.mipLevels == 2);
+	CHECK(decoded.data.size() == (8 * 4 + 4 * 2) * 4);
+}
+
+int main() {
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "lwEngineTestTexture";
+	std::filesystem::create_directories(directory);
+
+	testSizes();
+	testCodecs();
+	testUniformBlock();
+	testPartitionedBC7();
+	testKtx2(directory);
+	testDds(directory);
+	testDecompress();
+
+	std::filesystem::remove_all(directory);
+
+	return checkResult("texture");
+}
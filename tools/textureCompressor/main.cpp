@@ -0,0 +1,109 @@
+#include "lwEngine/blockcompression.hpp"
+#include "lwEngine/image.hpp"
+#include "lwEngine/jobsystem.hpp"
+#include "lwEngine/texture.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+// Converts an image (PNG, JPG, ...) into a block compressed KTX2 file with a full mip chain.
+// The chain is built from the uncompressed pixels, every level is then encoded on its own.
+
+static void printUsage() {
+	std::cerr << "Usage: TextureCompressor <input image> <output.ktx2> [--format bc1|bc3|bc7] [--linear] [--no-mips]\n"
+	          << "  --format   BC1: Opaque, 8:1. BC3: Alpha, 4:1. BC7: Alpha, 4:1, highest quality (default).\n"
+	          << "  --linear   Data is not color (eg. normal maps), no sRGB decoding.\n"
+	          << "  --no-mips  Only store the first level.\n";
+}
+
+static bool parseFormat(const std::string& name, bool srgb, VkFormat& format) {
+	if(name == "bc1") {
+		format = srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	} else if(name == "bc3") {
+		format = srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+	} else if(name == "bc7") {
+		format = srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	const std::string input = argv[1];
+	const std::string output = argv[2];
+	std::string formatName = "bc7";
+	bool srgb = true;
+	bool mips = true;
+
+	for(int i = 3; i < argc; ++i) {
+		if(strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			formatName = argv[++i];
+		} else if(strcmp(argv[i], "--linear") == 0) {
+			srgb = false;
+		} else if(strcmp(argv[i], "--no-mips") == 0) {
+			mips = false;
+		} else {
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	TextureData compressed;
+	if(!parseFormat(formatName, srgb, compressed.format)) {
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	try {
+		const auto start = std::chrono::steady_clock::now();
+		JobSystem jobs;
+
+		const TextureData image = loadImage(input);
+		compressed.width = image.width;
+		compressed.height = image.height;
+		compressed.mipLevels = mips ? mipLevelCount(image.width, image.height) : 1;
+
+		// Level 0 followed by the generated levels, tightly packed like the levels of TextureData.
+		std::vector<uint8_t> pixels = image.data;
+		const std::vector<uint8_t> chain = generateMipChain(image.data.data(), image.width, image.height, compressed.mipLevels, srgb, &jobs);
+		pixels.insert(pixels.end(), chain.begin(), chain.end());
+
+		const uint8_t* level = pixels.data();
+		for(uint32_t mipLevel = 0; mipLevel != compressed.mipLevels; ++mipLevel) {
+			const uint32_t width = mipExtent(image.width, mipLevel);
+			const uint32_t height = mipExtent(image.height, mipLevel);
+
+			const std::vector<uint8_t> blocks = compressImage(level, width, height, compressed.format, &jobs);
+			compressed.data.insert(compressed.data.end(), blocks.begin(), blocks.end());
+			level += static_cast<size_t>(width) * height * 4;
+		}
+
+		const std::filesystem::path outputDirectory = std::filesystem::path(output).parent_path();
+		if(!outputDirectory.empty()) {
+			std::filesystem::create_directories(outputDirectory);
+		}
+		writeKtx2(output, compressed);
+
+		const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << input << " -> " << output << " (" << formatName << ", " << compressed.width << "x" << compressed.height
+		          << ", " << compressed.mipLevels << " levels)\n"
+		          << "  RGBA8: " << pixels.size() << " bytes, compressed: " << compressed.data.size() << " bytes ("
+		          << static_cast<double>(pixels.size()) / static_cast<double>(compressed.data.size()) << ":1) in "
+		          << milliseconds << " ms\n";
+	} catch(const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}